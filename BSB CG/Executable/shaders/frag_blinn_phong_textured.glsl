@@ -1,38 +1,52 @@
-#version 410
+#version 430
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
 
+#ifdef USE_TEXTURE_ARRAY
+layout(location = 4) flat in int inTextureLayer;
+// The diffuse textures of every material that was merged into this one, see MaterialMerger
+uniform sampler2DArray s_DiffuseArray;
+#else
 uniform sampler2D s_Diffuse;
+#endif
 uniform sampler2D s_Diffuse2;
 uniform sampler2D s_Specular;
 
-uniform vec3  u_AmbientCol;
-uniform float u_AmbientStrength;
+// Uploaded once per frame, see RenderSystem::FrameData
+layout(std140, binding = 0) uniform FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
+
+// The scene's light, shared by every shader. See RenderSystem::LightData
+layout(std140, binding = 1) uniform LightData {
+	vec3  u_LightPos;
+	float u_AmbientLightStrength;
+	vec3  u_LightCol;
+	float u_SpecularLightStrength;
+	vec3  u_AmbientCol;
+	float u_AmbientStrength;
+	// NEW in week 7, see https://learnopengl.com/Lighting/Light-casters for a good reference on how this all works, or
+	// https://developer.valvesoftware.com/wiki/Constant-Linear-Quadratic_Falloff
+	float u_LightAttenuationConstant;
+	float u_LightAttenuationLinear;
+	float u_LightAttenuationQuadratic;
+	int   u_lightoff;
+	int   u_ambient;
+	int   u_specular;
+	int   u_ambientspecular;
+	int   u_ambientspeculartoon;
+};
 
-uniform vec3  u_LightPos;
-uniform vec3  u_LightCol;
-uniform float u_AmbientLightStrength;
-uniform float u_SpecularLightStrength;
 uniform float u_Shininess;
-// NEW in week 7, see https://learnopengl.com/Lighting/Light-casters for a good reference on how this all works, or
-// https://developer.valvesoftware.com/wiki/Constant-Linear-Quadratic_Falloff
-uniform float u_LightAttenuationConstant;
-uniform float u_LightAttenuationLinear;
-uniform float u_LightAttenuationQuadratic;
-
 uniform float u_TextureMix;
 
-uniform vec3  u_CamPos;
-
-uniform int u_lightoff;
-uniform int u_ambient;
-uniform int u_specular;
-uniform int u_ambientspecular;
-uniform int u_ambientspeculartoon;
-
 out vec4 frag_color;
 
 //Add stuff for toon shading
@@ -70,7 +84,11 @@ void main() {
 	vec3 specular = u_SpecularLightStrength * texSpec * spec * u_LightCol; // Can also use a specular color
 
 	// Get the albedo from the diffuse / albedo map
+#ifdef USE_TEXTURE_ARRAY
+	vec4 textureColor1 = texture(s_DiffuseArray, vec3(inUV, inTextureLayer));
+#else
 	vec4 textureColor1 = texture(s_Diffuse, inUV);
+#endif
 	vec4 textureColor2 = texture(s_Diffuse2, inUV);
 	vec4 textureColor = mix(textureColor1, textureColor2, u_TextureMix);
 
@@ -1,4 +1,4 @@
-#version 410
+#version 430
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inColor;
@@ -7,8 +7,17 @@ layout(location = 3) in vec2 inUV;
 
 uniform samplerCube s_Environment;
 uniform mat3 u_EnvironmentRotation;
+// 0 for a mirror, up to 1 for fully rough. Picks a level of the prefiltered environment
+uniform float u_EnvironmentRoughness;
 
-uniform vec3  u_CamPos;
+// Uploaded once per frame, see RenderSystem::FrameData
+layout(std140, binding = 0) uniform FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
 
 out vec4 frag_color;
 
@@ -20,7 +29,8 @@ void main() {
 	vec3 reflected = reflect(toEye, N);
 
 	// Look up the environment texture
-	vec3 environment = texture(s_Environment, u_EnvironmentRotation * reflected).rgb;
+	float lod = u_EnvironmentRoughness * float(textureQueryLevels(s_Environment) - 1);
+	vec3 environment = textureLod(s_Environment, u_EnvironmentRotation * reflected, lod).rgb;
 
 	// For now just return the result, fully reflective!
 	frag_color = vec4(environment, 1.0);
@@ -9,5 +9,6 @@ out vec4 frag_color;
 void main() {
     vec3 norm = normalize(inNormal);
 
-    frag_color = vec4(texture(s_Environment, norm).rgb, 1.0);
+    // Always the sharp top level, the rest of the chain is prefiltered for reflections
+    frag_color = vec4(textureLod(s_Environment, norm, 0.0).rgb, 1.0);
 }
\ No newline at end of file
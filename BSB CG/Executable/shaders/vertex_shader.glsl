@@ -1,38 +1,69 @@
-#version 410
+#version 430
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
+// Which ObjectData to use, this steps through the draw's instances starting at its base instance (see RenderSystem)
+layout(location = 4) in uint inDrawId;
 
 layout(location = 0) out vec3 outPos;
 layout(location = 1) out vec3 outColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec2 outUV;
+// The layer to sample in shaders that use texture arrays (see MaterialMerger)
+layout(location = 4) flat out int outTextureLayer;
 
-uniform mat4 u_ModelViewProjection;
-uniform mat4 u_View;
-uniform mat4 u_Model;
-uniform mat3 u_NormalMatrix;
-uniform vec3 u_LightPos;
+// Uploaded once per frame, see RenderSystem::FrameData
+layout(std140, binding = 0) uniform FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
+
+// See RenderSystem::ObjectData
+struct ObjectData {
+	mat4  Model;
+	mat4  NormalMatrix;
+	// How to unpack the mesh's vertices (see VertexPacker). Positions are dequantized by Model
+	vec4  TexCoordTransform; // xy = scale, zw = offset
+	ivec4 Flags; // x = octahedral normals, y = texture array layer
+};
+
+layout(std430, binding = 2) readonly buffer ObjectBuffer {
+	ObjectData u_Objects[];
+};
+
+// Decodes a normal that was stored as 2 octahedral components
+vec3 OctDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
 
 
 void main() {
 
-	gl_Position = u_ModelViewProjection * vec4(inPosition, 1.0);
+	ObjectData object = u_Objects[inDrawId];
+
+	gl_Position = u_ViewProjection * object.Model * vec4(inPosition, 1.0);
 
 	// Lecture 5
 	// Pass vertex pos in world space to frag shader
-	outPos = (u_Model * vec4(inPosition, 1.0)).xyz;
+	outPos = (object.Model * vec4(inPosition, 1.0)).xyz;
 
 	// Normals
-	outNormal = u_NormalMatrix * inNormal;
+	vec3 normal = object.Flags.x != 0 ? OctDecode(inNormal.xy) : inNormal;
+	outNormal = mat3(object.NormalMatrix) * normal;
 
 	// Pass our UV coords to the fragment shader
-	outUV = inUV;
+	outUV = inUV * object.TexCoordTransform.xy + object.TexCoordTransform.zw;
+	outTextureLayer = object.Flags.y;
 
 	///////////
 	outColor = inColor;
 
 }
-
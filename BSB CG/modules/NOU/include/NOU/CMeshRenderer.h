@@ -52,6 +52,13 @@ namespace nou
 		Material* m_mat;
 		std::unique_ptr<VertexArray> m_vao;
 
+		//The uniforms we set on every draw, looked up the first time we
+		//draw with a shader program (and again if the program changes).
+		const ShaderProgram* m_program;
+		UniformHandle<glm::mat4> m_viewProjLoc;
+		UniformHandle<glm::mat4> m_modelLoc;
+		UniformHandle<glm::mat3> m_normalLoc;
+
 		//Having a default constructor makes it easier for us to inherit from
 		//this class later on (e.g., for a mesh renderer with skeletal animation).
 		//However, it does not make sense to instantiate this class on its own
@@ -12,25 +12,36 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 #include "Mesh.h"
 
 #include <string>
+#include <cstdint>
 
 //Forward declaration of objects defined by the tinyGLTF library.
 namespace tinygltf
 {
 	class Model;
+	class Node;
 	struct Primitive;
 }
 
 namespace nou::GLTF
 {
+	//A view straight into a glTF buffer - nothing is copied, so it is only
+	//valid for as long as the model it was built from.
 	struct DataGetter
 	{
 		const unsigned char* data;
 		size_t len;
 		int stride;
 		int elementSize;
+		//The glTF component type (ex: TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT),
+		//the number of components per element, and whether integer components
+		//are normalized to [0, 1] (or [-1, 1] for signed types).
+		int componentType;
+		int numComponents;
+		bool normalized;
 	};
 
 	//Loads a 3D model into the mesh object given.
+	//Every triangle primitive of every mesh in the file is added.
 	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY = true);
 	
 	void DumpErrorsAndWarnings(const std::string& filename,
@@ -38,14 +49,29 @@ namespace nou::GLTF
 							   const std::string& warn);
 
 	//Parses the file with tinyGLTF.
+	//Binary (.glb) files are detected by their header, anything else is parsed as JSON.
 	bool ParseGLTF(const std::string& filename, tinygltf::Model& gltf,
 				   std::string& err, std::string& warn);
 
 	//Takes a glTF model and extracts vertex positions, normals, and texture coordinates.
+	//Nou's Mesh has no index buffer, so the primitives are expanded into a triangle list.
 	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
 					     std::string& err, std::string& warn);
 
 	//Utility functions for more easily accessing data stored in glTF buffers.
 	int FindAccessor(const tinygltf::Primitive& geom, const std::string& name);
-	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex);
+	//Accessors without a buffer view read as zeros. If the accessor reaches past the
+	//end of its buffer, the reason is added to "warn" and the getter's data is null.
+	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex, std::string& warn);
+
+	//Reads a single index from an index accessor (8, 16 or 32 bit).
+	uint32_t ReadIndex(const DataGetter& getter, size_t i);
+	//Reads up to "count" components of an element as floats, converting
+	//normalized integers as per the glTF spec. Returns the number of components read.
+	int ReadFloats(const DataGetter& getter, size_t i, float* out, int count);
+
+	//Returns true if the primitive is a triangle list, the only mode we render.
+	bool IsTriangleList(const tinygltf::Primitive& geom);
+	//Gets the local transform of a node, from either its matrix or its TRS properties.
+	glm::mat4 GetLocalTransform(const tinygltf::Node& node);
 }
\ No newline at end of file
@@ -13,6 +13,8 @@ Utility classes for managing OpenGL shaders and shader programs.
 #include <vector>
 
 #include "glad/glad.h"
+#include "GLM/glm.hpp"
+#include "entt.hpp"
 
 namespace nou
 {
@@ -48,6 +50,17 @@ namespace nou
 		GLuint m_id;
 	};
 
+	//A uniform's location in a particular shader program, looked up once by name
+	//with ShaderProgram::GetUniform. Setting a uniform through a handle skips
+	//the name lookup entirely, and the type makes sure we set it with the right type.
+	template<typename T>
+	struct UniformHandle
+	{
+		GLint loc = -1;
+
+		bool IsValid() const { return loc != -1; }
+	};
+
 	class ShaderProgram
 	{
 		public:
@@ -64,19 +77,60 @@ namespace nou
 
 		//Utility functions for managing uniforms - variables
 		//we send to the shader that persist until we change them.
+		//Names are looked up by their hash in a table we build when linking,
+		//so we never have to ask OpenGL. String literals (or "name"_hs) are
+		//hashed at compile time, std::strings are hashed when they are passed in.
+		GLint GetUniformLoc(const entt::hashed_string& name) const;
 		GLint GetUniformLoc(const std::string& name) const;
 
+		//Looks up a uniform once, so that it can be set quickly later on.
+		template<typename T>
+		UniformHandle<T> GetUniform(const entt::hashed_string& name) const
+		{
+			return { GetUniformLoc(name) };
+		}
+
 		template<typename T>
-		void SetUniform(const std::string& name, const T& value) const;
+		void SetUniform(const entt::hashed_string& name, const T& value) const
+		{
+			SetUniform(GetUniformLoc(name), value);
+		}
 
 		template<typename T>
-		void SetUniformArray(const std::string& name, T* data, int len) const;
+		void SetUniform(const UniformHandle<T>& handle, const T& value) const
+		{
+			SetUniform(handle.loc, value);
+		}
+
+		//Sets the uniform at a location in this program (nothing happens if loc is -1).
+		void SetUniform(GLint loc, const int& value) const;
+		void SetUniform(GLint loc, const glm::mat4& value) const;
+		void SetUniform(GLint loc, const glm::mat3& value) const;
+		void SetUniform(GLint loc, const glm::vec4& value) const;
+		void SetUniform(GLint loc, const glm::vec3& value) const;
+
+		template<typename T>
+		void SetUniformArray(const entt::hashed_string& name, T* data, int len) const;
 
 		protected:
 
 		//The OpenGL ID of our shader program.
 		GLuint m_id;
 
+		//An active uniform, found by the hash of its name.
+		struct UniformInfo
+		{
+			entt::hashed_string::hash_type hash;
+			GLint loc;
+		};
+
+		//The program's active uniforms, sorted by hash.
+		std::vector<UniformInfo> m_uniforms;
+
+		//Fills in m_uniforms once the program has linked.
+		void FindUniforms();
+		GLint FindUniform(entt::hashed_string::hash_type hash) const;
+
 		//The shader program currently in use.
 		static const ShaderProgram* m_current;
 
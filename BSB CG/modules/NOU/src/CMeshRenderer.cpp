@@ -20,6 +20,7 @@ namespace nou
 		m_owner = nullptr;
 		m_mat = nullptr;
 		m_vao = nullptr;
+		m_program = nullptr;
 	}
 
 	CMeshRenderer::CMeshRenderer(Entity& owner, 
@@ -29,6 +30,7 @@ namespace nou
 		m_owner = &owner;
 		m_mat = &mat;
 		m_vao = std::make_unique<VertexArray>();
+		m_program = nullptr;
 		SetMesh(mesh);	
 	}
 
@@ -55,13 +57,22 @@ namespace nou
 		m_mat->Use();
 
 		auto& transform = m_owner->transform;
+		const ShaderProgram* program = ShaderProgram::Current();
 
 		//We are assuming the names used by uniform shader variables as a convention here.
 		//In a larger project, we would have a more elegant system for registering
 		//or even automatically detecting uniform names.
-		ShaderProgram::Current()->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
-		ShaderProgram::Current()->SetUniform("model", transform.GetGlobal());
-		ShaderProgram::Current()->SetUniform("normal", transform.GetNormal());
+		if (program != m_program)
+		{
+			m_program = program;
+			m_viewProjLoc = program->GetUniform<glm::mat4>("viewproj");
+			m_modelLoc = program->GetUniform<glm::mat4>("model");
+			m_normalLoc = program->GetUniform<glm::mat3>("normal");
+		}
+
+		program->SetUniform(m_viewProjLoc, CCamera::current->Get<CCamera>().GetVP());
+		program->SetUniform(m_modelLoc, transform.GetGlobal());
+		program->SetUniform(m_normalLoc, transform.GetNormal());
 		
 		m_vao->Draw();
 	}
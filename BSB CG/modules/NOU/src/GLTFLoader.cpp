@@ -10,6 +10,12 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 #include "NOU/GLTFLoader.h"
 
 #include <sstream>
+#include <fstream>
+#include <cstring>
+
+#include "GLM/gtc/matrix_transform.hpp"
+#include "GLM/gtc/quaternion.hpp"
+#include "GLM/gtc/type_ptr.hpp"
 
 #include "tiny_gltf.h"
 
@@ -58,8 +64,18 @@ namespace nou::GLTF
 	{
 		auto loader = std::make_unique<tinygltf::TinyGLTF>();
 
+		//Binary glTF files start with the magic "glTF", JSON files start with "{".
+		char magic[4] = {};
+		{
+			std::ifstream file(filename, std::ios::binary);
+			file.read(magic, sizeof(magic));
+		}
+		bool isBinary = memcmp(magic, "glTF", sizeof(magic)) == 0;
+
 		std::string tinygltfErr, tinygltfWarn;
-		bool result = loader->LoadASCIIFromFile(&gltf, &tinygltfErr, &tinygltfWarn, filename.c_str());
+		bool result = isBinary ?
+			loader->LoadBinaryFromFile(&gltf, &tinygltfErr, &tinygltfWarn, filename.c_str()) :
+			loader->LoadASCIIFromFile(&gltf, &tinygltfErr, &tinygltfWarn, filename.c_str());
 
 		if (!tinygltfErr.empty())
 		{
@@ -76,7 +92,7 @@ namespace nou::GLTF
 		}
 
 		if (!result)
-			printf("Failed to load .gltf: %s\n", filename.c_str());
+			printf("Failed to load %s: %s\n", isBinary ? ".glb" : ".gltf", filename.c_str());
 
 		return result;
 	}
@@ -89,168 +105,314 @@ namespace nou::GLTF
 			err = "No meshes in file.";
 			return false;
 		}
-			
-		const tinygltf::Mesh& meshData = gltf.meshes[0];
-
-		if (meshData.primitives.size() == 0)
-		{
-			err = "No geometry data associated with mesh.";
-			return false;
-		}
 
-		const tinygltf::Primitive& geom = meshData.primitives[0];
+		std::vector<glm::vec3> verts;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> uvs;
 
-		//glTF stores data per-vertex.
-		//This indexer will allow us to access the data that tells
-		//us which vertices make up the faces of the object.
-		//This allows us to specify our data in the order we need it
-		//for OpenGL vertex buffers - in other words, spelling out the vertex
-		//data as a set of triangles.
-		DataGetter faceIndexer = BuildGetter(gltf, geom.indices);
+		//If any primitive is missing normals or UVs, we leave them out of
+		//the whole mesh, since each attribute needs one entry per vertex.
+		bool hasNormals = true;
+		bool hasUVs = true;
 
-		if (faceIndexer.elementSize != sizeof(GLshort))
+		for (const tinygltf::Mesh& meshData : gltf.meshes)
 		{
-			err = "Primitive indices are in a currently unsupported format." \
-				"Consider changing your GLTF export settings, or else check for " \
-				"and support this format in your GLTF loader implementation.";
-
-			return false;
+			for (const tinygltf::Primitive& geom : meshData.primitives)
+			{
+				if (!IsTriangleList(geom))
+				{
+					warn += "\nSkipping a primitive that is not a triangle list in mesh \"" + meshData.name + "\".";
+					continue;
+				}
+
+				int vID = FindAccessor(geom, "POSITION");
+
+				if (vID == -1)
+				{
+					warn += "\nNo vertex positions found in mesh \"" + meshData.name + "\".";
+					continue;
+				}
+
+				DataGetter vGetter = BuildGetter(gltf, vID, warn);
+
+				if (vGetter.data == nullptr)
+					continue;
+
+				if (vGetter.elementSize != sizeof(glm::vec3))
+				{
+					err = "Vertex position data is in a currently unsupported format." \
+						  "Consider changing your GLTF export settings, or else check for " \
+						  "and support this format in your GLTF loader implementation.";
+
+					return false;
+				}
+
+				int nID = FindAccessor(geom, "NORMAL");
+				int uvID = FindAccessor(geom, "TEXCOORD_0");
+
+				if (nID == -1 && hasNormals)
+				{
+					hasNormals = false;
+					warn += "\nNo normals found in mesh \"" + meshData.name + "\".";
+				}
+
+				if (uvID == -1 && hasUVs)
+				{
+					hasUVs = false;
+					warn += "\nNo UVs found in mesh \"" + meshData.name + "\".";
+				}
+
+				//Primitives without indices are already a triangle list.
+				bool indexed = geom.indices != -1;
+				DataGetter faceIndexer = {};
+
+				if (indexed)
+				{
+					faceIndexer = BuildGetter(gltf, geom.indices, warn);
+
+					if (faceIndexer.data == nullptr)
+						continue;
+				}
+
+				DataGetter nGetter = {}, uvGetter = {};
+
+				if (nID != -1)
+				{
+					nGetter = BuildGetter(gltf, nID, warn);
+
+					//Broken normals are treated the same as missing ones.
+					if (nGetter.data == nullptr)
+					{
+						nID = -1;
+						hasNormals = false;
+					}
+				}
+
+				if (uvID != -1)
+				{
+					uvGetter = BuildGetter(gltf, uvID, warn);
+
+					if (uvGetter.data == nullptr)
+					{
+						uvID = -1;
+						hasUVs = false;
+					}
+				}
+
+				size_t count = indexed ? faceIndexer.len : vGetter.len;
+				size_t start = verts.size();
+
+				verts.resize(start + count);
+				normals.resize(start + count);
+				uvs.resize(start + count);
+
+				//Nou's Mesh has no index buffer, so we spell out each triangle.
+				for (size_t i = 0; i < count; ++i)
+				{
+					//What vertex do we need to look at?
+					size_t vert = indexed ? ReadIndex(faceIndexer, i) : i;
+
+					if (vert >= vGetter.len)
+					{
+						err = "Primitive index is out of range in mesh \"" + meshData.name + "\".";
+						return false;
+					}
+
+					//Grab our vertex position.
+					memcpy(&verts[start + i], &vGetter.data[vert * vGetter.stride], sizeof(glm::vec3));
+
+					//Grab our vertex normal.
+					if (nID != -1)
+						ReadFloats(nGetter, vert, glm::value_ptr(normals[start + i]), 3);
+
+					//Grab our texture coordinates.
+					if (uvID != -1)
+					{
+						ReadFloats(uvGetter, vert, glm::value_ptr(uvs[start + i]), 2);
+
+						//We may need to flip our vertical UV-coordinate.
+						//You will probably need to do this, depending on your export settings/texture.
+						if (flipUVY)
+							uvs[start + i].y = 1.0f - uvs[start + i].y;
+					}
+				}
+			}
 		}
 
-		int vID = FindAccessor(geom, "POSITION");
-
-		if (vID == -1)
+		if (verts.size() == 0)
 		{
-			err = "No vertex positions found in mesh.";
+			err = "No triangle geometry found in any mesh.";
 			return false;
 		}
 
-		int nID = FindAccessor(geom, "NORMAL");
-		bool hasNormals = nID != -1;
+		mesh.SetVerts(verts);
 
-		if (!hasNormals)
-			warn += "\nNo normals found in mesh.";
+		if(hasNormals)
+			mesh.SetNormals(normals);
 
-		int uvID = FindAccessor(geom, "TEXCOORD_0");
-		bool hasUVs = uvID != -1;
+		if(hasUVs)
+			mesh.SetUVs(uvs);
 
-		if (uvID == -1)
-			warn += "\nNo UVs found in mesh.";
+		return true;
+	}
 
-		DataGetter vGetter, nGetter, uvGetter;
+	int FindAccessor(const tinygltf::Primitive& geom, const std::string& name)
+	{
+		auto it = geom.attributes.find(name);
 
-		vGetter = BuildGetter(gltf, vID);
+		if(it == geom.attributes.end())
+			return -1;
 
-		if (vGetter.elementSize != sizeof(glm::vec3))
-		{
-			err = "Vertex position data is in a currently unsupported format." \
-				  "Consider changing your GLTF export settings, or else check for " \
-				  "and support this format in your GLTF loader implementation.";
+		return it->second;
+	}
 
-			return false;
-		}
+	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex, std::string& warn)
+	{
+		//Big enough for the largest element type, a 4x4 matrix of floats.
+		static const unsigned char zeros[64] = {};
 
-		if (hasNormals)
-		{
-			nGetter = BuildGetter(gltf, nID);
+		const tinygltf::Accessor& acc = gltf.accessors[accIndex];
+		size_t len = acc.count;
+		int numComponents = tinygltf::GetNumComponentsInType(acc.type);
+		int size = tinygltf::GetComponentSizeInBytes(acc.componentType) * numComponents;
 
-			if (nGetter.elementSize != sizeof(glm::vec3))
-			{
-				hasNormals = false;
-				warn += "\nNormal data is in a currently unsupported format." \
-				   "Consider changing your GLTF export settings, or else check for " \
-				   "and support this format in your GLTF loader implementation.";
-			}
-		}
-			
+		//The spec says an accessor without a buffer view is all zeros (unless it is
+		//sparse, which we don't support), so every element reads from the same zeros.
+		if (acc.bufferView == -1)
+			return { zeros, len, 0, size, acc.componentType, numComponents, acc.normalized };
 
-		if(hasUVs)
-		{
-			uvGetter = BuildGetter(gltf, uvID);
+		DataGetter invalid = { nullptr, 0, 0, size, acc.componentType, numComponents, acc.normalized };
 
-			if (uvGetter.elementSize != sizeof(glm::vec2))
-			{
-				hasUVs = false;
-				warn += "\nUV data is in a currently unsupported format." \
-					"Consider changing your GLTF export settings, or else check for " \
-					"and support this format in your GLTF loader implementation.";
-			}
+		if (acc.bufferView < 0 || acc.bufferView >= (int)gltf.bufferViews.size())
+		{
+			warn += "\nAccessor " + std::to_string(accIndex) + " refers to a buffer view that does not exist.";
+			return invalid;
 		}
 
-		std::vector<glm::vec3> verts;
-		verts.resize(faceIndexer.len);
-		
-		std::vector<glm::vec3> normals;
+		const tinygltf::BufferView& bv = gltf.bufferViews[acc.bufferView];
+		int stride = acc.ByteStride(bv);
 
-		if(hasNormals)
-			normals.resize(faceIndexer.len);
+		if (bv.buffer < 0 || bv.buffer >= (int)gltf.buffers.size() || stride <= 0 || size <= 0)
+		{
+			warn += "\nAccessor " + std::to_string(accIndex) + " has an invalid buffer view or element type.";
+			return invalid;
+		}
 
-		std::vector<glm::vec2> uvs;
+		const tinygltf::Buffer& buf = gltf.buffers[bv.buffer];
 
-		if(hasUVs)
-			uvs.resize(faceIndexer.len);
+		//The last element has to end inside both the buffer view and the buffer.
+		size_t end = len == 0 ? 0 : stride * (len - 1) + size;
 
-		//This is the bit where we actually get to extracting our data.
-		for (size_t i = 0; i < faceIndexer.len; ++i)
+		if (acc.byteOffset + end > bv.byteLength ||
+			bv.byteOffset + bv.byteLength > buf.data.size())
 		{
-			//What vertex do we need to look at?
-			GLshort vertIndex;
-			memcpy(&vertIndex, &faceIndexer.data[i * faceIndexer.stride], sizeof(GLshort));
-
-			size_t vert = vertIndex;
-			
-			//Grab our vertex position.
-			memcpy(&verts[i], &vGetter.data[vert * vGetter.stride], sizeof(glm::vec3));
-			
-			//Grab our vertex normal.
-			if(hasNormals)
-				memcpy(&normals[i], &nGetter.data[vert * nGetter.stride], sizeof(glm::vec3));
-
-			//Grab our texture coordinates.
-			if (hasUVs)
-			{
-				memcpy(&uvs[i], &uvGetter.data[vert * uvGetter.stride], sizeof(glm::vec2));
-				
-				//We may need to flip our vertical UV-coordinate.
-				//You will probably need to do this, depending on your export settings/texture.
-				if(flipUVY)
-					uvs[i].y = 1.0f - uvs[i].y;
-			}							
+			warn += "\nAccessor " + std::to_string(accIndex) + " reads past the end of its buffer.";
+			return invalid;
 		}
 
-		mesh.SetVerts(verts);
+		const unsigned char* data = buf.data.data() + bv.byteOffset + acc.byteOffset;
 
-		if(hasNormals)
-			mesh.SetNormals(normals);
+		return { data, len, stride, size, acc.componentType, numComponents, acc.normalized };
+	}
 
-		if(hasUVs)
-			mesh.SetUVs(uvs);
+	uint32_t ReadIndex(const DataGetter& getter, size_t i)
+	{
+		const unsigned char* element = &getter.data[i * getter.stride];
 
-		return true;
+		switch (getter.componentType)
+		{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				return *element;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				uint16_t index;
+				memcpy(&index, element, sizeof(uint16_t));
+				return index;
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+			{
+				uint32_t index;
+				memcpy(&index, element, sizeof(uint32_t));
+				return index;
+			}
+			default:
+				return 0;
+		}
 	}
 
-	int FindAccessor(const tinygltf::Primitive& geom, const std::string& name)
+	int ReadFloats(const DataGetter& getter, size_t i, float* out, int count)
 	{
-		auto it = geom.attributes.find(name);
+		const unsigned char* element = &getter.data[i * getter.stride];
+		int n = count < getter.numComponents ? count : getter.numComponents;
 
-		if(it == geom.attributes.end())
-			return -1;
+		for (int c = 0; c < n; ++c)
+		{
+			//Integer components are only meaningful as floats when normalized,
+			//otherwise we just convert the value as-is.
+			switch (getter.componentType)
+			{
+				case TINYGLTF_COMPONENT_TYPE_FLOAT:
+					memcpy(&out[c], element + c * sizeof(float), sizeof(float));
+					break;
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+					out[c] = getter.normalized ? element[c] / 255.0f : element[c];
+					break;
+				case TINYGLTF_COMPONENT_TYPE_BYTE:
+				{
+					float v = (float)(int8_t)element[c];
+					out[c] = getter.normalized ? glm::max(v / 127.0f, -1.0f) : v;
+					break;
+				}
+				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				{
+					uint16_t v;
+					memcpy(&v, element + c * sizeof(uint16_t), sizeof(uint16_t));
+					out[c] = getter.normalized ? v / 65535.0f : v;
+					break;
+				}
+				case TINYGLTF_COMPONENT_TYPE_SHORT:
+				{
+					int16_t v;
+					memcpy(&v, element + c * sizeof(int16_t), sizeof(int16_t));
+					out[c] = getter.normalized ? glm::max(v / 32767.0f, -1.0f) : v;
+					break;
+				}
+				default:
+					out[c] = 0.0f;
+					break;
+			}
+		}
 
-		return it->second;
+		return n;
 	}
 
-	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex)
+	bool IsTriangleList(const tinygltf::Primitive& geom)
 	{
-		const tinygltf::Accessor& acc = gltf.accessors[accIndex];
-		const tinygltf::BufferView& bv = gltf.bufferViews[acc.bufferView];
-		const tinygltf::Buffer& buf = gltf.buffers[bv.buffer];
+		//The mode is optional, and defaults to triangles.
+		return geom.mode == -1 || geom.mode == TINYGLTF_MODE_TRIANGLES;
+	}
 
-		const unsigned char* data = &(buf.data[bv.byteOffset + acc.byteOffset]);
-		size_t len = acc.count;
-		int stride = acc.ByteStride(bv);
-		int size = tinygltf::GetComponentSizeInBytes(acc.componentType) *
-				   tinygltf::GetNumComponentsInType(acc.type);
+	glm::mat4 GetLocalTransform(const tinygltf::Node& node)
+	{
+		if (node.matrix.size() == 16)
+		{
+			glm::dmat4 matrix = glm::make_mat4(node.matrix.data());
+			return glm::mat4(matrix);
+		}
 
-		return { data, len, stride, size };
+		glm::mat4 result = glm::mat4(1.0f);
+
+		if (node.translation.size() == 3)
+			result = glm::translate(result, glm::vec3(node.translation[0], node.translation[1], node.translation[2]));
+
+		//glTF stores rotations as (x, y, z, w), GLM's constructor takes w first.
+		if (node.rotation.size() == 4)
+			result *= glm::mat4_cast(glm::quat((float)node.rotation[3], (float)node.rotation[0],
+				(float)node.rotation[1], (float)node.rotation[2]));
+
+		if (node.scale.size() == 3)
+			result = glm::scale(result, glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
+
+		return result;
 	}
 }
\ No newline at end of file
@@ -12,6 +12,7 @@ Utility classes for managing OpenGL shaders and shader programs.
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 namespace nou
 {
@@ -148,7 +149,10 @@ namespace nou
 
 		//Provide feedback on the program's linking.
 		if (result)
+		{
 			printf("Linked shader program successfully.\n");
+			FindUniforms();
+		}
 		else
 		{
 			GLint buflen = 0;
@@ -182,44 +186,82 @@ namespace nou
 		return m_current;
 	}
 
+	void ShaderProgram::FindUniforms()
+	{
+		GLint count = 0, maxLen = 0;
+		glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+		glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxLen);
+
+		std::vector<GLchar> name(std::max(maxLen, 1));
+
+		for (GLint i = 0; i < count; ++i)
+		{
+			GLsizei len = 0;
+			glGetProgramResourceName(m_id, GL_UNIFORM, i, (GLsizei)name.size(), &len, name.data());
+
+			//Uniforms in blocks don't have a location, so we skip those.
+			GLint loc = glGetProgramResourceLocation(m_id, GL_UNIFORM, name.data());
+
+			if (loc == -1)
+				continue;
+
+			m_uniforms.push_back({ entt::hashed_string::value(name.data(), len), loc });
+
+			//Arrays show up as "name[0]", but we want to be able to find them by "name" as well.
+			if (len > 3 && std::string(name.data() + len - 3) == "[0]")
+				m_uniforms.push_back({ entt::hashed_string::value(name.data(), len - 3), loc });
+		}
+
+		std::sort(m_uniforms.begin(), m_uniforms.end(),
+			[](const UniformInfo& a, const UniformInfo& b) { return a.hash < b.hash; });
+	}
+
+	GLint ShaderProgram::FindUniform(entt::hashed_string::hash_type hash) const
+	{
+		auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), hash,
+			[](const UniformInfo& info, entt::hashed_string::hash_type h) { return info.hash < h; });
+
+		return (it != m_uniforms.end() && it->hash == hash) ? it->loc : -1;
+	}
+
+	GLint ShaderProgram::GetUniformLoc(const entt::hashed_string& name) const
+	{
+		return FindUniform(name.value());
+	}
+
 	GLint ShaderProgram::GetUniformLoc(const std::string& name) const
 	{
-		return glGetUniformLocation(m_id, name.c_str());
+		return FindUniform(entt::hashed_string::value(name.c_str(), name.length()));
 	}
 
-	template<>
-	void ShaderProgram::SetUniform<int>(const std::string& name, const int& value) const
+	void ShaderProgram::SetUniform(GLint loc, const int& value) const
 	{
-		glUniform1i(GetUniformLoc(name), value);
+		glProgramUniform1i(m_id, loc, value);
 	}
 
-	template<>
-	void ShaderProgram::SetUniform<glm::mat4>(const std::string& name, const glm::mat4& value) const
+	void ShaderProgram::SetUniform(GLint loc, const glm::mat4& value) const
 	{
-		glUniformMatrix4fv(GetUniformLoc(name), 1, GL_FALSE, &value[0][0]);
+		glProgramUniformMatrix4fv(m_id, loc, 1, GL_FALSE, &value[0][0]);
 	}
 
-	template<>
-	void ShaderProgram::SetUniform<glm::mat3>(const std::string& name, const glm::mat3& value) const
+	void ShaderProgram::SetUniform(GLint loc, const glm::mat3& value) const
 	{
-		glUniformMatrix3fv(GetUniformLoc(name), 1, GL_FALSE, &value[0][0]);
+		glProgramUniformMatrix3fv(m_id, loc, 1, GL_FALSE, &value[0][0]);
 	}
 
-	template<>
-	void ShaderProgram::SetUniform<glm::vec4>(const std::string& name, const glm::vec4& value) const
+	void ShaderProgram::SetUniform(GLint loc, const glm::vec4& value) const
 	{
-		glUniform4fv(GetUniformLoc(name), 1, &(value.x));
+		glProgramUniform4fv(m_id, loc, 1, &(value.x));
 	}
 
-	template<>
-	void ShaderProgram::SetUniform<glm::vec3>(const std::string& name, const glm::vec3& value) const
+	void ShaderProgram::SetUniform(GLint loc, const glm::vec3& value) const
 	{
-		glUniform3fv(GetUniformLoc(name), 1, &(value.x));
+		glProgramUniform3fv(m_id, loc, 1, &(value.x));
 	}
 
 	template<>
-	void ShaderProgram::SetUniformArray<glm::mat4>(const std::string& name, glm::mat4* data, int len) const
+	void ShaderProgram::SetUniformArray<glm::mat4>(const entt::hashed_string& name, glm::mat4* data, int len) const
 	{
-		glUniformMatrix4fv(GetUniformLoc(name), len, GL_FALSE, (GLfloat*)data);
+		glProgramUniformMatrix4fv(m_id, GetUniformLoc(name), len, GL_FALSE, (GLfloat*)data);
 	}
 }
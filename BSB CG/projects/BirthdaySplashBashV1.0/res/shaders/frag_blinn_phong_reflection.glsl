@@ -1,4 +1,4 @@
-#version 410
+#version 430
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inColor;
@@ -13,25 +13,41 @@ uniform sampler2D s_Specular;
 uniform sampler2D s_Reflectivity;
 uniform samplerCube s_Environment;
 uniform mat3 u_EnvironmentRotation;
+// 0 for a mirror, up to 1 for fully rough. Picks a level of the prefiltered environment
+uniform float u_EnvironmentRoughness;
+
+// Uploaded once per frame, see RenderSystem::FrameData
+layout(std140, binding = 0) uniform FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
+
+// The scene's light, shared by every shader. See RenderSystem::LightData
+layout(std140, binding = 1) uniform LightData {
+	vec3  u_LightPos;
+	float u_AmbientLightStrength;
+	vec3  u_LightCol;
+	float u_SpecularLightStrength;
+	vec3  u_AmbientCol;
+	float u_AmbientStrength;
+	// NEW in week 7, see https://learnopengl.com/Lighting/Light-casters for a good reference on how this all works, or
+	// https://developer.valvesoftware.com/wiki/Constant-Linear-Quadratic_Falloff
+	float u_LightAttenuationConstant;
+	float u_LightAttenuationLinear;
+	float u_LightAttenuationQuadratic;
+	int   u_lightoff;
+	int   u_ambient;
+	int   u_specular;
+	int   u_ambientspecular;
+	int   u_ambientspeculartoon;
+};
 
-uniform vec3  u_AmbientCol;
-uniform float u_AmbientStrength;
-
-uniform vec3  u_LightPos;
-uniform vec3  u_LightCol;
-uniform float u_AmbientLightStrength;
-uniform float u_SpecularLightStrength;
 uniform float u_Shininess;
-// NEW in week 7, see https://learnopengl.com/Lighting/Light-casters for a good reference on how this all works, or
-// https://developer.valvesoftware.com/wiki/Constant-Linear-Quadratic_Falloff
-uniform float u_LightAttenuationConstant;
-uniform float u_LightAttenuationLinear;
-uniform float u_LightAttenuationQuadratic;
-
 uniform float u_TextureMix;
 
-uniform vec3  u_CamPos;
-
 out vec4 frag_color;
 
 // https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
@@ -69,7 +85,8 @@ void main() {
 	vec4 textureColor2 = texture(s_Diffuse2, inUV);
 	vec4 textureColor = mix(textureColor1, textureColor2, u_TextureMix);
 
-	vec3 environment = texture(s_Environment, u_EnvironmentRotation * reflected).rgb;
+	float lod = u_EnvironmentRoughness * float(textureQueryLevels(s_Environment) - 1);
+	vec3 environment = textureLod(s_Environment, u_EnvironmentRotation * reflected, lod).rgb;
 
 	vec3 result = (
 		(u_AmbientCol * u_AmbientStrength) + // global ambient light
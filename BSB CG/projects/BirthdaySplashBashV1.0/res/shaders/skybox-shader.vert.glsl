@@ -1,10 +1,18 @@
-#version 410
+#version 430
 
 layout(location = 0) in vec3 inPosition;
 
 layout(location = 0) out vec3 outNormal;
 
-uniform mat4 u_SkyboxMatrix;
+// Uploaded once per frame, see RenderSystem::FrameData
+layout(std140, binding = 0) uniform FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_ViewProjection;
+	mat4 u_SkyboxMatrix;
+	vec3 u_CamPos;
+};
+
 uniform mat3 u_EnvironmentRotation;
 
 void main() {
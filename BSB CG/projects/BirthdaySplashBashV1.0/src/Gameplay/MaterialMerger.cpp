@@ -0,0 +1,93 @@
+#include "MaterialMerger.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "Logging.h"
+#include "Gameplay/RendererComponent.h"
+#include "Graphics/Texture2D.h"
+#include "Graphics/TextureArrayPacker.h"
+
+MaterialMerger::Result MaterialMerger::MergeTextureArrays(entt::registry& registry, const Shader::sptr& sourceShader, const Shader::sptr& arrayShader,
+	const std::string& textureName, const std::string& arrayName)
+{
+	Result result;
+
+	// Group the distinct materials that use the source shader by everything except the texture we're replacing
+	std::unordered_map<uint64_t, std::vector<ShaderMaterial::sptr>> groups;
+	std::vector<ShaderMaterial*> seen;
+	registry.view<RendererComponent>().each([&](RendererComponent& renderer) {
+		const ShaderMaterial::sptr& material = renderer.Material;
+		if (material == nullptr || material->Shader != sourceShader) {
+			return;
+		}
+		if (std::find(seen.begin(), seen.end(), material.get()) != seen.end()) {
+			return;
+		}
+		seen.push_back(material.get());
+		if (std::dynamic_pointer_cast<Texture2D>(material->GetTexture(textureName)) != nullptr) {
+			groups[material->HashParams(textureName)].push_back(material);
+		}
+	});
+
+	// Where each of the merged materials went
+	struct Replacement {
+		ShaderMaterial::sptr Material;
+		uint32_t             Layer;
+	};
+	std::unordered_map<ShaderMaterial*, Replacement> replacements;
+
+	for (auto& kvp : groups) {
+		const std::vector<ShaderMaterial::sptr>& materials = kvp.second;
+		if (materials.size() < 2) {
+			continue;
+		}
+
+		std::vector<Texture2D::sptr> textures;
+		textures.reserve(materials.size());
+		for (const ShaderMaterial::sptr& material : materials) {
+			textures.push_back(std::static_pointer_cast<Texture2D>(material->GetTexture(textureName)));
+		}
+		const std::vector<TextureArrayPacker::Placement> placements = TextureArrayPacker::Pack(textures);
+
+		// A group can end up in several arrays if its textures have different formats, each gets its own material
+		std::unordered_map<Texture2DArray*, ShaderMaterial::sptr> arrayMaterials;
+		for (size_t ix = 0; ix < materials.size(); ix++) {
+			const TextureArrayPacker::Placement& placement = placements[ix];
+			if (placement.Array == nullptr) {
+				continue;
+			}
+			ShaderMaterial::sptr& merged = arrayMaterials[placement.Array.get()];
+			if (merged == nullptr) {
+				merged = ShaderMaterial::Create();
+				merged->Shader = arrayShader;
+				merged->RenderLayer = materials[ix]->RenderLayer;
+				merged->DebugName = "Merged " + textureName + " array";
+				merged->CopyParams(*materials[ix], textureName);
+				merged->Set(arrayName, placement.Array);
+				result.MaterialsCreated++;
+			}
+			replacements[materials[ix].get()] = { merged, placement.Layer };
+			result.MaterialsMerged++;
+		}
+	}
+
+	// Patching lets any render systems know that the renderers' materials changed, so that they get re-sorted
+	std::vector<entt::entity> entities;
+	registry.view<RendererComponent>().each([&](entt::entity entity, RendererComponent& renderer) {
+		if (renderer.Material != nullptr && replacements.count(renderer.Material.get())) {
+			entities.push_back(entity);
+		}
+	});
+	for (entt::entity entity : entities) {
+		registry.patch<RendererComponent>(entity, [&](RendererComponent& renderer) {
+			const Replacement& replacement = replacements[renderer.Material.get()];
+			renderer.SetMaterial(replacement.Material).SetTextureLayer(replacement.Layer);
+		});
+		result.RenderersChanged++;
+	}
+
+	LOG_INFO("Merged {} materials into {} texture array materials, {} renderers changed", result.MaterialsMerged, result.MaterialsCreated, result.RenderersChanged);
+	return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <entt.hpp>
+
+#include "Graphics/Shader.h"
+#include "Gameplay/ShaderMaterial.h"
+
+/// <summary>
+/// Merges materials that only differ by one texture into a single material that samples a texture array, so that
+/// everything drawn with them shares one material state and can be batched together.
+///
+/// Materials are grouped by everything but the texture (see ShaderMaterial::HashParams), and each group's textures
+/// are packed with the TextureArrayPacker. Every array becomes one new material using the array shader, which must
+/// be a variant of the source shader that samples the named sampler2DArray at the layer in ObjectData.Flags.y (see
+/// USE_TEXTURE_ARRAY in frag_blinn_phong_textured.glsl). The renderers are then patched to use the new material and their layer
+/// </summary>
+class MaterialMerger
+{
+public:
+	/// <summary>
+	/// What a call to MergeTextureArrays did
+	/// </summary>
+	struct Result {
+		// The materials that were replaced, and the array materials that replaced them
+		size_t MaterialsMerged  = 0;
+		size_t MaterialsCreated = 0;
+		size_t RenderersChanged = 0;
+	};
+
+	/// <summary>
+	/// Merges the materials of every renderer in a registry that uses the source shader. The textures must have
+	/// finished loading, and materials whose textures can't share an array with any other are left as they are
+	/// </summary>
+	/// <param name="registry">The registry holding the renderers to merge</param>
+	/// <param name="sourceShader">The shader of the materials to merge</param>
+	/// <param name="arrayShader">The shader for the merged materials</param>
+	/// <param name="textureName">The sampler2D that differs between the materials (ex: s_Diffuse)</param>
+	/// <param name="arrayName">The sampler2DArray in the array shader that replaces it (ex: s_DiffuseArray)</param>
+	static Result MergeTextureArrays(entt::registry& registry, const Shader::sptr& sourceShader, const Shader::sptr& arrayShader,
+		const std::string& textureName, const std::string& arrayName);
+
+protected:
+	MaterialMerger() = default;
+	~MaterialMerger() = default;
+};
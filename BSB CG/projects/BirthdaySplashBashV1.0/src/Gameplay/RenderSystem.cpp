@@ -0,0 +1,405 @@
+#include "RenderSystem.h"
+
+#include <cfloat>
+#include <algorithm>
+
+/// <summary>
+/// Maps a view depth onto the depth bits of a sort key. Depth is stored logarithmically, so nearby objects keep
+/// their precision while far ones still fit
+/// </summary>
+static uint64_t QuantizeDepth(float depth) {
+	return (uint64_t)glm::min(glm::log2(1.0f + glm::max(depth, 0.0f)) * 4096.0f, 65535.0f);
+}
+
+RenderSystem::RenderSystem(entt::registry& registry) :
+	_registry(registry),
+	_items(std::vector<DrawItem>()),
+	_sortBuffer(std::vector<DrawItem>()),
+	_cullX(std::vector<float>()),
+	_cullY(std::vector<float>()),
+	_cullZ(std::vector<float>()),
+	_cullRadius(std::vector<float>()),
+	_cullResults(std::vector<Frustum::CullResult>()),
+	_visible(std::vector<uint32_t>()),
+	_batches(std::vector<DrawBatch>()),
+	_runs(std::vector<DrawRun>()),
+	_frameBuffer(UniformBuffer::Create()),
+	_objectBuffer(RingBuffer::Create(GL_SHADER_STORAGE_BUFFER)),
+	_commandBuffer(RingBuffer::Create(GL_DRAW_INDIRECT_BUFFER)),
+	_drawIds(VertexBuffer::Create(GL_STATIC_DRAW)),
+	_changed(std::vector<entt::entity>()),
+	_needsRebuild(true),
+	_stats(Stats())
+{
+	_registry.on_construct<RendererComponent>().connect<&RenderSystem::_OnRendererChanged>(*this);
+	_registry.on_update<RendererComponent>().connect<&RenderSystem::_OnRendererChanged>(*this);
+	_registry.on_destroy<RendererComponent>().connect<&RenderSystem::_OnRendererChanged>(*this);
+}
+
+RenderSystem::~RenderSystem() {
+	_registry.on_construct<RendererComponent>().disconnect(*this);
+	_registry.on_update<RendererComponent>().disconnect(*this);
+	_registry.on_destroy<RendererComponent>().disconnect(*this);
+}
+
+uint64_t RenderSystem::MakeKey(int layer, uint32_t shader, uint32_t material, uint32_t mesh, float depth) {
+	// Layers are signed, so we shift them up to keep negative layers sorting before positive ones
+	const uint64_t layerBits = (uint64_t)glm::clamp(layer + 128, 0, 255);
+
+	uint64_t result = layerBits;
+	result = (result << SHADER_BITS)   | (shader   & ((1u << SHADER_BITS) - 1));
+	result = (result << MATERIAL_BITS) | (material & ((1u << MATERIAL_BITS) - 1));
+	result = (result << MESH_BITS)     | (mesh     & ((1u << MESH_BITS) - 1));
+	result = (result << DEPTH_BITS)    | QuantizeDepth(depth);
+	return result;
+}
+
+void RenderSystem::Render(const glm::mat4& view, const glm::mat4& projection) {
+	_stats = Stats();
+	_ApplyChanges();
+	_Cull(view, projection);
+	_RefreshDepths(view, projection);
+	_BuildBatches();
+	_UploadFrameData(view, projection);
+	_UploadObjectData();
+	_BuildRuns();
+	_Draw();
+	_objectBuffer->Fence();
+	_commandBuffer->Fence();
+}
+
+bool RenderSystem::_MakeItem(entt::entity entity, DrawItem& item) const {
+	if (!_registry.valid(entity) || !_registry.has<RendererComponent, Transform>(entity)) {
+		return false;
+	}
+	const RendererComponent& renderer = _registry.get<RendererComponent>(entity);
+	if (renderer.Mesh == nullptr || renderer.Material == nullptr || renderer.Material->Shader == nullptr) {
+		return false;
+	}
+	// The depth is filled in every frame, the rest of the key only changes when the renderer does. Levels of
+	// detail share the key of the full detail mesh, so switching levels doesn't move the item
+	item.Key       = MakeKey(renderer.Material->RenderLayer, renderer.Material->Shader->GetHandle(), renderer.Material->Id, renderer.Mesh->GetHandle(), 0.0f);
+	item.Entity    = entity;
+	item.Shader    = renderer.Material->Shader.get();
+	item.Material  = renderer.Material.get();
+	item.Mesh      = renderer.Mesh.get();
+	item.Renderer  = nullptr;
+	item.Transform = nullptr;
+	item.Visible   = true;
+	return true;
+}
+
+void RenderSystem::_ApplyChanges() {
+	if (_changed.empty() && !_needsRebuild) {
+		return;
+	}
+	// The same entity can be flagged several times (ex: a renderer that was added and then patched)
+	std::sort(_changed.begin(), _changed.end());
+	_changed.erase(std::unique(_changed.begin(), _changed.end()), _changed.end());
+
+	if (_needsRebuild || _changed.size() > REBUILD_THRESHOLD) {
+		_Rebuild();
+		_changed.clear();
+		return;
+	}
+
+	// Drop the old items for every changed entity, then insert the ones that still have something to draw
+	const size_t oldCount = _items.size();
+	_items.erase(std::remove_if(_items.begin(), _items.end(), [&](const DrawItem& item) {
+		return std::binary_search(_changed.begin(), _changed.end(), item.Entity);
+	}), _items.end());
+	_stats.Removes = oldCount - _items.size();
+
+	DrawItem item;
+	for (entt::entity entity : _changed) {
+		if (_MakeItem(entity, item)) {
+			// Insert after any items with the same key, so that existing draws keep their order
+			auto it = std::upper_bound(_items.begin(), _items.end(), item.Key, [](uint64_t key, const DrawItem& other) {
+				return key < other.Key;
+			});
+			_items.insert(it, item);
+			_stats.Inserts++;
+		}
+	}
+	_changed.clear();
+}
+
+void RenderSystem::_Rebuild() {
+	_items.clear();
+	DrawItem item;
+	_registry.group<RendererComponent>(entt::get_t<Transform>()).each([&](entt::entity entity, RendererComponent&, Transform&) {
+		if (_MakeItem(entity, item)) {
+			_items.push_back(item);
+		}
+	});
+	_RadixSort();
+	_needsRebuild = false;
+	_stats.Rebuilt = true;
+}
+
+void RenderSystem::_Cull(const glm::mat4& view, const glm::mat4& projection) {
+	const size_t count = _items.size();
+	_cullX.resize(count);
+	_cullY.resize(count);
+	_cullZ.resize(count);
+	_cullRadius.resize(count);
+	_cullResults.resize(count);
+
+	// Gather the world space spheres, items without bounds get an infinite radius so they always pass
+	for (size_t ix = 0; ix < count; ix++) {
+		DrawItem& item = _items[ix];
+		item.Renderer = &_registry.get<RendererComponent>(item.Entity);
+		item.Transform = &_registry.get<Transform>(item.Entity);
+
+		const MeshBounds& bounds = item.Renderer->Mesh->GetBounds();
+		const glm::mat4& world = item.Transform->WorldTransform();
+		const glm::vec3 center = world * glm::vec4(bounds.Center, 1.0f);
+		const float scale = glm::max(glm::max(glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1]))), glm::length(glm::vec3(world[2])));
+		_cullX[ix] = center.x;
+		_cullY[ix] = center.y;
+		_cullZ[ix] = center.z;
+		_cullRadius[ix] = item.Renderer->Cull && bounds.IsValid ? bounds.Radius * scale : FLT_MAX;
+	}
+
+	const Frustum frustum(projection * view);
+	frustum.TestSpheres(_cullX.data(), _cullY.data(), _cullZ.data(), _cullRadius.data(), count, _cullResults.data());
+
+	for (size_t ix = 0; ix < count; ix++) {
+		DrawItem& item = _items[ix];
+		item.Visible = _cullResults[ix] != Frustum::CullResult::Outside;
+		// Spheres are loose around long, thin meshes (ex: the hedges), so give the ones on the edge a tighter test
+		if (_cullResults[ix] == Frustum::CullResult::Intersecting && _cullRadius[ix] != FLT_MAX) {
+			const MeshBounds& bounds = item.Renderer->Mesh->GetBounds();
+			const glm::mat4& world = item.Transform->WorldTransform();
+			const glm::vec3 center = world * glm::vec4((bounds.Min + bounds.Max) * 0.5f, 1.0f);
+			// The world space box that encloses the rotated box (Arvo 1990)
+			const glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(world[0])), glm::abs(glm::vec3(world[1])), glm::abs(glm::vec3(world[2])));
+			item.Visible = frustum.TestBox(center, absolute * bounds.GetExtents()) != Frustum::CullResult::Outside;
+		}
+		_stats.Culled += item.Visible ? 0 : 1;
+	}
+}
+
+void RenderSystem::_RefreshDepths(const glm::mat4& view, const glm::mat4& projection) {
+	// Culled items keep their old depth, they are skipped when drawing so their order doesn't matter
+	for (DrawItem& item : _items) {
+		if (!item.Visible) {
+			continue;
+		}
+		item.Mesh = item.Renderer->SelectMesh(item.Transform->WorldTransform(), view, projection).get();
+
+		const float depth = -(view * item.Transform->WorldTransform()[3]).z;
+		item.Key = (item.Key & ~DEPTH_MASK) | QuantizeDepth(depth);
+	}
+
+	// Only the depths have changed, so the list is almost always still sorted or very close to it. An insertion
+	// sort handles that in a single pass, but if the camera jumped and the order changed a lot we give up and
+	// radix sort everything instead
+	const size_t maxMoves = _items.size() * 4;
+	for (size_t ix = 1; ix < _items.size(); ix++) {
+		if (_items[ix - 1].Key <= _items[ix].Key) {
+			continue;
+		}
+		DrawItem item = _items[ix];
+		size_t jx = ix;
+		while (jx > 0 && _items[jx - 1].Key > item.Key) {
+			_items[jx] = _items[jx - 1];
+			jx--;
+		}
+		_items[jx] = item;
+		_stats.SortMoves += ix - jx;
+		if (_stats.SortMoves > maxMoves) {
+			_RadixSort();
+			break;
+		}
+	}
+}
+
+void RenderSystem::_RadixSort() {
+	// LSD radix sort, one byte at a time. Most bytes are the same for every item (ex: the layer), so we check
+	// each byte's histogram and skip the passes that wouldn't move anything
+	_sortBuffer.resize(_items.size());
+	DrawItem* source = _items.data();
+	DrawItem* dest   = _sortBuffer.data();
+	const size_t count = _items.size();
+
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		size_t offsets[256] = { 0 };
+		for (size_t ix = 0; ix < count; ix++) {
+			offsets[(source[ix].Key >> shift) & 0xFF]++;
+		}
+		if (count == 0 || offsets[(source[0].Key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		size_t total = 0;
+		for (size_t& offset : offsets) {
+			const size_t bucket = offset;
+			offset = total;
+			total += bucket;
+		}
+		for (size_t ix = 0; ix < count; ix++) {
+			dest[offsets[(source[ix].Key >> shift) & 0xFF]++] = source[ix];
+		}
+		std::swap(source, dest);
+	}
+
+	// After an odd number of passes the sorted items are in the scratch buffer
+	if (source != _items.data()) {
+		_items.swap(_sortBuffer);
+	}
+}
+
+void RenderSystem::_BuildBatches() {
+	_visible.clear();
+	_batches.clear();
+	for (uint32_t ix = 0; ix < (uint32_t)_items.size(); ix++) {
+		if (_items[ix].Visible) {
+			_visible.push_back(ix);
+		}
+	}
+
+	// Items with the same mesh and material are next to each other after sorting, unless they picked different
+	// levels of detail, so we only need to look at runs of neighbours
+	size_t first = 0;
+	while (first < _visible.size()) {
+		const DrawItem& head = _items[_visible[first]];
+		size_t count = 1;
+		while (first + count < _visible.size()) {
+			const DrawItem& next = _items[_visible[first + count]];
+			if (next.Mesh != head.Mesh || next.Material != head.Material) {
+				break;
+			}
+			count++;
+		}
+		_batches.push_back({ first, count });
+		first += count;
+	}
+}
+
+void RenderSystem::_UploadFrameData(const glm::mat4& view, const glm::mat4& projection) {
+	FrameData data;
+	data.View           = view;
+	data.Projection     = projection;
+	data.ViewProjection = projection * view;
+	data.SkyboxMatrix   = projection * glm::mat4(glm::mat3(view));
+	data.CamPos         = glm::inverse(view) * glm::vec4(0, 0, 0, 1);
+	_frameBuffer->SetData(data);
+	_frameBuffer->Bind(FRAME_DATA_BINDING);
+}
+
+void RenderSystem::_UploadObjectData() {
+	if (_visible.empty()) {
+		return;
+	}
+
+	// The draw ids never change, so we only upload them when there are more items than ever before
+	if ((size_t)_drawIds->GetElementCount() < _visible.size()) {
+		std::vector<uint32_t> ids(std::max(_visible.size() * 2, (size_t)256));
+		for (uint32_t ix = 0; ix < (uint32_t)ids.size(); ix++) {
+			ids[ix] = ix;
+		}
+		_drawIds->LoadData(ids.data(), ids.size());
+	}
+
+	// The visible items are already in draw order, so each batch's objects end up next to each other
+	ObjectData* objects = _objectBuffer->Map<ObjectData>(_visible.size());
+	for (size_t ix = 0; ix < _visible.size(); ix++) {
+		const DrawItem& item = _items[_visible[ix]];
+		// Packed meshes store their positions relative to their bounds, so we fold the dequantization into the
+		// model matrix. Normals are stored in model space, so the normal matrix stays the same
+		const VertexDecodeInfo& decode = item.Mesh->GetDecodeInfo();
+		ObjectData& object = objects[ix];
+		object.Model             = item.Transform->WorldTransform() * decode.PositionDequantize;
+		object.NormalMatrix      = glm::mat4(item.Transform->WorldNormalMatrix());
+		object.TexCoordTransform = decode.TexCoordTransform;
+		object.Flags             = glm::ivec4(decode.OctNormals ? 1 : 0, (int)item.Renderer->TextureLayer, 0, 0);
+	}
+	_objectBuffer->Bind(OBJECT_DATA_BINDING, _visible.size() * sizeof(ObjectData));
+}
+
+void RenderSystem::_BuildRuns() {
+	_runs.clear();
+
+	// Pooled meshes that share a material end up next to each other after sorting, as long as they're in the same pool
+	size_t commandCount = 0;
+	size_t first = 0;
+	while (first < _batches.size()) {
+		const DrawItem& head = _items[_visible[_batches[first].First]];
+		size_t count = 1;
+		if (head.Mesh->IsPooled()) {
+			while (first + count < _batches.size()) {
+				const DrawItem& next = _items[_visible[_batches[first + count].First]];
+				if (next.Material != head.Material || next.Shader != head.Shader || !head.Mesh->CanMultiDrawWith(*next.Mesh)) {
+					break;
+				}
+				count++;
+			}
+		}
+		_runs.push_back({ first, count, commandCount });
+		if (count > 1) {
+			commandCount += count;
+		}
+		first += count;
+	}
+
+	if (commandCount == 0) {
+		return;
+	}
+	GeometryPool::DrawCommand* commands = _commandBuffer->Map<GeometryPool::DrawCommand>(commandCount);
+	for (const DrawRun& run : _runs) {
+		if (run.BatchCount < 2) {
+			continue;
+		}
+		for (size_t ix = 0; ix < run.BatchCount; ix++) {
+			const DrawBatch& batch = _batches[run.FirstBatch + ix];
+			const VertexArrayObject* mesh = _items[_visible[batch.First]].Mesh;
+			GeometryPool::DrawCommand& command = commands[run.FirstCommand + ix];
+			command.Count         = mesh->GetPoolIndices()->GetCount();
+			command.InstanceCount = (GLuint)batch.Count;
+			command.FirstIndex    = mesh->GetPoolIndices()->GetFirst();
+			command.BaseVertex    = (GLint)mesh->GetPoolVertices()->GetFirst();
+			command.BaseInstance  = (GLuint)batch.First;
+		}
+	}
+	_commandBuffer->Bind();
+}
+
+void RenderSystem::_Draw() {
+	Shader* currentShader = nullptr;
+	ShaderMaterial* currentMaterial = nullptr;
+
+	for (const DrawRun& run : _runs) {
+		const DrawBatch& batch = _batches[run.FirstBatch];
+		const DrawItem& item = _items[_visible[batch.First]];
+		// The per frame uniforms live in the frame buffer, so switching shaders is just a bind
+		if (item.Shader != currentShader) {
+			currentShader = item.Shader;
+			currentShader->Bind();
+			_stats.ShaderSwitches++;
+		}
+		// If the material has changed, apply it
+		if (item.Material != currentMaterial) {
+			currentMaterial = item.Material;
+			currentMaterial->Apply();
+			_stats.MaterialSwitches++;
+		}
+
+		if (run.BatchCount > 1) {
+			const GeometryPool::sptr& pool = item.Mesh->GetPool();
+			pool->AttachDrawIds(_drawIds);
+			// The constant color isn't part of the commands, but every mesh in the run has the same one
+			item.Mesh->ApplyConstantColor();
+			pool->MultiDraw(_commandBuffer->GetOffset() + run.FirstCommand * sizeof(GeometryPool::DrawCommand), (GLsizei)run.BatchCount);
+			_stats.MultiDrawn += run.BatchCount;
+		} else {
+			item.Mesh->RenderInstanced(_drawIds, (GLuint)batch.First, (GLsizei)batch.Count);
+		}
+		_stats.Draws++;
+		for (size_t ix = run.FirstBatch; ix < run.FirstBatch + run.BatchCount; ix++) {
+			if (_batches[ix].Count > 1) {
+				_stats.Instanced += _batches[ix].Count;
+			}
+		}
+	}
+}
@@ -0,0 +1,249 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <entt.hpp>
+#include <GLM/glm.hpp>
+
+#include "Graphics/Shader.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/RingBuffer.h"
+#include "Graphics/GeometryPool.h"
+#include "Gameplay/ShaderMaterial.h"
+#include "Gameplay/Transform.h"
+#include "Gameplay/RendererComponent.h"
+#include "Utilities/Macros.h"
+#include "Utilities/Frustum.h"
+
+/// <summary>
+/// Draws every RendererComponent in a scene's registry.
+///
+/// The renderers are kept in a flat array of draw items, each holding a 64 bit sort key and raw pointers to what
+/// it needs to draw. The key packs (from most to least significant) the render layer, the shader, the material,
+/// the mesh and the view depth, so sorting on the keys groups draws to minimize shader and material switches, and
+/// draws that share all of those go front to back to help early depth testing.
+///
+/// The array is kept sorted between frames. Renderers that are added, replaced, patched or removed are picked up
+/// through the registry's signals and inserted or removed in place at the start of the next Render, and only a
+/// large batch of changes rebuilds and radix sorts the whole array. Since the renderer's setters don't go through
+/// the registry, changing the mesh or material of a renderer that has already been drawn must be done with
+/// registry.patch (or MarkDirty) for the change to be seen. Depths are refreshed every frame and fixed up with an
+/// insertion sort, which is linear when the camera and objects haven't moved much.
+///
+/// Before that, every item's bounding sphere is moved into world space and tested against the camera's frustum
+/// in SIMD batches. Spheres that straddle a plane get a second test with the mesh's box, and items that fail
+/// either test skip the level of detail, depth and draw work for the frame.
+///
+/// Shaders don't get any per frame or per object uniforms set on them. The camera is uploaded once per frame to
+/// a FrameData uniform buffer, and every visible item's transforms are written to an ObjectData array in a ring
+/// buffered storage buffer. Draws are issued with a base instance, which the VAO's draw id attribute turns into
+/// the index of the item's ObjectData (see VertexArrayObject::RenderInstanced and vertex_shader.glsl), so a draw
+/// only costs the draw call itself. Runs of visible items that share a mesh and material have consecutive
+/// ObjectData, and are drawn together with a single instanced draw.
+///
+/// Meshes baked into a GeometryPool share their VAO with every other mesh of the same format, so neighbouring
+/// batches that share a material and pool are gathered into one glMultiDrawElementsIndirect call. Their commands
+/// are written to a ring buffered indirect buffer, and each command's base instance is its batch's first ObjectData,
+/// so the shaders can't tell the difference.
+///
+/// Shaders drawn by a render system must declare the blocks from vertex_shader.glsl with the bindings below
+/// </summary>
+class RenderSystem final
+{
+	SMART_MEMORY_MANAGED(RenderSystem)
+public:
+	/// <summary>
+	/// The per frame uniforms, matching the std140 FrameData block in the shaders
+	/// </summary>
+	struct FrameData {
+		glm::mat4 View;
+		glm::mat4 Projection;
+		glm::mat4 ViewProjection;
+		// The view projection without the camera's translation, for the skybox
+		glm::mat4 SkyboxMatrix;
+		// xyz = the camera's position in world space
+		glm::vec4 CamPos;
+	};
+	/// <summary>
+	/// The scene's light, matching the std140 LightData block in the shaders. This is owned by the application,
+	/// which binds it to LIGHT_DATA_BINDING
+	/// </summary>
+	struct LightData {
+		glm::vec3 LightPos;
+		float     AmbientLightStrength;
+		glm::vec3 LightCol;
+		float     SpecularLightStrength;
+		glm::vec3 AmbientCol;
+		float     AmbientStrength;
+		float     AttenuationConstant;
+		float     AttenuationLinear;
+		float     AttenuationQuadratic;
+		// Toggles for the lighting debug modes, see frag_blinn_phong_textured.glsl
+		int       LightOff;
+		int       Ambient;
+		int       Specular;
+		int       AmbientSpecular;
+		int       AmbientSpecularToon;
+	};
+	/// <summary>
+	/// The per object data, matching the std430 ObjectData struct in the shaders
+	/// </summary>
+	struct ObjectData {
+		// The world transform with the mesh's position dequantization folded in
+		glm::mat4 Model;
+		// Stored as a mat4 since a mat3's columns are padded to vec4s in the shader anyways, only the upper 3x3 is used
+		glm::mat4 NormalMatrix;
+		// How to unpack the mesh's vertices (see VertexDecodeInfo)
+		glm::vec4 TexCoordTransform;
+		// x = 1 if the normals are octahedral encoded, y = the renderer's texture array layer
+		glm::ivec4 Flags;
+	};
+
+	// The indexed bindings that the blocks above are bound to
+	static constexpr GLuint FRAME_DATA_BINDING  = 0;
+	static constexpr GLuint LIGHT_DATA_BINDING  = 1;
+	static constexpr GLuint OBJECT_DATA_BINDING = 2;
+
+	/// <summary>
+	/// Counters for the last call to Render
+	/// </summary>
+	struct Stats {
+		// Draw calls issued, and how many of the items were drawn together with others in an instanced draw
+		size_t Draws            = 0;
+		size_t Instanced        = 0;
+		// Batches that were drawn as part of a multi draw, each multi draw only counts once in Draws
+		size_t MultiDrawn       = 0;
+		size_t Culled           = 0;
+		size_t ShaderSwitches   = 0;
+		size_t MaterialSwitches = 0;
+		// Items that were inserted or removed in place
+		size_t Inserts          = 0;
+		size_t Removes          = 0;
+		// Whether the list was rebuilt from scratch, and how many items the depth fix up had to move
+		bool   Rebuilt          = false;
+		size_t SortMoves        = 0;
+	};
+
+	/// <summary>
+	/// Batches with more changed renderers than this rebuild the list instead of inserting each one
+	/// </summary>
+	static constexpr size_t REBUILD_THRESHOLD = 32;
+
+	/// <summary>
+	/// Creates a render system for the given registry, which must outlive it
+	/// </summary>
+	RenderSystem(entt::registry& registry);
+	~RenderSystem();
+
+	/// <summary>
+	/// Sorts and draws all renderers in the registry. The world matrices must have been updated for this frame
+	/// </summary>
+	/// <param name="view">The camera's view matrix</param>
+	/// <param name="projection">The camera's projection matrix</param>
+	void Render(const glm::mat4& view, const glm::mat4& projection);
+
+	const Stats& GetStats() const { return _stats; }
+
+	/// <summary>
+	/// Flags an entity's renderer to be re-sorted before the next frame, for when its mesh or material has
+	/// been changed without going through the registry
+	/// </summary>
+	void MarkDirty(entt::entity entity) { _changed.push_back(entity); }
+
+	/// <summary>
+	/// Packs the parts of a draw into a sort key, see the layout below. Ids that don't fit into their field wrap
+	/// around, which only costs a few extra state changes since drawing compares the actual objects
+	/// </summary>
+	/// <param name="layer">The material's render layer, clamped to [-128, 127]</param>
+	/// <param name="shader">The shader's id</param>
+	/// <param name="material">The material's id</param>
+	/// <param name="mesh">The mesh's id</param>
+	/// <param name="depth">The distance from the camera along the view direction</param>
+	static uint64_t MakeKey(int layer, uint32_t shader, uint32_t material, uint32_t mesh, float depth);
+
+	// Key layout, from the most significant bit down
+	static constexpr uint32_t LAYER_BITS    = 8;
+	static constexpr uint32_t SHADER_BITS   = 12;
+	static constexpr uint32_t MATERIAL_BITS = 16;
+	static constexpr uint32_t MESH_BITS     = 12;
+	static constexpr uint32_t DEPTH_BITS    = 16;
+	static constexpr uint64_t DEPTH_MASK    = (1ull << DEPTH_BITS) - 1;
+
+protected:
+	struct DrawItem {
+		uint64_t           Key;
+		entt::entity       Entity;
+		Shader*            Shader;
+		ShaderMaterial*    Material;
+		// Refreshed every frame, since the level of detail may change and components may move in memory
+		VertexArrayObject* Mesh;
+		RendererComponent* Renderer;
+		const Transform*   Transform;
+		bool               Visible;
+	};
+
+	/// <summary>
+	/// A run of visible items drawn together with one draw call
+	/// </summary>
+	struct DrawBatch {
+		// A range in _visible, which is also the range of the batch's ObjectData
+		size_t First;
+		size_t Count;
+	};
+
+	/// <summary>
+	/// A run of batches drawn with one call, either a single batch or a multi draw of pooled meshes
+	/// </summary>
+	struct DrawRun {
+		// A range in _batches
+		size_t FirstBatch;
+		size_t BatchCount;
+		// Where the run's commands start in this frame's region of the command buffer, for multi draws
+		size_t FirstCommand;
+	};
+
+	entt::registry&           _registry;
+	std::vector<DrawItem>     _items;
+	// Scratch space for the radix sort, kept around so that we don't allocate every frame
+	std::vector<DrawItem>     _sortBuffer;
+	// The world space bounding spheres of the items as separate arrays, for the batched frustum test
+	std::vector<float>                _cullX;
+	std::vector<float>                _cullY;
+	std::vector<float>                _cullZ;
+	std::vector<float>                _cullRadius;
+	std::vector<Frustum::CullResult>  _cullResults;
+	// The indices of the visible items, and the batches they are drawn in
+	std::vector<uint32_t>             _visible;
+	std::vector<DrawBatch>            _batches;
+	std::vector<DrawRun>              _runs;
+	UniformBuffer::sptr               _frameBuffer;
+	RingBuffer::sptr                  _objectBuffer;
+	// The indirect commands of this frame's multi draws
+	RingBuffer::sptr                  _commandBuffer;
+	// Holds 0, 1, 2... for the VAOs' draw id attribute, grown to fit the largest number of visible items
+	VertexBuffer::sptr                _drawIds;
+	// Entities whose renderers have been added, changed or removed since the last frame
+	std::vector<entt::entity> _changed;
+	bool                      _needsRebuild;
+	Stats                     _stats;
+
+	void _OnRendererChanged(entt::registry&, entt::entity entity) { _changed.push_back(entity); }
+
+	/// <summary>
+	/// Fills in an item for the entity, returns false if it has nothing to draw
+	/// </summary>
+	bool _MakeItem(entt::entity entity, DrawItem& item) const;
+	void _ApplyChanges();
+	void _Rebuild();
+	void _Cull(const glm::mat4& view, const glm::mat4& projection);
+	void _RefreshDepths(const glm::mat4& view, const glm::mat4& projection);
+	void _RadixSort();
+	void _BuildBatches();
+	/// <summary>
+	/// Gathers the batches into runs, and writes the commands for the multi draws
+	/// </summary>
+	void _BuildRuns();
+	void _UploadFrameData(const glm::mat4& view, const glm::mat4& projection);
+	void _UploadObjectData();
+	void _Draw();
+};
@@ -1,12 +1,34 @@
 #pragma once
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshLodChain.h"
 #include "Gameplay/ShaderMaterial.h"
 
 class RendererComponent {
 public:
 	VertexArrayObject::sptr Mesh;
 	ShaderMaterial::sptr    Material;
+	// Optional levels of detail for Mesh, and the level that was drawn last frame
+	MeshLodChain::sptr      Lods;
+	size_t                  CurrentLod = 0;
+	// False for objects that should be drawn even when their bounds are off screen (ex: the skybox)
+	bool                    Cull = true;
+	// The layer to sample when the material's textures are arrays (see MaterialMerger), passed to the shader per draw
+	uint32_t                TextureLayer = 0;
 
-	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = mesh; return *this; }
+	RendererComponent& SetMesh(const VertexArrayObject::sptr& mesh) { Mesh = mesh; Lods = nullptr; CurrentLod = 0; return *this; }
+	RendererComponent& SetLods(const MeshLodChain::sptr& lods) { Lods = lods; CurrentLod = 0; Mesh = lods->GetMesh(0); return *this; }
 	RendererComponent& SetMaterial(const ShaderMaterial::sptr& material) { Material = material; return *this; }
-};
\ No newline at end of file
+	RendererComponent& SetCulling(bool cull) { Cull = cull; return *this; }
+	RendererComponent& SetTextureLayer(uint32_t layer) { TextureLayer = layer; return *this; }
+
+	/// <summary>
+	/// Picks the mesh to draw this frame, choosing a level of detail by screen size if the renderer has any
+	/// </summary>
+	const VertexArrayObject::sptr& SelectMesh(const glm::mat4& world, const glm::mat4& view, const glm::mat4& projection) {
+		if (Lods == nullptr || Lods->GetLevelCount() <= 1) {
+			return Mesh;
+		}
+		CurrentLod = Lods->SelectLevel(Lods->GetScreenSize(world, view, projection), CurrentLod);
+		return Lods->GetMesh(CurrentLod);
+	}
+};
@@ -1,21 +1,15 @@
 #include "ShaderMaterial.h"
+#include "Graphics/GLStateCache.h"
+#include "Utilities/Hash.h"
 
-template<typename T>
-void SubmitUniforms(const Shader::sptr& shader, const std::unordered_map<ShaderParamName, T>& values) {
-	for (auto& kvp : values) {
-		shader->SetUniform(kvp.first.Location, kvp.second);
-	}
-}
+#include <algorithm>
+#include <cstring>
 
-template<typename T>
-void SubmitUniformsMat(const Shader::sptr& shader, const std::unordered_map<ShaderParamName, T>& values) {
-	for (auto& kvp : values) {
-		shader->SetUniformMatrix(kvp.first.Location, kvp.second);
-	}
-}
+uint32_t ShaderMaterial::_nextId = 0;
+uint64_t ShaderMaterial::_nextStamp = 0;
 
 ShaderMaterial::ShaderMaterial()
-	: Shader(nullptr),  RenderLayer(0)
+	: Shader(nullptr),  RenderLayer(0), Id(_nextId++), _isDirty(true), _stamp(0), _compiledShader(nullptr)
 {
 }
 
@@ -25,68 +19,188 @@ ShaderMaterial::~ShaderMaterial() {
 
 void ShaderMaterial::Apply()
 {	
-	int slot = 1;
-	for (auto& kvp : Textures) {
-		if (kvp.first.Location != -1 && kvp.second != nullptr) {
-			Shader->SetUniform(kvp.first.Location, slot);
-			kvp.second->Bind(slot);
+	LOG_ASSERT(Shader != nullptr, "Must set Material shader before applying it");
+	if (_isDirty || _compiledShader != Shader.get()) {
+		_Compile();
+	}
+
+	// Textures are recreated when they're resized, so we grab the current handles instead of keeping them around
+	for (size_t ix = 0; ix < _boundTextures.size(); ix++) {
+		_textureHandles[ix] = _boundTextures[ix]->GetHandle();
+	}
+	GLStateCache::BindTextures(TEXTURE_SLOT_START, (GLsizei)_textureHandles.size(), _textureHandles.data());
+
+	// The shader still has our values from last time, nothing to upload
+	if (Shader->GetMaterialStamp() == _stamp) {
+		return;
+	}
+	Shader->SetMaterialStamp(_stamp);
+
+	for (const CompiledParam& param : _params) {
+		const uint8_t* value = _paramData.data() + param.Offset;
+		switch (param.Type) {
+			case GL_INT:
+				Shader->SetUniform(param.Location, reinterpret_cast<const int*>(value));
+				break;
+			case GL_FLOAT:
+				Shader->SetUniform(param.Location, reinterpret_cast<const float*>(value));
+				break;
+			case GL_FLOAT_VEC2:
+				Shader->SetUniform(param.Location, reinterpret_cast<const glm::vec2*>(value));
+				break;
+			case GL_FLOAT_VEC3:
+				Shader->SetUniform(param.Location, reinterpret_cast<const glm::vec3*>(value));
+				break;
+			case GL_FLOAT_VEC4:
+				Shader->SetUniform(param.Location, reinterpret_cast<const glm::vec4*>(value));
+				break;
+			case GL_FLOAT_MAT3:
+				Shader->SetUniformMatrix(param.Location, reinterpret_cast<const glm::mat3*>(value));
+				break;
+			case GL_FLOAT_MAT4:
+				Shader->SetUniformMatrix(param.Location, reinterpret_cast<const glm::mat4*>(value));
+				break;
+			default:
+				LOG_ASSERT(false, "Unknown material parameter type: {}", param.Type);
+				break;
+		}
+	}
+}
+
+void ShaderMaterial::_Compile()
+{
+	_params.clear();
+	_paramData.clear();
+	_boundTextures.clear();
+
+	// Each texture gets the next unit, and its sampler uniform is just an int in the block
+	int slot = TEXTURE_SLOT_START;
+	for (auto& kvp : _textures) {
+		const int location = kvp.second != nullptr ? Shader->GetUniformLocation(kvp.first.Name) : -1;
+		if (location != -1) {
+			_boundTextures.push_back(kvp.second);
+			_AddParam(location, GL_INT, &slot, sizeof(int));
 			slot++;
 		}
 	}
+	_textureHandles.resize(_boundTextures.size());
+
+	_AddParams(_floatParams, GL_FLOAT);
+	_AddParams(_vec2Params, GL_FLOAT_VEC2);
+	_AddParams(_vec3Params, GL_FLOAT_VEC3);
+	_AddParams(_vec4Params, GL_FLOAT_VEC4);
+	_AddParams(_mat3Params, GL_FLOAT_MAT3);
+	_AddParams(_mat4Params, GL_FLOAT_MAT4);
 
-	SubmitUniforms(Shader, FloatParams);
-	SubmitUniforms(Shader, Vec2Params);
-	SubmitUniforms(Shader, Vec3Params);
-	SubmitUniforms(Shader, Vec4Params);
-	SubmitUniformsMat(Shader, Mat4Params);
-	SubmitUniformsMat(Shader, Mat3Params);
+	std::sort(_params.begin(), _params.end(), [](const CompiledParam& a, const CompiledParam& b) {
+		return a.Location < b.Location;
+	});
+
+	_stamp = ++_nextStamp;
+	_isDirty = false;
+	_compiledShader = Shader.get();
+}
+
+void ShaderMaterial::_AddParam(int location, GLenum type, const void* value, size_t size)
+{
+	if (location == -1) {
+		return;
+	}
+	CompiledParam param;
+	param.Location = location;
+	param.Type = type;
+	param.Offset = (uint32_t)_paramData.size();
+	_params.push_back(param);
+	_paramData.resize(_paramData.size() + size);
+	memcpy(_paramData.data() + param.Offset, value, size);
 }
 
 void ShaderMaterial::Set(const std::string& name, const ITexture::sptr& texture) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
-	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	Textures[pName] = texture;
+	_textures[ShaderParamName(name)] = texture;
+	_isDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, float value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
-	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	FloatParams[pName] = value;
+	_floatParams[ShaderParamName(name)] = value;
+	_isDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec2& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
-	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	Vec2Params[pName] = value;
+	_vec2Params[ShaderParamName(name)] = value;
+	_isDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec3& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
-	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	Vec3Params[pName] = value;
+	_vec3Params[ShaderParamName(name)] = value;
+	_isDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::vec4& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
-	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	Vec4Params[pName] = value;
+	_vec4Params[ShaderParamName(name)] = value;
+	_isDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::mat4& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
-	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	Mat4Params[pName] = value;
+	_mat4Params[ShaderParamName(name)] = value;
+	_isDirty = true;
 }
 
 void ShaderMaterial::Set(const std::string& name, const glm::mat3& value) {
-	LOG_ASSERT(Shader != nullptr, "Must set Material shader before setting params");
-	ShaderParamName pName = name;
-	pName.Location = Shader->GetUniformLocation(name);
-	Mat3Params[pName] = value;
+	_mat3Params[ShaderParamName(name)] = value;
+	_isDirty = true;
+}
+
+ITexture::sptr ShaderMaterial::GetTexture(const std::string& name) const {
+	auto it = _textures.find(ShaderParamName(name));
+	return it != _textures.end() ? it->second : nullptr;
+}
+
+template<typename T>
+uint64_t HashParamMap(const std::unordered_map<ShaderParamName, T>& values, const std::string& except) {
+	// The maps don't have a fixed order, so the entries are combined with a sum, which doesn't depend on it
+	uint64_t result = 0;
+	for (auto& kvp : values) {
+		if (kvp.first.Name != except) {
+			result += Hash::Fnv1a(&kvp.second, sizeof(T), Hash::Fnv1aString(kvp.first.Name.c_str()));
+		}
+	}
+	return result;
+}
+
+uint64_t ShaderMaterial::HashParams(const std::string& except) const {
+	const ::Shader* shader = Shader.get();
+	uint64_t result = Hash::Fnv1a(&shader, sizeof(shader));
+	result = Hash::Fnv1a(&RenderLayer, sizeof(RenderLayer), result);
+	// Textures are compared by object, since their handles change when they get resized
+	std::unordered_map<ShaderParamName, const ITexture*> textures;
+	for (auto& kvp : _textures) {
+		textures[kvp.first] = kvp.second.get();
+	}
+	result += HashParamMap(textures, except);
+	result += HashParamMap(_floatParams, except);
+	result += HashParamMap(_vec2Params, except);
+	result += HashParamMap(_vec3Params, except);
+	result += HashParamMap(_vec4Params, except);
+	result += HashParamMap(_mat3Params, except);
+	result += HashParamMap(_mat4Params, except);
+	return result;
+}
+
+template<typename T>
+void CopyParamMap(ShaderMaterial& target, const std::unordered_map<ShaderParamName, T>& values, const std::string& except) {
+	for (auto& kvp : values) {
+		if (kvp.first.Name != except) {
+			target.Set(kvp.first.Name, kvp.second);
+		}
+	}
+}
+
+void ShaderMaterial::CopyParams(const ShaderMaterial& other, const std::string& except) {
+	CopyParamMap(*this, other._textures, except);
+	CopyParamMap(*this, other._floatParams, except);
+	CopyParamMap(*this, other._vec2Params, except);
+	CopyParamMap(*this, other._vec3Params, except);
+	CopyParamMap(*this, other._vec4Params, except);
+	CopyParamMap(*this, other._mat3Params, except);
+	CopyParamMap(*this, other._mat4Params, except);
 }
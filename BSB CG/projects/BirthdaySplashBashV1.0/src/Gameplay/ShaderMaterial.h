@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "Graphics/Shader.h"
 #include "Graphics/ITexture.h"
 #include "Utilities/Macros.h"
@@ -7,10 +9,9 @@
 
 struct ShaderParamName {
 	std::string Name;
-	int         Location;
 
 	ShaderParamName(const std::string& name) :
-		Name(name), Location(-1) {}
+		Name(name) {}
 
 	bool operator ==(const ShaderParamName& r) const {
 		return Name == r.Name;
@@ -38,19 +39,24 @@ public:
 	virtual ~ShaderMaterial();
 
 	Shader::sptr Shader;
-	std::unordered_map<ShaderParamName, ITexture::sptr> Textures;
-	std::unordered_map<ShaderParamName, float> FloatParams;
-	std::unordered_map<ShaderParamName, glm::vec2> Vec2Params;
-	std::unordered_map<ShaderParamName, glm::vec3> Vec3Params;
-	std::unordered_map<ShaderParamName, glm::vec4> Vec4Params;
-	std::unordered_map<ShaderParamName, glm::mat4> Mat4Params;
-	std::unordered_map<ShaderParamName, glm::mat3> Mat3Params;
 
 	int RenderLayer;
 	std::string DebugName;
+	// A small number that is unique to this material, used to group draws by material when sorting
+	const uint32_t Id;
 
+	/// <summary>
+	/// Uploads this material's parameters to its shader and binds its textures. The parameters are compiled into a
+	/// flat block the first time this is called after a change, and are only uploaded if another material (or a
+	/// change to this one) has been applied to the shader since. Textures are bound in one glBindTextures call
+	/// </summary>
 	void Apply();
 
+	/// <summary>
+	/// Sets a parameter by name. The uniform locations aren't looked up until the material is first applied, so
+	/// materials can be set up while their shader is still compiling
+	/// </summary>
+
 	void Set(const std::string& name, const ITexture::sptr& texture);
 	void Set(const std::string& name, float value);
 	void Set(const std::string& name, const glm::vec2& value);
@@ -59,5 +65,75 @@ public:
 	void Set(const std::string& name, const glm::mat4& value);
 	void Set(const std::string& name, const glm::mat3& value);
 
+	/// <summary>
+	/// Gets the texture set with the given name, or nullptr if there isn't one
+	/// </summary>
+	ITexture::sptr GetTexture(const std::string& name) const;
+	/// <summary>
+	/// Hashes the shader, render layer and every parameter except the one with the given name. Two materials with
+	/// the same hash only differ by that parameter (barring collisions), and could be merged
+	/// </summary>
+	uint64_t HashParams(const std::string& except = "") const;
+	/// <summary>
+	/// Sets every parameter of another material on this one, except the one with the given name
+	/// </summary>
+	void CopyParams(const ShaderMaterial& other, const std::string& except = "");
+
+	/// <summary>
+	/// The first texture unit that material textures are bound to, units below this are left for other uses
+	/// </summary>
+	static constexpr GLuint TEXTURE_SLOT_START = 1;
+
 protected:
+	static uint32_t _nextId;
+	// Stamps are unique across all materials, so a shader can tell both which material and which version of it was
+	// last applied from a single number
+	static uint64_t _nextStamp;
+
+	// The parameters as they were set, these get compiled into the block below when they change
+	std::unordered_map<ShaderParamName, ITexture::sptr> _textures;
+	std::unordered_map<ShaderParamName, float> _floatParams;
+	std::unordered_map<ShaderParamName, glm::vec2> _vec2Params;
+	std::unordered_map<ShaderParamName, glm::vec3> _vec3Params;
+	std::unordered_map<ShaderParamName, glm::vec4> _vec4Params;
+	std::unordered_map<ShaderParamName, glm::mat4> _mat4Params;
+	std::unordered_map<ShaderParamName, glm::mat3> _mat3Params;
+
+	/// <summary>
+	/// A single uniform in the compiled block
+	/// </summary>
+	struct CompiledParam {
+		int      Location;
+		// The GL type of the value (ex: GL_FLOAT_VEC3), samplers are stored as GL_INT
+		GLenum   Type;
+		// The offset of the value in _paramData, in bytes
+		uint32_t Offset;
+	};
+	// Sorted by location
+	std::vector<CompiledParam> _params;
+	std::vector<uint8_t>       _paramData;
+	// The textures in the order of the units they're bound to, starting at TEXTURE_SLOT_START
+	std::vector<ITexture::sptr> _boundTextures;
+	std::vector<GLuint>         _textureHandles;
+
+	bool     _isDirty;
+	uint64_t _stamp;
+	// The shader the block was compiled for, the locations have to be looked up again if Shader changes
+	const ::Shader* _compiledShader;
+
+	/// <summary>
+	/// Rebuilds the compiled parameter block from the parameter maps, looking up the location of each parameter in
+	/// the shader, and gives the material a new stamp
+	/// </summary>
+	void _Compile();
+	/// <summary>
+	/// Adds a value to the compiled block
+	/// </summary>
+	void _AddParam(int location, GLenum type, const void* value, size_t size);
+	template <typename T>
+	void _AddParams(const std::unordered_map<ShaderParamName, T>& values, GLenum type) {
+		for (auto& kvp : values) {
+			_AddParam(Shader->GetUniformLocation(kvp.first.Name), type, &kvp.second, sizeof(T));
+		}
+	}
 };
@@ -0,0 +1,402 @@
+#include "BlockCompression.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "Logging.h"
+
+namespace {
+	// The weight that each BC1 index gives to the first endpoint (in 4 color mode)
+	const float BC1_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	uint16_t To565(const float color[3]) {
+		const int r = (int)std::round(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f);
+		const int g = (int)std::round(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f);
+		const int b = (int)std::round(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	void From565(uint16_t color, int result[3]) {
+		const int r = (color >> 11) & 0x1F;
+		const int g = (color >> 5) & 0x3F;
+		const int b = color & 0x1F;
+		// Replicate the high bits into the low bits so that 0x1F maps to 255 exactly
+		result[0] = (r << 3) | (r >> 2);
+		result[1] = (g << 2) | (g >> 4);
+		result[2] = (b << 3) | (b >> 2);
+	}
+
+	/// <summary>
+	/// Builds the 4 colors a BC1 block can pick from, returns false if the block is in 3 color mode
+	/// </summary>
+	bool MakeBC1Palette(uint16_t c0, uint16_t c1, int palette[4][3], bool forceFourColor) {
+		From565(c0, palette[0]);
+		From565(c1, palette[1]);
+		const bool fourColor = forceFourColor || c0 > c1;
+		for (int ix = 0; ix < 3; ix++) {
+			if (fourColor) {
+				palette[2][ix] = (2 * palette[0][ix] + palette[1][ix]) / 3;
+				palette[3][ix] = (palette[0][ix] + 2 * palette[1][ix]) / 3;
+			} else {
+				palette[2][ix] = (palette[0][ix] + palette[1][ix]) / 2;
+				palette[3][ix] = 0;
+			}
+		}
+		return fourColor;
+	}
+
+	/// <summary>
+	/// Picks the closest palette entry for every texel, returning the packed indices and the total squared error
+	/// </summary>
+	uint32_t FindBC1Indices(const float colors[16][3], uint16_t c0, uint16_t c1, float& error) {
+		int palette[4][3];
+		MakeBC1Palette(c0, c1, palette, true);
+		uint32_t result = 0;
+		error = 0.0f;
+		for (int ix = 0; ix < 16; ix++) {
+			int   best = 0;
+			float bestDistance = INFINITY;
+			// When both endpoints are the same only the first entry is meaningful
+			const int paletteSize = c0 == c1 ? 1 : 4;
+			for (int p = 0; p < paletteSize; p++) {
+				const float dr = colors[ix][0] - palette[p][0];
+				const float dg = colors[ix][1] - palette[p][1];
+				const float db = colors[ix][2] - palette[p][2];
+				const float distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			result |= (uint32_t)best << (ix * 2);
+			error += bestDistance;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Makes sure the endpoints are in 4 color order (c0 > c1), swapping the indices to match if needed
+	/// </summary>
+	void OrderBC1Endpoints(uint16_t& c0, uint16_t& c1, uint32_t& indices) {
+		if (c0 < c1) {
+			std::swap(c0, c1);
+			// Swapping the endpoints maps index 0<->1 and 2<->3, which is just flipping the low bit of each index
+			indices ^= 0x55555555;
+		}
+	}
+
+	void MakeBC4Palette(uint8_t a0, uint8_t a1, int palette[8]) {
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1) {
+			for (int ix = 1; ix < 7; ix++) {
+				palette[ix + 1] = ((7 - ix) * a0 + ix * a1) / 7;
+			}
+		} else {
+			for (int ix = 1; ix < 5; ix++) {
+				palette[ix + 1] = ((5 - ix) * a0 + ix * a1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	/// <summary>
+	/// Reads a 4x4 block of texels from a level as RGBA, repeating the edge texels for blocks that hang off the
+	/// edge of the image
+	/// </summary>
+	void ReadBlock(const Texture2DData& source, uint32_t level, uint32_t blockX, uint32_t blockY, uint8_t rgba[64]) {
+		const uint32_t width    = source.GetLevelWidth(level);
+		const uint32_t height   = source.GetLevelHeight(level);
+		const size_t   channels = GetTexelComponentCount(source.GetFormat());
+		const uint8_t* data     = static_cast<const uint8_t*>(source.GetLevelDataPtr(level));
+		const bool     swapRB   = source.GetFormat() == PixelFormat::BGR || source.GetFormat() == PixelFormat::BGRA;
+
+		for (uint32_t y = 0; y < 4; y++) {
+			const uint32_t sy = std::min(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++) {
+				const uint32_t sx = std::min(blockX * 4 + x, width - 1);
+				const uint8_t* texel = data + (sy * (size_t)width + sx) * channels;
+				uint8_t* out = rgba + (y * 4 + x) * 4;
+				out[0] = texel[0];
+				out[1] = channels > 1 ? texel[1] : 0;
+				out[2] = channels > 2 ? texel[2] : 0;
+				out[3] = channels > 3 ? texel[3] : 255;
+				if (swapRB) {
+					std::swap(out[0], out[2]);
+				}
+			}
+		}
+	}
+}
+
+InternalFormat BlockCompression::ChooseFormat(const Texture2DData& source) {
+	const GLint channels = GetTexelComponentCount(source.GetFormat());
+	if (channels == 2) {
+		return InternalFormat::BC5;
+	}
+	if (channels == 4) {
+		const uint8_t* data = static_cast<const uint8_t*>(source.GetLevelDataPtr(0));
+		const size_t texelCount = source.GetLevelWidth(0) * (size_t)source.GetLevelHeight(0);
+		for (size_t ix = 0; ix < texelCount; ix++) {
+			if (data[ix * 4 + 3] != 255) {
+				return InternalFormat::BC3;
+			}
+		}
+	}
+	return InternalFormat::BC1;
+}
+
+Texture2DData::sptr BlockCompression::Compress(const Texture2DData& source, InternalFormat format) {
+	LOG_ASSERT(!source.IsCompressed() && source.GetPixelType() == PixelType::UByte, "Only 8 bit uncompressed data can be compressed");
+	if (format != InternalFormat::BC1 && format != InternalFormat::BC3 && format != InternalFormat::BC5) {
+		LOG_WARN("Can not encode {} on the CPU", ~format);
+		return nullptr;
+	}
+
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(source.GetWidth(), source.GetHeight(), format, source.GetLevelCount(), nullptr);
+	result->DebugName = source.DebugName;
+	const size_t blockSize = GetBlockSize(format);
+
+	uint8_t rgba[64];
+	uint8_t channel[16];
+	for (uint32_t level = 0; level < source.GetLevelCount(); level++) {
+		const uint32_t blocksX = (source.GetLevelWidth(level) + 3) / 4;
+		const uint32_t blocksY = (source.GetLevelHeight(level) + 3) / 4;
+		uint8_t* output = static_cast<uint8_t*>(result->GetLevelDataPtr(level));
+
+		for (uint32_t by = 0; by < blocksY; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				ReadBlock(source, level, bx, by, rgba);
+				uint8_t* block = output + (by * (size_t)blocksX + bx) * blockSize;
+
+				switch (format) {
+					case InternalFormat::BC1:
+						EncodeBC1(rgba, block);
+						break;
+					case InternalFormat::BC3:
+						for (int ix = 0; ix < 16; ix++) channel[ix] = rgba[ix * 4 + 3];
+						EncodeBC4(channel, block);
+						EncodeBC1(rgba, block + 8);
+						break;
+					case InternalFormat::BC5:
+						for (int ix = 0; ix < 16; ix++) channel[ix] = rgba[ix * 4 + 0];
+						EncodeBC4(channel, block);
+						for (int ix = 0; ix < 16; ix++) channel[ix] = rgba[ix * 4 + 1];
+						EncodeBC4(channel, block + 8);
+						break;
+					default:
+						break;
+				}
+			}
+		}
+	}
+	return result;
+}
+
+Texture2DData::sptr BlockCompression::Decompress(const Texture2DData& source) {
+	const InternalFormat format = source.GetRecommendedFormat();
+	if (format != InternalFormat::BC1 && format != InternalFormat::BC3 && format != InternalFormat::BC5) {
+		// BC7 (and RGTC) are core in OpenGL 4.2, so any driver that can run us will support them
+		LOG_ERROR("Can not decode {} on the CPU", ~format);
+		return nullptr;
+	}
+
+	const bool isTwoChannel = format == InternalFormat::BC5;
+	const size_t channels = isTwoChannel ? 2 : 4;
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(source.GetWidth(), source.GetHeight(),
+		isTwoChannel ? PixelFormat::RG : PixelFormat::RGBA, PixelType::UByte, nullptr,
+		isTwoChannel ? InternalFormat::RG8 : InternalFormat::RGBA8, source.GetLevelCount());
+	result->DebugName = source.DebugName;
+	const size_t blockSize = GetBlockSize(format);
+
+	uint8_t rgba[64];
+	uint8_t channel[16];
+	for (uint32_t level = 0; level < source.GetLevelCount(); level++) {
+		const uint32_t width   = source.GetLevelWidth(level);
+		const uint32_t height  = source.GetLevelHeight(level);
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		const uint8_t* input   = static_cast<const uint8_t*>(source.GetLevelDataPtr(level));
+		uint8_t* output        = static_cast<uint8_t*>(result->GetLevelDataPtr(level));
+
+		for (uint32_t by = 0; by < blocksY; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				const uint8_t* block = input + (by * (size_t)blocksX + bx) * blockSize;
+				switch (format) {
+					case InternalFormat::BC1:
+						DecodeBC1(block, rgba, true);
+						break;
+					case InternalFormat::BC3:
+						DecodeBC1(block + 8, rgba, false);
+						DecodeBC4(block, channel);
+						for (int ix = 0; ix < 16; ix++) rgba[ix * 4 + 3] = channel[ix];
+						break;
+					case InternalFormat::BC5:
+						DecodeBC4(block, channel);
+						for (int ix = 0; ix < 16; ix++) rgba[ix * 4 + 0] = channel[ix];
+						DecodeBC4(block + 8, channel);
+						for (int ix = 0; ix < 16; ix++) rgba[ix * 4 + 1] = channel[ix];
+						break;
+					default:
+						break;
+				}
+
+				// Copy out the texels that land inside of the image
+				for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++) {
+					for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++) {
+						uint8_t* texel = output + ((by * 4 + y) * (size_t)width + bx * 4 + x) * channels;
+						memcpy(texel, rgba + (y * 4 + x) * 4, channels);
+					}
+				}
+			}
+		}
+	}
+	return result;
+}
+
+void BlockCompression::EncodeBC1(const uint8_t rgba[64], uint8_t block[8]) {
+	float colors[16][3];
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int ix = 0; ix < 16; ix++) {
+		for (int c = 0; c < 3; c++) {
+			colors[ix][c] = rgba[ix * 4 + c];
+			mean[c] += colors[ix][c] / 16.0f;
+		}
+	}
+
+	// Find the axis that the colors vary the most along (the principal component), using a few power iterations
+	// on the covariance matrix. The endpoints are then the extremes of the colors projected onto that axis
+	float cov[6] = { 0.0f };
+	for (int ix = 0; ix < 16; ix++) {
+		const float r = colors[ix][0] - mean[0];
+		const float g = colors[ix][1] - mean[1];
+		const float b = colors[ix][2] - mean[2];
+		cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+		cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+	}
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; iteration++) {
+		const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		const float length = std::max({ std::abs(x), std::abs(y), std::abs(z) });
+		if (length < 1e-6f) break;
+		axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+	}
+	const float axisLengthSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+	float minT = 0.0f, maxT = 0.0f;
+	for (int ix = 0; ix < 16; ix++) {
+		const float t = ((colors[ix][0] - mean[0]) * axis[0] + (colors[ix][1] - mean[1]) * axis[1] + (colors[ix][2] - mean[2]) * axis[2]) / axisLengthSq;
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	float high[3], low[3];
+	for (int c = 0; c < 3; c++) {
+		high[c] = mean[c] + axis[c] * maxT;
+		low[c]  = mean[c] + axis[c] * minT;
+	}
+
+	uint16_t c0 = To565(high);
+	uint16_t c1 = To565(low);
+	float error;
+	uint32_t indices = FindBC1Indices(colors, c0, c1, error);
+
+	// Refine the endpoints with a least squares fit to the indices we picked, keeping the result if it helps
+	for (int iteration = 0; iteration < 2 && c0 != c1; iteration++) {
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[3] = { 0.0f }, bx[3] = { 0.0f };
+		for (int ix = 0; ix < 16; ix++) {
+			const float a = BC1_WEIGHTS[(indices >> (ix * 2)) & 3];
+			const float b = 1.0f - a;
+			aa += a * a; ab += a * b; bb += b * b;
+			for (int c = 0; c < 3; c++) {
+				ax[c] += a * colors[ix][c];
+				bx[c] += b * colors[ix][c];
+			}
+		}
+		const float det = aa * bb - ab * ab;
+		if (std::abs(det) < 1e-6f) break;
+		for (int c = 0; c < 3; c++) {
+			high[c] = (bb * ax[c] - ab * bx[c]) / det;
+			low[c]  = (aa * bx[c] - ab * ax[c]) / det;
+		}
+		const uint16_t newC0 = To565(high);
+		const uint16_t newC1 = To565(low);
+		float newError;
+		const uint32_t newIndices = FindBC1Indices(colors, newC0, newC1, newError);
+		if (newError >= error) break;
+		c0 = newC0; c1 = newC1; indices = newIndices; error = newError;
+	}
+
+	OrderBC1Endpoints(c0, c1, indices);
+	if (c0 == c1) {
+		indices = 0;
+	}
+	memcpy(block + 0, &c0, sizeof(uint16_t));
+	memcpy(block + 2, &c1, sizeof(uint16_t));
+	memcpy(block + 4, &indices, sizeof(uint32_t));
+}
+
+void BlockCompression::EncodeBC4(const uint8_t values[16], uint8_t block[8]) {
+	uint8_t low = 255, high = 0;
+	for (int ix = 0; ix < 16; ix++) {
+		low  = std::min(low, values[ix]);
+		high = std::max(high, values[ix]);
+	}
+
+	// Using the maximum as the first endpoint selects the 8 value mode, if they are equal every index is 0
+	int palette[8];
+	MakeBC4Palette(high, low, palette);
+	uint64_t indices = 0;
+	for (int ix = 0; ix < 16 && high != low; ix++) {
+		int best = 0;
+		int bestDistance = 256;
+		for (int p = 0; p < 8; p++) {
+			const int distance = std::abs(values[ix] - palette[p]);
+			if (distance < bestDistance) {
+				bestDistance = distance;
+				best = p;
+			}
+		}
+		indices |= (uint64_t)best << (ix * 3);
+	}
+
+	block[0] = high;
+	block[1] = low;
+	for (int ix = 0; ix < 6; ix++) {
+		block[2 + ix] = (uint8_t)(indices >> (ix * 8));
+	}
+}
+
+void BlockCompression::DecodeBC1(const uint8_t block[8], uint8_t rgba[64], bool allowTransparent) {
+	uint16_t c0, c1;
+	uint32_t indices;
+	memcpy(&c0, block + 0, sizeof(uint16_t));
+	memcpy(&c1, block + 2, sizeof(uint16_t));
+	memcpy(&indices, block + 4, sizeof(uint32_t));
+
+	int palette[4][3];
+	const bool fourColor = MakeBC1Palette(c0, c1, palette, !allowTransparent);
+	for (int ix = 0; ix < 16; ix++) {
+		const uint32_t index = (indices >> (ix * 2)) & 3;
+		uint8_t* texel = rgba + ix * 4;
+		texel[0] = (uint8_t)palette[index][0];
+		texel[1] = (uint8_t)palette[index][1];
+		texel[2] = (uint8_t)palette[index][2];
+		texel[3] = (!fourColor && index == 3) ? 0 : 255;
+	}
+}
+
+void BlockCompression::DecodeBC4(const uint8_t block[8], uint8_t values[16]) {
+	int palette[8];
+	MakeBC4Palette(block[0], block[1], palette);
+	uint64_t indices = 0;
+	for (int ix = 0; ix < 6; ix++) {
+		indices |= (uint64_t)block[2 + ix] << (ix * 8);
+	}
+	for (int ix = 0; ix < 16; ix++) {
+		values[ix] = (uint8_t)palette[(indices >> (ix * 3)) & 7];
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+
+#include "Graphics/Texture2DData.h"
+
+/// <summary>
+/// CPU encoders and decoders for the block compressed texture formats. Every format splits the image into
+/// 4x4 blocks of texels, each of which stores two endpoint values and a small index per texel that picks a
+/// value interpolated between them. See https://docs.microsoft.com/en-us/windows/win32/direct3d11/texture-block-compression-in-direct3d-11
+///
+/// Encoding is used by the TextureCompressor to make compressed copies of our images ahead of time, decoding is
+/// used as a fallback when the GPU does not support a format
+/// </summary>
+class BlockCompression
+{
+public:
+	/// <summary>
+	/// Picks a compressed format for an image based on its contents. Images with any transparency use BC3, two
+	/// channel images use BC5 and everything else uses BC1
+	/// </summary>
+	/// <param name="source">The uncompressed 8 bit image data</param>
+	static InternalFormat ChooseFormat(const Texture2DData& source);
+
+	/// <summary>
+	/// Compresses every mip level of an image on the CPU
+	/// </summary>
+	/// <param name="source">The uncompressed 8 bit image data</param>
+	/// <param name="format">The format to compress to, BC1, BC3 or BC5 (we do not have a BC7 encoder)</param>
+	/// <returns>The compressed data, or nullptr if the format can not be encoded</returns>
+	static Texture2DData::sptr Compress(const Texture2DData& source, InternalFormat format);
+	/// <summary>
+	/// Decompresses every mip level of an image on the CPU. BC1 and BC3 are decompressed to RGBA8, BC5 to RG8
+	/// </summary>
+	/// <param name="source">The compressed image data</param>
+	/// <returns>The uncompressed data, or nullptr if the format can not be decoded</returns>
+	static Texture2DData::sptr Decompress(const Texture2DData& source);
+
+	/// <summary>
+	/// Encodes a block of 16 RGBA texels (stored row by row) into an 8 byte BC1 block, ignoring alpha
+	/// </summary>
+	static void EncodeBC1(const uint8_t rgba[64], uint8_t block[8]);
+	/// <summary>
+	/// Encodes a block of 16 single channel values into an 8 byte BC4 block, which is used for the alpha of BC3
+	/// and for each of the two channels of BC5
+	/// </summary>
+	static void EncodeBC4(const uint8_t values[16], uint8_t block[8]);
+	/// <summary>
+	/// Decodes an 8 byte BC1 block into 16 RGBA texels
+	/// </summary>
+	/// <param name="allowTransparent">True to allow the 3 color + transparent black mode, which BC3 never uses</param>
+	static void DecodeBC1(const uint8_t block[8], uint8_t rgba[64], bool allowTransparent = true);
+	/// <summary>
+	/// Decodes an 8 byte BC4 block into 16 single channel values
+	/// </summary>
+	static void DecodeBC4(const uint8_t block[8], uint8_t values[16]);
+
+protected:
+	BlockCompression() = default;
+	~BlockCompression() = default;
+};
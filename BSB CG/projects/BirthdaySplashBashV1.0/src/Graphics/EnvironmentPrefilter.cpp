@@ -0,0 +1,331 @@
+#include "EnvironmentPrefilter.h"
+
+#include <cmath>
+#include <future>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/constants.hpp>
+
+#include "Logging.h"
+#include "Utilities/Hash.h"
+#include "Graphics/GammaTables.h"
+#include "Utilities/FileUtils.h"
+#include "Utilities/MappedFile.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	const char ENV_CACHE_MAGIC[4] = { 'B', 'E', 'N', 'V' };
+
+	// The number of GGX samples taken per texel for the first prefiltered level, doubling for each level after it up
+	// to the max. Since every sample reads from a level of the box filtered chain that matches its footprint this can
+	// be kept low, and the largest (most expensive) level has the narrowest lobe so it needs the fewest
+	constexpr uint32_t BASE_SAMPLE_COUNT = 16;
+	constexpr uint32_t MAX_SAMPLE_COUNT  = 128;
+
+	/// <summary>
+	/// A single level of a cube map, as linear floats
+	/// </summary>
+	struct FloatLevel {
+		uint32_t Size;
+		std::vector<glm::vec3> Faces[6];
+	};
+
+	/// <summary>
+	/// A GGX sample in tangent space (Z is the normal), along with its weight and the level of the source chain to read
+	/// </summary>
+	struct LobeSample {
+		glm::vec3 Direction;
+		float     Weight;
+		float     Lod;
+	};
+
+	/// <summary>
+	/// Gets the direction through a point on a face, using the face layout from the OpenGL spec (table 8.19)
+	/// </summary>
+	/// <param name="sc">The horizontal position on the face, from -1 to 1</param>
+	/// <param name="tc">The vertical position on the face, from -1 to 1</param>
+	glm::vec3 FaceToDirection(int face, float sc, float tc) {
+		switch (face) {
+			case 0:  return glm::vec3( 1.0f, -tc, -sc);
+			case 1:  return glm::vec3(-1.0f, -tc,  sc);
+			case 2:  return glm::vec3( sc,  1.0f,  tc);
+			case 3:  return glm::vec3( sc, -1.0f, -tc);
+			case 4:  return glm::vec3( sc, -tc,  1.0f);
+			default: return glm::vec3(-sc, -tc, -1.0f);
+		}
+	}
+
+	/// <summary>
+	/// The inverse of FaceToDirection, gets the face a direction points at and the texture coordinates (0 to 1) on that face
+	/// </summary>
+	void DirectionToFace(const glm::vec3& dir, int& face, float& s, float& t) {
+		const glm::vec3 a = glm::abs(dir);
+		float sc, tc, ma;
+		if (a.x >= a.y && a.x >= a.z) {
+			face = dir.x > 0.0f ? 0 : 1;
+			sc = dir.x > 0.0f ? -dir.z : dir.z;
+			tc = -dir.y;
+			ma = a.x;
+		} else if (a.y >= a.z) {
+			face = dir.y > 0.0f ? 2 : 3;
+			sc = dir.x;
+			tc = dir.y > 0.0f ? dir.z : -dir.z;
+			ma = a.y;
+		} else {
+			face = dir.z > 0.0f ? 4 : 5;
+			sc = dir.z > 0.0f ? dir.x : -dir.x;
+			tc = -dir.y;
+			ma = a.z;
+		}
+		s = 0.5f * (sc / ma + 1.0f);
+		t = 0.5f * (tc / ma + 1.0f);
+	}
+
+	glm::vec3 SampleBilinear(const FloatLevel& level, int face, float s, float t) {
+		const float x = s * level.Size - 0.5f;
+		const float y = t * level.Size - 0.5f;
+		const float x0f = std::floor(x), y0f = std::floor(y);
+		const float fx = x - x0f, fy = y - y0f;
+		const int max = (int)level.Size - 1;
+		// Clamp to the edge of the face, the seams are too small to be noticed after filtering
+		const int x0 = std::clamp((int)x0f, 0, max), x1 = std::clamp((int)x0f + 1, 0, max);
+		const int y0 = std::clamp((int)y0f, 0, max), y1 = std::clamp((int)y0f + 1, 0, max);
+		const std::vector<glm::vec3>& texels = level.Faces[face];
+		const glm::vec3 top    = glm::mix(texels[y0 * level.Size + x0], texels[y0 * level.Size + x1], fx);
+		const glm::vec3 bottom = glm::mix(texels[y1 * level.Size + x0], texels[y1 * level.Size + x1], fx);
+		return glm::mix(top, bottom, fy);
+	}
+
+	glm::vec3 SampleChain(const std::vector<FloatLevel>& chain, const glm::vec3& dir, float lod) {
+		int face;
+		float s, t;
+		DirectionToFace(dir, face, s, t);
+		lod = std::clamp(lod, 0.0f, (float)(chain.size() - 1));
+		const uint32_t level = (uint32_t)lod;
+		const uint32_t next = std::min(level + 1, (uint32_t)chain.size() - 1);
+		return glm::mix(SampleBilinear(chain[level], face, s, t), SampleBilinear(chain[next], face, s, t), lod - level);
+	}
+
+	float RadicalInverse(uint32_t bits) {
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return (float)bits * 2.3283064365386963e-10f;
+	}
+
+	/// <summary>
+	/// Importance samples a GGX lobe, assuming the view and reflection directions are the same as the normal
+	/// (see Real Shading in Unreal Engine 4, Karis 2013). The samples are the same for every texel of a level
+	/// </summary>
+	std::vector<LobeSample> BuildSamples(float roughness, uint32_t sourceSize, uint32_t sampleCount) {
+		const float alpha = roughness * roughness;
+		const float texelSolidAngle = 4.0f * glm::pi<float>() / (6.0f * sourceSize * sourceSize);
+
+		std::vector<LobeSample> result;
+		result.reserve(sampleCount);
+		for (uint32_t ix = 0; ix < sampleCount; ix++) {
+			const float u = (ix + 0.5f) / sampleCount;
+			const float v = RadicalInverse(ix);
+			const float phi = 2.0f * glm::pi<float>() * u;
+			const float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alpha * alpha - 1.0f) * v));
+			const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			const glm::vec3 half(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+			const glm::vec3 light = 2.0f * half.z * half - glm::vec3(0.0f, 0.0f, 1.0f);
+			if (light.z <= 0.0f) {
+				continue;
+			}
+
+			// Read from the level whose texels cover about as much of the sphere as this sample does
+			const float a2 = alpha * alpha;
+			const float d = (cosTheta * cosTheta) * (a2 - 1.0f) + 1.0f;
+			const float distribution = a2 / (glm::pi<float>() * d * d);
+			const float pdf = distribution * 0.25f;
+			const float sampleSolidAngle = 1.0f / (sampleCount * pdf + 1e-4f);
+			const float lod = roughness == 0.0f ? 0.0f : std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+
+			result.push_back({ light, light.z, lod });
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Filters one face of one level, reading from the box filtered chain
+	/// </summary>
+	void FilterFace(const std::vector<FloatLevel>& chain, const std::vector<LobeSample>& samples, int face, uint32_t size, size_t channels, uint8_t* output) {
+		const GammaTables& tables = GammaTables::Get();
+		for (uint32_t y = 0; y < size; y++) {
+			for (uint32_t x = 0; x < size; x++) {
+				const float sc = 2.0f * (x + 0.5f) / size - 1.0f;
+				const float tc = 2.0f * (y + 0.5f) / size - 1.0f;
+				const glm::vec3 normal = glm::normalize(FaceToDirection(face, sc, tc));
+				const glm::vec3 up = std::abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+				const glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+				const glm::vec3 bitangent = glm::cross(normal, tangent);
+
+				glm::vec3 sum(0.0f);
+				float totalWeight = 0.0f;
+				for (const LobeSample& sample : samples) {
+					const glm::vec3 dir = tangent * sample.Direction.x + bitangent * sample.Direction.y + normal * sample.Direction.z;
+					sum += SampleChain(chain, dir, sample.Lod) * sample.Weight;
+					totalWeight += sample.Weight;
+				}
+				sum /= totalWeight;
+
+				uint8_t* texel = output + (y * (size_t)size + x) * channels;
+				texel[0] = tables.LinearToSrgb(sum.r);
+				texel[1] = tables.LinearToSrgb(sum.g);
+				texel[2] = tables.LinearToSrgb(sum.b);
+				if (channels == 4) {
+					texel[3] = 255;
+				}
+			}
+		}
+	}
+}
+
+TextureCubeMapData::sptr EnvironmentPrefilter::Prefilter(const TextureCubeMapData& source) {
+	const size_t channels = GetTexelComponentCount(source.GetFormat());
+	if (source.GetPixelType() != PixelType::UByte || channels < 3) {
+		LOG_WARN("Can not prefilter \"{}\", only 8 bit RGB and RGBA cube maps are supported", source.DebugName);
+		return nullptr;
+	}
+
+	const uint32_t size = source.GetSize();
+	const uint32_t levelCount = std::min(GetMipLevelCount(size, size), MAX_LEVELS);
+	TextureCubeMapData::sptr result = std::make_shared<TextureCubeMapData>(size, source.GetFormat(), source.GetPixelType(),
+		nullptr, source.GetRecommendedFormat(), levelCount);
+	result->DebugName = source.DebugName;
+	memcpy(result->GetLevelFaceDataPtr(0), source.GetLevelFaceDataPtr(0), source.GetLevelFaceDataSize(0) * 6);
+	if (levelCount == 1) {
+		return result;
+	}
+
+	// Build a box filtered chain in linear space for the samples to read from
+	const float* toLinear = GammaTables::Get().ToLinear;
+	std::vector<FloatLevel> chain(GetMipLevelCount(size, size));
+	chain[0].Size = size;
+	for (int face = 0; face < 6; face++) {
+		const uint8_t* src = static_cast<const uint8_t*>(source.GetLevelFaceDataPtr(0, (CubeMapFace)face));
+		std::vector<glm::vec3>& texels = chain[0].Faces[face];
+		texels.resize(size * (size_t)size);
+		for (size_t ix = 0; ix < texels.size(); ix++) {
+			texels[ix] = glm::vec3(toLinear[src[ix * channels]], toLinear[src[ix * channels + 1]], toLinear[src[ix * channels + 2]]);
+		}
+	}
+	for (size_t level = 1; level < chain.size(); level++) {
+		const FloatLevel& above = chain[level - 1];
+		chain[level].Size = std::max(above.Size / 2, 1u);
+		for (int face = 0; face < 6; face++) {
+			std::vector<glm::vec3>& texels = chain[level].Faces[face];
+			texels.resize(chain[level].Size * (size_t)chain[level].Size);
+			const std::vector<glm::vec3>& src = above.Faces[face];
+			for (uint32_t y = 0; y < chain[level].Size; y++) {
+				const size_t y0 = std::min(y * 2, above.Size - 1) * (size_t)above.Size;
+				const size_t y1 = std::min(y * 2 + 1, above.Size - 1) * (size_t)above.Size;
+				for (uint32_t x = 0; x < chain[level].Size; x++) {
+					const uint32_t x0 = std::min(x * 2, above.Size - 1);
+					const uint32_t x1 = std::min(x * 2 + 1, above.Size - 1);
+					texels[y * chain[level].Size + x] = 0.25f * (src[y0 + x0] + src[y0 + x1] + src[y1 + x0] + src[y1 + x1]);
+				}
+			}
+		}
+	}
+
+	// The faces are independent, so we filter the 6 faces of each level in parallel
+	for (uint32_t level = 1; level < levelCount; level++) {
+		const uint32_t sampleCount = std::min(BASE_SAMPLE_COUNT << (level - 1), MAX_SAMPLE_COUNT);
+		const std::vector<LobeSample> samples = BuildSamples(level / (float)(levelCount - 1), size, sampleCount);
+		std::future<void> tasks[6];
+		for (int face = 0; face < 6; face++) {
+			uint8_t* output = static_cast<uint8_t*>(result->GetLevelFaceDataPtr(level, (CubeMapFace)face));
+			tasks[face] = std::async(std::launch::async, FilterFace,
+				std::cref(chain), std::cref(samples), face, result->GetLevelSize(level), channels, output);
+		}
+		for (std::future<void>& task : tasks) {
+			task.get();
+		}
+	}
+	return result;
+}
+
+std::string EnvironmentPrefilter::GetCachePath(const std::string& rootImagePath) {
+	return rootImagePath + ".envmap";
+}
+
+bool EnvironmentPrefilter::_FingerprintFaces(const std::string& rootImagePath, uint64_t& size, uint64_t& hash) {
+	size = 0;
+	hash = Hash::FNV_OFFSET_BASIS;
+	for (int face = 0; face < 6; face++) {
+		MappedFile source(TextureCubeMapData::GetFacePath(rootImagePath, (CubeMapFace)face));
+		if (!source.IsOpen()) return false;
+		size += source.GetSize();
+		hash = Hash::Fnv1a(source.GetData(), source.GetSize(), hash);
+	}
+	return true;
+}
+
+TextureCubeMapData::sptr EnvironmentPrefilter::LoadCache(const std::string& rootImagePath) {
+	const std::string cachePath = GetCachePath(rootImagePath);
+	MappedFile cache;
+	if (!cache.Open(cachePath) || cache.GetSize() < sizeof(Header)) {
+		return nullptr;
+	}
+	Header header;
+	memcpy(&header, cache.GetData(), sizeof(Header));
+
+	if (memcmp(header.Magic, ENV_CACHE_MAGIC, sizeof(ENV_CACHE_MAGIC)) != 0 || header.Version != FORMAT_VERSION) {
+		LOG_WARN("Environment cache \"{}\" is from an older version, rebuilding", cachePath);
+		return nullptr;
+	}
+	if (header.Size == 0 || header.LevelCount == 0 || header.LevelCount > GetMipLevelCount(header.Size, header.Size) ||
+		IsCompressedFormat((InternalFormat)header.RecommendedFormat) ||
+		cache.GetSize() != sizeof(Header) + header.DataSize) {
+		LOG_WARN("Environment cache \"{}\" is truncated or corrupt, rebuilding", cachePath);
+		return nullptr;
+	}
+
+	// Validate against the faces, if they're missing we trust the cache like FileUtils::IsSourceUnchanged does
+	std::error_code error;
+	if (fs::exists(TextureCubeMapData::GetFacePath(rootImagePath, CubeMapFace::PosX), error)) {
+		uint64_t size, hash;
+		if (!_FingerprintFaces(rootImagePath, size, hash) || size != header.SourceSize || hash != header.SourceHash) {
+			return nullptr;
+		}
+	}
+
+	TextureCubeMapData::sptr result = std::make_shared<TextureCubeMapData>(header.Size, (PixelFormat)header.Format,
+		(PixelType)header.Type, nullptr, (InternalFormat)header.RecommendedFormat, header.LevelCount);
+	if (result->GetDataSize() != header.DataSize) {
+		LOG_WARN("Environment cache \"{}\" does not match its header, rebuilding", cachePath);
+		return nullptr;
+	}
+	memcpy(result->GetLevelFaceDataPtr(0), cache.GetData() + sizeof(Header), result->GetDataSize());
+	result->DebugName = fs::path(rootImagePath).filename().string();
+	return result;
+}
+
+bool EnvironmentPrefilter::SaveCache(const std::string& rootImagePath, const TextureCubeMapData& data) {
+	Header header = {};
+	memcpy(header.Magic, ENV_CACHE_MAGIC, sizeof(ENV_CACHE_MAGIC));
+	header.Version           = FORMAT_VERSION;
+	header.Size              = data.GetSize();
+	header.LevelCount        = data.GetLevelCount();
+	header.Format            = (uint32_t)data.GetFormat();
+	header.Type              = (uint32_t)data.GetPixelType();
+	header.RecommendedFormat = (uint32_t)data.GetRecommendedFormat();
+	header.DataSize          = data.GetDataSize();
+	if (!_FingerprintFaces(rootImagePath, header.SourceSize, header.SourceHash)) {
+		LOG_WARN("Could not read the faces of \"{}\" to fingerprint them, skipping environment cache", rootImagePath);
+		return false;
+	}
+
+	return FileUtils::WriteFileAtomic(GetCachePath(rootImagePath), {
+		{ &header, sizeof(Header) },
+		{ data.GetDataPtr(), data.GetDataSize() }
+	});
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+#include "Graphics/TextureCubeMapData.h"
+
+/// <summary>
+/// Prefilters environment cube maps for glossy reflections. Each mip level below the first is convolved with a
+/// GGX lobe for a roughness of level / (levels - 1), so shaders can pick a level with
+/// textureLod(env, dir, roughness * (textureQueryLevels(env) - 1)).
+///
+/// Filtering is done on the CPU with importance sampling, reading from a box filtered copy of the source so that
+/// a few samples per texel are enough (see GPU Gems 3, chapter 20). It is far too slow to do every launch, so the
+/// results are cached next to the source images
+/// </summary>
+class EnvironmentPrefilter
+{
+public:
+	// Rougher levels below this count would be too small to be useful
+	static constexpr uint32_t MAX_LEVELS = 6;
+
+	/// <summary>
+	/// Builds the prefiltered mip chain for an 8 bit cube map. The faces are treated as sRGB and filtered in linear space
+	/// </summary>
+	/// <param name="source">The cube map to filter, only the first level is used</param>
+	/// <returns>A copy of the source with the prefiltered levels, or nullptr if the source can not be filtered</returns>
+	static TextureCubeMapData::sptr Prefilter(const TextureCubeMapData& source);
+
+	/// <summary>
+	/// Gets the path that a prefiltered cube map is cached at
+	/// </summary>
+	/// <param name="rootImagePath">The base path of the face images (see TextureCubeMapData::LoadFromImages)</param>
+	static std::string GetCachePath(const std::string& rootImagePath);
+	/// <summary>
+	/// Loads a prefiltered cube map from its cache, if it exists and all 6 faces are unchanged. If the faces are
+	/// missing the cache is trusted
+	/// </summary>
+	/// <param name="rootImagePath">The base path of the face images</param>
+	/// <returns>The cube map with all of its levels, or nullptr if there is no valid cache</returns>
+	static TextureCubeMapData::sptr LoadCache(const std::string& rootImagePath);
+	/// <summary>
+	/// Writes a prefiltered cube map to the cache, fingerprinting the face images it was made from
+	/// </summary>
+	/// <param name="rootImagePath">The base path of the face images</param>
+	/// <param name="data">The prefiltered cube map</param>
+	/// <returns>True if the cache was written</returns>
+	static bool SaveCache(const std::string& rootImagePath, const TextureCubeMapData& data);
+
+protected:
+	EnvironmentPrefilter() = default;
+	~EnvironmentPrefilter() = default;
+
+	// Bump this whenever the layout of the file or the output of the filter changes
+	static constexpr uint32_t FORMAT_VERSION = 2;
+
+	struct Header {
+		char     Magic[4];
+		uint32_t Version;
+		uint32_t Size;
+		uint32_t LevelCount;
+		uint32_t Format;
+		uint32_t Type;
+		uint32_t RecommendedFormat;
+		uint32_t Reserved;
+		uint64_t SourceSize;
+		uint64_t SourceHash;
+		uint64_t DataSize;
+	};
+
+	/// <summary>
+	/// Gets the combined size and hash of all 6 face images, returns false if any of them could not be read
+	/// </summary>
+	static bool _FingerprintFaces(const std::string& rootImagePath, uint64_t& size, uint64_t& hash);
+};
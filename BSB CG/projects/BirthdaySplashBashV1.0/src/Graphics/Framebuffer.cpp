@@ -1,4 +1,5 @@
 #include "Framebuffer.h"
+#include "GLStateCache.h"
 
 GLuint Framebuffer::_fullscreenQuadVBO = 0;
 GLuint Framebuffer::_fullscreenQuadVAO = 0;
@@ -15,6 +16,7 @@ DepthTarget::~DepthTarget()
 void DepthTarget::Unload()
 {
 	//Deletes the texture at the specific handle
+	GLStateCache::ForgetTexture(_texture.GetHandle());
 	glDeleteTextures(1, &_texture.GetHandle());
 }
 
@@ -26,6 +28,10 @@ ColorTarget::~ColorTarget()
 
 void ColorTarget::Unload()
 {
+	for (unsigned i = 0; i < _numAttachments; i++)
+	{
+		GLStateCache::ForgetTexture(_textures[i].GetHandle());
+	}
 	glDeleteTextures(_numAttachments, &_textures[0].GetHandle());
 }
 
@@ -41,6 +47,7 @@ Framebuffer::~Framebuffer()
 void Framebuffer::Unload()
 {
 	//Deletes the framebuffer
+	GLStateCache::ForgetFramebuffer(_FBO);
 	glDeleteFramebuffers(1, &_FBO);
 	//Sets init to false
 	_isInit = false;
@@ -60,19 +67,17 @@ void Framebuffer::Init()
 	//Generates the FBO
 	glGenFramebuffers(1, &_FBO);
 	//Bind it
-	glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, _FBO);
 
 	if (_depthActive)
 	{
 		//because we have depth we need to clear our depth bit
 		_clearFlag |= GL_DEPTH_BUFFER_BIT;
 
-		//Generate the texture
-		glGenTextures(1, &_depth._texture.GetHandle());
-		//Binds the texture
-		glBindTexture(GL_TEXTURE_2D, _depth._texture.GetHandle());
+		//Generate the texture, created with DSA so that we don't disturb whatever is bound to the active unit
+		glCreateTextures(GL_TEXTURE_2D, 1, &_depth._texture.GetHandle());
 		//Sets the texture data
-		glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, _width, _height);
+		glTextureStorage2D(_depth._texture.GetHandle(), 1, GL_DEPTH_COMPONENT24, _width, _height);
 
 		//Set texture parameters
 		glTextureParameteri(_depth._texture.GetHandle(), GL_TEXTURE_MIN_FILTER, _filter);
@@ -82,8 +87,6 @@ void Framebuffer::Init()
 
 		//Sets up as a framebuffer texture
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depth._texture.GetHandle(), 0);
-
-		glBindTexture(GL_TEXTURE_2D, GL_NONE);
 	}
 
 	//If there is more than zero color attachments
@@ -95,17 +98,15 @@ void Framebuffer::Init()
 		//Creates the GLuints to hold the new texture handles;
 		GLuint* textureHandles = new GLuint[_color._numAttachments];
 
-		glGenTextures(_color._numAttachments, textureHandles);
+		glCreateTextures(GL_TEXTURE_2D, _color._numAttachments, textureHandles);
 
 		//Loops through them
 		for (unsigned i = 0; i < _color._numAttachments; i++)
 		{
 			_color._textures[i].GetHandle() = textureHandles[i];
 
-			//Binds the texture
-			glBindTexture(GL_TEXTURE_2D, _color._textures[i].GetHandle());
 			//Sets the texture storage
-			glTexStorage2D(GL_TEXTURE_2D, 1, _color._formats[i], _width, _height);
+			glTextureStorage2D(_color._textures[i].GetHandle(), 1, _color._formats[i], _width, _height);
 
 			//Set texture parameters
 			glTextureParameteri(_color._textures[i].GetHandle(), GL_TEXTURE_MIN_FILTER, _filter);
@@ -123,7 +124,7 @@ void Framebuffer::Init()
 	//Make sure it's set up right
 	CheckFBO();
 	//Unbind buffer
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
 	//Set init to true
 	_isInit = true;
 }
@@ -164,8 +165,7 @@ void Framebuffer::BindColorAsTexture(unsigned colorBuffer, int textureSlot) cons
 void Framebuffer::UnbindTexture(int textureSlot) const
 {
 	//Binds textures to GL_NONE
-	glActiveTexture(GL_TEXTURE0 + textureSlot);
-	glBindTexture(GL_TEXTURE_2D, GL_NONE);
+	GLStateCache::BindTextureUnit(textureSlot, GL_NONE);
 }
 
 void Framebuffer::Reshape(unsigned width, unsigned height)
@@ -191,12 +191,12 @@ void Framebuffer::SetSize(unsigned width, unsigned height)
 
 void Framebuffer::SetViewport() const
 {
-	glViewport(0, 0, _width, _height);
+	GLStateCache::Viewport(0, 0, _width, _height);
 }
 
 void Framebuffer::Bind() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, _FBO);
 
 	if (_color._numAttachments)
 	{
@@ -206,7 +206,7 @@ void Framebuffer::Bind() const
 
 void Framebuffer::Unbind() const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
 }
 
 void Framebuffer::RenderToFSQ() const
@@ -223,19 +223,19 @@ void Framebuffer::RenderToFSQ() const
 
 void Framebuffer::DrawToBackbuffer()
 {
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, _FBO);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_DRAW_FRAMEBUFFER, GL_NONE);
 
 	//Blits the framebuffer to the back buffer
 	glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
 }
 
 void Framebuffer::Clear()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, _FBO);
 	glClear(_clearFlag);
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
 }
 
 bool Framebuffer::CheckFBO()
@@ -282,7 +282,7 @@ void Framebuffer::InitFullscreenQuad()
 	//Generates vertex array
 	glGenVertexArrays(1, &_fullscreenQuadVAO);
 	//Binds VAO
-	glBindVertexArray(_fullscreenQuadVAO);
+	GLStateCache::BindVertexArray(_fullscreenQuadVAO);
 
 	//Enables 2 vertex attrib array slots
 	glEnableVertexAttribArray(0); //Vertices
@@ -305,14 +305,13 @@ void Framebuffer::InitFullscreenQuad()
 #pragma warning(pop)
 
 	glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
-	glBindVertexArray(GL_NONE);
+	GLStateCache::BindVertexArray(GL_NONE);
 }
 
 void Framebuffer::DrawFullscreenQuad()
 {
-	glBindVertexArray(_fullscreenQuadVAO);
+	GLStateCache::BindVertexArray(_fullscreenQuadVAO);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
-	glBindVertexArray(GL_NONE);
 }
 
 
@@ -0,0 +1,228 @@
+#include "GLStateCache.h"
+
+const GLenum GLStateCache::_caps[CAP_COUNT] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST, GL_STENCIL_TEST };
+
+GLuint GLStateCache::_program = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_vao = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_drawFramebuffer = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_readFramebuffer = GLStateCache::UNKNOWN;
+std::vector<GLuint> GLStateCache::_textures;
+std::vector<GLuint> GLStateCache::_samplers;
+GLuint GLStateCache::_capStates[CAP_COUNT] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+GLuint GLStateCache::_depthFunc = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_depthMask = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_cullFace = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_blendSource = GLStateCache::UNKNOWN;
+GLuint GLStateCache::_blendDest = GLStateCache::UNKNOWN;
+GLint  GLStateCache::_viewport[4] = { 0, 0, 0, 0 };
+bool   GLStateCache::_hasViewport = false;
+GLStateCache::Stats GLStateCache::_stats;
+GLStateCache::Stats GLStateCache::_frameStats;
+
+bool GLStateCache::_Set(GLuint& cached, GLuint value) {
+	if (cached == value) {
+		_stats.Skipped++;
+		return false;
+	}
+	cached = value;
+	_stats.Issued++;
+	return true;
+}
+
+GLuint& GLStateCache::_GetUnit(std::vector<GLuint>& units, GLuint unit) {
+	if (unit >= units.size()) {
+		units.resize(unit + 1, UNKNOWN);
+	}
+	return units[unit];
+}
+
+void GLStateCache::UseProgram(GLuint program) {
+	if (_Set(_program, program)) {
+		glUseProgram(program);
+	}
+}
+
+void GLStateCache::BindVertexArray(GLuint vao) {
+	if (_Set(_vao, vao)) {
+		glBindVertexArray(vao);
+	}
+}
+
+void GLStateCache::BindFramebuffer(GLenum target, GLuint fbo) {
+	switch (target) {
+		case GL_DRAW_FRAMEBUFFER:
+			if (_Set(_drawFramebuffer, fbo)) {
+				glBindFramebuffer(target, fbo);
+			}
+			break;
+		case GL_READ_FRAMEBUFFER:
+			if (_Set(_readFramebuffer, fbo)) {
+				glBindFramebuffer(target, fbo);
+			}
+			break;
+		default:
+			if (_drawFramebuffer == fbo && _readFramebuffer == fbo) {
+				_stats.Skipped++;
+			} else {
+				_drawFramebuffer = _readFramebuffer = fbo;
+				_stats.Issued++;
+				glBindFramebuffer(target, fbo);
+			}
+			break;
+	}
+}
+
+void GLStateCache::BindTextureUnit(GLuint unit, GLuint texture) {
+	if (_Set(_GetUnit(_textures, unit), texture)) {
+		glBindTextureUnit(unit, texture);
+	}
+}
+
+void GLStateCache::BindTextures(GLuint first, GLsizei count, const GLuint* textures) {
+	if (count <= 0) {
+		return;
+	}
+	bool changed = false;
+	for (GLsizei ix = 0; ix < count; ix++) {
+		GLuint& bound = _GetUnit(_textures, first + ix);
+		if (bound != textures[ix]) {
+			bound = textures[ix];
+			changed = true;
+		}
+	}
+	if (changed) {
+		_stats.Issued++;
+		glBindTextures(first, count, textures);
+	} else {
+		_stats.Skipped++;
+	}
+}
+
+void GLStateCache::BindSampler(GLuint unit, GLuint sampler) {
+	if (_Set(_GetUnit(_samplers, unit), sampler)) {
+		glBindSampler(unit, sampler);
+	}
+}
+
+bool GLStateCache::IsEnabled(GLenum cap) {
+	for (size_t ix = 0; ix < CAP_COUNT; ix++) {
+		if (_caps[ix] == cap) {
+			if (_capStates[ix] == UNKNOWN) {
+				_capStates[ix] = glIsEnabled(cap);
+			}
+			return _capStates[ix] == GL_TRUE;
+		}
+	}
+	return glIsEnabled(cap) == GL_TRUE;
+}
+
+void GLStateCache::SetEnabled(GLenum cap, bool enabled) {
+	for (size_t ix = 0; ix < CAP_COUNT; ix++) {
+		if (_caps[ix] == cap) {
+			if (!_Set(_capStates[ix], enabled ? GL_TRUE : GL_FALSE)) {
+				return;
+			}
+			break;
+		}
+	}
+	if (enabled) {
+		glEnable(cap);
+	} else {
+		glDisable(cap);
+	}
+}
+
+void GLStateCache::DepthFunc(GLenum func) {
+	if (_Set(_depthFunc, func)) {
+		glDepthFunc(func);
+	}
+}
+
+void GLStateCache::DepthMask(bool write) {
+	if (_Set(_depthMask, write ? GL_TRUE : GL_FALSE)) {
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void GLStateCache::CullFace(GLenum face) {
+	if (_Set(_cullFace, face)) {
+		glCullFace(face);
+	}
+}
+
+void GLStateCache::BlendFunc(GLenum source, GLenum dest) {
+	if (_blendSource == source && _blendDest == dest) {
+		_stats.Skipped++;
+		return;
+	}
+	_blendSource = source;
+	_blendDest = dest;
+	_stats.Issued++;
+	glBlendFunc(source, dest);
+}
+
+void GLStateCache::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	if (_hasViewport && _viewport[0] == x && _viewport[1] == y && _viewport[2] == width && _viewport[3] == height) {
+		_stats.Skipped++;
+		return;
+	}
+	_viewport[0] = x;
+	_viewport[1] = y;
+	_viewport[2] = width;
+	_viewport[3] = height;
+	_hasViewport = true;
+	_stats.Issued++;
+	glViewport(x, y, width, height);
+}
+
+void GLStateCache::Invalidate() {
+	_program = UNKNOWN;
+	_vao = UNKNOWN;
+	_drawFramebuffer = UNKNOWN;
+	_readFramebuffer = UNKNOWN;
+	_textures.assign(_textures.size(), UNKNOWN);
+	_samplers.assign(_samplers.size(), UNKNOWN);
+	for (GLuint& state : _capStates) {
+		state = UNKNOWN;
+	}
+	_depthFunc = UNKNOWN;
+	_depthMask = UNKNOWN;
+	_cullFace = UNKNOWN;
+	_blendSource = UNKNOWN;
+	_blendDest = UNKNOWN;
+	_hasViewport = false;
+}
+
+void GLStateCache::ForgetProgram(GLuint program) {
+	if (_program == program) {
+		_program = UNKNOWN;
+	}
+}
+
+void GLStateCache::ForgetVertexArray(GLuint vao) {
+	if (_vao == vao) {
+		_vao = UNKNOWN;
+	}
+}
+
+void GLStateCache::ForgetFramebuffer(GLuint fbo) {
+	if (_drawFramebuffer == fbo) {
+		_drawFramebuffer = UNKNOWN;
+	}
+	if (_readFramebuffer == fbo) {
+		_readFramebuffer = UNKNOWN;
+	}
+}
+
+void GLStateCache::ForgetTexture(GLuint texture) {
+	for (GLuint& bound : _textures) {
+		if (bound == texture) {
+			bound = UNKNOWN;
+		}
+	}
+}
+
+void GLStateCache::EndFrame() {
+	_frameStats = _stats;
+	_stats = Stats();
+}
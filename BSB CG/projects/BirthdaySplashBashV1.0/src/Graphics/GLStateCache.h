@@ -0,0 +1,116 @@
+#pragma once
+#include <glad/glad.h>
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// Keeps a shadow copy of the OpenGL state that we change most often, and skips any call that would set
+/// something to the value it already has. Everything that binds programs, VAOs, framebuffers or textures
+/// should go through here, otherwise the cache falls out of sync with the real state. Code that changes
+/// that state directly must call Invalidate afterwards.
+///
+/// Everything starts out as unknown, so the first call for each piece of state is always issued
+/// </summary>
+class GLStateCache
+{
+public:
+	/// <summary>
+	/// Counts of state changes that were sent to the driver, and that were skipped since they wouldn't have
+	/// changed anything
+	/// </summary>
+	struct Stats {
+		size_t Issued  = 0;
+		size_t Skipped = 0;
+	};
+
+	static void UseProgram(GLuint program);
+	static void BindVertexArray(GLuint vao);
+	/// <summary>
+	/// Binds a framebuffer, GL_FRAMEBUFFER binds both the draw and read framebuffers
+	/// </summary>
+	static void BindFramebuffer(GLenum target, GLuint fbo);
+	/// <summary>
+	/// Binds a texture to a texture unit with glBindTextureUnit, 0 unbinds every target on the unit
+	/// </summary>
+	static void BindTextureUnit(GLuint unit, GLuint texture);
+	/// <summary>
+	/// Binds a run of textures to the units starting at first with a single glBindTextures call, which is skipped
+	/// if every unit already has its texture bound
+	/// </summary>
+	static void BindTextures(GLuint first, GLsizei count, const GLuint* textures);
+	static void BindSampler(GLuint unit, GLuint sampler);
+
+	/// <summary>
+	/// Enables or disables one of GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST or GL_STENCIL_TEST.
+	/// Other capabilities aren't tracked, and are always passed on
+	/// </summary>
+	static void SetEnabled(GLenum cap, bool enabled);
+	/// <summary>
+	/// Returns whether a capability is enabled, only asking the GL if it isn't tracked or its state is unknown
+	/// </summary>
+	static bool IsEnabled(GLenum cap);
+	static void DepthFunc(GLenum func);
+	static void DepthMask(bool write);
+	static void CullFace(GLenum face);
+	static void BlendFunc(GLenum source, GLenum dest);
+	static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+	/// <summary>
+	/// Forgets all of the cached state, so that the next call for each piece of state is issued
+	/// </summary>
+	static void Invalidate();
+	/// <summary>
+	/// Forgets any binding of an object that is being deleted. GL reuses names, so without this a new object
+	/// that gets the same name could have its first bind skipped
+	/// </summary>
+	static void ForgetProgram(GLuint program);
+	static void ForgetVertexArray(GLuint vao);
+	static void ForgetFramebuffer(GLuint fbo);
+	static void ForgetTexture(GLuint texture);
+
+	/// <summary>
+	/// Ends a frame, the counts for the frame are kept for GetFrameStats and the counters are reset
+	/// </summary>
+	static void EndFrame();
+	/// <summary>
+	/// Gets the counts for the last full frame
+	/// </summary>
+	static const Stats& GetFrameStats() { return _frameStats; }
+
+protected:
+	GLStateCache() = default;
+
+	// Stands in for state that we haven't set yet, or that has been invalidated
+	static constexpr GLuint UNKNOWN = 0xFFFFFFFF;
+
+	static constexpr size_t CAP_COUNT = 5;
+	static const GLenum _caps[CAP_COUNT];
+
+	static GLuint _program;
+	static GLuint _vao;
+	static GLuint _drawFramebuffer;
+	static GLuint _readFramebuffer;
+	static std::vector<GLuint> _textures;
+	static std::vector<GLuint> _samplers;
+	// UNKNOWN, GL_FALSE or GL_TRUE for each of _caps
+	static GLuint _capStates[CAP_COUNT];
+	static GLuint _depthFunc;
+	static GLuint _depthMask;
+	static GLuint _cullFace;
+	static GLuint _blendSource;
+	static GLuint _blendDest;
+	static GLint  _viewport[4];
+	static bool   _hasViewport;
+
+	static Stats _stats;
+	static Stats _frameStats;
+
+	/// <summary>
+	/// Updates a cached value, returns true if it changed and the call needs to be issued
+	/// </summary>
+	static bool _Set(GLuint& cached, GLuint value);
+	/// <summary>
+	/// Gets the cached value for a texture unit, growing the list to fit it
+	/// </summary>
+	static GLuint& _GetUnit(std::vector<GLuint>& units, GLuint unit);
+};
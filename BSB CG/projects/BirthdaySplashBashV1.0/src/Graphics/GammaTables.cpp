@@ -0,0 +1,20 @@
+#include "GammaTables.h"
+
+#include <cmath>
+
+GammaTables::GammaTables() {
+	for (int ix = 0; ix < 256; ix++) {
+		const float value = ix / 255.0f;
+		ToLinear[ix] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+	for (int ix = 0; ix < LINEAR_TO_SRGB_SIZE; ix++) {
+		const float value = ix / (float)(LINEAR_TO_SRGB_SIZE - 1);
+		const float srgb  = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		ToSrgb[ix] = (uint8_t)std::lround(std::clamp(srgb, 0.0f, 1.0f) * 255.0f);
+	}
+}
+
+const GammaTables& GammaTables::Get() {
+	static GammaTables tables;
+	return tables;
+}
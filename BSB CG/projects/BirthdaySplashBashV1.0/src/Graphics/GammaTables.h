@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+
+/// <summary>
+/// Lookup tables for converting 8 bit sRGB values to linear floats and back, shared by the CPU side filters
+/// (MipGenerator and EnvironmentPrefilter). The tables are built the first time they are needed
+/// </summary>
+class GammaTables
+{
+public:
+	// The size of the table used to convert linear values back to sRGB, large enough that every 8 bit value is reachable
+	static constexpr int LINEAR_TO_SRGB_SIZE = 4096;
+
+	float   ToLinear[256];
+	uint8_t ToSrgb[LINEAR_TO_SRGB_SIZE];
+
+	/// <summary>
+	/// Gets the tables, building them on the first call
+	/// </summary>
+	static const GammaTables& Get();
+
+	/// <summary>
+	/// Converts a linear value to an 8 bit sRGB value, clamping it to [0, 1] first
+	/// </summary>
+	uint8_t LinearToSrgb(float value) const {
+		return ToSrgb[(int)(std::clamp(value, 0.0f, 1.0f) * (LINEAR_TO_SRGB_SIZE - 1) + 0.5f)];
+	}
+
+protected:
+	GammaTables();
+};
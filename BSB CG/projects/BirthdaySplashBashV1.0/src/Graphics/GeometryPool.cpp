@@ -0,0 +1,236 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+
+#include "Logging.h"
+#include "GLStateCache.h"
+
+std::vector<GeometryPool::sptr> GeometryPool::_pools;
+bool GeometryPool::_enabled = true;
+
+GeometryAllocation::GeometryAllocation(const std::weak_ptr<GeometryPool>& pool, bool isIndices, uint32_t first, uint32_t count) :
+	_pool(pool),
+	_isIndices(isIndices),
+	_first(first),
+	_count(count)
+{ }
+
+GeometryAllocation::~GeometryAllocation() {
+	// If the pool is already gone, so are its buffers
+	GeometryPool::sptr pool = _pool.lock();
+	if (pool != nullptr) {
+		pool->_Free(this);
+	}
+}
+
+GeometryPool::GeometryPool(const std::vector<BufferAttribute>& decl, GLenum indexType) :
+	_decl(decl),
+	_indexType(indexType),
+	_vertices(Arena()),
+	_indices(Arena()),
+	_vao(0),
+	_drawIdBuffer(0)
+{
+	LOG_ASSERT(!decl.empty(), "Geometry pools need at least one vertex attribute!");
+	LOG_ASSERT(indexType == GL_UNSIGNED_SHORT || indexType == GL_UNSIGNED_INT, "Geometry pools only support 16 and 32 bit indices!");
+
+	_vertices.ElementSize = (uint32_t)decl[0].Stride;
+	_vertices.MinCapacity = MIN_VERTEX_CAPACITY;
+	_indices.ElementSize  = indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+	_indices.MinCapacity  = MIN_INDEX_CAPACITY;
+
+	// Every attribute reads from binding 0, so swapping out the vertex buffer is a single call
+	glCreateVertexArrays(1, &_vao);
+	for (const BufferAttribute& attrib : _decl) {
+		LOG_ASSERT(attrib.Stride == decl[0].Stride, "Pooled vertices must be interleaved in a single buffer!");
+		glEnableVertexArrayAttrib(_vao, attrib.Slot);
+		glVertexArrayAttribFormat(_vao, attrib.Slot, attrib.Size, attrib.Type, attrib.Normalized, (GLuint)attrib.Offset);
+		glVertexArrayAttribBinding(_vao, attrib.Slot, 0);
+	}
+}
+
+GeometryPool::~GeometryPool() {
+	if (_vao != 0) {
+		GLStateCache::ForgetVertexArray(_vao);
+		glDeleteVertexArrays(1, &_vao);
+		_vao = 0;
+	}
+	for (Arena* arena : { &_vertices, &_indices }) {
+		if (arena->Buffer != 0) {
+			glDeleteBuffers(1, &arena->Buffer);
+			arena->Buffer = 0;
+		}
+	}
+}
+
+GeometryPool::sptr GeometryPool::Get(const std::vector<BufferAttribute>& decl, GLenum indexType) {
+	for (const sptr& pool : _pools) {
+		if (pool->Matches(decl, indexType)) {
+			return pool;
+		}
+	}
+	sptr result = std::make_shared<GeometryPool>(decl, indexType);
+	_pools.push_back(result);
+	LOG_INFO("Created a geometry pool for {} byte vertices with {} bit indices", result->GetStride(), result->GetIndexSize() * 8);
+	return result;
+}
+
+void GeometryPool::CompactAll() {
+	for (auto it = _pools.begin(); it != _pools.end(); ) {
+		// Nothing but the list holds on to empty pools, so we can let them go entirely
+		if ((*it)->_vertices.Allocations.empty() && (*it)->_indices.Allocations.empty() && it->use_count() == 1) {
+			it = _pools.erase(it);
+		} else {
+			(*it)->Compact();
+			++it;
+		}
+	}
+}
+
+void GeometryPool::Clear() {
+	_pools.clear();
+}
+
+bool GeometryPool::Matches(const std::vector<BufferAttribute>& decl, GLenum indexType) const {
+	if (indexType != _indexType || decl.size() != _decl.size()) {
+		return false;
+	}
+	for (size_t ix = 0; ix < decl.size(); ix++) {
+		const BufferAttribute& a = decl[ix];
+		const BufferAttribute& b = _decl[ix];
+		if (a.Slot != b.Slot || a.Size != b.Size || a.Type != b.Type || a.Normalized != b.Normalized ||
+			a.Stride != b.Stride || a.Offset != b.Offset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+GeometryAllocation::sptr GeometryPool::AllocateVertices(const void* data, uint32_t count) {
+	GeometryAllocation::sptr result = _Allocate(_vertices, false, count);
+	glNamedBufferSubData(_vertices.Buffer, (GLintptr)result->_first * _vertices.ElementSize, (GLsizeiptr)count * _vertices.ElementSize, data);
+	return result;
+}
+
+GeometryAllocation::sptr GeometryPool::AllocateIndices(const uint32_t* data, uint32_t count) {
+	GeometryAllocation::sptr result = _Allocate(_indices, true, count);
+	const GLintptr offset = (GLintptr)result->_first * _indices.ElementSize;
+	if (_indexType == GL_UNSIGNED_SHORT) {
+		std::vector<uint16_t> narrowed(data, data + count);
+		glNamedBufferSubData(_indices.Buffer, offset, (GLsizeiptr)count * sizeof(uint16_t), narrowed.data());
+	} else {
+		glNamedBufferSubData(_indices.Buffer, offset, (GLsizeiptr)count * sizeof(uint32_t), data);
+	}
+	return result;
+}
+
+void GeometryPool::Compact() {
+	for (Arena* arena : { &_vertices, &_indices }) {
+		if (arena->Buffer == 0) {
+			continue;
+		}
+		const uint32_t end = arena->Allocations.empty() ? 0 : arena->Allocations.back()->_first + arena->Allocations.back()->_count;
+		// Leave some room to grow, so that loading the next scene doesn't immediately grow the buffer again
+		const uint32_t capacity = std::max(arena->Used + arena->Used / 2, arena->MinCapacity);
+		if (end > arena->Used || arena->Capacity > capacity * 2) {
+			LOG_INFO("Compacting a geometry pool from {} to {} elements ({} in use)", arena->Capacity, capacity, arena->Used);
+			_Reallocate(*arena, capacity, true);
+		}
+	}
+}
+
+void GeometryPool::Bind() const {
+	GLStateCache::BindVertexArray(_vao);
+}
+
+void GeometryPool::AttachDrawIds(const VertexBuffer::sptr& drawIds) {
+	if (_drawIdBuffer == 0) {
+		glEnableVertexArrayAttrib(_vao, VertexArrayObject::DRAW_ID_SLOT);
+		glVertexArrayAttribIFormat(_vao, VertexArrayObject::DRAW_ID_SLOT, 1, GL_UNSIGNED_INT, 0);
+		glVertexArrayAttribBinding(_vao, VertexArrayObject::DRAW_ID_SLOT, VertexArrayObject::DRAW_ID_BINDING);
+		glVertexArrayBindingDivisor(_vao, VertexArrayObject::DRAW_ID_BINDING, 1);
+	}
+	if (_drawIdBuffer != drawIds->GetHandle()) {
+		_drawIdBuffer = drawIds->GetHandle();
+		glVertexArrayVertexBuffer(_vao, VertexArrayObject::DRAW_ID_BINDING, _drawIdBuffer, 0, sizeof(uint32_t));
+	}
+}
+
+void GeometryPool::MultiDraw(size_t offset, GLsizei count) const {
+	Bind();
+	glMultiDrawElementsIndirect(GL_TRIANGLES, _indexType, (const void*)offset, count, 0);
+}
+
+GeometryAllocation::sptr GeometryPool::_Allocate(Arena& arena, bool isIndices, uint32_t count) {
+	// First fit, walking the gaps between the live ranges
+	uint32_t first = 0;
+	size_t insertAt = 0;
+	for (; insertAt < arena.Allocations.size(); insertAt++) {
+		const GeometryAllocation* next = arena.Allocations[insertAt];
+		if (next->_first - first >= count) {
+			break;
+		}
+		first = next->_first + next->_count;
+	}
+
+	// Nothing fit, grow the buffer. Ranges keep their place, so only the space past the last one is new
+	if (insertAt == arena.Allocations.size() && arena.Capacity - first < count) {
+		const uint64_t capacity = std::max({ (uint64_t)first + count, (uint64_t)arena.Capacity * 2, (uint64_t)arena.MinCapacity });
+		LOG_ASSERT(capacity <= UINT32_MAX, "Geometry pool is out of space!");
+		_Reallocate(arena, (uint32_t)capacity, false);
+	}
+
+	GeometryAllocation::sptr result = std::make_shared<GeometryAllocation>(weak_from_this(), isIndices, first, count);
+	arena.Allocations.insert(arena.Allocations.begin() + insertAt, result.get());
+	arena.Used += count;
+	return result;
+}
+
+void GeometryPool::_Free(GeometryAllocation* allocation) {
+	Arena& arena = allocation->_isIndices ? _indices : _vertices;
+	auto it = std::lower_bound(arena.Allocations.begin(), arena.Allocations.end(), allocation,
+		[](const GeometryAllocation* a, const GeometryAllocation* b) { return a->_first < b->_first; });
+	// Empty ranges can share their first element with a neighbour, so we search from the first candidate
+	it = std::find(it, arena.Allocations.end(), allocation);
+	if (it != arena.Allocations.end()) {
+		arena.Allocations.erase(it);
+		arena.Used -= allocation->_count;
+	}
+}
+
+void GeometryPool::_Reallocate(Arena& arena, uint32_t capacity, bool packed) {
+	GLuint buffer = 0;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, (GLsizeiptr)capacity * arena.ElementSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	if (arena.Buffer != 0) {
+		const GLsizeiptr elementSize = arena.ElementSize;
+		if (packed) {
+			uint32_t next = 0;
+			for (GeometryAllocation* allocation : arena.Allocations) {
+				if (allocation->_count > 0) {
+					glCopyNamedBufferSubData(arena.Buffer, buffer, allocation->_first * elementSize, next * elementSize, allocation->_count * elementSize);
+				}
+				allocation->_first = next;
+				next += allocation->_count;
+			}
+		} else if (!arena.Allocations.empty()) {
+			const GeometryAllocation* last = arena.Allocations.back();
+			const GLsizeiptr end = ((GLsizeiptr)last->_first + last->_count) * elementSize;
+			if (end > 0) {
+				glCopyNamedBufferSubData(arena.Buffer, buffer, 0, 0, end);
+			}
+		}
+		// The GL keeps the old storage alive until the draws that were already submitted are done with it
+		glDeleteBuffers(1, &arena.Buffer);
+	}
+
+	arena.Buffer = buffer;
+	arena.Capacity = capacity;
+	_AttachBuffers();
+}
+
+void GeometryPool::_AttachBuffers() {
+	glVertexArrayVertexBuffer(_vao, 0, _vertices.Buffer, 0, (GLsizei)_vertices.ElementSize);
+	glVertexArrayElementBuffer(_vao, _indices.Buffer);
+}
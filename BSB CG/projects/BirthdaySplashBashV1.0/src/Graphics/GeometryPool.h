@@ -0,0 +1,201 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include "VertexArrayObject.h"
+
+class GeometryPool;
+
+/// <summary>
+/// A range of vertices or indices inside a GeometryPool. The range is handed back to the pool when the last
+/// reference to the allocation goes away, and may move when the pool grows or is compacted, so draws should read
+/// GetFirst each time instead of keeping it around
+/// </summary>
+class GeometryAllocation final
+{
+public:
+	typedef std::shared_ptr<GeometryAllocation> sptr;
+
+	GeometryAllocation(const std::weak_ptr<GeometryPool>& pool, bool isIndices, uint32_t first, uint32_t count);
+	~GeometryAllocation();
+
+	GeometryAllocation(const GeometryAllocation& other) = delete;
+	GeometryAllocation(GeometryAllocation&& other) = delete;
+	GeometryAllocation& operator=(const GeometryAllocation& other) = delete;
+	GeometryAllocation& operator=(GeometryAllocation&& other) = delete;
+
+	/// <summary>
+	/// The index of the first vertex or index in the pool's buffer, and how many there are
+	/// </summary>
+	uint32_t GetFirst() const { return _first; }
+	uint32_t GetCount() const { return _count; }
+
+protected:
+	friend class GeometryPool;
+
+	std::weak_ptr<GeometryPool> _pool;
+	bool     _isIndices;
+	uint32_t _first;
+	uint32_t _count;
+};
+
+/// <summary>
+/// Shares one vertex buffer, one index buffer and one VAO between every mesh with the same vertex format and index
+/// type, so that consecutive draws of different meshes don't need to switch VAOs and can be submitted together with
+/// a single multi draw (see RenderSystem).
+///
+/// Meshes get a range in each buffer, found first fit in the gaps between the live ranges. Indices stay relative to
+/// the mesh's own vertices and are drawn with the mesh's first vertex as the base vertex, so 16 bit indices can be
+/// used for any mesh with up to 65536 vertices no matter where it lands in the pool. The buffers are immutable
+/// storage, so when one runs out of space it's replaced with a larger one and the live ranges are copied over on the
+/// GPU. Freed ranges leave holes behind, Compact closes them up once a scene has been unloaded
+/// </summary>
+class GeometryPool final : public std::enable_shared_from_this<GeometryPool>
+{
+public:
+	typedef std::shared_ptr<GeometryPool> sptr;
+
+	GeometryPool(const GeometryPool& other) = delete;
+	GeometryPool(GeometryPool&& other) = delete;
+	GeometryPool& operator=(const GeometryPool& other) = delete;
+	GeometryPool& operator=(GeometryPool&& other) = delete;
+
+	/// <summary>
+	/// The layout of glMultiDrawElementsIndirect's commands
+	/// </summary>
+	struct DrawCommand {
+		GLuint Count;
+		GLuint InstanceCount;
+		GLuint FirstIndex;
+		GLint  BaseVertex;
+		GLuint BaseInstance;
+	};
+
+	/// <summary>
+	/// The smallest buffers a pool will allocate, in vertices and indices
+	/// </summary>
+	static constexpr uint32_t MIN_VERTEX_CAPACITY = 1 << 16;
+	static constexpr uint32_t MIN_INDEX_CAPACITY  = 1 << 18;
+
+	/// <summary>
+	/// Gets the pool for a vertex format and index type, creating it if this is the first mesh to use them
+	/// </summary>
+	/// <param name="decl">The attributes of one interleaved vertex buffer</param>
+	/// <param name="indexType">GL_UNSIGNED_SHORT or GL_UNSIGNED_INT</param>
+	static sptr Get(const std::vector<BufferAttribute>& decl, GLenum indexType);
+	/// <summary>
+	/// Gets the index type a mesh should be pooled with, 16 bits unless it has too many vertices
+	/// </summary>
+	static GLenum GetIndexType(size_t vertexCount) { return vertexCount <= (1 << 16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+	/// <summary>
+	/// Compacts every pool, call this after unloading assets
+	/// </summary>
+	static void CompactAll();
+	/// <summary>
+	/// Drops the pools, any meshes still using them keep them alive. Must be called before the GL context is destroyed
+	/// </summary>
+	static void Clear();
+	static const std::vector<sptr>& GetPools() { return _pools; }
+
+	/// <summary>
+	/// Whether mesh baking puts new meshes in pools, true by default. Meshes that are already pooled stay pooled
+	/// </summary>
+	static void SetEnabled(bool enabled) { _enabled = enabled; }
+	static bool IsEnabled() { return _enabled; }
+
+	/// <summary>
+	/// Creates an empty pool, use Get instead so that meshes of the same format end up together
+	/// </summary>
+	GeometryPool(const std::vector<BufferAttribute>& decl, GLenum indexType);
+	~GeometryPool();
+
+	/// <summary>
+	/// Copies vertices into the pool
+	/// </summary>
+	/// <param name="data">A pointer to the first vertex, laid out as described by the pool's format</param>
+	/// <param name="count">The number of vertices</param>
+	GeometryAllocation::sptr AllocateVertices(const void* data, uint32_t count);
+	/// <summary>
+	/// Copies indices into the pool, narrowing them if the pool uses 16 bit indices
+	/// </summary>
+	/// <param name="data">A pointer to the first index, relative to the mesh's first vertex</param>
+	/// <param name="count">The number of indices</param>
+	GeometryAllocation::sptr AllocateIndices(const uint32_t* data, uint32_t count);
+
+	/// <summary>
+	/// Moves the live ranges to the start of new buffers sized to fit them, if freed ranges have left enough holes
+	/// or unused space behind. Draws that were already submitted keep reading the old buffers
+	/// </summary>
+	void Compact();
+
+	/// <summary>
+	/// Binds the pool's VAO, which has both buffers attached
+	/// </summary>
+	void Bind() const;
+	/// <summary>
+	/// Attaches a draw id buffer to the VAO, see VertexArrayObject::RenderInstanced
+	/// </summary>
+	void AttachDrawIds(const VertexBuffer::sptr& drawIds);
+	/// <summary>
+	/// Draws a list of commands from the buffer bound to GL_DRAW_INDIRECT_BUFFER with one call
+	/// </summary>
+	/// <param name="offset">The byte offset of the first command in the indirect buffer</param>
+	/// <param name="count">The number of commands to draw</param>
+	void MultiDraw(size_t offset, GLsizei count) const;
+
+	/// <summary>
+	/// Returns true if this pool holds vertices with the given attributes and indices of the given type
+	/// </summary>
+	bool Matches(const std::vector<BufferAttribute>& decl, GLenum indexType) const;
+
+	GLenum   GetIndexType() const { return _indexType; }
+	uint32_t GetIndexSize() const { return _indices.ElementSize; }
+	GLsizei  GetStride() const { return (GLsizei)_vertices.ElementSize; }
+	uint32_t GetVertexCapacity() const { return _vertices.Capacity; }
+	uint32_t GetVerticesUsed() const { return _vertices.Used; }
+	uint32_t GetIndexCapacity() const { return _indices.Capacity; }
+	uint32_t GetIndicesUsed() const { return _indices.Used; }
+	GLuint   GetHandle() const { return _vao; }
+
+protected:
+	friend class GeometryAllocation;
+
+	/// <summary>
+	/// One of the pool's buffers, and the ranges that have been handed out from it
+	/// </summary>
+	struct Arena {
+		GLuint   Buffer      = 0;
+		uint32_t ElementSize = 0;
+		uint32_t MinCapacity = 0;
+		uint32_t Capacity    = 0;
+		// The number of elements in live ranges
+		uint32_t Used        = 0;
+		// The live ranges, sorted by their first element
+		std::vector<GeometryAllocation*> Allocations;
+	};
+
+	std::vector<BufferAttribute> _decl;
+	GLenum _indexType;
+	Arena  _vertices;
+	Arena  _indices;
+	GLuint _vao;
+	// The draw id buffer attached to DRAW_ID_BINDING, 0 until the first instanced draw
+	GLuint _drawIdBuffer;
+
+	static std::vector<sptr> _pools;
+	static bool _enabled;
+
+	/// <summary>
+	/// Finds room for count elements, growing the buffer if there isn't any, and adds the range to the arena
+	/// </summary>
+	GeometryAllocation::sptr _Allocate(Arena& arena, bool isIndices, uint32_t count);
+	void _Free(GeometryAllocation* allocation);
+	/// <summary>
+	/// Replaces an arena's buffer with one of the given capacity, copying the live ranges over. Packed moves the
+	/// ranges to the start of the new buffer, otherwise they keep their place
+	/// </summary>
+	void _Reallocate(Arena& arena, uint32_t capacity, bool packed);
+	void _AttachBuffers();
+};
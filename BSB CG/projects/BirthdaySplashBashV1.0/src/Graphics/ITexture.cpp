@@ -1,9 +1,11 @@
 #include "ITexture.h"
+#include "GLStateCache.h"
 
 #include "Logging.h"
 
 ITexture::Limits ITexture::_limits = ITexture::Limits();
 bool ITexture::_isStaticInit = false;
+std::unordered_map<GLint, bool> ITexture::_compressedFormatSupport;
 
 ITexture::ITexture()
 	: _handle(0)
@@ -14,6 +16,7 @@ ITexture::ITexture()
 		glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &_limits.MAX_TEXTURE_UNITS);
 		glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &_limits.MAX_3D_TEXTURE_SIZE);
 		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &_limits.MAX_TEXTURE_IMAGE_UNITS);
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &_limits.MAX_ARRAY_TEXTURE_LAYERS);
 		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &_limits.MAX_ANISOTROPY);
 
 		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
@@ -23,29 +26,45 @@ ITexture::ITexture()
 		LOG_INFO("\tUnits:      {}", _limits.MAX_TEXTURE_UNITS);
 		LOG_INFO("\t3D Size:    {}", _limits.MAX_3D_TEXTURE_SIZE);
 		LOG_INFO("\tUnits (FS): {}", _limits.MAX_TEXTURE_IMAGE_UNITS);
+		LOG_INFO("\tLayers:     {}", _limits.MAX_ARRAY_TEXTURE_LAYERS);
 		LOG_INFO("\tMax Aniso.: {}", _limits.MAX_ANISOTROPY);
+
+		// S3TC in particular is an extension, so we check which of the compressed formats we can actually use
+		for (InternalFormat format : { InternalFormat::BC1, InternalFormat::BC3, InternalFormat::BC5, InternalFormat::BC7 }) {
+			GLint supported = GL_FALSE;
+			glGetInternalformativ(GL_TEXTURE_2D, *format, GL_INTERNALFORMAT_SUPPORTED, 1, &supported);
+			_compressedFormatSupport[*format] = supported == GL_TRUE;
+			LOG_INFO("\t{}:        {}", ~format, supported == GL_TRUE ? "Supported" : "Not supported");
+		}
 		
 		_isStaticInit = true;
 	}
 }
 
+bool ITexture::IsFormatSupported(InternalFormat format) {
+	if (!IsCompressedFormat(format)) {
+		return true;
+	}
+	auto it = _compressedFormatSupport.find(*format);
+	return it != _compressedFormatSupport.end() && it->second;
+}
+
 ITexture::~ITexture() {
 	if (glIsTexture(_handle)) {
+		GLStateCache::ForgetTexture(_handle);
 		glDeleteTextures(1, &_handle);
 	}
 }
 
 void ITexture::Bind(int slot) const {
 	if (_handle != 0) {
-		//glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTextureUnit(slot, _handle);
+		GLStateCache::BindTextureUnit(slot, _handle);
 	}
 }
 
 void ITexture::Unbind(int slot)
 {
-	//glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTextureUnit(slot, 0);
+	GLStateCache::BindTextureUnit(slot, 0);
 }
 
 
@@ -1,9 +1,12 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include <unordered_map>
 #include <glad/glad.h>
 #include <GLM/glm.hpp>
 
+#include "TextureEnums.h"
+
 class ITexture
 {
 public:
@@ -18,6 +21,7 @@ public:
 		int   MAX_TEXTURE_UNITS;
 		int   MAX_3D_TEXTURE_SIZE;
 		int   MAX_TEXTURE_IMAGE_UNITS;
+		int   MAX_ARRAY_TEXTURE_LAYERS;
 		float MAX_ANISOTROPY;
 	};
 
@@ -26,6 +30,12 @@ public:
 	/// </summary>
 	/// <returns>A structure containing all the texture limits of the GPU</returns>
 	static const Limits& GetLimits() { return _limits; }
+	/// <summary>
+	/// Checks whether the GPU can sample textures in the given format. Only the compressed formats can be
+	/// missing, every other format we use is required by OpenGL. This is filled in when the first texture is
+	/// created, after which it is safe to call from any thread
+	/// </summary>
+	static bool IsFormatSupported(InternalFormat format);
 	
 	/// <summary>
 	/// Unbinds a texture from the given slot
@@ -57,5 +67,6 @@ protected:
 	GLuint _handle;
 
 	static Limits _limits;
+	static std::unordered_map<GLint, bool> _compressedFormatSupport;
 	static bool _isStaticInit;
 };
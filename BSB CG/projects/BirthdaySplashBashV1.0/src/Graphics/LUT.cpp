@@ -1,5 +1,52 @@
 #include "LUT.h"
-#pragma warning(disable : 4996)
+#include "GLStateCache.h"
+#include "Logging.h"
+
+#include <cmath>
+#include <charconv>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/packing.hpp>
+
+#include "Utilities/FileUtils.h"
+#include "Utilities/MappedFile.h"
+
+namespace {
+	const char LUT_CACHE_MAGIC[4] = { 'B', 'L', 'U', 'T' };
+
+	// The largest table size allowed by the .cube spec
+	constexpr uint32_t MAX_LUT_SIZE = 256;
+
+	inline const char* SkipSpaces(const char* it, const char* end) {
+		while (it < end && (*it == ' ' || *it == '\t' || *it == '\r')) {
+			it++;
+		}
+		return it;
+	}
+
+	inline bool StartsWith(const char* it, const char* end, const char* keyword) {
+		const size_t length = strlen(keyword);
+		return (size_t)(end - it) >= length && memcmp(it, keyword, length) == 0;
+	}
+
+	// Parses up to count floats separated by spaces, returns how many were read
+	inline int ParseFloats(const char* it, const char* end, float* values, int count) {
+		int read = 0;
+		for (; read < count; read++) {
+			it = SkipSpaces(it, end);
+			// from_chars does not accept a leading plus sign, so we skip it ourselves
+			if (it < end && *it == '+') {
+				it++;
+			}
+			std::from_chars_result result = std::from_chars(it, end, values[read]);
+			if (result.ec != std::errc()) {
+				break;
+			}
+			it = result.ptr;
+		}
+		return read;
+	}
+}
+
 LUT3D::LUT3D()
 {
 }
@@ -11,57 +58,218 @@ LUT3D::LUT3D(std::string path)
 
 void LUT3D::loadFromFile(std::string path)
 {
-	std::string filePath = path;
-	std::ifstream LUTstream;
-	LUTstream.open(filePath);
+	loadData(readFile(path));
+}
+
+std::string LUT3D::getCachePath(const std::string& path)
+{
+	return path + ".blut";
+}
 
-	while (!LUTstream.eof())
-	{
-		std::string _line;
-		std::getline(LUTstream, _line);
+LUT3DData::sptr LUT3D::readFile(const std::string& path)
+{
+	LUT3DData::sptr result = _readCache(path);
+	if (result != nullptr) {
+		return result;
+	}
+	result = parseFile(path);
+	if (result != nullptr) {
+		_writeCache(path, *result);
+	}
+	return result;
+}
 
-		if (_line.empty())
+LUT3DData::sptr LUT3D::parseFile(const std::string& path)
+{
+	MappedFile file(path);
+	if (!file.IsOpen()) {
+		LOG_WARN("Failed to open LUT \"{}\"", path);
+		return nullptr;
+	}
+
+	LUT3DData::sptr result = std::make_shared<LUT3DData>();
+	std::vector<glm::vec3> entries;
+	const char* it  = reinterpret_cast<const char*>(file.GetData());
+	const char* end = it + file.GetSize();
+	while (it < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(it, '\n', end - it));
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		const char* line = SkipSpaces(it, lineEnd);
+		it = lineEnd + 1;
+
+		if (line == lineEnd || *line == '#') {
 			continue;
+		}
+		float values[3];
+		if ((*line >= '0' && *line <= '9') || *line == '-' || *line == '+' || *line == '.') {
+			if (ParseFloats(line, lineEnd, values, 3) == 3) {
+				entries.emplace_back(values[0], values[1], values[2]);
+			}
+		} else if (StartsWith(line, lineEnd, "LUT_3D_SIZE")) {
+			if (ParseFloats(line + 11, lineEnd, values, 1) == 1) {
+				result->Size = (uint32_t)values[0];
+			}
+		} else if (StartsWith(line, lineEnd, "DOMAIN_MIN")) {
+			if (ParseFloats(line + 10, lineEnd, values, 3) == 3) {
+				result->DomainMin = glm::vec3(values[0], values[1], values[2]);
+			}
+		} else if (StartsWith(line, lineEnd, "DOMAIN_MAX")) {
+			if (ParseFloats(line + 10, lineEnd, values, 3) == 3) {
+				result->DomainMax = glm::vec3(values[0], values[1], values[2]);
+			}
+		} else if (StartsWith(line, lineEnd, "LUT_1D_SIZE")) {
+			LOG_WARN("\"{}\" is a 1D LUT, only 3D LUTs are supported", path);
+			return nullptr;
+		}
+		// Anything else (TITLE, LUT_3D_INPUT_RANGE, etc) doesn't affect how we use the table
+	}
 
-		glm::vec3 lineData;
-		if (sscanf(_line.c_str(), "%f %f %f", &lineData.x, &lineData.y, &lineData.z) == 3)
-			data.push_back(lineData);
+	// Older files without a header are assumed to be a full cube
+	if (result->Size == 0) {
+		result->Size = (uint32_t)std::lround(std::cbrt((double)entries.size()));
+	}
+	if (result->Size < 2 || result->Size > MAX_LUT_SIZE) {
+		LOG_WARN("LUT \"{}\" has an invalid size of {}, ignoring", path, result->Size);
+		return nullptr;
+	}
+	const size_t count = (size_t)result->Size * result->Size * result->Size;
+	if (entries.size() != count) {
+		LOG_WARN("LUT \"{}\" has {} entries, expected {}, ignoring", path, entries.size(), count);
+		return nullptr;
+	}
+	if (glm::any(glm::lessThanEqual(result->DomainMax, result->DomainMin))) {
+		LOG_WARN("LUT \"{}\" has an empty domain, using [0, 1]", path);
+		result->DomainMin = glm::vec3(0.0f);
+		result->DomainMax = glm::vec3(1.0f);
 	}
 
-	glEnable(GL_TEXTURE_3D);
+	// 10 bits per channel is plenty for grading tables, unless the table goes outside of [0, 1]
+	bool inRange = true;
+	for (const glm::vec3& entry : entries) {
+		inRange &= glm::all(glm::greaterThanEqual(entry, glm::vec3(0.0f))) && glm::all(glm::lessThanEqual(entry, glm::vec3(1.0f)));
+	}
+	if (inRange) {
+		result->Format = GL_RGB10_A2;
+		result->Texels.resize(count * sizeof(uint32_t));
+		uint32_t* texels = reinterpret_cast<uint32_t*>(result->Texels.data());
+		for (size_t ix = 0; ix < count; ix++) {
+			texels[ix] = glm::packUnorm3x10_1x2(glm::vec4(entries[ix], 1.0f));
+		}
+	} else {
+		result->Format = GL_RGBA16F;
+		result->Texels.resize(count * sizeof(uint64_t));
+		uint64_t* texels = reinterpret_cast<uint64_t*>(result->Texels.data());
+		for (size_t ix = 0; ix < count; ix++) {
+			texels[ix] = glm::packHalf4x16(glm::vec4(entries[ix], 1.0f));
+		}
+	}
+	return result;
+}
 
-	glGenTextures(1, &_handle);
-	bind();
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+LUT3DData::sptr LUT3D::_readCache(const std::string& path)
+{
+	const std::string cachePath = getCachePath(path);
+	MappedFile cache;
+	if (!cache.Open(cachePath) || cache.GetSize() < sizeof(CacheHeader)) {
+		return nullptr;
+	}
+	CacheHeader header;
+	memcpy(&header, cache.GetData(), sizeof(CacheHeader));
+	if (memcmp(header.Magic, LUT_CACHE_MAGIC, sizeof(LUT_CACHE_MAGIC)) != 0 || header.Version != CACHE_VERSION) {
+		LOG_WARN("LUT cache \"{}\" is from an older version, rebuilding", cachePath);
+		return nullptr;
+	}
+	const size_t texelSize = header.Format == GL_RGB10_A2 ? sizeof(uint32_t) : header.Format == GL_RGBA16F ? sizeof(uint64_t) : 0;
+	if (texelSize == 0 || header.Size < 2 || header.Size > MAX_LUT_SIZE ||
+		header.DataSize != (uint64_t)header.Size * header.Size * header.Size * texelSize ||
+		cache.GetSize() != sizeof(CacheHeader) + header.DataSize) {
+		LOG_WARN("LUT cache \"{}\" is truncated or corrupt, rebuilding", cachePath);
+		return nullptr;
+	}
 
-	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB, 64, 64, 64, 0, GL_RGB, GL_FLOAT, &data[0]);
-	unbind();
+	if (!FileUtils::IsSourceUnchanged(path, header.SourceSize, header.SourceHash)) {
+		return nullptr;
+	}
 
-	glDisable(GL_TEXTURE_3D);
+	LUT3DData::sptr result = std::make_shared<LUT3DData>();
+	result->Size      = header.Size;
+	result->Format    = header.Format;
+	result->DomainMin = glm::vec3(header.DomainMin[0], header.DomainMin[1], header.DomainMin[2]);
+	result->DomainMax = glm::vec3(header.DomainMax[0], header.DomainMax[1], header.DomainMax[2]);
+	result->Texels.assign(cache.GetData() + sizeof(CacheHeader), cache.GetData() + sizeof(CacheHeader) + header.DataSize);
+	return result;
+}
+
+bool LUT3D::_writeCache(const std::string& path, const LUT3DData& table)
+{
+	CacheHeader header = {};
+	memcpy(header.Magic, LUT_CACHE_MAGIC, sizeof(LUT_CACHE_MAGIC));
+	header.Version  = CACHE_VERSION;
+	header.Size     = table.Size;
+	header.Format   = table.Format;
+	header.DataSize = table.Texels.size();
+	for (int ix = 0; ix < 3; ix++) {
+		header.DomainMin[ix] = table.DomainMin[ix];
+		header.DomainMax[ix] = table.DomainMax[ix];
+	}
+	if (!FileUtils::FingerprintFile(path, header.SourceSize, header.SourceHash)) {
+		return false;
+	}
+
+	return FileUtils::WriteFileAtomic(getCachePath(path), {
+		{ &header, sizeof(CacheHeader) },
+		{ table.Texels.data(), table.Texels.size() }
+	});
+}
+
+void LUT3D::loadData(const LUT3DData::sptr& table)
+{
+	if (table == nullptr) {
+		return;
+	}
+	if (_handle != GL_NONE) {
+		GLStateCache::ForgetTexture(_handle);
+		glDeleteTextures(1, &_handle);
+	}
+	_size = table->Size;
+	_domainMin = table->DomainMin;
+	_domainMax = table->DomainMax;
+
+	glCreateTextures(GL_TEXTURE_3D, 1, &_handle);
+	glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// Colors outside of the domain should use the edge of the table, not wrap around to the other side
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	glTextureStorage3D(_handle, 1, table->Format, _size, _size, _size);
+	if (table->Format == GL_RGB10_A2) {
+		glTextureSubImage3D(_handle, 0, 0, 0, 0, _size, _size, _size, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, table->Texels.data());
+	} else {
+		glTextureSubImage3D(_handle, 0, 0, 0, 0, _size, _size, _size, GL_RGBA, GL_HALF_FLOAT, table->Texels.data());
+	}
 }
 
 void LUT3D::bind()
 {
-	glBindTexture(GL_TEXTURE_3D, _handle);
+	// Nothing changes the active texture unit, so this is the unit a plain glBindTexture would have used
+	bind(0);
 }
 
 void LUT3D::unbind()
 {
-	glBindTexture(GL_TEXTURE_3D, GL_NONE);
+	unbind(0);
 }
 
 void LUT3D::bind(int textureSlot)
 {
-	glActiveTexture(GL_TEXTURE0 + textureSlot);
-	bind();
+	GLStateCache::BindTextureUnit(textureSlot, _handle);
 }
 
 void LUT3D::unbind(int textureSlot)
 {
-	glActiveTexture(GL_TEXTURE0 + textureSlot);
-	unbind();
-}
\ No newline at end of file
+	GLStateCache::BindTextureUnit(textureSlot, GL_NONE);
+}
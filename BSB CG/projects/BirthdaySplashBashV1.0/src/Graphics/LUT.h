@@ -1,22 +1,79 @@
 #pragma once
 #include <vector>
+#include <memory>
 #include <fstream>
 #include <string>
+#include <cstdint>
 #include <glad/glad.h>
 #include "glm/common.hpp"
 
+// A 3D color table, packed and ready to upload. Tables whose values all fit in [0, 1] are packed as RGB10_A2
+// (4 bytes per entry), anything else (HDR grades) is packed as RGBA16F (8 bytes per entry)
+struct LUT3DData
+{
+	typedef std::shared_ptr<LUT3DData> sptr;
+
+	uint32_t  Size = 0;
+	// The range of input colors that the table covers, from the DOMAIN_MIN and DOMAIN_MAX keywords
+	glm::vec3 DomainMin = glm::vec3(0.0f);
+	glm::vec3 DomainMax = glm::vec3(1.0f);
+	// GL_RGB10_A2 or GL_RGBA16F
+	GLenum    Format = GL_RGB10_A2;
+	// Size^3 packed entries, with red changing fastest
+	std::vector<uint8_t> Texels;
+};
+
 class LUT3D
 {
 public:
+	typedef std::shared_ptr<LUT3D> sptr;
+
 	LUT3D();
 	LUT3D(std::string path);
 	void loadFromFile(std::string path);
+
+	// Loads a table from the binary cache next to a .cube file, parsing the .cube file and writing the cache if
+	// the cache is missing or out of date. Does not touch OpenGL, safe to call from worker threads
+	static LUT3DData::sptr readFile(const std::string& path);
+	// Parses a .cube file, including the LUT_3D_SIZE and DOMAIN_MIN/DOMAIN_MAX keywords
+	static LUT3DData::sptr parseFile(const std::string& path);
+	// Creates the 3D texture from a table returned by readFile or parseFile
+	void loadData(const LUT3DData::sptr& table);
+	// Binds to texture unit 0, through the GL state cache like the slotted overloads
 	void bind();
 	void unbind();
 
 	void bind(int textureSlot);
 	void unbind(int textureSlot);
+
+	// Gets the number of entries along each side of the table, or 0 if it has not been loaded
+	uint32_t getSize() const { return _size; }
+	const glm::vec3& getDomainMin() const { return _domainMin; }
+	const glm::vec3& getDomainMax() const { return _domainMax; }
+
+	// Gets the path that the binary copy of a .cube file is cached at
+	static std::string getCachePath(const std::string& path);
 private:
 	GLuint _handle = GL_NONE;
-	std::vector<glm::vec3> data;
-};
\ No newline at end of file
+	uint32_t _size = 0;
+	glm::vec3 _domainMin = glm::vec3(0.0f);
+	glm::vec3 _domainMax = glm::vec3(1.0f);
+
+	// Bump this whenever the layout of the cache changes
+	static constexpr uint32_t CACHE_VERSION = 1;
+
+	struct CacheHeader {
+		char     Magic[4];
+		uint32_t Version;
+		uint32_t Size;
+		uint32_t Format;
+		float    DomainMin[3];
+		float    DomainMax[3];
+		uint64_t SourceSize;
+		uint64_t SourceHash;
+		uint64_t DataSize;
+	};
+
+	static LUT3DData::sptr _readCache(const std::string& path);
+	static bool _writeCache(const std::string& path, const LUT3DData& table);
+};
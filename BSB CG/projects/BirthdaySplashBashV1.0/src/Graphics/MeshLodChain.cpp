@@ -0,0 +1,67 @@
+#include "MeshLodChain.h"
+
+#include <cfloat>
+#include <algorithm>
+
+float MeshLodChain::_lodBias = 0.0f;
+
+const VertexArrayObject::sptr& MeshLodChain::GetMesh(size_t level) const {
+	return _levels[std::min(level, _levels.size() - 1)].Mesh;
+}
+
+float MeshLodChain::GetScreenSize(const glm::mat4& world, const glm::mat4& view, const glm::mat4& projection) const {
+	// The sphere grows with the largest scale axis, so that it still encloses the mesh under non uniform scales
+	const float scale = glm::max(glm::max(glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1]))), glm::length(glm::vec3(world[2])));
+	const float radius = _boundsRadius * scale;
+
+	// Orthographic projections have no perspective divide, so the size doesn't depend on the distance
+	if (projection[2][3] == 0.0f) {
+		return radius * projection[1][1];
+	}
+	const glm::vec4 center = view * world * glm::vec4(_boundsCenter, 1.0f);
+	const float depth = -center.z;
+	// When the camera is inside the sphere, it covers the whole screen
+	if (depth <= radius) {
+		return FLT_MAX;
+	}
+	return radius * projection[1][1] / depth;
+}
+
+float MeshLodChain::_GetMaxScreenSize(size_t level) const {
+	const float error = _levels[level].Error;
+	if (error <= 0.0f) {
+		return FLT_MAX;
+	}
+	// The error covers error / diameter of the sphere's projected size
+	return MAX_SCREEN_ERROR * 2.0f * _boundsRadius / error;
+}
+
+size_t MeshLodChain::SelectLevel(float screenSize, size_t currentLevel) const {
+	if (_levels.size() <= 1 || _boundsRadius <= 0.0f) {
+		return 0;
+	}
+	const float size = screenSize * glm::exp2(-_lodBias);
+
+	size_t level = std::min(currentLevel, _levels.size() - 1);
+	// Step to finer levels while the current one is too coarse, then to coarser ones while the next one is
+	// good enough. Each step has to clear the switch point by the hysteresis, so the two can't undo each other
+	while (level > 0 && size > _GetMaxScreenSize(level) * (1.0f + HYSTERESIS)) {
+		level--;
+	}
+	while (level + 1 < _levels.size() && size < _GetMaxScreenSize(level + 1) * (1.0f - HYSTERESIS)) {
+		level++;
+	}
+	return level;
+}
+
+size_t MeshLodChain::GetTotalBufferSize() const {
+	if (_levels.empty()) {
+		return 0;
+	}
+	// Every level shares the first level's vertices
+	size_t result = _levels[0].Mesh->GetTotalBufferSize();
+	for (size_t ix = 1; ix < _levels.size(); ix++) {
+		result += _levels[ix].Mesh->GetIndexDataSize();
+	}
+	return result;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <GLM/glm.hpp>
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// A mesh along with its simplified versions (see MeshSimplifier), and the bounding sphere that is used to pick
+/// between them. Level 0 is the full detail mesh, and each level after it is coarser.
+///
+/// Levels are picked by how much of the screen's height the bounding sphere covers. A level may be drawn once
+/// its error would cover less than MAX_SCREEN_ERROR of the screen, and the selection only changes once the size
+/// has moved HYSTERESIS past the switch point, so objects sitting right at a threshold don't pop back and forth
+/// </summary>
+class MeshLodChain final
+{
+public:
+	typedef std::shared_ptr<MeshLodChain> sptr;
+	static inline sptr Create() {
+		return std::make_shared<MeshLodChain>();
+	}
+
+	/// <summary>
+	/// The projected error that we accept, as a fraction of the screen's height (about a pixel at 1080p)
+	/// </summary>
+	static constexpr float MAX_SCREEN_ERROR = 1.0f / 1080.0f;
+	/// <summary>
+	/// How far past a switch point the screen size must move before the level changes, as a fraction of the switch point
+	/// </summary>
+	static constexpr float HYSTERESIS = 0.1f;
+
+	struct Level {
+		VertexArrayObject::sptr Mesh;
+		/// <summary>
+		/// How far this level strays from the full detail mesh, in model units
+		/// </summary>
+		float Error;
+	};
+
+	MeshLodChain() = default;
+	~MeshLodChain() = default;
+
+	/// <summary>
+	/// Sets the bounding sphere of the mesh, in model space
+	/// </summary>
+	void SetBounds(const glm::vec3& center, float radius) { _boundsCenter = center; _boundsRadius = radius; }
+	const glm::vec3& GetBoundsCenter() const { return _boundsCenter; }
+	float GetBoundsRadius() const { return _boundsRadius; }
+
+	/// <summary>
+	/// Adds the next coarsest level, levels must be added from the most to the least detailed
+	/// </summary>
+	/// <param name="mesh">The mesh to draw for this level</param>
+	/// <param name="error">How far the level strays from the full detail mesh, in model units</param>
+	void AddLevel(const VertexArrayObject::sptr& mesh, float error) { _levels.push_back({ mesh, error }); }
+	size_t GetLevelCount() const { return _levels.size(); }
+	const Level& GetLevel(size_t level) const { return _levels[level]; }
+	/// <summary>
+	/// Gets the mesh for a level, levels past the end of the chain get the coarsest mesh
+	/// </summary>
+	const VertexArrayObject::sptr& GetMesh(size_t level) const;
+
+	/// <summary>
+	/// Gets how much of the screen's height the bounding sphere's diameter covers when drawn with the given matrices,
+	/// where 1 is the whole height. Works for both perspective and orthographic projections
+	/// </summary>
+	float GetScreenSize(const glm::mat4& world, const glm::mat4& view, const glm::mat4& projection) const;
+	/// <summary>
+	/// Picks the level to draw for an object of the given screen size, after applying the LOD bias
+	/// </summary>
+	/// <param name="screenSize">The size from GetScreenSize</param>
+	/// <param name="currentLevel">The level that the object was drawn with last time, for hysteresis</param>
+	size_t SelectLevel(float screenSize, size_t currentLevel) const;
+
+	/// <summary>
+	/// Returns the total size in bytes of all the buffers in the chain, counting shared buffers once
+	/// </summary>
+	size_t GetTotalBufferSize() const;
+
+	/// <summary>
+	/// Sets the bias that is applied to every chain's selection. Like a texture's LOD bias, each step above 0 picks
+	/// levels as if objects were half their size on screen, and each step below 0 as if they were twice their size
+	/// </summary>
+	static void SetLodBias(float bias) { _lodBias = bias; }
+	static float GetLodBias() { return _lodBias; }
+
+protected:
+	std::vector<Level> _levels;
+	glm::vec3 _boundsCenter = glm::vec3(0.0f);
+	float _boundsRadius = 0.0f;
+
+	static float _lodBias;
+
+	/// <summary>
+	/// Gets the largest screen size that a level can be drawn at before its error becomes visible
+	/// </summary>
+	float _GetMaxScreenSize(size_t level) const;
+};
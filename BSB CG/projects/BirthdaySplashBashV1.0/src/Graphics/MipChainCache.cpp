@@ -0,0 +1,83 @@
+#include "MipChainCache.h"
+
+#include <filesystem>
+
+#include "Logging.h"
+#include "Utilities/FileUtils.h"
+#include "Utilities/MappedFile.h"
+
+namespace fs = std::filesystem;
+
+static const char MIP_CACHE_MAGIC[4] = { 'B', 'M', 'I', 'P' };
+
+/// <summary>
+/// Packs the generator settings into a single value for the cache header
+/// </summary>
+static uint32_t PackSettings(MipFilter filter, bool gammaCorrect) {
+	return (uint32_t)filter | ((gammaCorrect ? 1u : 0u) << 8);
+}
+
+std::string MipChainCache::GetCachePath(const std::string& sourceFile) {
+	return sourceFile + ".mips";
+}
+
+Texture2DData::sptr MipChainCache::Load(const std::string& sourceFile, MipFilter filter, bool gammaCorrect) {
+	const std::string cachePath = GetCachePath(sourceFile);
+	MappedFile cache;
+	if (!cache.Open(cachePath) || cache.GetSize() < sizeof(Header)) {
+		return nullptr;
+	}
+	Header header;
+	memcpy(&header, cache.GetData(), sizeof(Header));
+
+	if (memcmp(header.Magic, MIP_CACHE_MAGIC, sizeof(MIP_CACHE_MAGIC)) != 0 || header.Version != FORMAT_VERSION) {
+		LOG_WARN("Mip cache \"{}\" is from an older version, rebuilding", cachePath);
+		return nullptr;
+	}
+	if (header.Settings != PackSettings(filter, gammaCorrect)) {
+		return nullptr;
+	}
+	if (header.Width == 0 || header.Height == 0 || header.LevelCount == 0 || IsCompressedFormat((InternalFormat)header.RecommendedFormat) ||
+		header.LevelCount > GetMipLevelCount(header.Width, header.Height) ||
+		cache.GetSize() != sizeof(Header) + header.DataSize) {
+		LOG_WARN("Mip cache \"{}\" is truncated or corrupt, rebuilding", cachePath);
+		return nullptr;
+	}
+
+	if (!FileUtils::IsSourceUnchanged(sourceFile, header.SourceSize, header.SourceHash)) {
+		return nullptr;
+	}
+
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(header.Width, header.Height,
+		(PixelFormat)header.Format, (PixelType)header.Type, nullptr, (InternalFormat)header.RecommendedFormat, header.LevelCount);
+	if (result->GetDataSize() != header.DataSize) {
+		LOG_WARN("Mip cache \"{}\" does not match its header, rebuilding", cachePath);
+		return nullptr;
+	}
+	memcpy(result->GetDataPtr(), cache.GetData() + sizeof(Header), result->GetDataSize());
+	result->DebugName = fs::path(sourceFile).filename().string();
+	return result;
+}
+
+bool MipChainCache::Save(const std::string& sourceFile, const Texture2DData& data, MipFilter filter, bool gammaCorrect) {
+	Header header = {};
+	memcpy(header.Magic, MIP_CACHE_MAGIC, sizeof(MIP_CACHE_MAGIC));
+	header.Version           = FORMAT_VERSION;
+	header.Width             = data.GetWidth();
+	header.Height            = data.GetHeight();
+	header.LevelCount        = data.GetLevelCount();
+	header.Format            = (uint32_t)data.GetFormat();
+	header.Type              = (uint32_t)data.GetPixelType();
+	header.RecommendedFormat = (uint32_t)data.GetRecommendedFormat();
+	header.Settings          = PackSettings(filter, gammaCorrect);
+	header.DataSize          = data.GetDataSize();
+	if (!FileUtils::FingerprintFile(sourceFile, header.SourceSize, header.SourceHash)) {
+		LOG_WARN("Could not read \"{}\" to fingerprint it, skipping mip cache", sourceFile);
+		return false;
+	}
+
+	return FileUtils::WriteFileAtomic(GetCachePath(sourceFile), {
+		{ &header, sizeof(Header) },
+		{ data.GetDataPtr(), data.GetDataSize() }
+	});
+}
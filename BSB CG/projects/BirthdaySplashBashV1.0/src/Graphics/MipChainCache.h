@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+#include "Graphics/Texture2DData.h"
+#include "Graphics/MipGenerator.h"
+
+/// <summary>
+/// Stores the uncompressed mip chains built by the MipGenerator on disk, next to their source images, so that
+/// the chain (and the image decode) never needs to be redone at startup. Caches are fingerprinted with the size
+/// and hash of the source image, and record the settings they were generated with
+/// </summary>
+class MipChainCache
+{
+public:
+	/// <summary>
+	/// Gets the path that the mip chain for an image is cached at
+	/// </summary>
+	/// <param name="sourceFile">The path of the source image (ex: images/Arena1/Ground.png)</param>
+	static std::string GetCachePath(const std::string& sourceFile);
+
+	/// <summary>
+	/// Loads the cached mip chain for an image, if it exists and is still up to date. If the source image is
+	/// missing the cache is trusted
+	/// </summary>
+	/// <param name="sourceFile">The path of the source image</param>
+	/// <param name="filter">The filter the chain must have been generated with</param>
+	/// <param name="gammaCorrect">Whether the chain must have been generated with gamma correction</param>
+	/// <returns>The image with all of its mip levels, or nullptr if there is no valid cache</returns>
+	static Texture2DData::sptr Load(const std::string& sourceFile, MipFilter filter, bool gammaCorrect);
+	/// <summary>
+	/// Writes a mip chain to the cache for an image
+	/// </summary>
+	/// <param name="sourceFile">The path of the source image, which gets fingerprinted</param>
+	/// <param name="data">The uncompressed image, including all of its mip levels</param>
+	/// <param name="filter">The filter the chain was generated with</param>
+	/// <param name="gammaCorrect">Whether the chain was generated with gamma correction</param>
+	/// <returns>True if the cache was written</returns>
+	static bool Save(const std::string& sourceFile, const Texture2DData& data, MipFilter filter, bool gammaCorrect);
+
+protected:
+	MipChainCache() = default;
+	~MipChainCache() = default;
+
+	// Bump this whenever the layout of the file or the output of the MipGenerator changes
+	static constexpr uint32_t FORMAT_VERSION = 1;
+
+	struct Header {
+		char     Magic[4];
+		uint32_t Version;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t LevelCount;
+		uint32_t Format;
+		uint32_t Type;
+		uint32_t RecommendedFormat;
+		uint32_t Settings;
+		uint32_t Reserved;
+		uint64_t SourceSize;
+		uint64_t SourceHash;
+		uint64_t DataSize;
+	};
+};
@@ -0,0 +1,212 @@
+#include "MipGenerator.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <GLM/gtc/constants.hpp>
+
+#include "Logging.h"
+#include "Graphics/GammaTables.h"
+
+// Every x64 CPU has SSE2, on other platforms we fall back to plain floats
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIP_GENERATOR_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+	// The half width of the Kaiser filter in destination texels, and how quickly its window falls off. These match
+	// the defaults that the NVIDIA texture tools use for their mip maps
+	constexpr float KAISER_WIDTH = 3.0f;
+	constexpr float KAISER_ALPHA = 4.0f;
+
+	/// <summary>
+	/// The filter taps for a single destination texel, the source texels are First to First + Weights.size() - 1
+	/// (before clamping to the edge of the image)
+	/// </summary>
+	struct FilterTaps {
+		int First;
+		std::vector<float> Weights;
+	};
+
+	/// <summary>
+	/// Zeroth order modified Bessel function of the first kind, used for the Kaiser window
+	/// </summary>
+	float Bessel0(float x) {
+		float sum = 1.0f, term = 1.0f;
+		const float halfSq = x * x * 0.25f;
+		for (int k = 1; k < 32 && term > sum * 1e-8f; k++) {
+			term *= halfSq / (float)(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float Sinc(float x) {
+		return std::abs(x) < 1e-4f ? 1.0f : std::sin(glm::pi<float>() * x) / (glm::pi<float>() * x);
+	}
+
+	/// <summary>
+	/// Evaluates the filter at a distance from the center of a destination texel, measured in destination texels
+	/// </summary>
+	float EvaluateFilter(MipFilter filter, float x) {
+		switch (filter) {
+			case MipFilter::Box:
+				return std::abs(x) <= 0.5f ? 1.0f : 0.0f;
+			case MipFilter::Kaiser: {
+				const float t = x / KAISER_WIDTH;
+				if (t * t >= 1.0f) {
+					return 0.0f;
+				}
+				return Sinc(x) * Bessel0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / Bessel0(KAISER_ALPHA);
+			}
+			default:
+				return 0.0f;
+		}
+	}
+
+	/// <summary>
+	/// Works out the taps for every destination texel along one axis. Each source texel is integrated over its
+	/// footprint, which gives the box filter the right weights for odd sized levels (ex: 5 -> 2)
+	/// </summary>
+	std::vector<FilterTaps> BuildTaps(MipFilter filter, uint32_t srcSize, uint32_t dstSize) {
+		constexpr int SAMPLES = 8;
+		const float scale  = srcSize / (float)dstSize;
+		const float radius = (filter == MipFilter::Box ? 0.5f : KAISER_WIDTH) * scale;
+
+		std::vector<FilterTaps> result(dstSize);
+		// Levels that are only 1 texel along one side stay the same size along that side, so just copy them
+		if (srcSize == dstSize) {
+			for (uint32_t x = 0; x < dstSize; x++) {
+				result[x] = { (int)x, { 1.0f } };
+			}
+			return result;
+		}
+		for (uint32_t x = 0; x < dstSize; x++) {
+			const float center = (x + 0.5f) * scale;
+			FilterTaps& taps = result[x];
+			taps.First = (int)std::floor(center - radius);
+			const int last = (int)std::ceil(center + radius);
+
+			float total = 0.0f;
+			for (int ix = taps.First; ix < last; ix++) {
+				float weight = 0.0f;
+				for (int s = 0; s < SAMPLES; s++) {
+					const float position = ix + (s + 0.5f) / SAMPLES;
+					weight += EvaluateFilter(filter, (position - center) / scale);
+				}
+				taps.Weights.push_back(weight);
+				total += weight;
+			}
+			// Normalize so that flat areas keep their value
+			for (float& weight : taps.Weights) {
+				weight /= total;
+			}
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Applies a set of taps along one row or column of a 4 channel float image. The strides let the horizontal and
+	/// vertical passes share this code
+	/// </summary>
+	/// <param name="src">The first texel of the row or column to filter</param>
+	/// <param name="srcSize">The number of texels in the row or column</param>
+	/// <param name="srcStride">The number of floats between texels in the row or column</param>
+	/// <param name="dst">The first texel of the row or column to write to</param>
+	/// <param name="dstStride">The number of floats between texels in the output</param>
+	void ApplyTaps(const std::vector<FilterTaps>& taps, const float* src, int srcSize, size_t srcStride, float* dst, size_t dstStride) {
+		for (size_t x = 0; x < taps.size(); x++) {
+			const FilterTaps& tap = taps[x];
+			#ifdef MIP_GENERATOR_SSE
+			__m128 sum = _mm_setzero_ps();
+			for (size_t ix = 0; ix < tap.Weights.size(); ix++) {
+				const int index = std::clamp(tap.First + (int)ix, 0, srcSize - 1);
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tap.Weights[ix]), _mm_loadu_ps(src + index * srcStride)));
+			}
+			_mm_storeu_ps(dst + x * dstStride, sum);
+			#else
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (size_t ix = 0; ix < tap.Weights.size(); ix++) {
+				const float* texel = src + std::clamp(tap.First + (int)ix, 0, srcSize - 1) * srcStride;
+				for (int c = 0; c < 4; c++) {
+					sum[c] += tap.Weights[ix] * texel[c];
+				}
+			}
+			memcpy(dst + x * dstStride, sum, sizeof(sum));
+			#endif
+		}
+	}
+}
+
+Texture2DData::sptr MipGenerator::Generate(const Texture2DData& source, MipFilter filter, bool gammaCorrect) {
+	if (source.IsCompressed() || source.GetPixelType() != PixelType::UByte) {
+		LOG_WARN("Can not generate mips for \"{}\", only uncompressed 8 bit images are supported", source.DebugName);
+		return nullptr;
+	}
+
+	const uint32_t levelCount = GetMipLevelCount(source.GetWidth(), source.GetHeight());
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(source.GetWidth(), source.GetHeight(),
+		source.GetFormat(), source.GetPixelType(), nullptr, source.GetRecommendedFormat(), levelCount);
+	result->DebugName = source.DebugName;
+	memcpy(result->GetLevelDataPtr(0), source.GetLevelDataPtr(0), source.GetLevelDataSize(0));
+	if (levelCount == 1) {
+		return result;
+	}
+
+	const GammaTables& tables = GammaTables::Get();
+	const size_t channels = GetTexelComponentCount(source.GetFormat());
+	// Alpha is coverage rather than a color, so it is always filtered as-is
+	const size_t srgbChannels = gammaCorrect && channels >= 3 ? 3 : 0;
+
+	// Expand the top level out to 4 linear floats per texel, so that every texel is one SSE register
+	uint32_t width  = source.GetWidth();
+	uint32_t height = source.GetHeight();
+	std::vector<float> current(width * (size_t)height * 4, 0.0f);
+	{
+		const uint8_t* src = static_cast<const uint8_t*>(source.GetLevelDataPtr(0));
+		for (size_t ix = 0; ix < width * (size_t)height; ix++) {
+			for (size_t c = 0; c < channels; c++) {
+				const uint8_t value = src[ix * channels + c];
+				current[ix * 4 + c] = c < srgbChannels ? tables.ToLinear[value] : value / 255.0f;
+			}
+		}
+	}
+
+	std::vector<float> horizontal, next;
+	for (uint32_t level = 1; level < levelCount; level++) {
+		const uint32_t dstWidth  = result->GetLevelWidth(level);
+		const uint32_t dstHeight = result->GetLevelHeight(level);
+
+		// The filter is separable, so we shrink along X first and then along Y
+		const std::vector<FilterTaps> tapsX = BuildTaps(filter, width, dstWidth);
+		const std::vector<FilterTaps> tapsY = BuildTaps(filter, height, dstHeight);
+		horizontal.resize(dstWidth * (size_t)height * 4);
+		next.resize(dstWidth * (size_t)dstHeight * 4);
+		for (uint32_t y = 0; y < height; y++) {
+			ApplyTaps(tapsX, current.data() + y * (size_t)width * 4, (int)width, 4, horizontal.data() + y * (size_t)dstWidth * 4, 4);
+		}
+		for (uint32_t x = 0; x < dstWidth; x++) {
+			ApplyTaps(tapsY, horizontal.data() + x * 4, (int)height, dstWidth * (size_t)4, next.data() + x * 4, dstWidth * (size_t)4);
+		}
+
+		// Convert back to 8 bit. The Kaiser filter has negative lobes, so values can overshoot and need clamping
+		uint8_t* dst = static_cast<uint8_t*>(result->GetLevelDataPtr(level));
+		for (size_t ix = 0; ix < dstWidth * (size_t)dstHeight; ix++) {
+			for (size_t c = 0; c < channels; c++) {
+				const float value = next[ix * 4 + c];
+				dst[ix * channels + c] = c < srgbChannels ?
+					tables.LinearToSrgb(value) :
+					(uint8_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+		}
+
+		// Each level is filtered from the float copy of the level above it, so rounding errors don't build up
+		current.swap(next);
+		width  = dstWidth;
+		height = dstHeight;
+	}
+	return result;
+}
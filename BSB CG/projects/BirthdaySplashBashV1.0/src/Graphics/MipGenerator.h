@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+#include "Graphics/Texture2DData.h"
+
+/// <summary>
+/// The filters that the MipGenerator can use to shrink each level down to the next
+/// </summary>
+enum class MipFilter : uint8_t {
+	/// <summary>
+	/// Averages each 2x2 group of texels, fast but slightly blurry
+	/// </summary>
+	Box    = 0,
+	/// <summary>
+	/// A Kaiser windowed sinc, keeps the mips sharper without ringing
+	/// </summary>
+	Kaiser = 1
+};
+
+/// <summary>
+/// Generates mip chains on the CPU, so that they can be built on the loader's worker threads (and cached on disk)
+/// rather than on the GPU with glGenerateTextureMipmap.
+///
+/// Filtering is done on linear floats, 4 channels at a time with SSE where it is available. Color images can be
+/// filtered in linear space by converting from sRGB first, which stops mips of high contrast textures from
+/// getting darker as they shrink
+/// </summary>
+class MipGenerator
+{
+public:
+	/// <summary>
+	/// Builds a full mip chain (down to 1x1) for an 8 bit image
+	/// </summary>
+	/// <param name="source">The image to build the chain from, only the first level is used</param>
+	/// <param name="filter">The filter to use when shrinking each level</param>
+	/// <param name="gammaCorrect">True to treat the RGB channels of 3 and 4 channel images as sRGB, alpha and images with fewer channels are always linear</param>
+	/// <returns>A copy of the source image with all of its mip levels</returns>
+	static Texture2DData::sptr Generate(const Texture2DData& source, MipFilter filter = MipFilter::Kaiser, bool gammaCorrect = true);
+
+protected:
+	MipGenerator() = default;
+	~MipGenerator() = default;
+};
@@ -1,4 +1,5 @@
 #include "PostEffect.h"
+#include "GLStateCache.h"
 
 void PostEffect::Init(unsigned width, unsigned height)
 {
@@ -79,7 +80,7 @@ void PostEffect::BindBuffer(int index)
 
 void PostEffect::UnbindBuffer()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+	GLStateCache::BindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
 }
 
 void PostEffect::BindColorAsTexture(int index, int colorBuffer, int textureSlot)
@@ -95,8 +96,7 @@ void PostEffect::BindDepthAsTexture(int index, int textureSlot)
 void PostEffect::UnbindTexture(int textureSlot)
 {
 	//Binds texture at slot to GL_NONE
-	glActiveTexture(GL_TEXTURE0 + textureSlot);
-	glBindTexture(GL_TEXTURE_2D, GL_NONE);
+	GLStateCache::BindTextureUnit(textureSlot, GL_NONE);
 }
 
 void PostEffect::BindShader(int index)
@@ -106,5 +106,5 @@ void PostEffect::BindShader(int index)
 
 void PostEffect::UnbindShader()
 {
-	glUseProgram(GL_NONE);
+	GLStateCache::UseProgram(GL_NONE);
 }
@@ -0,0 +1,107 @@
+#include "RingBuffer.h"
+#include "Logging.h"
+
+#include <algorithm>
+
+RingBuffer::RingBuffer(GLenum type, size_t regionCount) :
+	_type(type),
+	_handle(0),
+	_mapped(nullptr),
+	_regionSize(0),
+	_regionCount(std::max(regionCount, (size_t)1)),
+	_region(0),
+	_fences(std::vector<GLsync>(_regionCount, nullptr))
+{
+	LOG_ASSERT(type == GL_SHADER_STORAGE_BUFFER || type == GL_UNIFORM_BUFFER || type == GL_DRAW_INDIRECT_BUFFER,
+		"Ring buffers must be storage, uniform or indirect buffers!");
+}
+
+RingBuffer::~RingBuffer() {
+	_Release();
+}
+
+void* RingBuffer::Map(size_t size) {
+	_region = (_region + 1) % _regionCount;
+	if (size > _regionSize) {
+		// Leave some room to grow, so that a slowly growing scene doesn't re-allocate every frame
+		_Allocate(std::max(size + size / 2, (size_t)4096));
+	}
+	_Wait(_fences[_region]);
+	return _mapped + _region * _regionSize;
+}
+
+void RingBuffer::Fence() {
+	if (_handle == 0) {
+		return;
+	}
+	if (_fences[_region] != nullptr) {
+		glDeleteSync(_fences[_region]);
+	}
+	_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void RingBuffer::Bind(GLuint slot, size_t size) const {
+	if (_handle != 0) {
+		glBindBufferRange(_type, slot, _handle, (GLintptr)(_region * _regionSize), (GLsizeiptr)std::max(size, (size_t)1));
+	}
+}
+
+void RingBuffer::Bind() const {
+	glBindBuffer(_type, _handle);
+}
+
+void RingBuffer::_Allocate(size_t regionSize) {
+	_Release();
+
+	// Each region has to start on a multiple of the driver's offset alignment to be bound with glBindBufferRange
+	// Indirect commands only need to be aligned to their 4 byte fields
+	GLint alignment = 256;
+	if (_type == GL_DRAW_INDIRECT_BUFFER) {
+		alignment = 4;
+	} else {
+		glGetIntegerv(_type == GL_SHADER_STORAGE_BUFFER ? GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT : GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	}
+	alignment = std::max(alignment, 1);
+	_regionSize = (regionSize + alignment - 1) / alignment * alignment;
+
+	// Coherent mapping means our writes are visible to the GPU without flushing them
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &_handle);
+	glNamedBufferStorage(_handle, _regionSize * _regionCount, nullptr, flags);
+	_mapped = static_cast<uint8_t*>(glMapNamedBufferRange(_handle, 0, _regionSize * _regionCount, flags));
+	LOG_ASSERT(_mapped != nullptr, "Failed to map a ring buffer of {} bytes", _regionSize * _regionCount);
+}
+
+void RingBuffer::_Release() {
+	// The GL keeps the storage alive until any draws still reading from it are done, so we can drop it right away
+	for (GLsync& fence : _fences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	if (_handle != 0) {
+		glUnmapNamedBuffer(_handle);
+		glDeleteBuffers(1, &_handle);
+		_handle = 0;
+	}
+	_mapped = nullptr;
+	_regionSize = 0;
+}
+
+void RingBuffer::_Wait(GLsync& fence) {
+	if (fence == nullptr) {
+		return;
+	}
+	// Flush on the first try, so that we aren't waiting on a fence that is still sitting in the command queue
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true) {
+		const GLenum result = glClientWaitSync(fence, flags, 1000000);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+			break;
+		}
+		flags = 0;
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <glad/glad.h>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// A buffer for data that is rewritten every frame, split into several regions that are used in turn.
+///
+/// The buffer is allocated with glBufferStorage and stays mapped for its whole life, so the CPU writes straight
+/// into it without any glBufferData or glMapBuffer calls. Each region is fenced once the draws that read it have
+/// been submitted, and we only wait on that fence when we come back around to the region, by which point the GPU
+/// is normally long done with it
+/// </summary>
+class RingBuffer final
+{
+public:
+	typedef std::shared_ptr<RingBuffer> sptr;
+	static inline sptr Create(GLenum type, size_t regionCount = DEFAULT_REGION_COUNT) {
+		return std::make_shared<RingBuffer>(type, regionCount);
+	}
+
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	RingBuffer(const RingBuffer& other) = delete;
+	RingBuffer(RingBuffer&& other) = delete;
+	RingBuffer& operator=(const RingBuffer& other) = delete;
+	RingBuffer& operator=(RingBuffer&& other) = delete;
+
+	/// <summary>
+	/// The number of regions to cycle through if none is given, enough for the driver to queue up 2 frames
+	/// </summary>
+	static constexpr size_t DEFAULT_REGION_COUNT = 3;
+
+public:
+	/// <summary>
+	/// Creates a new ring buffer, nothing is allocated until the first call to Map
+	/// </summary>
+	/// <param name="type">The target the regions get bound to (GL_SHADER_STORAGE_BUFFER, GL_UNIFORM_BUFFER or GL_DRAW_INDIRECT_BUFFER)</param>
+	/// <param name="regionCount">The number of regions to cycle through</param>
+	RingBuffer(GLenum type, size_t regionCount = DEFAULT_REGION_COUNT);
+	~RingBuffer();
+
+	/// <summary>
+	/// Moves on to the next region and returns a pointer to write into it. Waits if the GPU is still reading the
+	/// region from a few frames ago, and grows the buffer if the regions are smaller than size
+	/// </summary>
+	/// <param name="size">The number of bytes that will be written</param>
+	void* Map(size_t size);
+	/// <summary>
+	/// Maps space for count elements of type T, see Map
+	/// </summary>
+	template <typename T>
+	T* Map(size_t count) {
+		return static_cast<T*>(Map(count * sizeof(T)));
+	}
+	/// <summary>
+	/// Marks the current region as in use by the GPU. Call this after submitting the draws that read it
+	/// </summary>
+	void Fence();
+
+	/// <summary>
+	/// Binds the current region to an indexed binding, which shaders refer to with layout(binding = slot)
+	/// </summary>
+	/// <param name="slot">The index of the binding point</param>
+	/// <param name="size">The number of bytes to bind, starting at the start of the region</param>
+	void Bind(GLuint slot, size_t size) const;
+	/// <summary>
+	/// Binds the whole buffer to a non indexed target (GL_DRAW_INDIRECT_BUFFER), reads from the current region
+	/// then need to be offset by GetOffset
+	/// </summary>
+	void Bind() const;
+
+	/// <summary>
+	/// Returns the offset in bytes of the current region from the start of the buffer
+	/// </summary>
+	size_t GetOffset() const { return _region * _regionSize; }
+
+	GLuint GetHandle() const { return _handle; }
+	GLenum GetType() const { return _type; }
+	size_t GetRegionSize() const { return _regionSize; }
+	size_t GetRegionCount() const { return _regionCount; }
+
+protected:
+	GLenum   _type;
+	GLuint   _handle;
+	uint8_t* _mapped;
+	size_t   _regionSize;
+	size_t   _regionCount;
+	size_t   _region;
+	// One fence per region, null if the region isn't waiting on the GPU
+	std::vector<GLsync> _fences;
+
+	/// <summary>
+	/// Replaces the buffer with one that has regions of at least the given size
+	/// </summary>
+	void _Allocate(size_t regionSize);
+	void _Release();
+	static void _Wait(GLsync& fence);
+};
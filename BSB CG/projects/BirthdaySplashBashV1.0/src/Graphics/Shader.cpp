@@ -1,18 +1,79 @@
 #include "Shader.h"
+#include "GLStateCache.h"
 #include "Logging.h"
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+
+#include "Utilities/Hash.h"
+#include "Utilities/FileUtils.h"
+#include "Utilities/MappedFile.h"
+
+namespace fs = std::filesystem;
+
+static const char SHADER_CACHE_MAGIC[4] = { 'B', 'P', 'R', 'G' };
+
+// From KHR_parallel_shader_compile, our GLAD build does not include the extension
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+std::string Shader::_cacheDirectory = "shader_cache";
+bool Shader::_deferCompile = true;
+bool Shader::_hasParallelCompile = false;
+
+void Shader::InitParallelCompile(GLADloadproc loader) {
+	bool hasKHR = false, hasARB = false;
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint ix = 0; ix < extensionCount; ix++) {
+		const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, ix));
+		hasKHR |= strcmp(name, "GL_KHR_parallel_shader_compile") == 0;
+		hasARB |= strcmp(name, "GL_ARB_parallel_shader_compile") == 0;
+	}
+	_hasParallelCompile = hasKHR || hasARB;
+
+	if (_hasParallelCompile) {
+		// The ARB version uses the same enums, only the function name differs
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)
+			loader(hasKHR ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB");
+		if (maxCompilerThreads != nullptr) {
+			// 0xFFFFFFFF lets the driver pick the number of threads
+			maxCompilerThreads(0xFFFFFFFF);
+		}
+		LOG_INFO("Parallel shader compiling is supported, shaders will compile in the background");
+	} else {
+		LOG_INFO("Parallel shader compiling is not supported, shaders will compile on first use");
+	}
+}
 
 Shader::Shader() :
+	_vsSource(),
+	_fsSource(),
+	_debugName(),
 	_vs(0),
 	_fs(0),
-	_handle(0)
+	_isPending(false),
+	_cacheKey(0),
+	_handle(0),
+	_materialStamp(0)
 {
 	_handle = glCreateProgram();
 }
 
 Shader::~Shader() {
+	if (_isPending) {
+		glDeleteShader(_vs);
+		glDeleteShader(_fs);
+	}
 	if (_handle != 0) {
+		GLStateCache::ForgetProgram(_handle);
 		glDeleteProgram(_handle);
 		_handle = 0;
 		LOG_INFO("Deleting shader program");
@@ -20,14 +81,72 @@ Shader::~Shader() {
 }
 
 bool Shader::LoadShaderPart(const char* source, GLenum type)
+{
+	switch (type) {
+		case GL_VERTEX_SHADER: _vsSource = source; break;
+		case GL_FRAGMENT_SHADER: _fsSource = source; break;
+		default: LOG_WARN("Not implemented"); return false;
+	}
+	return true;
+}
+
+bool Shader::LoadShaderPartFromFile(const char* path, GLenum type, const std::vector<std::string>& defines) {
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		LOG_ERROR("File not found: {}", path);
+		throw std::runtime_error("File not found, see logs for more information");
+	}
+	std::stringstream stream;
+	stream << file.rdbuf();
+	std::string source = stream.str();
+	file.close();
+
+	// #version has to stay the first statement, so the defines go on the line after it. They're part of the source,
+	// so each variant gets its own entry in the program binary cache
+	if (!defines.empty()) {
+		std::string block;
+		for (const std::string& define : defines) {
+			block += "#define " + define + "\n";
+		}
+		const size_t version = source.find("#version");
+		if (version == std::string::npos) {
+			source.insert(0, block);
+		} else {
+			const size_t lineEnd = source.find('\n', version);
+			if (lineEnd == std::string::npos) {
+				source += "\n" + block;
+			} else {
+				source.insert(lineEnd + 1, block);
+			}
+		}
+	}
+
+	bool result = LoadShaderPart(source.c_str(), type);
+	if (result) {
+		_debugName += _debugName.empty() ? path : std::string(" + ") + path;
+		for (const std::string& define : defines) {
+			_debugName += " " + define;
+		}
+	}
+	return result;
+}
+
+GLuint Shader::_CompileStage(const std::string& source, GLenum type)
 {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader(type);
 
-	// Load the GLSL source and compile it
-	glShaderSource(handle, 1, &source, nullptr);
+	// Load the GLSL source and compile it. We don't ask for the status here, since that would wait for the
+	// driver to finish compiling
+	const char* text = source.c_str();
+	glShaderSource(handle, 1, &text, nullptr);
 	glCompileShader(handle);
 
+	return handle;
+}
+
+bool Shader::_CheckStage(GLuint handle)
+{
 	// Get the compilation status for the shader part
 	GLint status = 0;
 	glGetShaderiv(handle, GL_COMPILE_STATUS, &status);
@@ -48,50 +167,91 @@ bool Shader::LoadShaderPart(const char* source, GLenum type)
 
 		// Clean up our log memory
 		delete[] log;
-
-		// Delete the broken shader result
-		glDeleteShader(handle);
-		handle = 0;
-	}
-
-	switch (type) {
-		case GL_VERTEX_SHADER: _vs = handle; break;
-		case GL_FRAGMENT_SHADER: _fs = handle; break;
-		default: LOG_WARN("Not implemented"); break;
 	}
 
 	return status != GL_FALSE;
 }
 
-bool Shader::LoadShaderPartFromFile(const char* path, GLenum type) {
-	std::ifstream file(path);
-	if (!file.is_open()) {
-		LOG_ERROR("File not found: {}", path);
-		throw std::runtime_error("File not found, see logs for more information");
-	}
-	std::stringstream stream;
-	stream << file.rdbuf();
-	bool result = LoadShaderPart(stream.str().c_str(), type);
-	file.close();
-	return result;
-}
-
 bool Shader::Link()
 {
-	LOG_ASSERT(_vs != 0 && _fs != 0, "Must attach both a vertex and fragment shader!");
+	LOG_ASSERT(!_vsSource.empty() && !_fsSource.empty(), "Must attach both a vertex and fragment shader!");
+	LOG_ASSERT(!_isPending, "Shader is already linking!");
+	const std::string name = _debugName.empty() ? "<inline source>" : _debugName;
+	const auto start = std::chrono::steady_clock::now();
+
+	_cacheKey = _GetCacheKey();
+	if (_LoadBinary(_cacheKey)) {
+		const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		LOG_INFO("Shader cache hit for {}, loaded in {:.2f}ms", name, ms);
+		_ReflectUniforms();
+		_vsSource.clear();
+		_fsSource.clear();
+		return true;
+	}
+
+	_vs = _CompileStage(_vsSource, GL_VERTEX_SHADER);
+	_fs = _CompileStage(_fsSource, GL_FRAGMENT_SHADER);
 
 	// Attach our two shaders
 	glAttachShader(_handle, _vs);
 	glAttachShader(_handle, _fs);
 
-	// Perform linking
+	// Ask the driver to keep the binary around so that we can cache it
+	glProgramParameteri(_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	// Perform linking, if the stages failed to compile this will fail as well and we'll report it in _Resolve
 	glLinkProgram(_handle);
+	_isPending = true;
+
+	if (_deferCompile) {
+		const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		LOG_INFO("Shader cache miss for {}, submitted for compiling in {:.2f}ms", name, ms);
+		return true;
+	}
+
+	bool result = _Resolve();
+	if (result) {
+		const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		LOG_INFO("Shader cache miss for {}, compiled in {:.2f}ms", name, ms);
+	}
+	return result;
+}
+
+bool Shader::IsReady() {
+	if (!_isPending) {
+		return true;
+	}
+	if (_hasParallelCompile) {
+		GLint done = GL_FALSE;
+		glGetProgramiv(_handle, GL_COMPLETION_STATUS_KHR, &done);
+		if (done == GL_FALSE) {
+			return false;
+		}
+	}
+	_Resolve();
+	return true;
+}
+
+bool Shader::_Resolve()
+{
+	if (!_isPending) {
+		GLint status = 0;
+		glGetProgramiv(_handle, GL_LINK_STATUS, &status);
+		return status != GL_FALSE;
+	}
+	_isPending = false;
+	const auto start = std::chrono::steady_clock::now();
+
+	// Report every stage that failed, not just the first
+	bool compiled = _CheckStage(_vs);
+	compiled = _CheckStage(_fs) && compiled;
 
 	// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
 	glDetachShader(_handle, _vs);
 	glDeleteShader(_vs);
 	glDetachShader(_handle, _fs);
 	glDeleteShader(_fs);
+	_vs = _fs = 0;
 
 	GLint status = 0;
 	glGetProgramiv(_handle, GL_LINK_STATUS, &status);
@@ -109,19 +269,126 @@ bool Shader::Link()
 			LOG_ERROR("Shader failed to link:\n{}", log);
 			delete[] log;
 		}
-		else {
+		else if (compiled) {
 			LOG_ERROR("Shader failed to link for an unknown reason!");
 		}
 	}
+	else {
+		if (_deferCompile) {
+			const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+			LOG_INFO("Shader {} is ready, waited {:.2f}ms at first use", _debugName.empty() ? "<inline source>" : _debugName, ms);
+		}
+		_SaveBinary(_cacheKey);
+		_ReflectUniforms();
+		_vsSource.clear();
+		_fsSource.clear();
+	}
 	return status != GL_FALSE;
 }
 
+uint64_t Shader::_GetCacheKey() const {
+	// The driver strings can't change while we're running, so we only need to hash them once
+	static const uint64_t driverHash = []() {
+		uint64_t result = Hash::FNV_OFFSET_BASIS;
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			const char* value = reinterpret_cast<const char*>(glGetString(name));
+			if (value != nullptr) {
+				result = Hash::Fnv1a(value, strlen(value) + 1, result);
+			}
+		}
+		return result;
+	}();
+
+	// We include the sizes so that moving text from one stage to the other changes the key
+	uint64_t result = driverHash;
+	for (const std::string* source : { &_vsSource, &_fsSource }) {
+		const uint64_t size = source->size();
+		result = Hash::Fnv1a(&size, sizeof(size), result);
+		result = Hash::Fnv1a(source->data(), source->size(), result);
+	}
+	return result;
+}
+
+std::string Shader::_GetCachePath(uint64_t key) {
+	char name[24];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return (fs::path(_cacheDirectory) / name).string();
+}
+
+bool Shader::_LoadBinary(uint64_t key) {
+	if (_cacheDirectory.empty()) {
+		return false;
+	}
+
+	const std::string path = _GetCachePath(key);
+	MappedFile cache;
+	if (!cache.Open(path) || cache.GetSize() < sizeof(CacheHeader)) {
+		return false;
+	}
+	CacheHeader header;
+	memcpy(&header, cache.GetData(), sizeof(CacheHeader));
+	if (memcmp(header.Magic, SHADER_CACHE_MAGIC, sizeof(SHADER_CACHE_MAGIC)) != 0 || header.Version != CACHE_VERSION ||
+		header.Key != key || cache.GetSize() != sizeof(CacheHeader) + header.DataSize) {
+		LOG_WARN("Shader cache \"{}\" is out of date or corrupt, recompiling", path);
+		return false;
+	}
+
+	// The driver may still reject the binary (ex: after a driver update that kept the same version string),
+	// in which case the program is left unlinked and we fall back to compiling the source
+	glProgramBinary(_handle, header.BinaryFormat, cache.GetData() + sizeof(CacheHeader), (GLsizei)header.DataSize);
+	GLint status = 0;
+	glGetProgramiv(_handle, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE) {
+		LOG_WARN("Driver rejected cached shader binary \"{}\", recompiling", path);
+		return false;
+	}
+	return true;
+}
+
+bool Shader::_SaveBinary(uint64_t key) {
+	if (_cacheDirectory.empty()) {
+		return false;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(_handle, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		// Some drivers support no binary formats at all
+		return false;
+	}
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(_handle, length, &length, &format, binary.data());
+
+	CacheHeader header = {};
+	memcpy(header.Magic, SHADER_CACHE_MAGIC, sizeof(SHADER_CACHE_MAGIC));
+	header.Version      = CACHE_VERSION;
+	header.BinaryFormat = format;
+	header.Key          = key;
+	header.DataSize     = (uint64_t)length;
+
+	std::error_code error;
+	fs::create_directories(_cacheDirectory, error);
+	if (error) {
+		LOG_WARN("Failed to create shader cache directory \"{}\": {}", _cacheDirectory, error.message());
+		return false;
+	}
+
+	return FileUtils::WriteFileAtomic(_GetCachePath(key), {
+		{ &header, sizeof(CacheHeader) },
+		{ binary.data(), (size_t)length }
+	});
+}
+
 void Shader::Bind() {
-	glUseProgram(_handle);
+	if (_isPending) {
+		_Resolve();
+	}
+	GLStateCache::UseProgram(_handle);
 }
 
 void Shader::UnBind() {
-	glUseProgram(0);
+	GLStateCache::UseProgram(0);
 }
 
 void Shader::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed) {
@@ -173,24 +440,66 @@ void Shader::SetUniform(int location, const glm::bvec4* value, int count) {
 	glProgramUniform4i(location, value->x, value->y, value->z, value->w, 1);
 }
 
-int Shader::GetUniformLocation(const std::string& name) {
-	// Search the map for the given name
-	std::unordered_map<std::string, int>::const_iterator it = _uniformLocs.find(name);
-	int result = -1;
+int Shader::GetUniformLocation(const Hash::HashedName& name) {
+	// We can't look up uniforms until the program has finished linking
+	if (_isPending) {
+		_Resolve();
+	}
+
+	std::vector<UniformInfo>::iterator it = std::lower_bound(_uniforms.begin(), _uniforms.end(), name.Value,
+		[](const UniformInfo& info, uint64_t hash) { return info.NameHash < hash; });
+	if (it != _uniforms.end() && it->NameHash == name.Value) {
+		return it->Location;
+	}
+
+	// Remember the missing name, so that we only warn about it once
+	LOG_WARN("Ignoring uniform \"{}\"", name.Name);
+	_uniforms.insert(it, { name.Value, -1, GL_NONE });
+	return -1;
+}
+
+void Shader::_ReflectUniforms() {
+	_uniforms.clear();
+	// Linking resets every uniform to its default, so whatever material was applied before is gone
+	_materialStamp = 0;
 
-	// If our entry was not found, we call glGetUniform and store it for next time
-	if (it == _uniformLocs.end()) {
-		result = glGetUniformLocation(_handle, name.c_str());
-		_uniformLocs[name] = result;
+	GLint count = 0;
+	glGetProgramInterfaceiv(_handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	GLint maxLength = 0;
+	glGetProgramInterfaceiv(_handle, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxLength);
+	std::vector<char> name(std::max(maxLength, 1));
 
-		if (result == -1) {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
+	const GLenum properties[] = { GL_TYPE, GL_LOCATION };
+	for (GLint ix = 0; ix < count; ix++) {
+		GLint values[2];
+		glGetProgramResourceiv(_handle, GL_UNIFORM, ix, 2, properties, 2, nullptr, values);
+		// Members of uniform blocks don't have locations, they are set through their buffers
+		if (values[1] == -1) {
+			continue;
+		}
+		GLsizei length = 0;
+		glGetProgramResourceName(_handle, GL_UNIFORM, ix, (GLsizei)name.size(), &length, name.data());
+		_uniforms.push_back({ Hash::Fnv1aString(name.data()), values[1], (GLenum)values[0] });
+
+		// Arrays are reported as "name[0]", but glGetUniformLocation also accepts just "name"
+		if (length > 3 && strcmp(name.data() + length - 3, "[0]") == 0) {
+			name[length - 3] = '\0';
+			_uniforms.push_back({ Hash::Fnv1aString(name.data()), values[1], (GLenum)values[0] });
 		}
-	}
-	// Otherwise, we had a value in the map, return it
-	else {
-		result = it->second;
 	}
 
-	return result;
-}
\ No newline at end of file
+	std::sort(_uniforms.begin(), _uniforms.end(), [](const UniformInfo& a, const UniformInfo& b) { return a.NameHash < b.NameHash; });
+}
+
+void Shader::_CheckUniformType(const Hash::HashedName& name, GLenum expected) const {
+	std::vector<UniformInfo>::const_iterator it = std::lower_bound(_uniforms.begin(), _uniforms.end(), name.Value,
+		[](const UniformInfo& info, uint64_t hash) { return info.NameHash < hash; });
+	if (it == _uniforms.end() || it->NameHash != name.Value || it->Type == expected) {
+		return;
+	}
+	// Samplers and images are set with the index of a texture slot, their types all come after the matrices
+	const bool isSlot = expected == GL_INT && it->Type > GL_FLOAT_MAT4;
+	if (!isSlot) {
+		LOG_WARN("Uniform \"{}\" is of type 0x{:04X} in {}, but the handle is for type 0x{:04X}", name.Name, it->Type, _debugName, expected);
+	}
+}
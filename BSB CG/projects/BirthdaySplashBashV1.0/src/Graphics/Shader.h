@@ -3,13 +3,41 @@
 #include <memory>
 
 #include <string>               // for std::string
-#include <unordered_map>        // for std::unordered_map
+#include <cstdint>              // for uint64_t
+#include <vector>               // for std::vector
+#include <type_traits>          // for std::is_same
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include "Logging.h"            // for the logging functions
+#include "Utilities/Hash.h"     // for Hash::HashedName
+
+/// <summary>
+/// A uniform's location in a particular shader, looked up once with Shader::GetUniform. Setting a uniform through
+/// a handle skips the name lookup entirely, and the type parameter makes sure that it is set with the right type
+/// </summary>
+template <typename T>
+struct UniformHandle
+{
+	int Location = -1;
+
+	bool IsValid() const { return Location != -1; }
+};
 
 /// <summary>
 /// This class will wrap around an OpenGL shader program
+/// 
+/// Shader parts are not compiled until Link is called. Link first checks the program binary cache (see
+/// SetCacheDirectory) for a binary built from the same sources on the same driver, and only compiles the
+/// GLSL source if there is no usable binary.
+/// 
+/// With deferred compiling enabled (the default), Link only submits the sources to the driver and returns.
+/// The compile and link status are checked the first time the program is bound or a uniform location is
+/// looked up, so creating all of our shaders up front lets the driver compile them in parallel
+/// (see KHR_parallel_shader_compile)
+/// 
+/// Once the program has linked, all of its active uniforms are read into a table sorted by the hash of their
+/// names, so looking up a uniform by name never calls into the driver. For uniforms that are set often, get a
+/// UniformHandle once and set the uniform through that
 /// </summary>
 class Shader final
 {
@@ -37,7 +65,8 @@ public:
 	~Shader();
 
 	/// <summary>
-	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
+	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader). The source
+	/// is compiled when Link is called, and only if the program is not in the binary cache
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -48,15 +77,23 @@ public:
 	/// </summary>
 	/// <param name="path">The relative path to the file containing the source</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
+	/// <param name="defines">Names to #define right after the #version line, for building variants of one source file</param>
 	/// <returns>True if the shader is loaded, false if there was an issue</returns>
-	bool LoadShaderPartFromFile(const char* path, GLenum type);
+	bool LoadShaderPartFromFile(const char* path, GLenum type, const std::vector<std::string>& defines = {});
 
 	/// <summary>
-	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// Links the vertex and fragment shader, and allows this shader program to be used. If the program binary
+	/// cache has a binary for these sources and this driver, it is loaded instead of compiling the sources
 	/// </summary>
-	/// <returns>True if the linking was sucessful, false if otherwise</returns>
+	/// <returns>True if the linking was sucessful, false if otherwise. When the compile is deferred this is always true, errors are logged at first use</returns>
 	bool Link();
 
+	/// <summary>
+	/// Checks whether the driver has finished compiling and linking this program, without waiting on it. Without
+	/// KHR_parallel_shader_compile there's no way to ask, so this waits for the program and returns true
+	/// </summary>
+	bool IsReady();
+
 	/// <summary>
 	/// Binds this shader for use
 	/// </summary>
@@ -66,23 +103,81 @@ public:
 	/// </summary>
 	static void UnBind();
 
+	/// <summary>
+	/// Sets the directory that linked program binaries are cached in, relative to the working directory.
+	/// An empty path disables the cache
+	/// </summary>
+	static void SetCacheDirectory(const std::string& directory) { _cacheDirectory = directory; }
+	static const std::string& GetCacheDirectory() { return _cacheDirectory; }
+
+	/// <summary>
+	/// Checks for KHR_parallel_shader_compile (or the ARB version) and lets the driver use as many compiler
+	/// threads as it likes. Must be called once after the GL context is created
+	/// </summary>
+	/// <param name="loader">The function to load extension entry points with (ex: glfwGetProcAddress)</param>
+	static void InitParallelCompile(GLADloadproc loader);
+	/// <summary>
+	/// Sets whether Link should wait for the program to finish compiling (false), or leave it to compile in the
+	/// background until first use (true)
+	/// </summary>
+	static void SetDeferredCompile(bool deferred) { _deferCompile = deferred; }
+	static bool HasParallelCompile() { return _hasParallelCompile; }
+
 	/// <summary>
 	/// Gets the underlying OpenGL handle that this class is wrapping
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
+
+	/// <summary>
+	/// Gets or sets the stamp of the material parameters that were last uploaded to this program. Uniform values
+	/// are part of the program's state, so a material whose stamp matches doesn't need to upload them again.
+	/// 0 means no material has been applied since the program was last linked
+	/// </summary>
+	uint64_t GetMaterialStamp() const { return _materialStamp; }
+	void SetMaterialStamp(uint64_t stamp) { _materialStamp = stamp; }
 	
 public:
-	int GetUniformLocation(const std::string& name);
+	/// <summary>
+	/// Gets the location of a uniform, or -1 if the program doesn't have an active uniform with that name.
+	/// Names can be passed as literals or std::strings, neither of which allocates
+	/// </summary>
+	int GetUniformLocation(const Hash::HashedName& name);
+	/// <summary>
+	/// Gets a handle to a uniform, which can be used to set it without looking up its name each time. Logs a
+	/// warning if the uniform's type in the shader doesn't match T
+	/// </summary>
+	template <typename T>
+	UniformHandle<T> GetUniform(const Hash::HashedName& name) {
+		UniformHandle<T> result;
+		result.Location = GetUniformLocation(name);
+		if (result.IsValid()) {
+			_CheckUniformType(name, _GetUniformType<T>());
+		}
+		return result;
+	}
+	/// <summary>
+	/// Sets a uniform through a handle from GetUniform, does nothing if the handle is invalid
+	/// </summary>
+	template <typename T>
+	void SetUniform(const UniformHandle<T>& handle, const T& value) {
+		if (handle.IsValid()) {
+			if constexpr (std::is_same<T, glm::mat3>::value || std::is_same<T, glm::mat4>::value) {
+				SetUniformMatrix(handle.Location, &value, 1);
+			} else {
+				SetUniform(handle.Location, &value, 1);
+			}
+		}
+	}
 	
 	template <typename T>
-	void SetUniform(const std::string& name, const T& value) {
+	void SetUniform(const Hash::HashedName& name, const T& value) {
 		int location = GetUniformLocation(name);
 		if (location != -1) {
 			SetUniform(location, &value, 1);
 		}
 	}
 	template <typename T>
-	void SetUniformMatrix(const std::string& name, const T& value, bool transposed = false) {
+	void SetUniformMatrix(const Hash::HashedName& name, const T& value, bool transposed = false) {
 		int location = GetUniformLocation(name);
 		if (location != -1) {
 			SetUniformMatrix(location, &value, 1, transposed);
@@ -117,11 +212,104 @@ public:
 	void SetUniform(int location, const glm::bvec4* value, int count = 1);
 	
 protected:
+	// The GLSL sources for each stage, kept until Link so that we can skip compiling them on a cache hit
+	std::string _vsSource;
+	std::string _fsSource;
+	// The files the stages were loaded from, for logging
+	std::string _debugName;
+
+	// The stages that are being compiled in the background, until _Resolve is called
 	GLuint _vs;
 	GLuint _fs;
+	bool   _isPending;
+	uint64_t _cacheKey;
 	
 	GLuint _handle;
+	uint64_t _materialStamp;
+
+	/// <summary>
+	/// An active uniform in the linked program
+	/// </summary>
+	struct UniformInfo {
+		uint64_t NameHash;
+		int      Location;
+		// The GL type of the uniform (ex: GL_FLOAT_VEC3), or GL_NONE for names we looked up that aren't in the program
+		GLenum   Type;
+	};
+	// Sorted by NameHash, filled in by _ReflectUniforms once the program has linked
+	std::vector<UniformInfo> _uniforms;
+
+	// Bump this whenever the layout of the cache files changes
+	static constexpr uint32_t CACHE_VERSION = 1;
+
+	struct CacheHeader {
+		char     Magic[4];
+		uint32_t Version;
+		uint32_t BinaryFormat;
+		uint32_t Reserved;
+		uint64_t Key;
+		uint64_t DataSize;
+	};
 
-	std::unordered_map<std::string, int> _uniformLocs;
+	static std::string _cacheDirectory;
+	static bool _deferCompile;
+	static bool _hasParallelCompile;
+
+	/// <summary>
+	/// Submits a single stage to the driver for compiling, without waiting for the result
+	/// </summary>
+	static GLuint _CompileStage(const std::string& source, GLenum type);
+	/// <summary>
+	/// Waits for a stage to compile, and logs the error if it failed. Returns true if it compiled
+	/// </summary>
+	static bool _CheckStage(GLuint handle);
+	/// <summary>
+	/// Waits for the pending compile and link to finish, checks their results and caches the binary.
+	/// Returns true if the program linked
+	/// </summary>
+	bool _Resolve();
+	/// <summary>
+	/// Reads all of the active uniforms in the linked program into _uniforms
+	/// </summary>
+	void _ReflectUniforms();
+	/// <summary>
+	/// Logs a warning if the uniform with the given name isn't of the expected GL type
+	/// </summary>
+	void _CheckUniformType(const Hash::HashedName& name, GLenum expected) const;
+	/// <summary>
+	/// Gets the GL type that matches a C++ type, for checking UniformHandles
+	/// </summary>
+	template <typename T>
+	static constexpr GLenum _GetUniformType() {
+		if constexpr (std::is_same<T, float>::value)          return GL_FLOAT;
+		else if constexpr (std::is_same<T, glm::vec2>::value) return GL_FLOAT_VEC2;
+		else if constexpr (std::is_same<T, glm::vec3>::value) return GL_FLOAT_VEC3;
+		else if constexpr (std::is_same<T, glm::vec4>::value) return GL_FLOAT_VEC4;
+		else if constexpr (std::is_same<T, int>::value)       return GL_INT;
+		else if constexpr (std::is_same<T, glm::ivec2>::value) return GL_INT_VEC2;
+		else if constexpr (std::is_same<T, glm::ivec3>::value) return GL_INT_VEC3;
+		else if constexpr (std::is_same<T, glm::ivec4>::value) return GL_INT_VEC4;
+		else if constexpr (std::is_same<T, bool>::value)      return GL_BOOL;
+		else if constexpr (std::is_same<T, glm::bvec2>::value) return GL_BOOL_VEC2;
+		else if constexpr (std::is_same<T, glm::bvec3>::value) return GL_BOOL_VEC3;
+		else if constexpr (std::is_same<T, glm::bvec4>::value) return GL_BOOL_VEC4;
+		else if constexpr (std::is_same<T, glm::mat3>::value) return GL_FLOAT_MAT3;
+		else if constexpr (std::is_same<T, glm::mat4>::value) return GL_FLOAT_MAT4;
+		else return GL_NONE;
+	}
+	/// <summary>
+	/// Hashes the stage sources together with the driver vendor, renderer and version strings, since binaries
+	/// can only be loaded by the exact driver that produced them
+	/// </summary>
+	uint64_t _GetCacheKey() const;
+	static std::string _GetCachePath(uint64_t key);
+	/// <summary>
+	/// Tries to load this program from the binary cache, returns true if the program was loaded and linked
+	/// </summary>
+	bool _LoadBinary(uint64_t key);
+	/// <summary>
+	/// Writes the linked program to the binary cache
+	/// </summary>
+	bool _SaveBinary(uint64_t key);
 	
 };
\ No newline at end of file
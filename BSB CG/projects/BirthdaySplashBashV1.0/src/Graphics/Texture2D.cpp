@@ -1,4 +1,9 @@
 #include "Texture2D.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+
+#include "Graphics/MipGenerator.h"
 
 Texture2D::Texture2D(const Texture2DDescription& description) :
 	ITexture(), _description(description)
@@ -9,9 +14,11 @@ Texture2D::Texture2D(const Texture2DDescription& description) :
 
 void Texture2D::_RecreateTexture() {
 	if (_handle != 0) {
+		GLStateCache::ForgetTexture(_handle);
 		glDeleteTextures(1, &_handle);
 		_handle = 0;
 	}
+	_levelCount = 0;
 
 	glCreateTextures(GL_TEXTURE_2D, 1, &_handle);
 
@@ -21,7 +28,11 @@ void Texture2D::_RecreateTexture() {
 
 	if (_description.Width * _description.Height > 0 && _description.Format != InternalFormat::Unknown)
 	{
-		glTextureStorage2D(_handle, 1, *_description.Format, _description.Width, _description.Height);
+		// Without enough levels the mip chain can't be generated, and the texture is incomplete for mipmapped filtering
+		const uint32_t fullChain = ::GetMipLevelCount(_description.Width, _description.Height);
+		_levelCount = _description.MipLevels > 0 ? std::min(_description.MipLevels, fullChain) : (_description.GenerateMipMaps ? fullChain : 1);
+		glTextureStorage2D(_handle, _levelCount, *_description.Format, _description.Width, _description.Height);
+		glTextureParameteri(_handle, GL_TEXTURE_MAX_LEVEL, _levelCount - 1);
 
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
@@ -31,16 +42,32 @@ void Texture2D::_RecreateTexture() {
 	}
 }
 
-void Texture2D::LoadData(const Texture2DData::sptr& data) {
+void Texture2D::LoadData(const Texture2DData::sptr& source) {
+	Texture2DData::sptr data = source;
+	if (data->IsCompressed() && !ITexture::IsFormatSupported(data->GetRecommendedFormat())) {
+		LOG_WARN("{} is not supported by this GPU, decompressing \"{}\" on the CPU", ~data->GetRecommendedFormat(), data->DebugName);
+		data = data->Decompress();
+		if (data == nullptr) {
+			return;
+		}
+	}
+
+	// Compressed data can only go into a texture of the exact same format, and uncompressed data can't go into a compressed texture
+	InternalFormat format = _description.Format;
+	if (data->IsCompressed() || format == InternalFormat::Unknown || IsCompressedFormat(format)) {
+		format = data->GetRecommendedFormat();
+	}
+	const uint32_t levels = data->GetLevelCount() > 1 || data->IsCompressed() ? data->GetLevelCount() : _description.MipLevels;
+
 	if (_description.Width != data->GetWidth() ||
-		_description.Height != data->GetHeight()) 
+		_description.Height != data->GetHeight() ||
+		_description.Format != format ||
+		_description.MipLevels != levels)
 	{
 		_description.Width = data->GetWidth();
 		_description.Height = data->GetHeight();
-		
-		if (_description.Format == InternalFormat::Unknown) {
-			_description.Format = data->GetRecommendedFormat();
-		}
+		_description.Format = format;
+		_description.MipLevels = levels;
 		
 		_RecreateTexture();
 	}
@@ -53,18 +80,27 @@ void Texture2D::LoadData(const Texture2DData::sptr& data) {
 	// Align the data store to the size of a single component in
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
 	int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
-	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
-
-	// Upload our data to our image
-	glTextureSubImage2D(_handle, 0, 0, 0, _description.Width, _description.Height, *data->GetFormat(), *data->GetPixelType(), data->GetDataPtr());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
+
+	// Upload our data to our image, one mip level at a time
+	for (uint32_t level = 0; level < data->GetLevelCount() && level < _levelCount; level++) {
+		if (data->IsCompressed()) {
+			glCompressedTextureSubImage2D(_handle, level, 0, 0, data->GetLevelWidth(level), data->GetLevelHeight(level),
+				*format, (GLsizei)data->GetLevelDataSize(level), data->GetLevelDataPtr(level));
+		} else {
+			glTextureSubImage2D(_handle, level, 0, 0, data->GetLevelWidth(level), data->GetLevelHeight(level),
+				*data->GetFormat(), *data->GetPixelType(), data->GetLevelDataPtr(level));
+		}
+	}
 
-	if (_description.GenerateMipMaps) {
+	// Compressed data can't be mipmapped by the driver, and data that brought its own levels doesn't need it
+	if (_description.GenerateMipMaps && _levelCount > 1 && data->GetLevelCount() == 1 && !data->IsCompressed()) {
 		glGenerateTextureMipmap(_handle);
 	}
 }
 
 Texture2D::sptr Texture2D::LoadFromFile(const std::string& path) {
-	Texture2DData::sptr data = Texture2DData::LoadFromFile(path);
+	Texture2DData::sptr data = Texture2DData::LoadWithMips(path, MipFilter::Kaiser);
 	LOG_ASSERT(data != nullptr, "Failed to load image from file!");
 	Texture2D::sptr result = Texture2D::Create();
 	result->LoadData(data);
@@ -19,6 +19,9 @@ struct Texture2DDescription
 	MagFilter      MagnificationFilter;
 	float          MaxAnisotropic;
 	bool           GenerateMipMaps;
+	// The number of mip levels to allocate storage for, data with its own mip levels overrides this. 0 allocates
+	// a full chain when GenerateMipMaps is set, or a single level otherwise
+	uint32_t       MipLevels;
 
 	Texture2DDescription() :
 		Width(0), Height(0),
@@ -28,7 +31,8 @@ struct Texture2DDescription
 		MinificationFilter(MinFilter::NearestMipLinear),
 		MagnificationFilter(MagFilter::Linear),
 		MaxAnisotropic(-1.0f),
-		GenerateMipMaps(true)
+		GenerateMipMaps(true),
+		MipLevels(0)
 	{ }
 };
 
@@ -57,13 +61,14 @@ public:
 	~Texture2D() = default;
 
 	/// <summary>
-	/// Uploads data to this texture
+	/// Uploads data to this texture, along with any mip levels it contains. Compressed data is uploaded as-is
+	/// if the GPU supports the format, otherwise it is decompressed on the CPU first
 	/// </summary>
 	/// <param name="data">The texture data to upload into this texture</param>
 	void LoadData(const Texture2DData::sptr& data);
 
 	/// <summary>
-	/// Loads an image directly from a file
+	/// Loads an image directly from a file, along with a full mip chain (see Texture2DData::LoadWithMips)
 	/// </summary>
 	/// <param name="path">The path to load the image from</param>
 	/// <returns>A pointer to the loaded image</returns>
@@ -72,6 +77,10 @@ public:
 	uint32_t GetWidth() const { return _description.Width; }
 	uint32_t GetHeight() const { return _description.Height; }
 	InternalFormat GetFormat() const { return _description.Format; }	
+	/// <summary>
+	/// Gets the number of mip levels that storage was allocated for
+	/// </summary>
+	uint32_t GetMipLevelCount() const { return _levelCount; }
 	MinFilter GetMinFilter() const { return _description.MinificationFilter; }
 	MagFilter GetMagFilter() const { return _description.MagnificationFilter; }
 	WrapMode GetWrapS() const { return _description.HorizontalWrap; }
@@ -87,6 +96,7 @@ public:
 	
 private:
 	Texture2DDescription _description;
+	uint32_t _levelCount = 0;
 
 	void _RecreateTexture();
 };
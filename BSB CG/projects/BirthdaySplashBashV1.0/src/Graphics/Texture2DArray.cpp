@@ -0,0 +1,88 @@
+#include "Texture2DArray.h"
+
+#include <algorithm>
+
+#include "Logging.h"
+#include "Graphics/GLStateCache.h"
+
+Texture2DArray::Texture2DArray(const Texture2DDescription& description, uint32_t layerCount) :
+	ITexture(), _description(description), _layerCount(layerCount), _levelCount(0)
+{
+	LOG_ASSERT(_description.Width * _description.Height > 0 && _layerCount > 0, "Array textures need a size and at least one layer!");
+	LOG_ASSERT(_description.Format != InternalFormat::Unknown, "Array textures need a format!");
+
+	if (_description.MaxAnisotropic < 0.0f) {
+		_description.MaxAnisotropic = ITexture::GetLimits().MAX_ANISOTROPY;
+	}
+
+	const uint32_t fullChain = ::GetMipLevelCount(_description.Width, _description.Height);
+	_levelCount = _description.MipLevels > 0 ? std::min(_description.MipLevels, fullChain) : fullChain;
+	_description.MipLevels = _levelCount;
+
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &_handle);
+	glTextureStorage3D(_handle, _levelCount, *_description.Format, _description.Width, _description.Height, _layerCount);
+	glTextureParameteri(_handle, GL_TEXTURE_MAX_LEVEL, _levelCount - 1);
+
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, (GLenum)_description.VerticalWrap);
+	glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
+	glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
+	glTextureParameterf(_handle, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
+}
+
+bool Texture2DArray::CopyLayer(uint32_t layer, Texture2D& source) {
+	LOG_ASSERT(layer < _layerCount, "Layer {} is out of range, the array has {} layers", layer, _layerCount);
+
+	const bool sameShape =
+		source.GetFormat() == _description.Format &&
+		source.GetWidth() == _description.Width &&
+		source.GetHeight() == _description.Height;
+
+	// Blocks can be copied but not rendered to, so a compressed layer has to come from an identical texture
+	if ((IsCompressedFormat(_description.Format) || IsCompressedFormat(source.GetFormat())) &&
+		!(sameShape && source.GetMipLevelCount() >= _levelCount)) {
+		return false;
+	}
+
+	GLuint framebuffers[2] = { 0, 0 };
+	bool scissorWasEnabled = false;
+	for (uint32_t level = 0; level < _levelCount; level++) {
+		const GLsizei width = std::max(_description.Width >> level, 1u);
+		const GLsizei height = std::max(_description.Height >> level, 1u);
+
+		if (sameShape && level < source.GetMipLevelCount()) {
+			glCopyImageSubData(source.GetHandle(), GL_TEXTURE_2D, level, 0, 0, 0,
+				_handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+			continue;
+		}
+
+		// Resample from the smallest source level that still has at least as many texels, so that the blit's
+		// linear filter doesn't skip over texels and alias
+		uint32_t sourceLevel = 0;
+		while (sourceLevel + 1 < source.GetMipLevelCount() &&
+			std::max(source.GetWidth() >> (sourceLevel + 1), 1u) >= (uint32_t)width &&
+			std::max(source.GetHeight() >> (sourceLevel + 1), 1u) >= (uint32_t)height) {
+			sourceLevel++;
+		}
+
+		// The blit goes through framebuffer objects that are never bound, so the GL state cache isn't disturbed.
+		// Blits are still clipped by the scissor test though, so it's turned off until we're done
+		if (framebuffers[0] == 0) {
+			glCreateFramebuffers(2, framebuffers);
+			glNamedFramebufferReadBuffer(framebuffers[0], GL_COLOR_ATTACHMENT0);
+			glNamedFramebufferDrawBuffer(framebuffers[1], GL_COLOR_ATTACHMENT0);
+			scissorWasEnabled = GLStateCache::IsEnabled(GL_SCISSOR_TEST);
+			GLStateCache::SetEnabled(GL_SCISSOR_TEST, false);
+		}
+		glNamedFramebufferTexture(framebuffers[0], GL_COLOR_ATTACHMENT0, source.GetHandle(), sourceLevel);
+		glNamedFramebufferTextureLayer(framebuffers[1], GL_COLOR_ATTACHMENT0, _handle, level, layer);
+		glBlitNamedFramebuffer(framebuffers[0], framebuffers[1],
+			0, 0, std::max(source.GetWidth() >> sourceLevel, 1u), std::max(source.GetHeight() >> sourceLevel, 1u),
+			0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	}
+	if (framebuffers[0] != 0) {
+		glDeleteFramebuffers(2, framebuffers);
+		GLStateCache::SetEnabled(GL_SCISSOR_TEST, scissorWasEnabled);
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <memory>
+#include <cstdint>
+
+#include "ITexture.h"
+#include "Texture2D.h"
+#include "TextureEnums.h"
+
+/// <summary>
+/// Represents a wrapper around a 2D array texture, where every layer has the same size, format and number of mip
+/// levels. Shaders sample it with a sampler2DArray, passing the layer as the third texture coordinate
+/// </summary>
+class Texture2DArray final : public ITexture
+{
+public:
+	// We'll disallow moving and copying, since we want to manually control when the destructor is called
+	// We'll use these classes via pointers
+	Texture2DArray(const Texture2DArray& other) = delete;
+	Texture2DArray(Texture2DArray&& other) = delete;
+	Texture2DArray& operator=(const Texture2DArray& other) = delete;
+	Texture2DArray& operator=(Texture2DArray&& other) = delete;
+
+	typedef std::shared_ptr<Texture2DArray> sptr;
+	static inline sptr Create(const Texture2DDescription& description, uint32_t layerCount) {
+		return std::make_shared<Texture2DArray>(description, layerCount);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new array texture and allocates storage for all of its layers
+	/// </summary>
+	/// <param name="description">The size, format, mip levels and sampling of every layer. MipLevels of 0 allocates a full chain</param>
+	/// <param name="layerCount">The number of layers to allocate</param>
+	Texture2DArray(const Texture2DDescription& description, uint32_t layerCount);
+	// ITexture handles destroying the OpenGL data, so we can use the default destructor
+	~Texture2DArray() = default;
+
+	/// <summary>
+	/// Copies a 2D texture into one of the layers. Textures of the same format and size are copied on the GPU as-is
+	/// with all of their mip levels, including compressed ones. Anything else is resampled with a linear blit, each
+	/// level from the closest source level that is at least as large, which only works for uncompressed formats
+	/// </summary>
+	/// <param name="layer">The layer to copy into</param>
+	/// <param name="source">The texture to copy from</param>
+	/// <returns>True if the texture was copied, false if it would need a compressed format to be resampled</returns>
+	bool CopyLayer(uint32_t layer, Texture2D& source);
+
+	uint32_t GetWidth() const { return _description.Width; }
+	uint32_t GetHeight() const { return _description.Height; }
+	InternalFormat GetFormat() const { return _description.Format; }
+	uint32_t GetLayerCount() const { return _layerCount; }
+	uint32_t GetMipLevelCount() const { return _levelCount; }
+
+	const Texture2DDescription& GetDescription() const { return _description; }
+
+private:
+	Texture2DDescription _description;
+	uint32_t _layerCount;
+	uint32_t _levelCount;
+};
@@ -1,15 +1,31 @@
 #include "Texture2DData.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <stb_image.h>
 
-Texture2DData::Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat) :
+#include "Graphics/BlockCompression.h"
+#include "Graphics/MipChainCache.h"
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureContainer.h"
+
+Texture2DData::Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat, uint32_t levelCount) :
 	_width(width), _height(height), _format(format), _type(type), _data(nullptr), _recommendedFormat(recommendedFormat)
 {
-	LOG_ASSERT(width > 0 & height > 0, "Width and height must both be greater than zero! Got {}x{}", width, height);
-	_dataSize = width * (size_t)height * GetTexelSize(_format, _type);
-	_data = malloc(_dataSize);
-	LOG_ASSERT(_data != nullptr, "Failed to allocate texture data!");
+	LOG_ASSERT(width > 0 && height > 0, "Width and height must both be greater than zero! Got {}x{}", width, height);
+	LOG_ASSERT(!IsCompressedFormat(recommendedFormat), "Use the compressed constructor for compressed data!");
+	_AllocateLevels(levelCount);
+	if (sourceData != nullptr) {
+		memcpy(_data, sourceData, _dataSize);
+	}
+}
+
+Texture2DData::Texture2DData(uint32_t width, uint32_t height, InternalFormat compressedFormat, uint32_t levelCount, const void* sourceData) :
+	_width(width), _height(height), _format(PixelFormat::RGBA), _type(PixelType::UByte), _data(nullptr), _recommendedFormat(compressedFormat)
+{
+	LOG_ASSERT(width > 0 && height > 0, "Width and height must both be greater than zero! Got {}x{}", width, height);
+	LOG_ASSERT(IsCompressedFormat(compressedFormat), "{} is not a compressed format!", compressedFormat);
+	_AllocateLevels(levelCount);
 	if (sourceData != nullptr) {
 		memcpy(_data, sourceData, _dataSize);
 	}
@@ -19,8 +35,52 @@ Texture2DData::~Texture2DData() {
 	free(_data);
 }
 
-Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool forceRgba)
+void Texture2DData::_AllocateLevels(uint32_t levelCount) {
+	LOG_ASSERT(levelCount > 0, "Texture data must have at least one level!");
+	_levels.resize(levelCount);
+	_dataSize = 0;
+	for (uint32_t ix = 0; ix < levelCount; ix++) {
+		MipLevel& level = _levels[ix];
+		level.Width  = std::max(_width >> ix, 1u);
+		level.Height = std::max(_height >> ix, 1u);
+		level.Offset = _dataSize;
+		level.Size   = IsCompressed() ?
+			GetImageSize(_recommendedFormat, level.Width, level.Height) :
+			level.Width * (size_t)level.Height * GetTexelSize(_format, _type);
+		_dataSize += level.Size;
+	}
+	_data = malloc(_dataSize);
+	LOG_ASSERT(_data != nullptr, "Failed to allocate texture data!");
+}
+
+Texture2DData::sptr Texture2DData::Decompress() const {
+	return BlockCompression::Decompress(*this);
+}
+
+Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool forceRgba, bool allowCompressed)
 {
+	// Pre-compressed containers are loaded as-is
+	std::string extension = std::filesystem::path(file).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	if (extension == ".dds") {
+		return TextureContainer::LoadDDS(file);
+	}
+	if (extension == ".ktx2") {
+		return TextureContainer::LoadKTX2(file);
+	}
+
+	// Prefer a compressed copy made by the TextureCompressor, as long as it was made from this version of the image
+	if (allowCompressed && !forceRgba) {
+		const std::string compressedPath = TextureContainer::GetCompressedPath(file);
+		if (TextureContainer::IsCompressedCopyValid(file, compressedPath)) {
+			Texture2DData::sptr result = TextureContainer::LoadDDS(compressedPath);
+			if (result != nullptr) {
+				result->DebugName = std::filesystem::path(file).filename().string();
+				return result;
+			}
+		}
+	}
+
 	// Variables that will store properties about our image
 	int width, height, numChannels;
 	const int targetChannels = forceRgba ? 4 : 0;
@@ -81,3 +141,31 @@ Texture2DData::sptr Texture2DData::LoadFromFile(const std::string& file, bool fo
 
 	return result;
 }
+
+Texture2DData::sptr Texture2DData::LoadWithMips(const std::string& file, MipFilter filter, bool gammaCorrect)
+{
+	// Containers and compressed copies already store their own mip chains
+	std::string extension = std::filesystem::path(file).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	if (extension == ".dds" || extension == ".ktx2" ||
+		TextureContainer::IsCompressedCopyValid(file, TextureContainer::GetCompressedPath(file))) {
+		return LoadFromFile(file);
+	}
+
+	Texture2DData::sptr result = MipChainCache::Load(file, filter, gammaCorrect);
+	if (result != nullptr) {
+		return result;
+	}
+
+	Texture2DData::sptr source = LoadFromFile(file, false, false);
+	if (source == nullptr) {
+		return nullptr;
+	}
+	result = MipGenerator::Generate(*source, filter, gammaCorrect);
+	if (result == nullptr) {
+		// We can only filter 8 bit images, anything else gets its mips from the driver
+		return source;
+	}
+	MipChainCache::Save(file, *result, filter, gammaCorrect);
+	return result;
+}
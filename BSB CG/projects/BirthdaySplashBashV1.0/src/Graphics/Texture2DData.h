@@ -1,11 +1,16 @@
 #pragma once
 #include <memory>
+#include <string>
+#include <vector>
 #include <cstdint>
 
 #include "TextureEnums.h"
 
+enum class MipFilter : uint8_t;
+
 /// <summary>
-/// Stores data required to upload texture data into OpenGL
+/// Stores data required to upload texture data into OpenGL. The data may contain several mip levels, which
+/// are stored back to back starting with the largest, and may be block compressed (see IsCompressed)
 /// </summary>
 class Texture2DData final
 {
@@ -27,16 +32,47 @@ public:
 	/// <param name="type">The component type of the pixel (ex: uint8_t)</param>
 	/// <param name="sourceData">A pointer to the data to upload to this texture</param>
 	/// <param name="recommendedFormat">The recommended internal format to use when creating textures from this data</param>
-	Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat = InternalFormat::Unknown);
+	/// <param name="levelCount">The number of mip levels stored in sourceData</param>
+	Texture2DData(uint32_t width, uint32_t height, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat = InternalFormat::Unknown, uint32_t levelCount = 1);
+	/// <summary>
+	/// Creates a new block compressed 2D texture data object
+	/// </summary>
+	/// <param name="width">The width of the largest mip level, in pixels</param>
+	/// <param name="height">The height of the largest mip level, in pixels</param>
+	/// <param name="compressedFormat">The compressed format of the data (ex: BC1)</param>
+	/// <param name="levelCount">The number of mip levels stored in sourceData</param>
+	/// <param name="sourceData">A pointer to the compressed blocks to copy, or nullptr to leave the data uninitialized</param>
+	Texture2DData(uint32_t width, uint32_t height, InternalFormat compressedFormat, uint32_t levelCount, const void* sourceData);
 	~Texture2DData();
 
 	/// <summary>
-	/// Loads image data from an external file
+	/// Loads image data from an external file. DDS and KTX2 files are loaded as compressed data, anything else is
+	/// decoded with STBI. If a compressed copy of an image has been made with TextureCompressor and still matches
+	/// the source image, the compressed copy is loaded instead
 	/// </summary>
 	/// <param name="file">The path of the file to load</param>
 	/// <param name="forceRgba">True to force STBI to load 4 component texture data</param>
+	/// <param name="allowCompressed">False to always decode the image itself, ignoring any compressed copy</param>
 	/// <returns>A pointer to the data loaded from the file, or nullptr if the file failed to load</returns>
-	static Texture2DData::sptr LoadFromFile(const std::string& file, bool forceRgba = false);
+	static Texture2DData::sptr LoadFromFile(const std::string& file, bool forceRgba = false, bool allowCompressed = true);
+	/// <summary>
+	/// Loads an image along with a full mip chain. A valid compressed copy is used as-is (it has its own mips),
+	/// otherwise the chain is loaded from the MipChainCache, or generated with the MipGenerator and then cached
+	/// so that later loads can skip both the decode and the filtering. This is slow on a cache miss, so it
+	/// should be called from a worker thread
+	/// </summary>
+	/// <param name="file">The path of the image to load</param>
+	/// <param name="filter">The filter to generate the mip chain with</param>
+	/// <param name="gammaCorrect">True to filter the color channels in linear space</param>
+	/// <returns>A pointer to the data loaded from the file, or nullptr if the file failed to load</returns>
+	static Texture2DData::sptr LoadWithMips(const std::string& file, MipFilter filter, bool gammaCorrect = true);
+
+	/// <summary>
+	/// Decompresses block compressed data into plain 8 bit data, keeping all of the mip levels. Used when the
+	/// GPU does not support the compressed format
+	/// </summary>
+	/// <returns>The decompressed data, or nullptr if this format can not be decompressed on the CPU</returns>
+	Texture2DData::sptr Decompress() const;
 
 	/// <summary>
 	/// Gets the width of the texture data, in pixels
@@ -60,19 +96,61 @@ public:
 	/// </summary>
 	InternalFormat  GetRecommendedFormat() const { return _recommendedFormat; }
 	/// <summary>
-	/// Get the total size of the underlying data (size of individual pixel * width * height)
+	/// Returns true if the data is block compressed, in which case GetRecommendedFormat returns the compressed
+	/// format and the data must be uploaded with glCompressedTextureSubImage2D
+	/// </summary>
+	bool IsCompressed() const { return IsCompressedFormat(_recommendedFormat); }
+	/// <summary>
+	/// Get the total size of the underlying data, including all mip levels
 	/// </summary>
 	size_t  GetDataSize() const { return _dataSize; }
 	/// <summary>
 	/// Gets a readonly copy of the underlying data in this image for upload
 	/// </summary>
 	const void* GetDataPtr() const { return _data; }
+	/// <summary>
+	/// Gets a pointer to the underlying data, for filling in data that was created without a source
+	/// </summary>
+	void* GetDataPtr() { return _data; }
+
+	/// <summary>
+	/// Gets the number of mip levels stored in this data, this is at least 1
+	/// </summary>
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(_levels.size()); }
+	/// <summary>
+	/// Gets the width of the given mip level, in pixels
+	/// </summary>
+	uint32_t GetLevelWidth(uint32_t level) const { return _levels[level].Width; }
+	/// <summary>
+	/// Gets the height of the given mip level, in pixels
+	/// </summary>
+	uint32_t GetLevelHeight(uint32_t level) const { return _levels[level].Height; }
+	/// <summary>
+	/// Gets the size of the given mip level, in bytes
+	/// </summary>
+	size_t GetLevelDataSize(uint32_t level) const { return _levels[level].Size; }
+	/// <summary>
+	/// Gets a pointer to the start of the given mip level
+	/// </summary>
+	const void* GetLevelDataPtr(uint32_t level) const { return static_cast<const uint8_t*>(_data) + _levels[level].Offset; }
+	void* GetLevelDataPtr(uint32_t level) { return static_cast<uint8_t*>(_data) + _levels[level].Offset; }
 
 private:
+	struct MipLevel {
+		uint32_t Width, Height;
+		size_t   Offset, Size;
+	};
+
 	uint32_t    _width, _height;
+	std::vector<MipLevel> _levels;
 	size_t      _dataSize;
 	PixelFormat _format;
 	PixelType   _type;
 	InternalFormat _recommendedFormat;
 	void* _data;
+
+	/// <summary>
+	/// Works out the size and offset of every mip level, and allocates the data for all of them
+	/// </summary>
+	void _AllocateLevels(uint32_t levelCount);
 };
\ No newline at end of file
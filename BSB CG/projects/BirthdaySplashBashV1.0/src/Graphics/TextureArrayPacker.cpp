@@ -0,0 +1,90 @@
+#include "TextureArrayPacker.h"
+
+#include <algorithm>
+
+#include "Logging.h"
+
+bool TextureArrayPacker::_CanShareArray(const Texture2D& a, const Texture2D& b) {
+	if (a.GetFormat() != b.GetFormat() ||
+		a.GetWrapS() != b.GetWrapS() ||
+		a.GetWrapT() != b.GetWrapT() ||
+		a.GetMinFilter() != b.GetMinFilter() ||
+		a.GetMagFilter() != b.GetMagFilter()) {
+		return false;
+	}
+	// Compressed layers are copied block for block, so they can't be resampled
+	if (IsCompressedFormat(a.GetFormat())) {
+		return a.GetWidth() == b.GetWidth() && a.GetHeight() == b.GetHeight() && a.GetMipLevelCount() == b.GetMipLevelCount();
+	}
+	return true;
+}
+
+std::vector<TextureArrayPacker::Placement> TextureArrayPacker::Pack(const std::vector<Texture2D::sptr>& textures) {
+	std::vector<Placement> result(textures.size());
+
+	// Each group holds indices into textures, only the first index of any duplicates is kept
+	std::vector<std::vector<size_t>> groups;
+	for (size_t ix = 0; ix < textures.size(); ix++) {
+		const Texture2D::sptr& texture = textures[ix];
+		if (texture == nullptr || texture->GetWidth() * texture->GetHeight() == 0 || texture->GetFormat() == InternalFormat::Unknown) {
+			continue;
+		}
+		if (std::find(textures.begin(), textures.begin() + ix, texture) != textures.begin() + ix) {
+			continue;
+		}
+		auto it = std::find_if(groups.begin(), groups.end(), [&](const std::vector<size_t>& group) {
+			return _CanShareArray(*textures[group[0]], *texture);
+		});
+		if (it != groups.end()) {
+			it->push_back(ix);
+		} else {
+			groups.push_back({ ix });
+		}
+	}
+
+	const size_t maxLayers = (size_t)std::max(ITexture::GetLimits().MAX_ARRAY_TEXTURE_LAYERS, 1);
+	for (const std::vector<size_t>& group : groups) {
+		for (size_t start = 0; start < group.size(); start += maxLayers) {
+			const size_t count = std::min(group.size() - start, maxLayers);
+			if (count < 2) {
+				continue;
+			}
+
+			// Uncompressed layers get resampled up to the largest texture, and get a full mip chain
+			const Texture2D& first = *textures[group[start]];
+			Texture2DDescription description = first.GetDescription();
+			if (!IsCompressedFormat(first.GetFormat())) {
+				for (size_t ix = start; ix < start + count; ix++) {
+					description.Width = std::max(description.Width, textures[group[ix]]->GetWidth());
+					description.Height = std::max(description.Height, textures[group[ix]]->GetHeight());
+				}
+				description.MipLevels = 0;
+			} else {
+				description.MipLevels = first.GetMipLevelCount();
+			}
+
+			Texture2DArray::sptr array = Texture2DArray::Create(description, (uint32_t)count);
+			for (size_t ix = start; ix < start + count; ix++) {
+				const uint32_t layer = (uint32_t)(ix - start);
+				if (array->CopyLayer(layer, *textures[group[ix]])) {
+					result[group[ix]].Array = array;
+					result[group[ix]].Layer = layer;
+				} else {
+					LOG_WARN("Could not copy texture {} into layer {} of a texture array", textures[group[ix]]->GetHandle(), layer);
+				}
+			}
+			LOG_INFO("Packed {} textures into a {}x{} {} texture array", count, description.Width, description.Height, ~description.Format);
+		}
+	}
+
+	// Duplicates share the placement of the first copy
+	for (size_t ix = 0; ix < textures.size(); ix++) {
+		if (result[ix].Array == nullptr && textures[ix] != nullptr) {
+			auto it = std::find(textures.begin(), textures.begin() + ix, textures[ix]);
+			if (it != textures.begin() + ix) {
+				result[ix] = result[it - textures.begin()];
+			}
+		}
+	}
+	return result;
+}
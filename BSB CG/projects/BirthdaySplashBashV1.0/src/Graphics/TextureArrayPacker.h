@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Graphics/Texture2D.h"
+#include "Graphics/Texture2DArray.h"
+
+/// <summary>
+/// Packs a set of 2D textures into as few array textures as possible, so that things drawn with different
+/// textures can share a single texture binding and pick their layer per draw.
+///
+/// Textures are grouped by format and sampling settings. Uncompressed textures of different sizes are resampled
+/// to the largest size in their group, while compressed textures can only share an array with textures of the
+/// exact same size and mip count. Groups larger than the GPU's layer limit are split over several arrays
+/// </summary>
+class TextureArrayPacker
+{
+public:
+	/// <summary>
+	/// Where a texture ended up, Array is null if the texture wasn't packed
+	/// </summary>
+	struct Placement {
+		Texture2DArray::sptr Array;
+		uint32_t             Layer = 0;
+	};
+
+	/// <summary>
+	/// Packs the textures into arrays. Textures must have finished loading. Textures that are empty, or that would
+	/// be the only layer in their array (which would save nothing), are left unpacked. The same texture can appear
+	/// more than once, and gets the same layer each time
+	/// </summary>
+	/// <param name="textures">The textures to pack</param>
+	/// <returns>The placement of each texture, in the same order as textures</returns>
+	static std::vector<Placement> Pack(const std::vector<Texture2D::sptr>& textures);
+
+protected:
+	TextureArrayPacker() = default;
+	~TextureArrayPacker() = default;
+
+	/// <summary>
+	/// Returns true if two textures can go in the same array
+	/// </summary>
+	static bool _CanShareArray(const Texture2D& a, const Texture2D& b);
+};
@@ -0,0 +1,316 @@
+#include "TextureContainer.h"
+
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#include "Logging.h"
+#include "Utilities/FileUtils.h"
+#include "Utilities/MappedFile.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+		return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+	}
+
+	// See https://docs.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
+	constexpr uint32_t DDS_MAGIC              = MakeFourCC('D', 'D', 'S', ' ');
+	constexpr uint32_t DDSD_CAPS              = 0x1;
+	constexpr uint32_t DDSD_HEIGHT            = 0x2;
+	constexpr uint32_t DDSD_WIDTH             = 0x4;
+	constexpr uint32_t DDSD_PIXELFORMAT       = 0x1000;
+	constexpr uint32_t DDSD_MIPMAPCOUNT       = 0x20000;
+	constexpr uint32_t DDSD_LINEARSIZE        = 0x80000;
+	constexpr uint32_t DDPF_FOURCC            = 0x4;
+	constexpr uint32_t DDSCAPS_COMPLEX        = 0x8;
+	constexpr uint32_t DDSCAPS_TEXTURE        = 0x1000;
+	constexpr uint32_t DDSCAPS_MIPMAP         = 0x400000;
+	constexpr uint32_t DDSCAPS2_CUBEMAP       = 0x200;
+	constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+	constexpr uint32_t DDS_RESOURCE_MISC_CUBE = 0x4;
+
+	// Used to tag compressed copies made by the TextureCompressor, stored in the reserved part of the DDS header
+	constexpr uint32_t FINGERPRINT_TAG        = MakeFourCC('B', 'S', 'B', 'T');
+
+	struct DdsPixelFormat {
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t FourCC;
+		uint32_t RGBBitCount;
+		uint32_t RBitMask, GBitMask, BBitMask, ABitMask;
+	};
+
+	struct DdsHeader {
+		uint32_t       Size;
+		uint32_t       Flags;
+		uint32_t       Height;
+		uint32_t       Width;
+		uint32_t       PitchOrLinearSize;
+		uint32_t       Depth;
+		uint32_t       MipMapCount;
+		uint32_t       Reserved1[11];
+		DdsPixelFormat PixelFormat;
+		uint32_t       Caps, Caps2, Caps3, Caps4;
+		uint32_t       Reserved2;
+	};
+	static_assert(sizeof(DdsHeader) == 124, "DDS header must match the file layout");
+
+	struct DdsHeaderDx10 {
+		uint32_t DxgiFormat;
+		uint32_t ResourceDimension;
+		uint32_t MiscFlag;
+		uint32_t ArraySize;
+		uint32_t MiscFlags2;
+	};
+
+	// See https://github.khronos.org/KTX-Specification/
+	const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct Ktx2Header {
+		uint8_t  Identifier[12];
+		uint32_t VkFormat;
+		uint32_t TypeSize;
+		uint32_t PixelWidth, PixelHeight, PixelDepth;
+		uint32_t LayerCount;
+		uint32_t FaceCount;
+		uint32_t LevelCount;
+		uint32_t SupercompressionScheme;
+		uint32_t DfdByteOffset, DfdByteLength;
+		uint32_t KvdByteOffset, KvdByteLength;
+		uint64_t SgdByteOffset, SgdByteLength;
+	};
+	static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must match the file layout");
+
+	struct Ktx2Level {
+		uint64_t ByteOffset;
+		uint64_t ByteLength;
+		uint64_t UncompressedByteLength;
+	};
+
+	/// <summary>
+	/// Gets our format for a DXGI format code, the sRGB variants are treated as linear since the rest
+	/// of our textures are not sRGB either
+	/// </summary>
+	InternalFormat FromDxgiFormat(uint32_t format) {
+		switch (format) {
+			case 71: case 72: return InternalFormat::BC1; // DXGI_FORMAT_BC1_UNORM(_SRGB)
+			case 77: case 78: return InternalFormat::BC3; // DXGI_FORMAT_BC3_UNORM(_SRGB)
+			case 83:          return InternalFormat::BC5; // DXGI_FORMAT_BC5_UNORM
+			case 98: case 99: return InternalFormat::BC7; // DXGI_FORMAT_BC7_UNORM(_SRGB)
+			default:          return InternalFormat::Unknown;
+		}
+	}
+
+	uint32_t ToDxgiFormat(InternalFormat format) {
+		switch (format) {
+			case InternalFormat::BC1: return 71;
+			case InternalFormat::BC3: return 77;
+			case InternalFormat::BC5: return 83;
+			case InternalFormat::BC7: return 98;
+			default:                  return 0;
+		}
+	}
+
+	InternalFormat FromVkFormat(uint32_t format) {
+		switch (format) {
+			case 131: case 132: case 133: case 134: return InternalFormat::BC1; // VK_FORMAT_BC1_RGB(A)_UNORM/SRGB_BLOCK
+			case 137: case 138:                     return InternalFormat::BC3; // VK_FORMAT_BC3_UNORM/SRGB_BLOCK
+			case 141:                               return InternalFormat::BC5; // VK_FORMAT_BC5_UNORM_BLOCK
+			case 145: case 146:                     return InternalFormat::BC7; // VK_FORMAT_BC7_UNORM/SRGB_BLOCK
+			default:                                return InternalFormat::Unknown;
+		}
+	}
+}
+
+std::string TextureContainer::GetCompressedPath(const std::string& sourceFile) {
+	return sourceFile + ".dds";
+}
+
+bool TextureContainer::IsCompressedCopyValid(const std::string& sourceFile, const std::string& compressedFile) {
+	std::ifstream file(compressedFile, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	uint32_t magic = 0;
+	DdsHeader header = {};
+	file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+	file.read(reinterpret_cast<char*>(&header), sizeof(DdsHeader));
+	if (!file || magic != DDS_MAGIC || header.Reserved1[0] != FINGERPRINT_TAG) {
+		return false;
+	}
+
+	const uint64_t size = (uint64_t)header.Reserved1[1] | ((uint64_t)header.Reserved1[2] << 32);
+	const uint64_t hash = (uint64_t)header.Reserved1[3] | ((uint64_t)header.Reserved1[4] << 32);
+	return FileUtils::IsSourceUnchanged(sourceFile, size, hash);
+}
+
+Texture2DData::sptr TextureContainer::LoadDDS(const std::string& file) {
+	MappedFile source(file);
+	if (!source.IsOpen() || source.GetSize() < sizeof(uint32_t) + sizeof(DdsHeader)) {
+		LOG_WARN("Failed to load DDS file \"{}\"", file);
+		return nullptr;
+	}
+
+	const uint8_t* data = source.GetData();
+	uint32_t magic;
+	DdsHeader header;
+	memcpy(&magic, data, sizeof(uint32_t));
+	memcpy(&header, data + sizeof(uint32_t), sizeof(DdsHeader));
+	size_t offset = sizeof(uint32_t) + sizeof(DdsHeader);
+	if (magic != DDS_MAGIC || header.Size != sizeof(DdsHeader) || header.Width == 0 || header.Height == 0) {
+		LOG_WARN("\"{}\" is not a DDS file", file);
+		return nullptr;
+	}
+	if (header.Caps2 & DDSCAPS2_CUBEMAP) {
+		LOG_WARN("\"{}\" is a cube map, only 2D DDS textures are supported", file);
+		return nullptr;
+	}
+
+	InternalFormat format = InternalFormat::Unknown;
+	if (header.PixelFormat.Flags & DDPF_FOURCC) {
+		switch (header.PixelFormat.FourCC) {
+			case MakeFourCC('D', 'X', 'T', '1'): format = InternalFormat::BC1; break;
+			case MakeFourCC('D', 'X', 'T', '5'): format = InternalFormat::BC3; break;
+			case MakeFourCC('A', 'T', 'I', '2'):
+			case MakeFourCC('B', 'C', '5', 'U'): format = InternalFormat::BC5; break;
+			case MakeFourCC('D', 'X', '1', '0'): {
+				DdsHeaderDx10 dx10;
+				if (source.GetSize() < offset + sizeof(DdsHeaderDx10)) {
+					LOG_WARN("DDS file \"{}\" is truncated", file);
+					return nullptr;
+				}
+				memcpy(&dx10, data + offset, sizeof(DdsHeaderDx10));
+				offset += sizeof(DdsHeaderDx10);
+				if (dx10.ResourceDimension != DDS_DIMENSION_TEXTURE2D || dx10.ArraySize > 1 || (dx10.MiscFlag & DDS_RESOURCE_MISC_CUBE)) {
+					LOG_WARN("\"{}\" is not a 2D texture, only 2D DDS textures are supported", file);
+					return nullptr;
+				}
+				format = FromDxgiFormat(dx10.DxgiFormat);
+				break;
+			}
+		}
+	}
+	if (format == InternalFormat::Unknown) {
+		LOG_WARN("DDS file \"{}\" does not use one of the supported formats (BC1, BC3, BC5, BC7)", file);
+		return nullptr;
+	}
+
+	uint32_t levelCount = (header.Flags & DDSD_MIPMAPCOUNT) ? std::max(header.MipMapCount, 1u) : 1u;
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(header.Width, header.Height, format, levelCount, nullptr);
+	if (source.GetSize() < offset + result->GetDataSize()) {
+		LOG_WARN("DDS file \"{}\" is truncated", file);
+		return nullptr;
+	}
+	// DDS stores the levels back to back from largest to smallest, just like we do
+	memcpy(result->GetDataPtr(), data + offset, result->GetDataSize());
+	result->DebugName = fs::path(file).filename().string();
+	return result;
+}
+
+Texture2DData::sptr TextureContainer::LoadKTX2(const std::string& file) {
+	MappedFile source(file);
+	if (!source.IsOpen() || source.GetSize() < sizeof(Ktx2Header)) {
+		LOG_WARN("Failed to load KTX2 file \"{}\"", file);
+		return nullptr;
+	}
+
+	const uint8_t* data = source.GetData();
+	Ktx2Header header;
+	memcpy(&header, data, sizeof(Ktx2Header));
+	if (memcmp(header.Identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0 || header.PixelWidth == 0 || header.PixelHeight == 0) {
+		LOG_WARN("\"{}\" is not a KTX2 file", file);
+		return nullptr;
+	}
+	if (header.PixelDepth > 1 || header.LayerCount > 1 || header.FaceCount != 1) {
+		LOG_WARN("\"{}\" is not a 2D texture, only 2D KTX2 textures are supported", file);
+		return nullptr;
+	}
+	if (header.SupercompressionScheme != 0) {
+		LOG_WARN("KTX2 file \"{}\" is supercompressed, which is not supported", file);
+		return nullptr;
+	}
+	const InternalFormat format = FromVkFormat(header.VkFormat);
+	if (format == InternalFormat::Unknown) {
+		LOG_WARN("KTX2 file \"{}\" does not use one of the supported formats (BC1, BC3, BC5, BC7)", file);
+		return nullptr;
+	}
+
+	// A level count of 0 means the file wants the mips generated at runtime, we just load the base level
+	const uint32_t levelCount = std::max(header.LevelCount, 1u);
+	if (source.GetSize() < sizeof(Ktx2Header) + levelCount * sizeof(Ktx2Level)) {
+		LOG_WARN("KTX2 file \"{}\" is truncated", file);
+		return nullptr;
+	}
+
+	Texture2DData::sptr result = std::make_shared<Texture2DData>(header.PixelWidth, header.PixelHeight, format, levelCount, nullptr);
+	for (uint32_t ix = 0; ix < levelCount; ix++) {
+		Ktx2Level level;
+		memcpy(&level, data + sizeof(Ktx2Header) + ix * sizeof(Ktx2Level), sizeof(Ktx2Level));
+		// Unlike DDS, KTX2 stores the smallest levels first, so each level needs to be copied into place
+		if (level.ByteLength != result->GetLevelDataSize(ix) || level.ByteOffset + level.ByteLength > source.GetSize()) {
+			LOG_WARN("KTX2 file \"{}\" has an invalid size for level {}", file, ix);
+			return nullptr;
+		}
+		memcpy(result->GetLevelDataPtr(ix), data + level.ByteOffset, level.ByteLength);
+	}
+	result->DebugName = fs::path(file).filename().string();
+	return result;
+}
+
+bool TextureContainer::SaveDDS(const std::string& file, const Texture2DData& data, const std::string& sourceFile) {
+	LOG_ASSERT(data.IsCompressed(), "Only compressed data can be saved to DDS files");
+
+	DdsHeader header = {};
+	header.Size              = sizeof(DdsHeader);
+	header.Flags             = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+	header.Width             = data.GetWidth();
+	header.Height            = data.GetHeight();
+	header.PitchOrLinearSize = (uint32_t)data.GetLevelDataSize(0);
+	header.MipMapCount       = data.GetLevelCount();
+	header.Caps              = DDSCAPS_TEXTURE;
+	if (data.GetLevelCount() > 1) {
+		header.Flags |= DDSD_MIPMAPCOUNT;
+		header.Caps  |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+	}
+	header.PixelFormat.Size  = sizeof(DdsPixelFormat);
+	header.PixelFormat.Flags = DDPF_FOURCC;
+
+	// Stick to the legacy codes where we can since more tools understand them, BC7 needs the extended header
+	DdsHeaderDx10 dx10 = {};
+	switch (data.GetRecommendedFormat()) {
+		case InternalFormat::BC1: header.PixelFormat.FourCC = MakeFourCC('D', 'X', 'T', '1'); break;
+		case InternalFormat::BC3: header.PixelFormat.FourCC = MakeFourCC('D', 'X', 'T', '5'); break;
+		case InternalFormat::BC5: header.PixelFormat.FourCC = MakeFourCC('A', 'T', 'I', '2'); break;
+		default:
+			header.PixelFormat.FourCC = MakeFourCC('D', 'X', '1', '0');
+			dx10.DxgiFormat        = ToDxgiFormat(data.GetRecommendedFormat());
+			dx10.ResourceDimension = DDS_DIMENSION_TEXTURE2D;
+			dx10.ArraySize         = 1;
+			break;
+	}
+
+	if (!sourceFile.empty()) {
+		uint64_t size, hash;
+		if (!FileUtils::FingerprintFile(sourceFile, size, hash)) {
+			LOG_WARN("Could not read \"{}\" to fingerprint it", sourceFile);
+			return false;
+		}
+		header.Reserved1[0] = FINGERPRINT_TAG;
+		header.Reserved1[1] = (uint32_t)size;
+		header.Reserved1[2] = (uint32_t)(size >> 32);
+		header.Reserved1[3] = (uint32_t)hash;
+		header.Reserved1[4] = (uint32_t)(hash >> 32);
+	}
+
+	std::vector<FileUtils::Chunk> chunks = {
+		{ &DDS_MAGIC, sizeof(uint32_t) },
+		{ &header, sizeof(DdsHeader) }
+	};
+	if (header.PixelFormat.FourCC == MakeFourCC('D', 'X', '1', '0')) {
+		chunks.push_back({ &dx10, sizeof(DdsHeaderDx10) });
+	}
+	chunks.push_back({ data.GetDataPtr(), data.GetDataSize() });
+	return FileUtils::WriteFileAtomic(file, chunks);
+}
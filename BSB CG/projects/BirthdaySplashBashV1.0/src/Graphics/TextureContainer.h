@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+
+#include "Graphics/Texture2DData.h"
+
+/// <summary>
+/// Reads and writes the container formats used for pre-compressed textures (DDS and KTX2). Only 2D textures
+/// in one of the block compressed formats we support (BC1, BC3, BC5 and BC7) can be loaded, with all of their
+/// mip levels.
+///
+/// Note that like the rest of our textures, the blocks are expected to be stored bottom row first (the way
+/// OpenGL wants them), which is what the TextureCompressor writes. Files made by other tools will usually
+/// be stored top row first and will appear upside down
+/// </summary>
+class TextureContainer
+{
+public:
+	/// <summary>
+	/// Gets the path that the TextureCompressor writes the compressed copy of an image to
+	/// </summary>
+	/// <param name="sourceFile">The path of the source image (ex: images/Arena1/Ground.png)</param>
+	static std::string GetCompressedPath(const std::string& sourceFile);
+	/// <summary>
+	/// Checks whether a compressed copy exists and was made from the current contents of the source image.
+	/// If the source image is missing the compressed copy is trusted (ex: shipping builds without the PNGs)
+	/// </summary>
+	/// <param name="sourceFile">The path of the source image</param>
+	/// <param name="compressedFile">The path of the compressed copy</param>
+	static bool IsCompressedCopyValid(const std::string& sourceFile, const std::string& compressedFile);
+
+	/// <summary>
+	/// Loads a compressed 2D texture from a DDS file
+	/// </summary>
+	/// <param name="file">The path of the file to load</param>
+	/// <returns>The compressed data, or nullptr if the file could not be loaded or uses an unsupported format</returns>
+	static Texture2DData::sptr LoadDDS(const std::string& file);
+	/// <summary>
+	/// Loads a compressed 2D texture from a KTX2 file. Supercompressed files (Basis, Zstd) are not supported
+	/// </summary>
+	/// <param name="file">The path of the file to load</param>
+	/// <returns>The compressed data, or nullptr if the file could not be loaded or uses an unsupported format</returns>
+	static Texture2DData::sptr LoadKTX2(const std::string& file);
+
+	/// <summary>
+	/// Writes compressed texture data to a DDS file
+	/// </summary>
+	/// <param name="file">The path of the file to write</param>
+	/// <param name="data">The compressed data to write, including all mip levels</param>
+	/// <param name="sourceFile">The image the data was made from, which gets fingerprinted for IsCompressedCopyValid, or empty for none</param>
+	/// <returns>True if the file was written</returns>
+	static bool SaveDDS(const std::string& file, const Texture2DData& data, const std::string& sourceFile = "");
+
+protected:
+	TextureContainer() = default;
+	~TextureContainer() = default;
+};
@@ -1,4 +1,7 @@
 #include "TextureCubeMap.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
 
 TextureCubeMap::TextureCubeMap(const TextureCubeDesc& description) :
 	ITexture(), _description(description)
@@ -9,15 +12,20 @@ TextureCubeMap::TextureCubeMap(const TextureCubeDesc& description) :
 
 void TextureCubeMap::_RecreateTexture() {
 	if (_handle != 0) {
+		GLStateCache::ForgetTexture(_handle);
 		glDeleteTextures(1, &_handle);
 		_handle = 0;
 	}
+	_levelCount = 0;
 
 	glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &_handle);
 
 	if (_description.Size > 0 && _description.Format != InternalFormat::Unknown)
 	{
-		glTextureStorage2D(_handle, 1, *_description.Format, _description.Size, _description.Size);
+		const uint32_t fullChain = ::GetMipLevelCount(_description.Size, _description.Size);
+		_levelCount = _description.MipLevels > 0 ? std::min(_description.MipLevels, fullChain) : (_description.GenerateMipMaps ? fullChain : 1);
+		glTextureStorage2D(_handle, _levelCount, *_description.Format, _description.Size, _description.Size);
+		glTextureParameteri(_handle, GL_TEXTURE_MAX_LEVEL, _levelCount - 1);
 
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTextureParameteri(_handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -27,9 +35,11 @@ void TextureCubeMap::_RecreateTexture() {
 }
 
 void TextureCubeMap::LoadData(const TextureCubeMapData::sptr& data) {
-	if (_description.Size != data->GetSize())
+	const uint32_t levels = data->GetLevelCount() > 1 ? data->GetLevelCount() : _description.MipLevels;
+	if (_description.Size != data->GetSize() || _description.MipLevels != levels)
 	{
 		_description.Size = data->GetSize();
+		_description.MipLevels = levels;
 
 		if (_description.Format == InternalFormat::Unknown) {
 			_description.Format = data->GetRecommendedFormat();
@@ -46,12 +56,16 @@ void TextureCubeMap::LoadData(const TextureCubeMapData::sptr& data) {
 	// Align the data store to the size of a single component in
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
 	int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
-	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
 
-	// Upload our data to our image
-	glTextureSubImage3D(_handle, 0, 0, 0, 0, _description.Size, _description.Size, 6, *data->GetFormat(), *data->GetPixelType(), data->GetDataPtr());
+	// Upload our data to our image, all 6 faces of a mip level at a time
+	for (uint32_t level = 0; level < data->GetLevelCount() && level < _levelCount; level++) {
+		const uint32_t size = data->GetLevelSize(level);
+		glTextureSubImage3D(_handle, level, 0, 0, 0, size, size, 6, *data->GetFormat(), *data->GetPixelType(), data->GetLevelFaceDataPtr(level));
+	}
 
-	if (_description.GenerateMipMaps) {
+	// Data that brought its own levels (ex: a prefiltered environment) must not be overwritten by the driver
+	if (_description.GenerateMipMaps && _levelCount > 1 && data->GetLevelCount() == 1) {
 		glGenerateTextureMipmap(_handle);
 	}
 }
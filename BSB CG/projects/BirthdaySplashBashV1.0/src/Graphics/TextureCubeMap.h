@@ -11,13 +11,17 @@ struct TextureCubeDesc {
 	MinFilter      MinificationFilter;
 	MagFilter      MagnificationFilter;
 	bool           GenerateMipMaps;
+	// The number of mip levels to allocate storage for, data with its own mip levels overrides this. 0 allocates
+	// a full chain when GenerateMipMaps is set, or a single level otherwise
+	uint32_t       MipLevels;
 
 	TextureCubeDesc() :
 		Size(0),
 		Format(InternalFormat::Unknown),
 		MinificationFilter(MinFilter::Linear),
 		MagnificationFilter(MagFilter::Linear),
-		GenerateMipMaps(false)
+		GenerateMipMaps(false),
+		MipLevels(0)
 	{ }
 };
 
@@ -45,7 +49,7 @@ public:
 	~TextureCubeMap() = default;
 
 	/// <summary>
-	/// Uploads data to this texture
+	/// Uploads data to this texture, along with any mip levels it contains
 	/// </summary>
 	/// <param name="data">The texture data to upload into this texture</param>
 	void LoadData(const TextureCubeMapData::sptr& data);
@@ -54,6 +58,10 @@ public:
 
 	uint32_t GetSize() const { return _description.Size; }
 	InternalFormat GetFormat() const { return _description.Format; }
+	/// <summary>
+	/// Gets the number of mip levels that storage was allocated for
+	/// </summary>
+	uint32_t GetMipLevelCount() const { return _levelCount; }
 	MinFilter GetMinFilter() const { return _description.MinificationFilter; }
 	MagFilter GetMagFilter() const { return _description.MagnificationFilter; }
 
@@ -64,6 +72,7 @@ public:
 
 private:
 	TextureCubeDesc _description;
+	uint32_t _levelCount = 0;
 
 	void _RecreateTexture();
 };
@@ -1,11 +1,25 @@
 #include "TextureCubeMapData.h"
+#include <future>
+#include <algorithm>
 #include <filesystem>
+#include <stb_image.h>
 
-TextureCubeMapData::TextureCubeMapData(uint32_t size, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat) :
+#include "Graphics/EnvironmentPrefilter.h"
+
+TextureCubeMapData::TextureCubeMapData(uint32_t size, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat, uint32_t levelCount) :
 	_size(size), _format(format), _type(type), _data(nullptr), _recommendedFormat(recommendedFormat) {
 	LOG_ASSERT(size > 0, "Size must be greater than zero! Got {}", size)
-	_faceDataSize = (size_t)_size * _size * GetTexelSize(_format, _type);
-	_dataSize = _faceDataSize * 6;
+	LOG_ASSERT(levelCount > 0, "Texture data must have at least one level!");
+	_levels.resize(levelCount);
+	_dataSize = 0;
+	for (uint32_t ix = 0; ix < levelCount; ix++) {
+		MipLevel& level = _levels[ix];
+		level.Size   = std::max(_size >> ix, 1u);
+		level.Offset = _dataSize;
+		level.FaceDataSize = (size_t)level.Size * level.Size * GetTexelSize(_format, _type);
+		_dataSize += level.FaceDataSize * 6;
+	}
+	_faceDataSize = _levels[0].FaceDataSize;
 	_data = malloc(_dataSize);
 	LOG_ASSERT(_data != nullptr, "Failed to allocate texture data!")
 	if (sourceData != nullptr) {
@@ -36,14 +50,8 @@ TextureCubeMapData::sptr TextureCubeMapData::CreateFromImages(const std::vector<
 	return result;
 }
 
-TextureCubeMapData::sptr TextureCubeMapData::LoadFromImages(const std::string& rootImagePath) {
-	namespace fs = std::filesystem;
-	fs::path imagePath = fs::path(rootImagePath);
-	fs::path directory = imagePath.parent_path();
-	fs::path rootFile  = directory / imagePath.stem();
-	fs::path extension = imagePath.extension();
-
-	const std::string PATHS[6] = {
+std::string TextureCubeMapData::GetFacePath(const std::string& rootImagePath, CubeMapFace face) {
+	static const char* SUFFIXES[6] = {
 		"_pos_x",
 		"_neg_x",
 		"_pos_y",
@@ -52,22 +60,96 @@ TextureCubeMapData::sptr TextureCubeMapData::LoadFromImages(const std::string& r
 		"_neg_z"
 	};
 
-	std::vector<Texture2DData::sptr> data;
-	data.resize(6);
+	namespace fs = std::filesystem;
+	fs::path imagePath = fs::path(rootImagePath);
+	fs::path result = imagePath.parent_path() / imagePath.stem();
+	result += SUFFIXES[(int)face];
+	result += imagePath.extension();
+	return result.string();
+}
 
-	for(int ix = 0; ix < 6; ix++) {
-		fs::path imagePath = rootFile;
-		imagePath += PATHS[ix];
-		imagePath += extension;
-		if (fs::exists(imagePath)) {
-			data[ix] = Texture2DData::LoadFromFile(imagePath.string());
+TextureCubeMapData::sptr TextureCubeMapData::LoadFromImages(const std::string& rootImagePath) {
+	std::string paths[6];
+	for (int ix = 0; ix < 6; ix++) {
+		paths[ix] = GetFacePath(rootImagePath, (CubeMapFace)ix);
+	}
+
+	// Read just the headers first, so that we can allocate the whole cube map before decoding anything
+	int size = 0, numChannels = 0;
+	for (int ix = 0; ix < 6 && size == 0; ix++) {
+		int width, height, channels;
+		if (stbi_info(paths[ix].c_str(), &width, &height, &channels)) {
+			LOG_ASSERT(width == height, "Cube map face \"{}\" is not square! {}x{}", paths[ix], width, height);
+			size = width;
+			numChannels = channels;
+		} else {
+			LOG_WARN("Image \"{}\" could not be found!", paths[ix]);
+		}
+	}
+	if (size == 0) {
+		LOG_WARN("None of the faces of \"{}\" could be loaded", rootImagePath);
+		return nullptr;
+	}
+
+	InternalFormat internalFormat;
+	PixelFormat    imageFormat;
+	switch (numChannels) {
+		case 1:  internalFormat = InternalFormat::R8;    imageFormat = PixelFormat::Red;  break;
+		case 2:  internalFormat = InternalFormat::RG8;   imageFormat = PixelFormat::RG;   break;
+		case 3:  internalFormat = InternalFormat::RGB8;  imageFormat = PixelFormat::RGB;  break;
+		default: internalFormat = InternalFormat::RGBA8; imageFormat = PixelFormat::RGBA; numChannels = 4; break;
+	}
+
+	TextureCubeMapData::sptr result = std::make_shared<TextureCubeMapData>(size, imageFormat, PixelType::UByte, nullptr, internalFormat);
+	result->DebugName = std::filesystem::path(rootImagePath).filename().string();
+	// Faces that fail to load are left black
+	memset(result->_data, 0, result->_dataSize);
+
+	// Each face is decoded on its own thread, and copied straight into its place in the cube map. Every face is
+	// converted to the channel count of the first one, so a stray greyscale face doesn't break the whole set
+	stbi_set_flip_vertically_on_load(true);
+	auto decodeFace = [&](int ix) {
+		int width, height, channels;
+		uint8_t* data = stbi_load(paths[ix].c_str(), &width, &height, &channels, numChannels);
+		if (data == nullptr) {
+			LOG_WARN("STBI Failed to load image from \"{}\"", paths[ix]);
+			return;
 		}
-		else {
-			LOG_WARN("Image \"{}\" could not be found!", imagePath.string());
+		if (width == size && height == size) {
+			memcpy(result->GetLevelFaceDataPtr(0, (CubeMapFace)ix), data, result->GetFaceDataSize());
+		} else {
+			LOG_WARN("Cube map face \"{}\" is {}x{}, expected {}x{}, ignoring", paths[ix], width, height, size, size);
 		}
+		stbi_image_free(data);
+	};
+	std::future<void> tasks[5];
+	for (int ix = 1; ix < 6; ix++) {
+		tasks[ix - 1] = std::async(std::launch::async, decodeFace, ix);
+	}
+	decodeFace(0);
+	for (std::future<void>& task : tasks) {
+		task.get();
 	}
 
-	return CreateFromImages(data);
+	return result;
+}
+
+TextureCubeMapData::sptr TextureCubeMapData::LoadPrefiltered(const std::string& rootImagePath) {
+	TextureCubeMapData::sptr result = EnvironmentPrefilter::LoadCache(rootImagePath);
+	if (result != nullptr) {
+		return result;
+	}
+
+	TextureCubeMapData::sptr source = LoadFromImages(rootImagePath);
+	if (source == nullptr) {
+		return nullptr;
+	}
+	result = EnvironmentPrefilter::Prefilter(*source);
+	if (result == nullptr) {
+		return source;
+	}
+	EnvironmentPrefilter::SaveCache(rootImagePath, *result);
+	return result;
 }
 
 void TextureCubeMapData::LoadFaceData(const Texture2DData::sptr& data, CubeMapFace face) {
@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "TextureEnums.h"
 
@@ -24,7 +25,8 @@ ENUM(CubeMapFace, GLint,
 );
 
 /// <summary>
-/// Stores data required to upload texture data into OpenGL
+/// Stores data required to upload texture data into OpenGL. The data may contain several mip levels, which are
+/// stored back to back starting with the largest, each holding all 6 faces in CubeMapFace order
 /// </summary>
 class TextureCubeMapData final
 {
@@ -46,7 +48,8 @@ public:
 	/// <param name="type">The component type of the pixel (ex: uint8_t)</param>
 	/// <param name="sourceData">A pointer to the data to upload to this texture</param>
 	/// <param name="recommendedFormat">The recommended internal format to use when creating textures from this data</param>
-	TextureCubeMapData(uint32_t size, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat = InternalFormat::Unknown);
+	/// <param name="levelCount">The number of mip levels stored in sourceData</param>
+	TextureCubeMapData(uint32_t size, PixelFormat format, PixelType type, void* sourceData, InternalFormat recommendedFormat = InternalFormat::Unknown, uint32_t levelCount = 1);
 	~TextureCubeMapData();
 
 	/// <summary>
@@ -65,10 +68,26 @@ public:
 	/// image_pos_y.png --> CubeMapFace::PosY
 	/// image_neg_z.png --> CubeMapFace::NegZ
 	/// image_pos_z.png --> CubeMapFace::PosZ
+	/// The faces are decoded in parallel, straight into their place in the cube map
 	/// </summary>
 	/// <param name="rootImagePath">The base path for images, including extension. This file name will be appended with _pos_x, _neg_x, etc...</param>
 	/// <returns>A pointer to the data created from the images</returns>
 	static TextureCubeMapData::sptr LoadFromImages(const std::string& rootImagePath);
+	/// <summary>
+	/// Loads a cubemap from a set of 6 images (see LoadFromImages) along with a chain of mip levels prefiltered for
+	/// increasing roughness, for use as a reflection environment (see EnvironmentPrefilter). The chain is cached in a
+	/// single file next to the images, and is only rebuilt when one of the faces changes. This is slow on a cache
+	/// miss, so it should be called from a worker thread
+	/// </summary>
+	/// <param name="rootImagePath">The base path for images, including extension</param>
+	/// <returns>A pointer to the data created from the images, or the unfiltered faces if they can not be prefiltered</returns>
+	static TextureCubeMapData::sptr LoadPrefiltered(const std::string& rootImagePath);
+	/// <summary>
+	/// Gets the path of one of the images that a cubemap is loaded from (see LoadFromImages)
+	/// </summary>
+	/// <param name="rootImagePath">The base path for images, including extension</param>
+	/// <param name="face">The face to get the image for</param>
+	static std::string GetFacePath(const std::string& rootImagePath, CubeMapFace face);
 
 	/// <summary>
 	/// Loads 2D image data into this cubemap data for the given face. Dimensions and format must match the existing size and formats
@@ -95,11 +114,11 @@ public:
 	/// </summary>
 	InternalFormat  GetRecommendedFormat() const { return _recommendedFormat; }
 	/// <summary>
-	/// Get the total size of the underlying data (size of individual pixel * width * height * 6)
+	/// Get the total size of the underlying data (size of individual pixel * width * height * 6), including all mip levels
 	/// </summary>
 	size_t  GetDataSize() const { return _dataSize; }
 	/// <summary>
-	/// Returns the size of a single face worth's of data, in bytes
+	/// Returns the size of a single face worth's of data in the largest mip level, in bytes
 	/// </summary>
 	/// <returns></returns>
 	size_t GetFaceDataSize() const { return _faceDataSize; }
@@ -115,7 +134,35 @@ public:
 	/// <returns>A const pointer to the start of data for the given face</returns>
 	const void* GetFaceDataPtr(CubeMapFace face) const { return static_cast<char*>(_data) + (_faceDataSize * (size_t)face); }
 
+	/// <summary>
+	/// Gets the number of mip levels stored in this data, this is at least 1
+	/// </summary>
+	uint32_t GetLevelCount() const { return static_cast<uint32_t>(_levels.size()); }
+	/// <summary>
+	/// Gets the width and height of each face in the given mip level, in pixels
+	/// </summary>
+	uint32_t GetLevelSize(uint32_t level) const { return _levels[level].Size; }
+	/// <summary>
+	/// Gets the size of a single face in the given mip level, in bytes
+	/// </summary>
+	size_t GetLevelFaceDataSize(uint32_t level) const { return _levels[level].FaceDataSize; }
+	/// <summary>
+	/// Gets a pointer to the start of a face in the given mip level, the rest of the faces in the level follow it
+	/// </summary>
+	const void* GetLevelFaceDataPtr(uint32_t level, CubeMapFace face = CubeMapFace::PosX) const {
+		return static_cast<const char*>(_data) + _levels[level].Offset + _levels[level].FaceDataSize * (size_t)face;
+	}
+	void* GetLevelFaceDataPtr(uint32_t level, CubeMapFace face = CubeMapFace::PosX) {
+		return static_cast<char*>(_data) + _levels[level].Offset + _levels[level].FaceDataSize * (size_t)face;
+	}
+
 private:
+	struct MipLevel {
+		uint32_t Size;
+		size_t   Offset, FaceDataSize;
+	};
+
+	std::vector<MipLevel> _levels;
 	uint32_t    _size;
 	size_t      _dataSize;
 	size_t      _faceDataSize;
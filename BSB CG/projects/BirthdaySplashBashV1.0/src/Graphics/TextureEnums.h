@@ -5,6 +5,14 @@
 #include "Logging.h"
 #include "glad/glad.h"
 
+// S3TC is still an extension (EXT_texture_compression_s3tc), so glad does not give us the enums for it
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 // https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexImage2D.xhtml
 // These are some of our more common available internal formats
 ENUM(InternalFormat, GLint,
@@ -18,7 +26,13 @@ ENUM(InternalFormat, GLint,
 	RGB10        = GL_RGB10,
 	RGB16        = GL_RGB16,
 	RGBA8        = GL_RGBA8,
-	RGBA16       = GL_RGBA16
+	RGBA16       = GL_RGBA16,
+
+	// Block compressed formats, these can only be filled with pre-compressed data (see Texture2DData)
+	BC1          = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, // RGB + 1 bit alpha, 8 bytes per 4x4 block
+	BC3          = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, // RGBA, 16 bytes per 4x4 block
+	BC5          = GL_COMPRESSED_RG_RGTC2,           // Two channels (ex: normal maps), 16 bytes per 4x4 block
+	BC7          = GL_COMPRESSED_RGBA_BPTC_UNORM     // High quality RGBA, 16 bytes per 4x4 block
 
 	// Note: There are sized internal formats but there is a LOT of them
 );
@@ -126,4 +140,94 @@ constexpr GLint GetTexelComponentCount(PixelFormat format)
  */
 constexpr size_t GetTexelSize(PixelFormat format, PixelType type) {
 	return GetTexelComponentSize(type) * GetTexelComponentCount(format);
-}
\ No newline at end of file
+}
+/*
+ * Checks whether the given internal format is one of the block compressed formats
+ */
+constexpr bool IsCompressedFormat(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::BC1:
+		case InternalFormat::BC3:
+		case InternalFormat::BC5:
+		case InternalFormat::BC7:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Gets the number of bytes used to store a single 4x4 block of a compressed format
+ * @param format The compressed internal format
+ * @returns The size of a block in bytes, or 0 if the format is not compressed
+ */
+constexpr size_t GetBlockSize(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::BC1:
+			return 8;
+		case InternalFormat::BC3:
+		case InternalFormat::BC5:
+		case InternalFormat::BC7:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * Gets the approximate number of bytes the GPU needs to store a single texel of the given internal format.
+ * Compressed formats should use GetImageSize instead, since they store less than a byte for some texels
+ * @param format The internal format of the texture
+ * @returns The size of a single texel in the given format, in bytes, or 0 if the format is unknown
+ */
+constexpr size_t GetTexelSize(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::R8:
+			return 1;
+		case InternalFormat::R16:
+		case InternalFormat::RG8:
+			return 2;
+		case InternalFormat::RGB8:
+			return 3;
+		case InternalFormat::Depth:
+		case InternalFormat::DepthStencil:
+		case InternalFormat::RGB10:
+		case InternalFormat::RGBA8:
+			return 4;
+		case InternalFormat::RGB16:
+			return 6;
+		case InternalFormat::RGBA16:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * Gets the number of bytes needed to store a single image of the given size and internal format
+ * @param format The internal format of the image
+ * @param width The width of the image in pixels
+ * @param height The height of the image in pixels
+ * @returns The size of the image in bytes
+ */
+constexpr size_t GetImageSize(InternalFormat format, uint32_t width, uint32_t height) {
+	if (IsCompressedFormat(format)) {
+		// Compressed images are always stored as whole 4x4 blocks, even when they are smaller than that
+		return ((width + 3) / 4) * (size_t)((height + 3) / 4) * GetBlockSize(format);
+	}
+	return width * (size_t)height * GetTexelSize(format);
+}
+
+/*
+ * Gets the number of levels in a full mip chain for an image of the given size, down to and including 1x1
+ * @param width The width of the largest level in pixels
+ * @param height The height of the largest level in pixels
+ * @returns The number of mip levels, at least 1
+ */
+constexpr uint32_t GetMipLevelCount(uint32_t width, uint32_t height) {
+	uint32_t result = 1;
+	for (uint32_t size = width > height ? width : height; size > 1; size >>= 1) {
+		result++;
+	}
+	return result;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+
+/// <summary>
+/// A uniform buffer holds a block of uniforms that can be shared between every shader that declares a matching
+/// uniform block, instead of setting the same uniforms on each program. The block in the shader should use the
+/// std140 layout, and the C++ struct must match it (vec3s are padded out to 16 bytes)
+/// </summary>
+class UniformBuffer : public IBuffer
+{
+public:
+	typedef std::shared_ptr<UniformBuffer> sptr;
+	static inline sptr Create(GLenum usage = GL_DYNAMIC_DRAW) {
+		return std::make_shared<UniformBuffer>(usage);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new uniform buffer, with the given usage. Data will still need to be uploaded before it can be used
+	/// </summary>
+	/// <param name="usage">The usage hint for the buffer, default is GL_DYNAMIC_DRAW</param>
+	UniformBuffer(GLenum usage = GL_DYNAMIC_DRAW) : IBuffer(GL_UNIFORM_BUFFER, usage) { }
+
+	/// <summary>
+	/// Updates the contents of the buffer. The storage is only re-allocated when the size changes, otherwise the
+	/// data is written in place with glNamedBufferSubData
+	/// </summary>
+	/// <param name="data">The data to upload</param>
+	/// <param name="size">The size of the data, in bytes</param>
+	void SetData(const void* data, size_t size) {
+		if (size == GetTotalSize()) {
+			glNamedBufferSubData(_handle, 0, size, data);
+		} else {
+			IBuffer::LoadData(data, size, 1);
+		}
+	}
+	/// <summary>
+	/// Updates the contents of the buffer from a struct matching the block's layout
+	/// </summary>
+	template <typename T>
+	void SetData(const T& value) {
+		SetData(&value, sizeof(T));
+	}
+
+	/// <summary>
+	/// Binds this buffer to an indexed uniform block binding, which shaders refer to with layout(binding = slot).
+	/// The binding stays in place until something else is bound to the same slot
+	/// </summary>
+	/// <param name="slot">The index of the binding point</param>
+	void Bind(GLuint slot) const {
+		glBindBufferBase(GL_UNIFORM_BUFFER, slot, _handle);
+	}
+	using IBuffer::Bind;
+
+	/// <summary>
+	/// Unbinds the buffer in the given uniform block binding
+	/// </summary>
+	static void UnBind(GLuint slot) { glBindBufferBase(GL_UNIFORM_BUFFER, slot, 0); }
+};
@@ -2,6 +2,29 @@
 #include "IndexBuffer.h"
 #include "Logging.h"
 #include "VertexBuffer.h"
+#include "GLStateCache.h"
+#include "GeometryPool.h"
+
+MeshBounds MeshBounds::FromPositions(const glm::vec3* positions, size_t count, size_t stride) {
+	MeshBounds result;
+	if (count == 0) {
+		return result;
+	}
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(positions);
+	result.Min = result.Max = positions[0];
+	for (size_t ix = 1; ix < count; ix++) {
+		const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(data + ix * stride);
+		result.Min = glm::min(result.Min, position);
+		result.Max = glm::max(result.Max, position);
+	}
+	result.Center = (result.Min + result.Max) * 0.5f;
+	for (size_t ix = 0; ix < count; ix++) {
+		const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(data + ix * stride);
+		result.Radius = glm::max(result.Radius, glm::length(position - result.Center));
+	}
+	result.IsValid = true;
+	return result;
+}
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
@@ -14,6 +37,7 @@ VertexArrayObject::VertexArrayObject() :
 VertexArrayObject::~VertexArrayObject()
 {
 	if (_handle != 0) {
+		GLStateCache::ForgetVertexArray(_handle);
 		glDeleteVertexArrays(1, &_handle);
 		_handle = 0;
 	}
@@ -53,20 +77,102 @@ void VertexArrayObject::AddVertexBuffer(const VertexBuffer::sptr& buffer, const
 
 }
 
+void VertexArrayObject::SetPoolGeometry(const std::shared_ptr<GeometryPool>& pool, const std::shared_ptr<GeometryAllocation>& vertices, const std::shared_ptr<GeometryAllocation>& indices) {
+	LOG_ASSERT(_vertexBuffers.empty() && _indexBuffer == nullptr, "Pooled meshes can't have buffers of their own!");
+	_pool = pool;
+	_poolVertices = vertices;
+	_poolIndices = indices;
+	_vertexCount = vertices != nullptr ? (GLsizei)vertices->GetCount() : 0;
+}
+
+size_t VertexArrayObject::GetTotalBufferSize() const {
+	size_t result = GetIndexDataSize();
+	if (_pool != nullptr) {
+		result += (size_t)_poolVertices->GetCount() * _pool->GetStride();
+	}
+	for (const VertexBufferBinding& binding : _vertexBuffers) {
+		result += binding.Buffer->GetTotalSize();
+	}
+	return result;
+}
+
+size_t VertexArrayObject::GetIndexDataSize() const {
+	if (_pool != nullptr) {
+		return (size_t)_poolIndices->GetCount() * _pool->GetIndexSize();
+	}
+	return _indexBuffer != nullptr ? _indexBuffer->GetTotalSize() : 0;
+}
+
+bool VertexArrayObject::CanMultiDrawWith(const VertexArrayObject& other) const {
+	if (_pool == nullptr || _pool != other._pool || _decodeInfo.HasConstantColor != other._decodeInfo.HasConstantColor) {
+		return false;
+	}
+	return !_decodeInfo.HasConstantColor ||
+		(_decodeInfo.ColorSlot == other._decodeInfo.ColorSlot && _decodeInfo.ConstantColor == other._decodeInfo.ConstantColor);
+}
+
 void VertexArrayObject::Bind() const {
-	glBindVertexArray(_handle);
+	if (_pool != nullptr) {
+		_pool->Bind();
+	} else {
+		GLStateCache::BindVertexArray(_handle);
+	}
 }
 
 void VertexArrayObject::UnBind() {
-	glBindVertexArray(0);
+	GLStateCache::BindVertexArray(0);
+}
+
+void VertexArrayObject::ApplyConstantColor() const {
+	// When the color array is disabled, the attribute reads this value instead
+	if (_decodeInfo.HasConstantColor) {
+		glVertexAttrib4fv(_decodeInfo.ColorSlot, &_decodeInfo.ConstantColor[0]);
+	}
 }
 
 void VertexArrayObject::Render() const {
 	Bind();
-	if (_indexBuffer != nullptr) {
+	ApplyConstantColor();
+	if (_pool != nullptr) {
+		const size_t offset = (size_t)_poolIndices->GetFirst() * _pool->GetIndexSize();
+		glDrawElementsBaseVertex(GL_TRIANGLES, _poolIndices->GetCount(), _pool->GetIndexType(), (const void*)offset, _poolVertices->GetFirst());
+	} else if (_indexBuffer != nullptr) {
 		glDrawElements(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr);
 	} else {
 		glDrawArrays(GL_TRIANGLES, 0, _vertexCount / 3);
 	}
-	UnBind();
+	// We leave the VAO bound, the state cache means the next draw with the same mesh doesn't have to re-bind it
+}
+
+void VertexArrayObject::RenderInstanced(const VertexBuffer::sptr& drawIds, GLuint firstInstance, GLsizei instanceCount) {
+	if (_pool != nullptr) {
+		_pool->AttachDrawIds(drawIds);
+		Bind();
+		ApplyConstantColor();
+		const size_t offset = (size_t)_poolIndices->GetFirst() * _pool->GetIndexSize();
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, _poolIndices->GetCount(), _pool->GetIndexType(), (const void*)offset,
+			instanceCount, _poolVertices->GetFirst(), firstInstance);
+		return;
+	}
+	if (_drawIdBuffer == 0) {
+		// An integer attribute, so that large ids don't lose precision. The divisor makes it step once per
+		// instance, and the base instance offsets where it starts
+		glEnableVertexArrayAttrib(_handle, DRAW_ID_SLOT);
+		glVertexArrayAttribIFormat(_handle, DRAW_ID_SLOT, 1, GL_UNSIGNED_INT, 0);
+		glVertexArrayAttribBinding(_handle, DRAW_ID_SLOT, DRAW_ID_BINDING);
+		glVertexArrayBindingDivisor(_handle, DRAW_ID_BINDING, 1);
+	}
+	// The buffer gets replaced when it grows, so we check that we're still pointing at the current one
+	if (_drawIdBuffer != drawIds->GetHandle()) {
+		_drawIdBuffer = drawIds->GetHandle();
+		glVertexArrayVertexBuffer(_handle, DRAW_ID_BINDING, _drawIdBuffer, 0, sizeof(uint32_t));
+	}
+
+	Bind();
+	ApplyConstantColor();
+	if (_indexBuffer != nullptr) {
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, _indexBuffer->GetElementCount(), _indexBuffer->GetElementType(), nullptr, instanceCount, firstInstance);
+	} else {
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, _vertexCount, instanceCount, firstInstance);
+	}
 }
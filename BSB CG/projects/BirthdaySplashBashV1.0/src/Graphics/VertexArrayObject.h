@@ -3,10 +3,14 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <GLM/glm.hpp>
 
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
 
+class GeometryPool;
+class GeometryAllocation;
+
 /// <summary>
 /// We'll use this just to make it more clear what the intended usage of an attribute is in our code!
 /// </summary>
@@ -70,6 +74,63 @@ struct BufferAttribute
 		Slot(slot), Size(size), Type(type), Normalized(normalized), Stride(stride), Offset(offset), Usage(usage) { }
 };
 
+/// <summary>
+/// Describes how the shader should turn a mesh's packed vertex attributes back into full precision values,
+/// the defaults describe an unpacked mesh (see VertexPacker)
+/// </summary>
+struct VertexDecodeInfo
+{
+	/// <summary>
+	/// Maps the quantized [0, 1] positions back into model space, this gets multiplied into the model matrix
+	/// </summary>
+	glm::mat4 PositionDequantize = glm::mat4(1.0f);
+	/// <summary>
+	/// The scale (xy) and offset (zw) that map the stored UVs back to their original range
+	/// </summary>
+	glm::vec4 TexCoordTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+	/// <summary>
+	/// True if the normals are stored as 2 octahedral encoded components
+	/// </summary>
+	bool      OctNormals = false;
+	/// <summary>
+	/// True if the mesh has no color attribute, and ConstantColor should be used for every vertex
+	/// </summary>
+	bool      HasConstantColor = false;
+	glm::vec4 ConstantColor = glm::vec4(1.0f);
+	/// <summary>
+	/// The attribute slot that ConstantColor is fed into
+	/// </summary>
+	GLuint    ColorSlot = 1;
+};
+
+/// <summary>
+/// The model space bounds of a mesh, used for culling and picking levels of detail
+/// </summary>
+struct MeshBounds
+{
+	glm::vec3 Min = glm::vec3(0.0f);
+	glm::vec3 Max = glm::vec3(0.0f);
+	/// <summary>
+	/// A sphere enclosing every vertex. It is centered on the box, which is close enough to the smallest sphere
+	/// </summary>
+	glm::vec3 Center = glm::vec3(0.0f);
+	float     Radius = 0.0f;
+	/// <summary>
+	/// False for meshes whose bounds are not known, which should never be culled
+	/// </summary>
+	bool      IsValid = false;
+
+	glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+	/// <summary>
+	/// Computes the bounds of a set of positions
+	/// </summary>
+	/// <param name="positions">A pointer to the position of the first vertex</param>
+	/// <param name="count">The number of vertices</param>
+	/// <param name="stride">The number of bytes between each vertex's position</param>
+	static MeshBounds FromPositions(const glm::vec3* positions, size_t count, size_t stride);
+};
+
 /// <summary>
 /// The Vertex Array Object wraps around an OpenGL VAO and basically represents all of the data for a mesh
 /// </summary>
@@ -113,6 +174,15 @@ public:
 	/// <param name="buffer">The buffer to add (note, does not take ownership, you will still need to delete later)</param>
 	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer</param>
 	void AddVertexBuffer(const VertexBuffer::sptr& buffer, const std::vector<BufferAttribute>& attributes);
+	/// <summary>
+	/// Makes this VAO draw a range of a geometry pool instead of its own buffers. Binding it binds the pool's VAO,
+	/// and draws offset into the pool's buffers by the ranges' first vertex and index. The VAO keeps its own handle
+	/// so that it can still be told apart from the other meshes in the pool
+	/// </summary>
+	/// <param name="pool">The pool holding the mesh</param>
+	/// <param name="vertices">The mesh's vertices, which may be shared with other levels of detail</param>
+	/// <param name="indices">The mesh's indices, relative to its first vertex</param>
+	void SetPoolGeometry(const std::shared_ptr<GeometryPool>& pool, const std::shared_ptr<GeometryAllocation>& vertices, const std::shared_ptr<GeometryAllocation>& indices);
 
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
@@ -127,8 +197,63 @@ public:
 	/// Returns the underlying OpenGL handle that this class is wrapping around
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
+	/// <summary>
+	/// Returns the total size in bytes of all the vertex and index buffers attached to this VAO
+	/// </summary>
+	size_t GetTotalBufferSize() const;
+	/// <summary>
+	/// Returns the index buffer bound to this VAO, or nullptr if it doesn't have one
+	/// </summary>
+	const IndexBuffer::sptr& GetIndexBuffer() const { return _indexBuffer; }
+	/// <summary>
+	/// Returns the size in bytes of this VAO's indices, whether they are in its own buffer or in a pool
+	/// </summary>
+	size_t GetIndexDataSize() const;
+
+	/// <summary>
+	/// Returns true if this mesh lives in a geometry pool (see SetPoolGeometry)
+	/// </summary>
+	bool IsPooled() const { return _pool != nullptr; }
+	const std::shared_ptr<GeometryPool>& GetPool() const { return _pool; }
+	const std::shared_ptr<GeometryAllocation>& GetPoolVertices() const { return _poolVertices; }
+	const std::shared_ptr<GeometryAllocation>& GetPoolIndices() const { return _poolIndices; }
+	/// <summary>
+	/// Returns true if this mesh and another can be drawn with the same multi draw, which needs them to be in the
+	/// same pool and to have the same constant color, since that is set outside of the draw
+	/// </summary>
+	bool CanMultiDrawWith(const VertexArrayObject& other) const;
+	/// <summary>
+	/// Feeds the constant color into the color attribute, for meshes that don't have one. The draw functions
+	/// already do this, it only needs calling when drawing the mesh some other way
+	/// </summary>
+	void ApplyConstantColor() const;
+
+	/// <summary>
+	/// Sets how the shader should decode this mesh's vertices, for meshes built by VertexPacker
+	/// </summary>
+	void SetDecodeInfo(const VertexDecodeInfo& info) { _decodeInfo = info; }
+	const VertexDecodeInfo& GetDecodeInfo() const { return _decodeInfo; }
+
+	/// <summary>
+	/// Sets the model space bounds of this mesh, these are filled in when a mesh is baked
+	/// </summary>
+	void SetBounds(const MeshBounds& bounds) { _bounds = bounds; }
+	const MeshBounds& GetBounds() const { return _bounds; }
 
 	void Render() const;
+	/// <summary>
+	/// Draws several copies of this mesh, starting at the given base instance. Each copy reads its index from the
+	/// draw id buffer into the uint attribute in DRAW_ID_SLOT, so the vertex shader sees firstInstance,
+	/// firstInstance + 1... and can use that to look up its per object data
+	/// </summary>
+	/// <param name="drawIds">A buffer of uint32_t holding 0, 1, 2... at least up to firstInstance + instanceCount</param>
+	/// <param name="firstInstance">The draw id of the first copy</param>
+	/// <param name="instanceCount">The number of copies to draw</param>
+	void RenderInstanced(const VertexBuffer::sptr& drawIds, GLuint firstInstance, GLsizei instanceCount);
+
+	static constexpr GLuint DRAW_ID_SLOT    = 4;
+	// The buffer binding that draw ids are read from, well past any of the mesh's own attributes
+	static constexpr GLuint DRAW_ID_BINDING = 15;
 	
 protected:
 	// Helper structure to store a buffer and the attributes
@@ -144,6 +269,16 @@ protected:
 	std::vector<VertexBufferBinding> _vertexBuffers;
 
 	GLsizei _vertexCount;
+
+	VertexDecodeInfo _decodeInfo;
+	MeshBounds _bounds;
+	// The draw id buffer attached to DRAW_ID_BINDING, 0 until the first instanced draw sets up the attribute
+	GLuint _drawIdBuffer = 0;
+
+	// The pool and ranges that pooled meshes draw from, null otherwise
+	std::shared_ptr<GeometryPool>       _pool;
+	std::shared_ptr<GeometryAllocation> _poolVertices;
+	std::shared_ptr<GeometryAllocation> _poolIndices;
 	
 	// The underlying OpenGL handle that this class is wrapping around
 	GLuint _handle;
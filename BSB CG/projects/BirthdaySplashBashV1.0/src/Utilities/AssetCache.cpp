@@ -0,0 +1,161 @@
+#include "AssetCache.h"
+
+#include <vector>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
+
+#include "Logging.h"
+#include "Utilities/AssetLoader.h"
+
+std::unordered_map<std::string, AssetCache::CacheEntry> AssetCache::_entries;
+
+/// <summary>
+/// Builds the key options for a mesh. The color and vertex layout get baked into the vertices, so they are part of the key
+/// </summary>
+static std::string GetMeshOptions(const glm::vec4& inColor, const PackedVertexFormat& format) {
+	std::string options = inColor == glm::vec4(1.0f) ? "" :
+		fmt::format("color={},{},{},{}", inColor.r, inColor.g, inColor.b, inColor.a);
+	if (format != PackedVertexFormat::Compact()) {
+		options += fmt::format("{}format={},{},{}", options.empty() ? "" : ";", (int)format.Position, (int)format.TexCoord, (int)format.Color);
+	}
+	return options;
+}
+
+VertexArrayObject::sptr AssetCache::LoadMesh(const std::string& path, const std::string& group, const glm::vec4& inColor, const PackedVertexFormat& format) {
+	return _FindOrLoad<VertexArrayObject>(MakeKey(path, GetMeshOptions(inColor, format)), group,
+		[&]() { return AssetLoader::LoadMesh(path, group, inColor, format); },
+		[](const VertexArrayObject& vao) { return vao.GetTotalBufferSize(); });
+}
+
+MeshLodChain::sptr AssetCache::LoadMeshLods(const std::string& path, const std::string& group, const glm::vec4& inColor, const PackedVertexFormat& format) {
+	std::string options = GetMeshOptions(inColor, format);
+	options += options.empty() ? "lods" : ";lods";
+	return _FindOrLoad<MeshLodChain>(MakeKey(path, options), group,
+		[&]() { return AssetLoader::LoadMeshLods(path, group, inColor, format); },
+		[](const MeshLodChain& chain) { return chain.GetTotalBufferSize(); });
+}
+
+Texture2D::sptr AssetCache::LoadTexture2D(const std::string& path, const std::string& group) {
+	return _FindOrLoad<Texture2D>(MakeKey(path), group,
+		[&]() { return AssetLoader::LoadTexture2D(path, group); },
+		[](const Texture2D& texture) {
+			size_t result = 0;
+			for (uint32_t level = 0; level < texture.GetMipLevelCount(); level++) {
+				result += GetImageSize(texture.GetFormat(), std::max(texture.GetWidth() >> level, 1u), std::max(texture.GetHeight() >> level, 1u));
+			}
+			return result;
+		});
+}
+
+TextureCubeMap::sptr AssetCache::LoadTextureCubeMap(const std::string& path, const std::string& group) {
+	// Cube maps are named after one of their faces, so make sure they never collide with a 2D texture of that face
+	return _FindOrLoad<TextureCubeMap>(MakeKey(path, "cube"), group,
+		[&]() { return AssetLoader::LoadTextureCubeMap(path, group); },
+		[](const TextureCubeMap& texture) {
+			size_t result = 0;
+			for (uint32_t level = 0; level < texture.GetMipLevelCount(); level++) {
+				const uint32_t size = std::max(texture.GetSize() >> level, 1u);
+				result += GetImageSize(texture.GetFormat(), size, size) * 6;
+			}
+			return result;
+		});
+}
+
+template <typename T>
+std::shared_ptr<T> AssetCache::_FindOrLoad(const std::string& key, const std::string& group,
+	const std::function<std::shared_ptr<T>()>& load, const std::function<size_t(const T&)>& getSize)
+{
+	auto it = _entries.find(key);
+	if (it != _entries.end()) {
+		it->second.Hits++;
+		// The asset may still be streaming in for another scene, make sure this group waits for it as well
+		AssetLoader::AddToGroup(it->second.Asset.get(), group);
+		if (std::find(it->second.Groups.begin(), it->second.Groups.end(), group) == it->second.Groups.end()) {
+			it->second.Groups.push_back(group);
+		}
+		return std::static_pointer_cast<T>(it->second.Asset);
+	}
+
+	std::shared_ptr<T> result = load();
+	T* asset = result.get();
+	_entries[key] = { result, 0, [asset, getSize]() { return getSize(*asset); }, { group } };
+	return result;
+}
+
+size_t AssetCache::Purge(const std::string& group) {
+	size_t released = 0;
+	for (auto it = _entries.begin(); it != _entries.end(); ) {
+		const std::vector<std::string>& groups = it->second.Groups;
+		const bool onlyInGroup = group.empty() || (groups.size() == 1 && groups[0] == group);
+		if (onlyInGroup && it->second.Asset.use_count() <= 1) {
+			it = _entries.erase(it);
+			released++;
+		} else {
+			++it;
+		}
+	}
+	if (released > 0) {
+		LOG_INFO("Asset cache released {} unused assets{}", released, group.empty() ? "" : " from group " + group);
+	}
+	return released;
+}
+
+void AssetCache::Clear() {
+	_entries.clear();
+}
+
+long AssetCache::GetRefCount(const std::string& key) {
+	auto it = _entries.find(key);
+	return it != _entries.end() ? it->second.Asset.use_count() - 1 : 0;
+}
+
+size_t AssetCache::GetBytesSaved() {
+	size_t result = 0;
+	for (const auto& [key, entry] : _entries) {
+		result += entry.Hits * entry.GetSize();
+	}
+	return result;
+}
+
+void AssetCache::LogReport() {
+	// Sort by the memory saved so the interesting entries are at the top
+	std::vector<std::pair<const std::string*, const CacheEntry*>> sorted;
+	sorted.reserve(_entries.size());
+	for (const auto& [key, entry] : _entries) {
+		sorted.push_back({ &key, &entry });
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const auto& l, const auto& r) {
+		return l.second->Hits * l.second->GetSize() > r.second->Hits * r.second->GetSize();
+	});
+
+	size_t totalBytes = 0;
+	size_t totalSaved = 0;
+	LOG_INFO("Asset cache: {} assets", _entries.size());
+	LOG_INFO("  {:<48} {:>6} {:>6} {:>12} {:>12}", "Asset", "Refs", "Hits", "Size (KB)", "Saved (KB)");
+	for (const auto& [key, entry] : sorted) {
+		const size_t size  = entry->GetSize();
+		const size_t saved = entry->Hits * size;
+		totalBytes += size;
+		totalSaved += saved;
+		LOG_INFO("  {:<48} {:>6} {:>6} {:>12.1f} {:>12.1f}", *key, entry->Asset.use_count() - 1, entry->Hits, size / 1024.0f, saved / 1024.0f);
+	}
+	LOG_INFO("  Total: {:.2f} MB resident, {:.2f} MB saved by sharing", totalBytes / (1024.0f * 1024.0f), totalSaved / (1024.0f * 1024.0f));
+}
+
+std::string AssetCache::NormalizePath(const std::string& path) {
+	std::string result = std::filesystem::path(path).lexically_normal().generic_string();
+	#ifdef WINDOWS
+	// Paths are case insensitive on Windows, so "Swing.obj" and "swing.obj" are the same file
+	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	#endif
+	return result;
+}
+
+std::string AssetCache::MakeKey(const std::string& path, const std::string& options) {
+	std::string result = NormalizePath(path);
+	if (!options.empty()) {
+		result += "?" + options;
+	}
+	return result;
+}
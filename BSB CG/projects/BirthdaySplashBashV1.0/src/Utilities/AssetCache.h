@@ -0,0 +1,119 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/Texture2D.h"
+#include "Graphics/TextureCubeMap.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshLodChain.h"
+#include "Utilities/VertexPacking.h"
+
+/// <summary>
+/// Keeps a single copy of every mesh and texture that has been loaded, keyed by the normalized path and the
+/// options it was loaded with. Requesting an asset that is already in the cache returns the same GL object,
+/// so scenes that share models and images no longer create their own buffers and textures for them.
+///
+/// New assets are streamed in through the AssetLoader. The cache holds a reference to everything it has
+/// handed out until Purge or Clear is called
+/// </summary>
+class AssetCache
+{
+public:
+	/// <summary>
+	/// Gets a shared mesh for the given OBJ or glTF file, loading it if this is the first request
+	/// </summary>
+	/// <param name="path">The path of the model file</param>
+	/// <param name="group">The loader group that should wait for this mesh, see AssetLoader</param>
+	/// <param name="inColor">The color to apply to all vertices, meshes loaded with different colors are cached separately</param>
+	/// <param name="format">The layout to pack the vertices into, meshes loaded with different formats are cached separately</param>
+	static VertexArrayObject::sptr LoadMesh(const std::string& path, const std::string& group = "", const glm::vec4& inColor = glm::vec4(1.0f),
+		const PackedVertexFormat& format = PackedVertexFormat::Compact());
+	/// <summary>
+	/// Gets a shared level of detail chain for the given OBJ or glTF file, loading it if this is the first request.
+	/// Chains are cached separately from the plain meshes returned by LoadMesh
+	/// </summary>
+	/// <param name="path">The path of the model file</param>
+	/// <param name="group">The loader group that should wait for this mesh, see AssetLoader</param>
+	/// <param name="inColor">The color to apply to all vertices</param>
+	/// <param name="format">The layout to pack the vertices into</param>
+	static MeshLodChain::sptr LoadMeshLods(const std::string& path, const std::string& group = "", const glm::vec4& inColor = glm::vec4(1.0f),
+		const PackedVertexFormat& format = PackedVertexFormat::Compact());
+	/// <summary>
+	/// Gets a shared 2D texture for the given image, loading it if this is the first request
+	/// </summary>
+	/// <param name="path">The path of the image file</param>
+	/// <param name="group">The loader group that should wait for this texture, see AssetLoader</param>
+	static Texture2D::sptr LoadTexture2D(const std::string& path, const std::string& group = "");
+	/// <summary>
+	/// Gets a shared cube map for the given images, loading them if this is the first request
+	/// </summary>
+	/// <param name="path">The base path of the images, see TextureCubeMapData::LoadFromImages for naming</param>
+	/// <param name="group">The loader group that should wait for this cube map, see AssetLoader</param>
+	static TextureCubeMap::sptr LoadTextureCubeMap(const std::string& path, const std::string& group = "");
+
+	/// <summary>
+	/// Drops assets that are no longer referenced outside of the cache, freeing their GPU memory. Given a loader
+	/// group, only assets that were requested by that group alone are dropped, so anything another scene asked for
+	/// stays cached for it even if nothing is using it right now
+	/// </summary>
+	/// <param name="group">The group of the scene being unloaded, or empty to drop every unreferenced asset</param>
+	/// <returns>The number of assets that were released</returns>
+	static size_t Purge(const std::string& group = "");
+	/// <summary>
+	/// Drops all cached assets. Assets that are still referenced elsewhere stay alive, but will be loaded
+	/// again the next time they are requested
+	/// </summary>
+	static void Clear();
+
+	/// <summary>
+	/// Returns the number of references to the cached asset outside of the cache, or 0 if it is not cached
+	/// </summary>
+	/// <param name="key">The cache key, as returned by MakeKey</param>
+	static long GetRefCount(const std::string& key);
+	/// <summary>
+	/// Returns the number of bytes of GPU memory that would have been allocated for duplicate assets without the cache
+	/// </summary>
+	static size_t GetBytesSaved();
+	/// <summary>
+	/// Logs every cached asset, along with how many times it was shared and how much memory that saved
+	/// </summary>
+	static void LogReport();
+
+	/// <summary>
+	/// Normalizes a path so that different spellings of the same file share a cache entry
+	/// (ex: "images//Arena1/../Arena1/Dunce.png" becomes "images/Arena1/Dunce.png")
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+	/// <summary>
+	/// Builds the key that an asset is cached under from its path and any options that change the loaded result
+	/// </summary>
+	/// <param name="path">The path of the asset</param>
+	/// <param name="options">A string describing the load options, or empty for the defaults</param>
+	static std::string MakeKey(const std::string& path, const std::string& options = "");
+
+protected:
+	AssetCache() = default;
+	~AssetCache() = default;
+
+	struct CacheEntry {
+		std::shared_ptr<void>         Asset;
+		// The number of requests that were served from the cache instead of loading the asset again
+		size_t                        Hits;
+		// Measured when needed rather than when loading, since the asset may not have been uploaded yet
+		std::function<size_t()>       GetSize;
+		// Every loader group that has requested the asset
+		std::vector<std::string>      Groups;
+	};
+
+	static std::unordered_map<std::string, CacheEntry> _entries;
+
+	/// <summary>
+	/// Returns the cached asset for key, or creates it with load and caches it
+	/// </summary>
+	template <typename T>
+	static std::shared_ptr<T> _FindOrLoad(const std::string& key, const std::string& group,
+		const std::function<std::shared_ptr<T>()>& load, const std::function<size_t(const T&)>& getSize);
+};
@@ -0,0 +1,244 @@
+#include "AssetLoader.h"
+
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+
+#include "Logging.h"
+#include "Graphics/Texture2DData.h"
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureCubeMapData.h"
+#include "Utilities/ObjLoader.h"
+#include "Utilities/GltfLoader.h"
+
+ThreadPool::sptr AssetLoader::_pool = nullptr;
+uint64_t AssetLoader::_nextId = 0;
+std::unordered_map<uint64_t, AssetLoader::PendingAsset> AssetLoader::_pending;
+std::unordered_map<const void*, uint64_t> AssetLoader::_pendingByAsset;
+std::unordered_map<std::string, AssetLoader::GroupStats> AssetLoader::_groups;
+std::mutex AssetLoader::_readyMutex;
+std::queue<uint64_t> AssetLoader::_ready;
+
+/// <summary>
+/// Gets the current time in seconds, for measuring how long uploads and groups take
+/// </summary>
+static double GetSeconds() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>
+/// Loads and packs a mesh, runs on a worker thread
+/// </summary>
+static PackedMeshData::sptr DecodeMesh(const std::string& path, const glm::vec4& inColor, const PackedVertexFormat& format, bool keepLods) {
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	if (GltfLoader::IsGltfFile(path)) {
+		GltfLoader::LoadMeshData(path, mesh, inColor);
+	} else {
+		// The pool already runs a load per worker, parsing on more threads would only oversubscribe the cores
+		ObjLoader::LoadMeshData(path, mesh, inColor, 1);
+	}
+	// Packing happens here on the worker, so the GL thread only has to copy the smaller buffer
+	PackedMeshData::sptr result = VertexPacker::Pack(mesh, format);
+	if (!keepLods) {
+		result->Lods.clear();
+	}
+	return result;
+}
+
+void AssetLoader::Init(size_t threadCount) {
+	LOG_ASSERT(_pool == nullptr, "AssetLoader has already been initialized!");
+	_pool = ThreadPool::Create(threadCount);
+	LOG_INFO("Asset loader started with {} worker threads", _pool->GetThreadCount());
+}
+
+void AssetLoader::Uninitialize() {
+	// Destroying the pool joins the workers and drops anything they have not started yet
+	_pool = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_readyMutex);
+		std::queue<uint64_t>().swap(_ready);
+	}
+	_pending.clear();
+	_pendingByAsset.clear();
+	_groups.clear();
+}
+
+Texture2D::sptr AssetLoader::LoadTexture2D(const std::string& path, const std::string& group) {
+	Texture2D::sptr result = Texture2D::Create();
+	_Submit<Texture2DData::sptr>(result.get(), group, path,
+		[path]() {
+			// Mips are built (or loaded from their cache) here, so the GL thread only has to upload them
+			Texture2DData::sptr data = Texture2DData::LoadWithMips(path, MipFilter::Kaiser);
+			// Decompress here if the GPU can't take the format, so the GL thread doesn't have to
+			if (data != nullptr && data->IsCompressed() && !ITexture::IsFormatSupported(data->GetRecommendedFormat())) {
+				LOG_WARN("{} is not supported by this GPU, decompressing \"{}\" on the CPU", ~data->GetRecommendedFormat(), path);
+				data = data->Decompress();
+			}
+			return data;
+		},
+		[result](Texture2DData::sptr& data) {
+			if (data != nullptr) {
+				result->LoadData(data);
+			}
+		});
+	return result;
+}
+
+TextureCubeMap::sptr AssetLoader::LoadTextureCubeMap(const std::string& path, const std::string& group) {
+	// Our cube maps are used as reflection environments, so they get a prefiltered roughness chain
+	TextureCubeDesc description;
+	description.MinificationFilter = MinFilter::LinearMipLinear;
+	TextureCubeMap::sptr result = TextureCubeMap::Create(description);
+	_Submit<TextureCubeMapData::sptr>(result.get(), group, path,
+		[path]() { return TextureCubeMapData::LoadPrefiltered(path); },
+		[result](TextureCubeMapData::sptr& data) {
+			if (data != nullptr) {
+				result->LoadData(data);
+			}
+		});
+	return result;
+}
+
+VertexArrayObject::sptr AssetLoader::LoadMesh(const std::string& path, const std::string& group, const glm::vec4& inColor, const PackedVertexFormat& format) {
+	VertexArrayObject::sptr result = VertexArrayObject::Create();
+	result->SetDebugName(path);
+	_Submit<PackedMeshData::sptr>(result.get(), group, path,
+		[path, inColor, format]() { return DecodeMesh(path, inColor, format, false); },
+		[result](PackedMeshData::sptr& mesh) {
+			VertexPacker::Bake(*mesh, result);
+		});
+	return result;
+}
+
+MeshLodChain::sptr AssetLoader::LoadMeshLods(const std::string& path, const std::string& group, const glm::vec4& inColor, const PackedVertexFormat& format) {
+	// Level 0 exists right away so that renderers have something to hold on to, the rest arrive with the upload
+	VertexArrayObject::sptr mesh = VertexArrayObject::Create();
+	mesh->SetDebugName(path);
+	MeshLodChain::sptr result = MeshLodChain::Create();
+	result->AddLevel(mesh, 0.0f);
+	_Submit<PackedMeshData::sptr>(result.get(), group, path,
+		[path, inColor, format]() { return DecodeMesh(path, inColor, format, true); },
+		[result, mesh](PackedMeshData::sptr& data) {
+			VertexPacker::Bake(*data, mesh, result.get());
+		});
+	return result;
+}
+
+LUT3D::sptr AssetLoader::LoadLUT3D(const std::string& path, const std::string& group) {
+	LUT3D::sptr result = std::make_shared<LUT3D>();
+	_Submit<LUT3DData::sptr>(result.get(), group, path,
+		[path]() { return LUT3D::readFile(path); },
+		[result](LUT3DData::sptr& table) {
+			result->loadData(table);
+		});
+	return result;
+}
+
+void AssetLoader::ProcessUploads(float budgetMs) {
+	const double start = GetSeconds();
+	const double budget = budgetMs / 1000.0;
+	while (true) {
+		uint64_t id;
+		{
+			std::lock_guard<std::mutex> lock(_readyMutex);
+			if (_ready.empty()) {
+				break;
+			}
+			id = _ready.front();
+			_ready.pop();
+		}
+		_UploadOne(id);
+
+		if (GetSeconds() - start >= budget) {
+			break;
+		}
+	}
+}
+
+void AssetLoader::WaitForGroup(const std::string& group) {
+	while (GetPendingCount(group) > 0) {
+		uint64_t id;
+		bool hasWork = false;
+		{
+			std::lock_guard<std::mutex> lock(_readyMutex);
+			if (!_ready.empty()) {
+				id = _ready.front();
+				_ready.pop();
+				hasWork = true;
+			}
+		}
+		if (hasWork) {
+			_UploadOne(id);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+size_t AssetLoader::GetPendingCount(const std::string& group) {
+	auto it = _groups.find(group);
+	return it != _groups.end() ? it->second.Pending : 0;
+}
+
+void AssetLoader::AddToGroup(const void* asset, const std::string& group) {
+	auto it = _pendingByAsset.find(asset);
+	if (it == _pendingByAsset.end()) {
+		return;
+	}
+	PendingAsset& pending = _pending[it->second];
+	for (const std::string& existing : pending.Groups) {
+		if (existing == group) {
+			return;
+		}
+	}
+	pending.Groups.push_back(group);
+	_AddPendingToGroup(group);
+}
+
+void AssetLoader::_AddPendingToGroup(const std::string& group) {
+	GroupStats& stats = _groups[group];
+	if (stats.Pending == 0) {
+		stats.Requested = 0;
+		stats.StartTime = GetSeconds();
+	}
+	stats.Pending++;
+	stats.Requested++;
+}
+
+void AssetLoader::_Enqueue(const void* asset, const std::string& group, const std::string& path, std::function<void()> decode, std::function<void()> upload) {
+	LOG_ASSERT(_pool != nullptr, "AssetLoader::Init must be called before loading assets!");
+
+	const uint64_t id = _nextId++;
+	_pending[id] = { asset, { group }, std::move(upload) };
+	_pendingByAsset[asset] = id;
+	_AddPendingToGroup(group);
+
+	_pool->Enqueue([id, path, decode]() {
+		try {
+			decode();
+		}
+		catch (const std::exception& e) {
+			LOG_WARN("Failed to load \"{}\": {}", path, e.what());
+		}
+		std::lock_guard<std::mutex> lock(_readyMutex);
+		_ready.push(id);
+	});
+}
+
+void AssetLoader::_UploadOne(uint64_t id) {
+	auto it = _pending.find(id);
+	if (it == _pending.end()) {
+		return;
+	}
+	it->second.Upload();
+
+	for (const std::string& group : it->second.Groups) {
+		GroupStats& stats = _groups[group];
+		stats.Pending--;
+		if (stats.Pending == 0) {
+			LOG_INFO("Finished loading {} assets for \"{}\" in {:.2f}s", stats.Requested, group, GetSeconds() - stats.StartTime);
+		}
+	}
+	_pendingByAsset.erase(it->second.Asset);
+	_pending.erase(it);
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+
+#include "Graphics/Texture2D.h"
+#include "Graphics/TextureCubeMap.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshLodChain.h"
+#include "Graphics/LUT.h"
+#include "Utilities/ThreadPool.h"
+#include "Utilities/VertexPacking.h"
+
+/// <summary>
+/// Streams assets in the background. Files are read and decoded on a thread pool, and the resulting data
+/// is queued for upload on the GL thread, which drains the queue a little bit each frame via ProcessUploads.
+///
+/// Every Load function returns its GL object immediately, so it can be handed to materials and renderers
+/// right away. The object stays empty until its upload has been processed. Assets can be tagged with a
+/// group name (ex: a scene) so that the game can check when everything a scene needs has arrived
+/// </summary>
+class AssetLoader
+{
+public:
+	/// <summary>
+	/// Starts the worker threads, must be called on the GL thread before any assets are requested
+	/// </summary>
+	/// <param name="threadCount">The number of workers, or 0 to use all but one of the hardware threads</param>
+	static void Init(size_t threadCount = 0);
+	/// <summary>
+	/// Stops the workers and drops any assets that have not been uploaded yet. Must be called on the GL thread
+	/// while the context is still alive
+	/// </summary>
+	static void Uninitialize();
+
+	/// <summary>
+	/// Loads an image into a 2D texture in the background
+	/// </summary>
+	/// <param name="path">The path of the image file</param>
+	/// <param name="group">The group to track this asset under</param>
+	/// <returns>An empty texture that will receive the image once it has been uploaded</returns>
+	static Texture2D::sptr LoadTexture2D(const std::string& path, const std::string& group = "");
+	/// <summary>
+	/// Loads a set of 6 images into a cube map in the background, see TextureCubeMapData::LoadFromImages for naming
+	/// </summary>
+	/// <param name="path">The base path of the images</param>
+	/// <param name="group">The group to track this asset under</param>
+	/// <returns>An empty cube map that will receive the images once they have been uploaded</returns>
+	static TextureCubeMap::sptr LoadTextureCubeMap(const std::string& path, const std::string& group = "");
+	/// <summary>
+	/// Loads an OBJ or glTF model in the background, using the binary mesh cache for OBJs when possible
+	/// </summary>
+	/// <param name="path">The path of the OBJ, glTF or GLB file</param>
+	/// <param name="group">The group to track this asset under</param>
+	/// <param name="inColor">The color to apply to all vertices</param>
+	/// <param name="format">The layout to pack the vertices into, see VertexPacker</param>
+	/// <returns>An empty VAO that will receive the mesh once it has been uploaded</returns>
+	static VertexArrayObject::sptr LoadMesh(const std::string& path, const std::string& group = "", const glm::vec4& inColor = glm::vec4(1.0f),
+		const PackedVertexFormat& format = PackedVertexFormat::Compact());
+	/// <summary>
+	/// Loads a model along with its levels of detail in the background, see LoadMesh
+	/// </summary>
+	/// <param name="path">The path of the OBJ, glTF or GLB file</param>
+	/// <param name="group">The group to track this asset under</param>
+	/// <param name="inColor">The color to apply to all vertices</param>
+	/// <param name="format">The layout to pack the vertices into, see VertexPacker</param>
+	/// <returns>A chain holding a single empty VAO, which will receive the full detail mesh and be joined by the
+	/// other levels once the mesh has been uploaded</returns>
+	static MeshLodChain::sptr LoadMeshLods(const std::string& path, const std::string& group = "", const glm::vec4& inColor = glm::vec4(1.0f),
+		const PackedVertexFormat& format = PackedVertexFormat::Compact());
+	/// <summary>
+	/// Loads a .cube color grading table in the background
+	/// </summary>
+	/// <param name="path">The path of the .cube file</param>
+	/// <param name="group">The group to track this asset under</param>
+	/// <returns>An empty LUT that will receive the table once it has been uploaded</returns>
+	static LUT3D::sptr LoadLUT3D(const std::string& path, const std::string& group = "");
+
+	/// <summary>
+	/// Uploads decoded assets to the GPU until the time budget has been used up. At least one asset is uploaded
+	/// per call if any are ready, so a single large asset can exceed the budget. Call once per frame on the GL thread
+	/// </summary>
+	/// <param name="budgetMs">The time to spend on uploads this frame, in milliseconds</param>
+	static void ProcessUploads(float budgetMs);
+	/// <summary>
+	/// Blocks until all assets in the group have been decoded and uploaded
+	/// </summary>
+	/// <param name="group">The group to wait for</param>
+	static void WaitForGroup(const std::string& group);
+
+	/// <summary>
+	/// Returns true if all assets requested under the group have been uploaded
+	/// </summary>
+	static bool IsGroupLoaded(const std::string& group) { return GetPendingCount(group) == 0; }
+	/// <summary>
+	/// Returns the number of assets in the group that are still being decoded or waiting to be uploaded
+	/// </summary>
+	static size_t GetPendingCount(const std::string& group);
+	/// <summary>
+	/// Adds an asset that is still loading to another group, so that the group also waits for it. Used when the
+	/// same asset is shared between scenes. Does nothing if the asset has already been uploaded
+	/// </summary>
+	/// <param name="asset">The object returned by one of the Load functions</param>
+	/// <param name="group">The group that should also wait for the asset</param>
+	static void AddToGroup(const void* asset, const std::string& group);
+
+protected:
+	AssetLoader() = default;
+	~AssetLoader() = default;
+
+	/// <summary>
+	/// Book keeping for an asset that has been requested but not uploaded yet. Only ever touched on the GL thread,
+	/// so the workers never hold references to GL objects
+	/// </summary>
+	struct PendingAsset {
+		const void*              Asset;
+		std::vector<std::string> Groups;
+		std::function<void()>    Upload;
+	};
+
+	struct GroupStats {
+		size_t Pending   = 0;
+		size_t Requested = 0;
+		double StartTime = 0.0;
+	};
+
+	static ThreadPool::sptr _pool;
+	static uint64_t _nextId;
+	static std::unordered_map<uint64_t, PendingAsset> _pending;
+	static std::unordered_map<const void*, uint64_t> _pendingByAsset;
+	static std::unordered_map<std::string, GroupStats> _groups;
+
+	// Assets that have been decoded and are ready to upload, filled by the workers
+	static std::mutex _readyMutex;
+	static std::queue<uint64_t> _ready;
+
+	/// <summary>
+	/// Queues decode to run on a worker and upload to run on the GL thread once it has finished. The data
+	/// returned by decode is passed to upload. If decode throws, the error is logged and upload is skipped
+	/// </summary>
+	template <typename TData>
+	static void _Submit(const void* asset, const std::string& group, const std::string& path, std::function<TData()> decode, std::function<void(TData&)> upload) {
+		std::shared_ptr<TData> result = std::make_shared<TData>();
+		std::shared_ptr<bool> succeeded = std::make_shared<bool>(false);
+		_Enqueue(asset, group, path,
+			[result, succeeded, decode]() { *result = decode(); *succeeded = true; },
+			[result, succeeded, upload]() { if (*succeeded) upload(*result); });
+	}
+	static void _Enqueue(const void* asset, const std::string& group, const std::string& path, std::function<void()> decode, std::function<void()> upload);
+	static void _UploadOne(uint64_t id);
+	static void _AddPendingToGroup(const std::string& group);
+};
@@ -0,0 +1,188 @@
+#include "BinaryMeshLoader.h"
+
+#include <fstream>
+#include <filesystem>
+
+#include "Logging.h"
+#include "Utilities/FileUtils.h"
+
+namespace fs = std::filesystem;
+
+static const char MESH_CACHE_MAGIC[4] = { 'B', 'M', 'S', 'H' };
+
+/// <summary>
+/// Gets the size and modification time of a file, returns false if the file does not exist
+/// </summary>
+static bool GetSourceInfo(const std::string& file, uint64_t& size, int64_t& modifiedTime) {
+	std::error_code error;
+	size = fs::file_size(file, error);
+	if (error) return false;
+	auto time = fs::last_write_time(file, error);
+	if (error) return false;
+	modifiedTime = static_cast<int64_t>(time.time_since_epoch().count());
+	return true;
+}
+
+std::string BinaryMeshLoader::GetCachePath(const std::string& sourceFile) {
+	return sourceFile + ".bmesh";
+}
+
+VertexArrayObject::sptr BinaryMeshLoader::LoadFromCache(const std::string& sourceFile, const glm::vec4& inColor) {
+	MappedFile cache;
+	Header header;
+	if (!_OpenCache(sourceFile, inColor, cache, header)) {
+		return nullptr;
+	}
+
+	// Upload straight out of the mapped file, no intermediate copies
+	const uint8_t* vertexData = cache.GetData() + sizeof(Header);
+	const uint8_t* indexData  = vertexData + header.VertexCount * header.VertexStride;
+	return MeshBuilder<VertexPosNormTexCol>::Bake(
+		reinterpret_cast<const VertexPosNormTexCol*>(vertexData), static_cast<size_t>(header.VertexCount),
+		reinterpret_cast<const uint32_t*>(indexData), static_cast<size_t>(header.IndexCount));
+}
+
+bool BinaryMeshLoader::ReadFromCache(const std::string& sourceFile, const glm::vec4& inColor, MeshBuilder<VertexPosNormTexCol>& mesh) {
+	MappedFile cache;
+	Header header;
+	if (!_OpenCache(sourceFile, inColor, cache, header)) {
+		return false;
+	}
+
+	const uint8_t* vertexData = cache.GetData() + sizeof(Header);
+	const uint8_t* indexData  = vertexData + header.VertexCount * header.VertexStride;
+	// The indices are offset by the builder's vertex count, so they have to go in before the vertices
+	const bool wasEmpty = mesh.GetVertexCount() == 0;
+	mesh.AddIndices(reinterpret_cast<const uint32_t*>(indexData), static_cast<size_t>(header.IndexCount));
+	mesh.AddVertices(reinterpret_cast<const VertexPosNormTexCol*>(vertexData), static_cast<size_t>(header.VertexCount));
+
+	// The levels of detail replace the whole index buffer, so they are only valid if the builder started out empty
+	const LodHeader* lods = reinterpret_cast<const LodHeader*>(indexData + header.IndexCount * header.IndexSize);
+	const uint32_t*  lodIndices = reinterpret_cast<const uint32_t*>(lods + header.LodCount);
+	if (wasEmpty) {
+		for (uint32_t ix = 0; ix < header.LodCount; ix++) {
+			MeshLod lod;
+			lod.Indices.assign(lodIndices, lodIndices + lods[ix].IndexCount);
+			lod.Error = lods[ix].Error;
+			mesh.AddLod(lod);
+			lodIndices += lods[ix].IndexCount;
+		}
+	}
+	return true;
+}
+
+bool BinaryMeshLoader::_OpenCache(const std::string& sourceFile, const glm::vec4& inColor, MappedFile& cache, Header& header) {
+	const std::string cachePath = GetCachePath(sourceFile);
+
+	if (!cache.Open(cachePath) || cache.GetSize() < sizeof(Header)) {
+		return false;
+	}
+	memcpy(&header, cache.GetData(), sizeof(Header));
+
+	// Make sure the file is one of ours, and was written with the same layout we expect
+	if (memcmp(header.Magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+		header.Version != FORMAT_VERSION ||
+		header.VertexStride != sizeof(VertexPosNormTexCol) ||
+		header.IndexSize != sizeof(uint32_t)) {
+		LOG_WARN("Mesh cache \"{}\" is from an older version, rebuilding", cachePath);
+		return false;
+	}
+	const uint64_t meshSize = sizeof(Header) + header.VertexCount * header.VertexStride + header.IndexCount * header.IndexSize;
+	uint64_t expectedSize = meshSize + header.LodCount * sizeof(LodHeader);
+	if (cache.GetSize() >= expectedSize) {
+		const LodHeader* lods = reinterpret_cast<const LodHeader*>(cache.GetData() + meshSize);
+		for (uint32_t ix = 0; ix < header.LodCount; ix++) {
+			expectedSize += lods[ix].IndexCount * header.IndexSize;
+		}
+	}
+	if (cache.GetSize() != expectedSize) {
+		LOG_WARN("Mesh cache \"{}\" is truncated or corrupt, rebuilding", cachePath);
+		return false;
+	}
+	// The color is baked into the vertices, so a cache built with a different color is useless to us
+	if (glm::vec4(header.Color[0], header.Color[1], header.Color[2], header.Color[3]) != inColor) {
+		return false;
+	}
+
+	// Validate against the source model, if it's missing we trust the cache (ex: shipping builds without the OBJs)
+	uint64_t sourceSize;
+	int64_t  sourceTime;
+	if (GetSourceInfo(sourceFile, sourceSize, sourceTime)) {
+		if (sourceSize != header.SourceSize) {
+			return false;
+		}
+		// Timestamps change when files are copied or checked out, so fall back to the content hash before rebuilding
+		if (sourceTime != header.SourceModifiedTime) {
+			uint64_t size, hash;
+			if (!FileUtils::FingerprintFile(sourceFile, size, hash) || hash != header.SourceHash) {
+				return false;
+			}
+
+			// Update the stored timestamp so we don't need to re-hash the source every time we load. The file
+			// can't be written while we have it mapped, so we remap it afterwards
+			header.SourceModifiedTime = sourceTime;
+			cache.Close();
+			{
+				std::fstream file(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+				if (file) {
+					file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+				}
+			}
+			if (!cache.Open(cachePath) || cache.GetSize() != expectedSize) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool BinaryMeshLoader::SaveToCache(const std::string& sourceFile, const glm::vec4& inColor,
+	const VertexPosNormTexCol* vertices, size_t vertexCount,
+	const uint32_t* indices, size_t indexCount,
+	const std::vector<MeshLod>& lods)
+{
+	Header header = {};
+	memcpy(header.Magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	header.Version      = FORMAT_VERSION;
+	header.VertexStride = sizeof(VertexPosNormTexCol);
+	header.IndexSize    = sizeof(uint32_t);
+	header.VertexCount  = vertexCount;
+	header.IndexCount   = indexCount;
+	header.Color[0] = inColor.r;
+	header.Color[1] = inColor.g;
+	header.Color[2] = inColor.b;
+	header.Color[3] = inColor.a;
+	header.LodCount = static_cast<uint32_t>(lods.size());
+	if (!GetSourceInfo(sourceFile, header.SourceSize, header.SourceModifiedTime) ||
+		!FileUtils::FingerprintFile(sourceFile, header.SourceSize, header.SourceHash)) {
+		LOG_WARN("Could not read \"{}\" to fingerprint it, skipping mesh cache", sourceFile);
+		return false;
+	}
+
+	return _WriteHeaderAndData(GetCachePath(sourceFile), header,
+		vertices, vertexCount * sizeof(VertexPosNormTexCol),
+		indices, indexCount * sizeof(uint32_t), lods);
+}
+
+bool BinaryMeshLoader::_WriteHeaderAndData(const std::string& path, const Header& header,
+	const void* vertices, size_t vertexBytes, const void* indices, size_t indexBytes, const std::vector<MeshLod>& lods)
+{
+	// The LOD headers all come before the LOD indices
+	std::vector<LodHeader> lodHeaders;
+	lodHeaders.reserve(lods.size());
+	for (const MeshLod& lod : lods) {
+		lodHeaders.push_back({ lod.Indices.size(), lod.Error, 0 });
+	}
+
+	std::vector<FileUtils::Chunk> chunks = {
+		{ &header, sizeof(Header) },
+		{ vertices, vertexBytes },
+		{ indices, indexBytes },
+		{ lodHeaders.data(), lodHeaders.size() * sizeof(LodHeader) }
+	};
+	for (const MeshLod& lod : lods) {
+		chunks.push_back({ lod.Indices.data(), lod.Indices.size() * sizeof(uint32_t) });
+	}
+	return FileUtils::WriteFileAtomic(path, chunks);
+}
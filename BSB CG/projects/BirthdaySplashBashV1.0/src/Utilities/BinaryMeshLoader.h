@@ -0,0 +1,107 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utilities/VertexTypes.h"
+#include "Utilities/MeshBuilder.h"
+#include "Utilities/MappedFile.h"
+
+/// <summary>
+/// Reads and writes our binary mesh cache format (.bmesh). These files sit next to the source model
+/// and store the already de-duplicated, interleaved vertex data and 32 bit indices, followed by the
+/// indices of each level of detail, so that loading a model is just a memory map followed by the uploads.
+///
+/// The header records the size, modification time and hash of the source file it was built from,
+/// so a stale cache is detected and rebuilt automatically when the source model changes
+/// </summary>
+class BinaryMeshLoader
+{
+public:
+	/// <summary>
+	/// Bump this whenever the layout of the file or of the vertex type changes, older caches will be rebuilt.
+	/// Version 2 stores the mesh after MeshBuilder::Optimize, version 3 adds the levels of detail
+	/// </summary>
+	static constexpr uint32_t FORMAT_VERSION = 3;
+
+	/// <summary>
+	/// Gets the path of the cache file that is used for the given source model
+	/// </summary>
+	/// <param name="sourceFile">The path to the source model (ex: models/Arena1/Ground.obj)</param>
+	static std::string GetCachePath(const std::string& sourceFile);
+
+	/// <summary>
+	/// Attempts to load the cached mesh for the given source model. Returns nullptr if there is no cache,
+	/// or if the cache is out of date, corrupt, or was built with a different vertex color
+	/// </summary>
+	/// <param name="sourceFile">The path to the source model that the cache was generated from</param>
+	/// <param name="inColor">The vertex color that the mesh was loaded with</param>
+	static VertexArrayObject::sptr LoadFromCache(const std::string& sourceFile, const glm::vec4& inColor);
+	/// <summary>
+	/// Copies the cached mesh for the given source model into a mesh builder without touching OpenGL, so this
+	/// is safe to call from worker threads. Returns false if there is no valid cache
+	/// </summary>
+	/// <param name="sourceFile">The path to the source model that the cache was generated from</param>
+	/// <param name="inColor">The vertex color that the mesh was loaded with</param>
+	/// <param name="mesh">The mesh builder to append the cached vertices, indices and levels of detail to</param>
+	static bool ReadFromCache(const std::string& sourceFile, const glm::vec4& inColor, MeshBuilder<VertexPosNormTexCol>& mesh);
+
+	/// <summary>
+	/// Writes a cache file for the given source model. Failing to write the cache is not fatal, a warning
+	/// will be logged and the model will simply be parsed again next time
+	/// </summary>
+	/// <param name="sourceFile">The path to the source model that the data was generated from</param>
+	/// <param name="inColor">The vertex color that the mesh was loaded with</param>
+	/// <param name="vertices">The interleaved vertex data</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="indices">The triangle list indices</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="lods">The levels of detail for the mesh, see MeshBuilder::GenerateLods</param>
+	/// <returns>True if the cache was written</returns>
+	static bool SaveToCache(const std::string& sourceFile, const glm::vec4& inColor,
+		const VertexPosNormTexCol* vertices, size_t vertexCount,
+		const uint32_t* indices, size_t indexCount,
+		const std::vector<MeshLod>& lods = std::vector<MeshLod>());
+
+protected:
+	BinaryMeshLoader() = default;
+	~BinaryMeshLoader() = default;
+
+	/// <summary>
+	/// The header at the start of every .bmesh file, padded to a multiple of 16 bytes so that
+	/// the vertex data which follows it stays aligned
+	/// </summary>
+	struct Header {
+		char     Magic[4];
+		uint32_t Version;
+		uint32_t VertexStride;
+		uint32_t IndexSize;
+		uint64_t VertexCount;
+		uint64_t IndexCount;
+		uint64_t SourceSize;
+		int64_t  SourceModifiedTime;
+		uint64_t SourceHash;
+		float    Color[4];
+		uint32_t LodCount;
+		uint32_t Reserved;
+	};
+	static_assert(sizeof(Header) % 16 == 0, "Mesh cache header must stay 16 byte aligned");
+
+	/// <summary>
+	/// Describes a level of detail, these follow the mesh's indices and are followed by all of the levels' indices
+	/// </summary>
+	struct LodHeader {
+		uint64_t IndexCount;
+		float    Error;
+		uint32_t Reserved;
+	};
+
+	/// <summary>
+	/// Maps and validates the cache for the given source model, leaving it mapped in cache if it is valid
+	/// </summary>
+	static bool _OpenCache(const std::string& sourceFile, const glm::vec4& inColor, MappedFile& cache, Header& header);
+	static bool _WriteHeaderAndData(const std::string& path, const Header& header,
+		const void* vertices, size_t vertexBytes, const void* indices, size_t indexBytes, const std::vector<MeshLod>& lods);
+};
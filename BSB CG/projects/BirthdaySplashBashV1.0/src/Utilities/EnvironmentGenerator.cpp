@@ -4,8 +4,6 @@
 std::vector<std::vector<GameObject>> EnvironmentGenerator::_objectsSpawned;
 
 //Object information for being spawned
-std::vector<VertexArrayObject::sptr> EnvironmentGenerator::_vaosToSpawn;
-std::vector<bool> EnvironmentGenerator::_loadedIn;
 std::vector<ShaderMaterial::sptr> EnvironmentGenerator::_materialsForSpawning;
 std::vector<int> EnvironmentGenerator::_numToSpawn;
 std::vector<glm::vec2> EnvironmentGenerator::_spawnFromAll;
@@ -34,18 +32,13 @@ void EnvironmentGenerator::GenerateEnvironment()
 	{
 		std::vector<GameObject> temp;
 		{
-			//Load in this object vao
-			if (!_loadedIn[i])
-			{
-				VertexArrayObject::sptr vao = ObjLoader::LoadFromFile(_objectsToSpawn[i]);
-				_vaosToSpawn.push_back(vao);
-				_loadedIn[i] = true;
-			}
+			//Grab the mesh from the cache, it was loaded when the object was added
+			VertexArrayObject::sptr vao = AssetCache::LoadMesh(_objectsToSpawn[i]);
 
 			for (int j = 0; j < _numToSpawn[i]; j++)
 			{
 				temp.push_back(Application::Instance().ActiveScene->CreateEntity(_objectsToSpawn[i] + (std::to_string(j + 1))));
-				temp[j].emplace<RendererComponent>().SetMesh(_vaosToSpawn[i]).SetMaterial(_materialsForSpawning[i]);
+				temp[j].emplace<RendererComponent>().SetMesh(vao).SetMaterial(_materialsForSpawning[i]);
 				//Randomly places
 				temp[j].get<Transform>().SetLocalPosition(glm::vec3(Util::GetRandomNumberBetween(_spawnFromAll[i],
 					_spawnToAll[i], _avoidFromAll[i], _avoidToAll[i]), 0.0f));
@@ -75,10 +68,14 @@ void EnvironmentGenerator::CleanEnvironment()
 
 void EnvironmentGenerator::CleanUpPointers()
 {
-	//Clear up vao references so the smart pointers can clear
-	_vaosToSpawn.clear();
-	//Clear up material references so the smart pointers can clear
+	//Clear up material references so the smart pointers can clear, the other lists go with them so they stay the same length
 	_materialsForSpawning.clear();
+	_objectsToSpawn.clear();
+	_numToSpawn.clear();
+	_spawnFromAll.clear();
+	_spawnToAll.clear();
+	_avoidFromAll.clear();
+	_avoidToAll.clear();
 }
 
 void EnvironmentGenerator::AddObjectToGeneration(std::string fileName, ShaderMaterial::sptr objMat, int numToSpawn, glm::vec2 spawnFrom, 
@@ -93,9 +90,8 @@ void EnvironmentGenerator::AddObjectToGeneration(std::string fileName, ShaderMat
 		return;
 	}
 
-	//Loads in the mesh and adds to list
-	VertexArrayObject::sptr vao = ObjLoader::LoadFromFile(fileName);
-	_vaosToSpawn.push_back(vao);
+	//Starts loading the mesh, the cache will hold onto it until we spawn
+	AssetCache::LoadMesh(fileName);
 	//Adds material to list
 	_materialsForSpawning.push_back(objMat);
 	//Adds number to spawn for this object
@@ -109,8 +105,6 @@ void EnvironmentGenerator::AddObjectToGeneration(std::string fileName, ShaderMat
 
 	//Adds the filename to the list
 	_objectsToSpawn.push_back(fileName);
-	//Sets it as not loaded
-	_loadedIn.push_back(false);
 }
 
 void EnvironmentGenerator::RemoveObjectFromGeneration(std::string fileName)
@@ -122,9 +116,7 @@ void EnvironmentGenerator::RemoveObjectFromGeneration(std::string fileName)
 		return;
 	}
 
-	//Erase from the vaosToSpawn, Materials, numbers, etc
-	_vaosToSpawn.erase(_vaosToSpawn.begin() + index);
-	_loadedIn.erase(_loadedIn.begin() + index);
+	//Erase from the Materials, numbers, etc
 	_materialsForSpawning.erase(_materialsForSpawning.begin() + index);
 	_numToSpawn.erase(_numToSpawn.begin() + index);
 	_avoidFromAll.erase(_avoidFromAll.begin() + index);
@@ -1,7 +1,7 @@
 #pragma once
 #include <Gameplay/Scene.h>
 #include <Gameplay/Application.h>
-#include <Utilities/ObjLoader.h>
+#include <Utilities/AssetCache.h>
 #include <Gameplay/RendererComponent.h>
 #include <Gameplay/Transform.h>
 #include <vector>
@@ -33,9 +33,6 @@ private:
 	//The gameobjects spawned here
 	static std::vector<std::vector<GameObject>> _objectsSpawned;
 
-	//The vaos to spawn in
-	static std::vector<VertexArrayObject::sptr> _vaosToSpawn;
-	static std::vector<bool> _loadedIn;
 	static std::vector<ShaderMaterial::sptr> _materialsForSpawning;
 	static std::vector<int> _numToSpawn;
 	static std::vector<glm::vec2> _spawnFromAll;
@@ -0,0 +1,62 @@
+#include "FileUtils.h"
+
+#include <thread>
+#include <fstream>
+#include <filesystem>
+
+#include "Logging.h"
+#include "Utilities/Hash.h"
+#include "Utilities/MappedFile.h"
+
+namespace fs = std::filesystem;
+
+bool FileUtils::FingerprintFile(const std::string& file, uint64_t& size, uint64_t& hash) {
+	MappedFile source(file);
+	if (!source.IsOpen()) return false;
+	size = source.GetSize();
+	hash = Hash::Fnv1a(source.GetData(), source.GetSize());
+	return true;
+}
+
+bool FileUtils::IsSourceUnchanged(const std::string& file, uint64_t size, uint64_t hash) {
+	std::error_code error;
+	if (!fs::exists(file, error)) {
+		return true;
+	}
+	// Checking the size first saves us from hashing the file in the common case of an edit that resized it
+	if (fs::file_size(file, error) != size || error) {
+		return false;
+	}
+	uint64_t sourceSize, sourceHash;
+	return FingerprintFile(file, sourceSize, sourceHash) && sourceSize == size && sourceHash == hash;
+}
+
+bool FileUtils::WriteFileAtomic(const std::string& path, const std::vector<Chunk>& chunks) {
+	const std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			LOG_WARN("Failed to open \"{}\" for writing", tempPath);
+			return false;
+		}
+		for (const Chunk& chunk : chunks) {
+			file.write(static_cast<const char*>(chunk.Data), chunk.Size);
+		}
+		if (!file) {
+			LOG_WARN("Failed to write \"{}\"", tempPath);
+			file.close();
+			std::error_code error;
+			fs::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(tempPath, path, error);
+	if (error) {
+		LOG_WARN("Failed to move \"{}\" into place: {}", path, error.message());
+		fs::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
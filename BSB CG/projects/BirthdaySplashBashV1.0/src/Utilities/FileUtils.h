@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/// <summary>
+/// File helpers shared by our on-disk caches (mip chains, meshes, LUTs, environment maps, shader binaries and
+/// compressed textures), so that they all validate and write their files the same way
+/// </summary>
+namespace FileUtils
+{
+	/// <summary>
+	/// A block of memory to write to a file
+	/// </summary>
+	struct Chunk
+	{
+		const void* Data;
+		size_t      Size;
+	};
+
+	/// <summary>
+	/// Gets the size and content hash of a file, this is what the caches store to tell if their source has changed
+	/// </summary>
+	/// <param name="file">The path to the file to fingerprint</param>
+	/// <param name="size">Receives the size of the file in bytes</param>
+	/// <param name="hash">Receives the FNV-1a hash of the file's contents</param>
+	/// <returns>True if the file was read, false if it could not be opened</returns>
+	bool FingerprintFile(const std::string& file, uint64_t& size, uint64_t& hash);
+
+	/// <summary>
+	/// Checks a cache's stored fingerprint against the file it was built from. If the source is missing we trust
+	/// the cache, so that builds can ship the caches without the source assets
+	/// </summary>
+	/// <param name="file">The path to the source file</param>
+	/// <param name="size">The size stored in the cache</param>
+	/// <param name="hash">The hash stored in the cache</param>
+	/// <returns>True if the source matches the fingerprint or is missing, false if it has changed</returns>
+	bool IsSourceUnchanged(const std::string& file, uint64_t size, uint64_t hash);
+
+	/// <summary>
+	/// Writes chunks of memory back to back to a file, replacing it if it exists. We write to a temporary and then
+	/// move it into place, so a crash mid-write never leaves a corrupt file behind. The temporary is named after the
+	/// calling thread, which keeps two workers that are writing the same file from writing to the same temporary
+	/// </summary>
+	/// <param name="path">The path to write the file to</param>
+	/// <param name="chunks">The blocks of memory to write, in order</param>
+	/// <returns>True if the file was written and moved into place, false if otherwise (the reason is logged)</returns>
+	bool WriteFileAtomic(const std::string& path, const std::vector<Chunk>& chunks);
+}
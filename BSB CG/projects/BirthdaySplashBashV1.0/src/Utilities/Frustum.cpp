@@ -0,0 +1,99 @@
+#include "Frustum.h"
+
+// SSE is part of the x64 baseline, so every 64 bit build gets the batched path
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum() {
+	for (glm::vec4& plane : _planes) {
+		plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	// glm is column major, so the rows of the matrix are spread across the columns
+	const glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	const glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	const glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	const glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	_planes[0] = row3 + row0;
+	_planes[1] = row3 - row0;
+	_planes[2] = row3 + row1;
+	_planes[3] = row3 - row1;
+	_planes[4] = row3 + row2;
+	_planes[5] = row3 - row2;
+	// Normalize so that the plane equations give real distances, which we compare against radii
+	for (glm::vec4& plane : _planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+Frustum::CullResult Frustum::TestSphere(const glm::vec3& center, float radius) const {
+	CullResult result = CullResult::Inside;
+	for (const glm::vec4& plane : _planes) {
+		const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		if (distance < -radius) {
+			return CullResult::Outside;
+		}
+		if (distance < radius) {
+			result = CullResult::Intersecting;
+		}
+	}
+	return result;
+}
+
+Frustum::CullResult Frustum::TestBox(const glm::vec3& center, const glm::vec3& extents) const {
+	CullResult result = CullResult::Inside;
+	for (const glm::vec4& plane : _planes) {
+		// The box's extent along the plane normal, its "radius" in that direction
+		const float radius = glm::dot(extents, glm::abs(glm::vec3(plane)));
+		const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		if (distance < -radius) {
+			return CullResult::Outside;
+		}
+		if (distance < radius) {
+			result = CullResult::Intersecting;
+		}
+	}
+	return result;
+}
+
+void Frustum::TestSpheres(const float* x, const float* y, const float* z, const float* radius, size_t count, CullResult* results) const {
+	size_t ix = 0;
+
+	#ifdef FRUSTUM_SSE
+	for (; ix + 4 <= count; ix += 4) {
+		const __m128 cx = _mm_loadu_ps(x + ix);
+		const __m128 cy = _mm_loadu_ps(y + ix);
+		const __m128 cz = _mm_loadu_ps(z + ix);
+		const __m128 r  = _mm_loadu_ps(radius + ix);
+		const __m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+		__m128 outside = _mm_setzero_ps();
+		__m128 intersecting = _mm_setzero_ps();
+		for (const glm::vec4& plane : _planes) {
+			__m128 distance = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+			distance = _mm_add_ps(distance, _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(plane.z)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negR));
+			intersecting = _mm_or_ps(intersecting, _mm_cmplt_ps(distance, r));
+		}
+
+		const int outsideMask = _mm_movemask_ps(outside);
+		const int intersectingMask = _mm_movemask_ps(intersecting);
+		for (int lane = 0; lane < 4; lane++) {
+			results[ix + lane] =
+				(outsideMask & (1 << lane))      ? CullResult::Outside :
+				(intersectingMask & (1 << lane)) ? CullResult::Intersecting : CullResult::Inside;
+		}
+	}
+	#endif
+
+	// Whatever doesn't fill a full batch (or everything, without SSE)
+	for (; ix < count; ix++) {
+		results[ix] = TestSphere(glm::vec3(x[ix], y[ix], z[ix]), radius[ix]);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// The 6 planes of a camera's view volume in world space, for culling objects that can't be seen
+/// </summary>
+class Frustum
+{
+public:
+	enum class CullResult : uint8_t {
+		Outside      = 0,
+		Intersecting = 1,
+		Inside       = 2
+	};
+
+	Frustum();
+	/// <summary>
+	/// Extracts the planes from a view projection matrix (Gribb and Hartmann), using OpenGL's [-1, 1] clip depth
+	/// </summary>
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	/// <summary>
+	/// Gets one of the planes as a normal pointing into the frustum (xyz) and a distance (w), in the order
+	/// left, right, bottom, top, near, far
+	/// </summary>
+	const glm::vec4& GetPlane(int index) const { return _planes[index]; }
+
+	CullResult TestSphere(const glm::vec3& center, float radius) const;
+	/// <summary>
+	/// Tests an axis aligned box, given by its center and half extents
+	/// </summary>
+	CullResult TestBox(const glm::vec3& center, const glm::vec3& extents) const;
+
+	/// <summary>
+	/// Tests a batch of spheres stored as separate arrays of components. Uses SSE to test 4 spheres at a time
+	/// where it is available
+	/// </summary>
+	/// <param name="x">The x coordinates of the centers</param>
+	/// <param name="y">The y coordinates of the centers</param>
+	/// <param name="z">The z coordinates of the centers</param>
+	/// <param name="radius">The radii</param>
+	/// <param name="count">The number of spheres</param>
+	/// <param name="results">Receives the result for each sphere</param>
+	void TestSpheres(const float* x, const float* y, const float* z, const float* radius, size_t count, CullResult* results) const;
+
+protected:
+	glm::vec4 _planes[6];
+};
@@ -0,0 +1,224 @@
+#include "GltfLoader.h"
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+#include <GLM/gtc/type_ptr.hpp>
+
+#include "tiny_gltf.h"
+#include "NOU/GLTFLoader.h"
+
+#include "Logging.h"
+#include "MappedFile.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// Nodes can nest arbitrarily deep, but anything past this is almost certainly a cycle in a broken file
+	constexpr int MAX_NODE_DEPTH = 64;
+
+	// We only want the geometry, textures are loaded separately through our own texture pipeline, so we skip
+	// decoding any images that the model references
+	bool SkipImage(tinygltf::Image*, const int, std::string*, std::string*, int, int, const unsigned char*, int, void*) {
+		return true;
+	}
+}
+
+bool GltfLoader::IsGltfFile(const std::string& filename)
+{
+	std::string extension = fs::path(filename).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return extension == ".gltf" || extension == ".glb";
+}
+
+VertexArrayObject::sptr GltfLoader::LoadFromFile(const std::string& filename, const glm::vec4& inColor)
+{
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	LoadMeshData(filename, mesh, inColor);
+	return mesh.Bake();
+}
+
+void GltfLoader::LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, bool flipUVY)
+{
+	// Map the file rather than reading it, tinygltf parses straight out of the mapping so a .glb's binary chunk
+	// is only copied once, into the model's buffer
+	MappedFile file(filename);
+	if (!file.IsOpen()) {
+		throw std::runtime_error("Failed to open file");
+	}
+
+	tinygltf::TinyGLTF loader;
+	loader.SetImageLoader(SkipImage, nullptr);
+
+	tinygltf::Model model;
+	std::string err, warn;
+	const std::string baseDir = fs::path(filename).parent_path().string();
+	const bool isBinary = file.GetSize() >= 4 && memcmp(file.GetData(), "glTF", 4) == 0;
+	const bool result = isBinary ?
+		loader.LoadBinaryFromMemory(&model, &err, &warn, file.GetData(), (unsigned int)file.GetSize(), baseDir) :
+		loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char*>(file.GetData()), (unsigned int)file.GetSize(), baseDir);
+	file.Close();
+
+	if (!warn.empty()) {
+		LOG_WARN("Warnings loading \"{}\":\n{}", filename, warn);
+	}
+	if (!result) {
+		LOG_ERROR("Failed to load \"{}\":\n{}", filename, err);
+		throw std::runtime_error("Failed to parse glTF file, see logs for more information");
+	}
+
+	const bool wasEmpty = mesh.GetVertexCount() == 0 && mesh.GetIndexCount() == 0;
+	ExtractGeometry(model, mesh, inColor, flipUVY);
+
+	// Exporters write triangles in whatever order the artist's tool kept them in, so we always optimize. We can
+	// only reorder the whole builder, so we skip it when appending to an existing mesh
+	if (wasEmpty) {
+		const MeshOptimizeReport report = mesh.Optimize();
+		LOG_INFO("Optimized \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", filename,
+			report.Before.ACMR, report.After.ACMR, report.Before.ATVR, report.After.ATVR);
+		const std::vector<MeshLod>& lods = mesh.GenerateLods();
+		for (size_t ix = 0; ix < lods.size(); ix++) {
+			LOG_INFO("  LOD {}: {} triangles, error {:.4f}", ix + 1, lods[ix].Indices.size() / 3, lods[ix].Error);
+		}
+	}
+}
+
+void GltfLoader::ExtractGeometry(const tinygltf::Model& model, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, bool flipUVY)
+{
+	// Reserve space for everything up front, instancing a mesh in multiple nodes will grow past this but that's rare
+	size_t vertexCount = 0, indexCount = 0;
+	for (const tinygltf::Mesh& gltfMesh : model.meshes) {
+		for (const tinygltf::Primitive& primitive : gltfMesh.primitives) {
+			const int positions = nou::GLTF::FindAccessor(primitive, "POSITION");
+			if (!nou::GLTF::IsTriangleList(primitive) || positions == -1) {
+				continue;
+			}
+			vertexCount += model.accessors[positions].count;
+			indexCount  += model.accessors[primitive.indices != -1 ? primitive.indices : positions].count;
+		}
+	}
+	mesh.ReserveVertexSpace(vertexCount);
+	mesh.ReserveIndexSpace(indexCount);
+
+	// Walk the scene graph so that each mesh ends up where the artist placed it. Files without a scene (which is
+	// allowed by the spec) just have their meshes added as-is
+	if (!model.scenes.empty()) {
+		const tinygltf::Scene& scene = model.scenes[model.defaultScene >= 0 ? model.defaultScene : 0];
+		for (int nodeIx : scene.nodes) {
+			_AppendNode(model, nodeIx, glm::mat4(1.0f), mesh, inColor, flipUVY, 0);
+		}
+	} else {
+		for (size_t meshIx = 0; meshIx < model.meshes.size(); meshIx++) {
+			_AppendMesh(model, (int)meshIx, glm::mat4(1.0f), mesh, inColor, flipUVY);
+		}
+	}
+}
+
+void GltfLoader::_AppendNode(const tinygltf::Model& model, int nodeIx, const glm::mat4& parent, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, bool flipUVY, int depth)
+{
+	if (nodeIx < 0 || nodeIx >= (int)model.nodes.size() || depth > MAX_NODE_DEPTH) {
+		LOG_WARN("Skipping invalid glTF node {}", nodeIx);
+		return;
+	}
+	const tinygltf::Node& node = model.nodes[nodeIx];
+	const glm::mat4 transform = parent * nou::GLTF::GetLocalTransform(node);
+
+	if (node.mesh >= 0 && node.mesh < (int)model.meshes.size()) {
+		_AppendMesh(model, node.mesh, transform, mesh, inColor, flipUVY);
+	}
+	for (int childIx : node.children) {
+		_AppendNode(model, childIx, transform, mesh, inColor, flipUVY, depth + 1);
+	}
+}
+
+void GltfLoader::_AppendMesh(const tinygltf::Model& model, int meshIx, const glm::mat4& transform, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, bool flipUVY)
+{
+	const tinygltf::Mesh& gltfMesh = model.meshes[meshIx];
+	const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+	// Mirrored transforms flip the winding of every triangle, so we swap it back to keep our front faces CCW
+	const bool flipWinding = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+	for (const tinygltf::Primitive& primitive : gltfMesh.primitives) {
+		if (!nou::GLTF::IsTriangleList(primitive)) {
+			LOG_WARN("Skipping primitive in \"{}\" that is not a triangle list", gltfMesh.name);
+			continue;
+		}
+		const int positionIx = nou::GLTF::FindAccessor(primitive, "POSITION");
+		if (positionIx == -1) {
+			LOG_WARN("Skipping primitive in \"{}\" with no positions", gltfMesh.name);
+			continue;
+		}
+		const int normalIx = nou::GLTF::FindAccessor(primitive, "NORMAL");
+		const int uvIx     = nou::GLTF::FindAccessor(primitive, "TEXCOORD_0");
+		const int colorIx  = nou::GLTF::FindAccessor(primitive, "COLOR_0");
+
+		// These are all views straight into the model's buffers. Accessors that reach past the end of their buffer
+		// come back with no data, we skip the primitive if that's the positions or indices and otherwise leave the
+		// attribute out
+		std::string warn;
+		const nou::GLTF::DataGetter positions = nou::GLTF::BuildGetter(model, positionIx, warn);
+		nou::GLTF::DataGetter indices = {}, normals = {}, uvs = {}, colors = {};
+		if (primitive.indices != -1) indices = nou::GLTF::BuildGetter(model, primitive.indices, warn);
+		if (normalIx != -1) normals = nou::GLTF::BuildGetter(model, normalIx, warn);
+		if (uvIx != -1)     uvs     = nou::GLTF::BuildGetter(model, uvIx, warn);
+		if (colorIx != -1)  colors  = nou::GLTF::BuildGetter(model, colorIx, warn);
+		if (!warn.empty()) {
+			LOG_WARN("Invalid accessors in \"{}\":{}", gltfMesh.name, warn);
+		}
+		if (positions.data == nullptr || (primitive.indices != -1 && indices.data == nullptr)) {
+			LOG_WARN("Skipping primitive in \"{}\" with invalid positions or indices", gltfMesh.name);
+			continue;
+		}
+
+		const uint32_t baseVertex = (uint32_t)mesh.GetVertexCount();
+		for (size_t ix = 0; ix < positions.len; ix++) {
+			VertexPosNormTexCol vertex;
+			nou::GLTF::ReadFloats(positions, ix, glm::value_ptr(vertex.Position), 3);
+			vertex.Position = glm::vec3(transform * glm::vec4(vertex.Position, 1.0f));
+
+			if (normals.data != nullptr) {
+				nou::GLTF::ReadFloats(normals, ix, glm::value_ptr(vertex.Normal), 3);
+				vertex.Normal = glm::normalize(normalMatrix * vertex.Normal);
+			}
+			if (uvs.data != nullptr) {
+				nou::GLTF::ReadFloats(uvs, ix, glm::value_ptr(vertex.UV), 2);
+				if (flipUVY) {
+					vertex.UV.y = 1.0f - vertex.UV.y;
+				}
+			}
+			// Colors can be RGB or RGBA, alpha stays at 1 when there's only 3 components
+			glm::vec4 color = glm::vec4(1.0f);
+			if (colors.data != nullptr) {
+				nou::GLTF::ReadFloats(colors, ix, glm::value_ptr(color), 4);
+			}
+			vertex.Color = color * inColor;
+
+			mesh.AddVertex(vertex);
+		}
+
+		// Primitives without an index buffer are already a triangle list
+		if (primitive.indices != -1) {
+			for (size_t ix = 0; ix + 2 < indices.len; ix += 3) {
+				uint32_t a = nou::GLTF::ReadIndex(indices, ix);
+				uint32_t b = nou::GLTF::ReadIndex(indices, ix + 1);
+				uint32_t c = nou::GLTF::ReadIndex(indices, ix + 2);
+				if (a >= positions.len || b >= positions.len || c >= positions.len) {
+					LOG_ERROR("Index out of range in \"{}\"", gltfMesh.name);
+					throw std::runtime_error("Invalid glTF index buffer, see logs for more information");
+				}
+				if (flipWinding) {
+					std::swap(b, c);
+				}
+				mesh.AddIndexTri(baseVertex + a, baseVertex + b, baseVertex + c);
+			}
+		} else {
+			for (uint32_t ix = 0; ix + 2 < positions.len; ix += 3) {
+				mesh.AddIndexTri(baseVertex + ix, baseVertex + (flipWinding ? ix + 2 : ix + 1), baseVertex + (flipWinding ? ix + 1 : ix + 2));
+			}
+		}
+	}
+}
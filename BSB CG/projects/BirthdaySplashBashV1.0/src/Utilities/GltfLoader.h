@@ -0,0 +1,50 @@
+#pragma once
+#include "MeshFactory.h"
+
+namespace tinygltf
+{
+	class Model;
+}
+
+/// <summary>
+/// Loads glTF 2.0 models (.gltf with external or embedded buffers, or binary .glb) into our vertex format.
+/// Unlike nou::GLTF::LoadMesh, the index buffers are kept as-is rather than expanded into a triangle list, and
+/// every triangle primitive in the default scene is merged into the one mesh with its node transform applied
+/// </summary>
+class GltfLoader
+{
+public:
+	/// <summary>
+	/// Returns true if the path has a .gltf or .glb extension (case insensitive)
+	/// </summary>
+	static bool IsGltfFile(const std::string& filename);
+
+	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f));
+
+	/// <summary>
+	/// Loads the vertices and indices for a model into a mesh builder without creating any OpenGL objects, this
+	/// is the part of LoadFromFile that is safe to run on a worker thread
+	/// </summary>
+	/// <param name="filename">The path to the .gltf or .glb file to load</param>
+	/// <param name="mesh">The mesh builder to append the model to</param>
+	/// <param name="inColor">The color to multiply with the vertex colors, or to apply to all vertices if the model has none</param>
+	/// <param name="flipUVY">True to flip the V coordinate, since glTF puts the origin at the top left and our images are loaded flipped</param>
+	static void LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor = glm::vec4(1.0f), bool flipUVY = true);
+
+	/// <summary>
+	/// Appends every triangle primitive in an already parsed model to a mesh builder. Attributes are read
+	/// straight out of the model's buffers, 8, 16 and 32 bit indices are all supported
+	/// </summary>
+	/// <param name="model">The model to extract the geometry from</param>
+	/// <param name="mesh">The mesh builder to append the results to</param>
+	/// <param name="inColor">The color to multiply with the vertex colors</param>
+	/// <param name="flipUVY">True to flip the V coordinate</param>
+	static void ExtractGeometry(const tinygltf::Model& model, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, bool flipUVY);
+
+protected:
+	GltfLoader() = default;
+	~GltfLoader() = default;
+
+	static void _AppendNode(const tinygltf::Model& model, int nodeIx, const glm::mat4& parent, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, bool flipUVY, int depth);
+	static void _AppendMesh(const tinygltf::Model& model, int meshIx, const glm::mat4& transform, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, bool flipUVY);
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/// <summary>
+/// Small helpers for the 64 bit FNV-1a hash, used to fingerprint files and other data
+/// for our on-disk caches, and to look up names like shader uniforms. This is NOT a cryptographic hash
+/// </summary>
+namespace Hash
+{
+	constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+	constexpr uint64_t FNV_PRIME        = 0x00000100000001b3ull;
+
+	/// <summary>
+	/// Hashes a block of memory using FNV-1a
+	/// </summary>
+	/// <param name="data">The data to hash</param>
+	/// <param name="size">The size of the data in bytes</param>
+	/// <param name="seed">The hash to continue from, allows hashing multiple blocks as one stream</param>
+	inline uint64_t Fnv1a(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t result = seed;
+		for (size_t ix = 0; ix < size; ix++) {
+			result ^= bytes[ix];
+			result *= FNV_PRIME;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Hashes a null terminated string with FNV-1a, this gives the same result as Fnv1a over the string's
+	/// characters. Being constexpr, literal names can be hashed at compile time
+	/// </summary>
+	/// <param name="str">The string to hash</param>
+	/// <param name="seed">The hash to continue from</param>
+	constexpr uint64_t Fnv1aString(const char* str, uint64_t seed = FNV_OFFSET_BASIS) {
+		uint64_t result = seed;
+		for (; *str != '\0'; str++) {
+			result ^= static_cast<uint8_t>(*str);
+			result *= FNV_PRIME;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// A name along with its hash, for looking things up by name without building a std::string. Declaring
+	/// these as constexpr (or using the _name literal) hashes the name at compile time, ex:
+	///		static constexpr Hash::HashedName LutSize = "u_LutSize";
+	/// Only a pointer to the name is kept, so the string must outlive the HashedName
+	/// </summary>
+	struct HashedName
+	{
+		uint64_t    Value;
+		const char* Name;
+
+		constexpr HashedName(const char* name) : Value(Fnv1aString(name)), Name(name) {}
+		HashedName(const std::string& name) : Value(Fnv1aString(name.c_str())), Name(name.c_str()) {}
+
+		constexpr bool operator ==(const HashedName& other) const { return Value == other.Value; }
+		constexpr bool operator !=(const HashedName& other) const { return Value != other.Value; }
+	};
+
+	namespace Literals
+	{
+		/// <summary>
+		/// Makes a HashedName from a literal, ex: shader->SetUniform("u_LutSize"_name, size). Compilers fold this
+		/// into a constant, but only a constexpr HashedName is guaranteed to be hashed at compile time
+		/// </summary>
+		constexpr HashedName operator "" _name(const char* str, size_t) { return HashedName(str); }
+	}
+}
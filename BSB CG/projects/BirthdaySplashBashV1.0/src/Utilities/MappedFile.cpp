@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+#ifdef WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile() :
+	_data(nullptr),
+	_size(0),
+	#ifdef WINDOWS
+	_fileHandle(INVALID_HANDLE_VALUE),
+	_mappingHandle(nullptr)
+	#else
+	_fileHandle(-1)
+	#endif
+{ }
+
+MappedFile::MappedFile(const std::string& filename) :
+	MappedFile()
+{
+	Open(filename);
+}
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const std::string& filename) {
+	Close();
+
+	#ifdef WINDOWS
+	_fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (_fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_fileHandle, &size) || size.QuadPart == 0) {
+		Close();
+		return false;
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+
+	_mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mappingHandle == nullptr) {
+		Close();
+		return false;
+	}
+
+	_data = static_cast<const uint8_t*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	#else
+	_fileHandle = open(filename.c_str(), O_RDONLY);
+	if (_fileHandle < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(_fileHandle, &info) != 0 || info.st_size == 0) {
+		Close();
+		return false;
+	}
+	_size = static_cast<size_t>(info.st_size);
+
+	void* mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileHandle, 0);
+	_data = mapping == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(mapping);
+	#endif
+
+	if (_data == nullptr) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close() {
+	#ifdef WINDOWS
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mappingHandle != nullptr) {
+		CloseHandle(_mappingHandle);
+		_mappingHandle = nullptr;
+	}
+	if (_fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(_fileHandle);
+		_fileHandle = INVALID_HANDLE_VALUE;
+	}
+	#else
+	if (_data != nullptr) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	if (_fileHandle >= 0) {
+		close(_fileHandle);
+		_fileHandle = -1;
+	}
+	#endif
+	_data = nullptr;
+	_size = 0;
+}
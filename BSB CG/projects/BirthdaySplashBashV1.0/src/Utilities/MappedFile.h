@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+/// <summary>
+/// A read-only memory mapped view of a file on disk. The contents are paged in
+/// by the OS on demand, so large files can be handed to the GPU or a parser
+/// without ever being copied into our own buffers
+/// </summary>
+class MappedFile final
+{
+public:
+	// The mapping is tied to OS handles, so we disallow copying and moving
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile(MappedFile&& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	MappedFile& operator=(MappedFile&& other) = delete;
+
+	MappedFile();
+	/// <summary>
+	/// Creates a new mapped file and attempts to open the file at the given path
+	/// </summary>
+	/// <param name="filename">The path to the file to map</param>
+	explicit MappedFile(const std::string& filename);
+	~MappedFile();
+
+	/// <summary>
+	/// Maps the given file into memory, closing any existing mapping first
+	/// </summary>
+	/// <param name="filename">The path to the file to map</param>
+	/// <returns>True if the file was mapped, false if it could not be opened</returns>
+	bool Open(const std::string& filename);
+	/// <summary>
+	/// Releases the mapping and any OS handles, invalidating all pointers returned by GetData
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if this file is currently mapped (note that empty files are never mapped)
+	/// </summary>
+	bool IsOpen() const { return _data != nullptr; }
+	/// <summary>
+	/// Gets a pointer to the first byte of the file, or nullptr if not open
+	/// </summary>
+	const uint8_t* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the mapped file in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+private:
+	const uint8_t* _data;
+	size_t         _size;
+
+	#ifdef WINDOWS
+	void* _fileHandle;
+	void* _mappingHandle;
+	#else
+	int   _fileHandle;
+	#endif
+};
@@ -1,6 +1,18 @@
 #pragma once
 #include <vector>
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/GeometryPool.h"
+#include "Utilities/MeshOptimizer.h"
+#include "Utilities/MeshSimplifier.h"
+
+/// <summary>
+/// The vertex cache statistics of a mesh before and after MeshBuilder::Optimize
+/// </summary>
+struct MeshOptimizeReport
+{
+	VertexCacheStats Before;
+	VertexCacheStats After;
+};
 
 template <typename VertType>
 class MeshBuilder
@@ -8,7 +20,8 @@ class MeshBuilder
 public:
 	MeshBuilder() :
 		_vertices(std::vector<VertType>()),
-		_indices(std::vector<uint32_t>()) {}
+		_indices(std::vector<uint32_t>()),
+		_lods(std::vector<MeshLod>()) {}
 	~MeshBuilder() = default;
 
 	/// <summary>
@@ -27,6 +40,15 @@ public:
 		return static_cast<uint32_t>(_vertices.size() - 1u);
 	}
 	
+	/// <summary>
+	/// Appends a block of vertices to the mesh, without remapping any indices
+	/// </summary>
+	/// <param name="vertices">A pointer to the first vertex to add</param>
+	/// <param name="count">The number of vertices to add</param>
+	void AddVertices(const VertType* vertices, size_t count) {
+		_vertices.insert(_vertices.end(), vertices, vertices + count);
+	}
+	
 	/// <summary>
 	/// Adds an index to the index buffer
 	/// </summary>
@@ -35,6 +57,20 @@ public:
 		_indices.push_back(index);
 	}
 
+	/// <summary>
+	/// Appends a block of indices to the index buffer, offset by the current vertex count so that they refer to
+	/// the vertices that are added next (call this before AddVertices)
+	/// </summary>
+	/// <param name="indices">A pointer to the first index to add, relative to the block of vertices they belong to</param>
+	/// <param name="count">The number of indices to add</param>
+	void AddIndices(const uint32_t* indices, size_t count) {
+		const uint32_t offset = static_cast<uint32_t>(_vertices.size());
+		_indices.reserve(_indices.size() + count);
+		for (size_t ix = 0; ix < count; ix++) {
+			_indices.push_back(indices[ix] + offset);
+		}
+	}
+
 	/// <summary>
 	/// Adds a triangle between the three indices
 	/// </summary>
@@ -43,7 +79,6 @@ public:
 	/// <param name="c">The index of the third vertex</param>
 	void AddIndexTri(uint32_t a, uint32_t b, uint32_t c)
 	{
-		ReserveIndexSpace(3);
 		_indices.push_back(a);
 		_indices.push_back(b);
 		_indices.push_back(c);
@@ -81,16 +116,93 @@ public:
 	/// </summary>
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
-	VertexArrayObject::sptr Bake() {
-		VertexBuffer::sptr vbo = VertexBuffer::Create();
-		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
+	/// <summary>
+	/// Reorders the triangles and vertices of this mesh so that it is cheaper to draw, see MeshOptimizer. Meshes
+	/// without an index buffer are left alone. Any levels of detail are dropped, since they would point at the
+	/// old vertex order
+	/// </summary>
+	/// <returns>The vertex cache statistics before and after optimizing</returns>
+	MeshOptimizeReport Optimize() {
+		_lods.clear();
+		MeshOptimizeReport result;
+		result.Before = MeshOptimizer::AnalyzeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+		if (_indices.size() < 3) {
+			result.After = result.Before;
+			return result;
+		}
+		MeshOptimizer::OptimizeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+		MeshOptimizer::OptimizeOverdraw(_indices.data(), _indices.size(), &_vertices[0].Position.x, _vertices.size(), sizeof(VertType));
+		_vertices.resize(MeshOptimizer::OptimizeVertexFetch(_vertices.data(), _vertices.size(), sizeof(VertType), _indices.data(), _indices.size()));
+		result.After = MeshOptimizer::AnalyzeVertexCache(_indices.data(), _indices.size(), _vertices.size());
+		return result;
+	}
+
+	/// <summary>
+	/// Builds simplified versions of this mesh that share its vertices, see MeshSimplifier. Should be called
+	/// after Optimize, which reorders the vertices
+	/// </summary>
+	/// <param name="levelCount">The most levels to build after the full detail mesh</param>
+	/// <returns>The levels that were built, which may be fewer than requested for small meshes</returns>
+	const std::vector<MeshLod>& GenerateLods(uint32_t levelCount = MeshSimplifier::MAX_LODS) {
+		_lods.clear();
+		if (_indices.size() >= 3) {
+			_lods = MeshSimplifier::GenerateLods(_indices.data(), _indices.size(),
+				&_vertices[0].Position.x, &_vertices[0].UV.x, &_vertices[0].Normal.x, _vertices.size(), sizeof(VertType), levelCount);
+		}
+		return _lods;
+	}
+	/// <summary>
+	/// Adds an already built level of detail, whose indices refer to this mesh's vertices
+	/// </summary>
+	void AddLod(const MeshLod& lod) {
+		_lods.push_back(lod);
+	}
+	/// <summary>
+	/// Gets the levels of detail for this mesh, from the most to the least detailed, not including the mesh itself
+	/// </summary>
+	const std::vector<MeshLod>& GetLods() const { return _lods; }
+
+	/// <summary>
+	/// Uploads this mesh into a VAO
+	/// </summary>
+	/// <param name="target">An existing, empty VAO to attach the buffers to, or nullptr to create a new one</param>
+	/// <param name="optimize">True to run Optimize before uploading</param>
+	VertexArrayObject::sptr Bake(VertexArrayObject::sptr target = nullptr, bool optimize = false) {
+		if (optimize) {
+			Optimize();
+		}
+		return Bake(GetVertexDataPtr(), _vertices.size(), GetIndexDataPtr(), _indices.size(), target);
+	}
+
+	/// <summary>
+	/// Creates a VAO from already built vertex and index data, for when the data lives somewhere
+	/// other than a mesh builder (ex: a memory mapped cache file)
+	/// </summary>
+	/// <param name="vertices">A pointer to the first vertex</param>
+	/// <param name="vertexCount">The number of vertices to upload</param>
+	/// <param name="indices">A pointer to the first index</param>
+	/// <param name="indexCount">The number of indices to upload</param>
+	/// <param name="target">An existing, empty VAO to attach the buffers to, or nullptr to create a new one</param>
+	static VertexArrayObject::sptr Bake(const VertType* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, VertexArrayObject::sptr target = nullptr) {
+		VertexArrayObject::sptr result = target != nullptr ? target : VertexArrayObject::Create();
+
+		// Indexed meshes go into the shared pool for their vertex format, so that they can be multi drawn
+		if (GeometryPool::IsEnabled() && vertexCount > 0 && indexCount > 0) {
+			GeometryPool::sptr pool = GeometryPool::Get(VertType::V_DECL, GeometryPool::GetIndexType(vertexCount));
+			result->SetPoolGeometry(pool, pool->AllocateVertices(vertices, (uint32_t)vertexCount), pool->AllocateIndices(indices, (uint32_t)indexCount));
+		} else {
+			VertexBuffer::sptr vbo = VertexBuffer::Create();
+			vbo->LoadData(vertices, vertexCount);
 
-		IndexBuffer::sptr ebo = IndexBuffer::Create();
-		ebo->LoadData(GetIndexDataPtr(), _indices.size());
+			IndexBuffer::sptr ebo = IndexBuffer::Create();
+			ebo->LoadIndices(indices, indexCount, vertexCount);
 
-		VertexArrayObject::sptr result = VertexArrayObject::Create();
-		result->AddVertexBuffer(vbo, VertType::V_DECL);
-		result->SetIndexBuffer(ebo);
+			result->AddVertexBuffer(vbo, VertType::V_DECL);
+			result->SetIndexBuffer(ebo);
+		}
+		if (vertexCount > 0) {
+			result->SetBounds(MeshBounds::FromPositions(&vertices[0].Position, vertexCount, sizeof(VertType)));
+		}
 
 		return result;
 	}
@@ -112,7 +224,9 @@ public:
 	
 protected:
 	friend class MeshFactory;
+	friend class ObjLoader;
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
+	std::vector<MeshLod>  _lods;
 };
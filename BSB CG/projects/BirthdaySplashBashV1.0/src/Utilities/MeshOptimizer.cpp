@@ -0,0 +1,280 @@
+#include "MeshOptimizer.h"
+
+#include <vector>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <GLM/glm.hpp>
+
+namespace
+{
+	/// <summary>
+	/// A FIFO cache simulation, a vertex is in the cache if fewer than cacheSize misses happened since it was added
+	/// </summary>
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount, uint32_t cacheSize) :
+			_stamps(vertexCount, 0), _time(cacheSize + 1), _size(cacheSize) {}
+
+		/// <summary>
+		/// Looks up a vertex, returns 1 if it was a miss
+		/// </summary>
+		uint32_t Touch(uint32_t vertex) {
+			if (_time - _stamps[vertex] > _size) {
+				_stamps[vertex] = _time++;
+				return 1;
+			}
+			return 0;
+		}
+		uint32_t TouchTriangle(const uint32_t* triangle) {
+			return Touch(triangle[0]) + Touch(triangle[1]) + Touch(triangle[2]);
+		}
+		/// <summary>
+		/// Empties the cache, without touching every vertex
+		/// </summary>
+		void Flush() {
+			_time += _size + 1;
+		}
+
+	private:
+		std::vector<uint32_t> _stamps;
+		uint32_t _time;
+		uint32_t _size;
+	};
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+	VertexCacheStats result;
+	if (indexCount < 3) {
+		return result;
+	}
+
+	FifoCache cache(vertexCount, cacheSize);
+	std::vector<bool> seen(vertexCount, false);
+	size_t misses = 0, unique = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		misses += cache.Touch(indices[ix]);
+		if (!seen[indices[ix]]) {
+			seen[indices[ix]] = true;
+			unique++;
+		}
+	}
+	result.ACMR = (float)misses / (float)(indexCount / 3);
+	result.ATVR = (float)misses / (float)unique;
+	return result;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0) {
+		return;
+	}
+
+	// Build the vertex -> triangle adjacency, live counts how many triangles using each vertex are left to emit
+	std::vector<uint32_t> live(vertexCount, 0);
+	for (size_t ix = 0; ix < triangleCount * 3; ix++) {
+		live[indices[ix]]++;
+	}
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		offsets[ix + 1] = offsets[ix] + live[ix];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t ix = 0; ix < triangleCount * 3; ix++) {
+			adjacency[fill[indices[ix]]++] = (uint32_t)(ix / 3);
+		}
+	}
+
+	std::vector<uint32_t> stamps(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	deadEnds.reserve(indexCount);
+	output.reserve(triangleCount * 3);
+	uint32_t time = cacheSize + 1;
+	size_t cursor = 0;
+
+	// Finds a vertex that still has triangles, first from the recently used vertices then by scanning the mesh
+	auto skipDeadEnd = [&]() -> int64_t {
+		while (!deadEnds.empty()) {
+			const uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (live[vertex] > 0) {
+				return vertex;
+			}
+		}
+		for (; cursor < vertexCount; cursor++) {
+			if (live[cursor] > 0) {
+				return (int64_t)cursor;
+			}
+		}
+		return -1;
+	};
+
+	int64_t fan = skipDeadEnd();
+	while (fan >= 0) {
+		// Emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (uint32_t it = offsets[fan]; it < offsets[fan + 1]; it++) {
+			const uint32_t triangle = adjacency[it];
+			if (emitted[triangle]) {
+				continue;
+			}
+			emitted[triangle] = true;
+			for (int corner = 0; corner < 3; corner++) {
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				live[vertex]--;
+				if (time - stamps[vertex] > cacheSize) {
+					stamps[vertex] = time++;
+				}
+			}
+		}
+
+		// Pick the candidate that will still be in the cache once all of its triangles are emitted, preferring the
+		// oldest one since it is the closest to being evicted
+		int64_t best = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t vertex : candidates) {
+			if (live[vertex] == 0) {
+				continue;
+			}
+			int64_t priority = 0;
+			if (time - stamps[vertex] + 2 * live[vertex] <= cacheSize) {
+				priority = time - stamps[vertex];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = vertex;
+			}
+		}
+		fan = best >= 0 ? best : skipDeadEnd();
+	}
+
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+std::vector<uint32_t> MeshOptimizer::_FindClusters(const uint32_t* indices, size_t indexCount, size_t vertexCount, float threshold, uint32_t cacheSize) {
+	const size_t triangleCount = indexCount / 3;
+	FifoCache cache(vertexCount, cacheSize);
+
+	// Hard boundaries, a triangle that misses on all 3 vertices is almost always the start of a new patch
+	std::vector<uint32_t> hard;
+	for (size_t tri = 0; tri < triangleCount; tri++) {
+		if (cache.TouchTriangle(indices + tri * 3) == 3 || tri == 0) {
+			hard.push_back((uint32_t)tri);
+		}
+	}
+	hard.push_back((uint32_t)triangleCount);
+
+	// Soft boundaries, we split a cluster as soon as its own ACMR (starting from a cold cache) is within the
+	// threshold of what the whole cluster gets, since a split there barely costs anything
+	std::vector<uint32_t> result;
+	for (size_t it = 0; it + 1 < hard.size(); it++) {
+		const uint32_t start = hard[it];
+		const uint32_t end = hard[it + 1];
+
+		cache.Flush();
+		uint32_t clusterMisses = 0;
+		for (uint32_t tri = start; tri < end; tri++) {
+			clusterMisses += cache.TouchTriangle(indices + tri * 3);
+		}
+		const float target = threshold * (float)clusterMisses / (float)(end - start);
+
+		result.push_back(start);
+		cache.Flush();
+		uint32_t misses = 0, count = 0;
+		for (uint32_t tri = start; tri < end; tri++) {
+			misses += cache.TouchTriangle(indices + tri * 3);
+			count++;
+			if ((float)misses / (float)count <= target && tri + 1 < end) {
+				result.push_back(tri + 1);
+				cache.Flush();
+				misses = count = 0;
+			}
+		}
+	}
+	return result;
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+	std::vector<uint32_t> clusters = _FindClusters(indices, indexCount, vertexCount, threshold, CACHE_SIZE);
+	if (clusters.size() < 2) {
+		return;
+	}
+	auto position = [&](uint32_t vertex) {
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+		return glm::vec3(p[0], p[1], p[2]);
+	};
+
+	// The area weighted centroid and normal of each cluster, and the centroid of the whole mesh
+	std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0.0f));
+	glm::vec3 meshCentroid = glm::vec3(0.0f);
+	float meshArea = 0.0f;
+	for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+		const size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+		float clusterArea = 0.0f;
+		for (size_t tri = clusters[cluster]; tri < end; tri++) {
+			const glm::vec3 a = position(indices[tri * 3 + 0]);
+			const glm::vec3 b = position(indices[tri * 3 + 1]);
+			const glm::vec3 c = position(indices[tri * 3 + 2]);
+			const glm::vec3 cross = glm::cross(b - a, c - a);
+			const float area = glm::length(cross);
+			centroids[cluster] += (a + b + c) * (area / 3.0f);
+			normals[cluster] += cross;
+			clusterArea += area;
+		}
+		meshCentroid += centroids[cluster];
+		meshArea += clusterArea;
+		centroids[cluster] = clusterArea > 0.0f ? centroids[cluster] / clusterArea : position(indices[clusters[cluster] * 3]);
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+	// Clusters that face away from the middle of the mesh are the most likely to cover the rest of it
+	std::vector<float> occlusion(clusters.size());
+	for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+		const float length = glm::length(normals[cluster]);
+		occlusion[cluster] = length > 0.0f ? glm::dot(centroids[cluster] - meshCentroid, normals[cluster] / length) : 0.0f;
+	}
+	std::vector<uint32_t> order(clusters.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return occlusion[a] > occlusion[b]; });
+
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	for (uint32_t cluster : order) {
+		const size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangleCount;
+		output.insert(output.end(), indices + clusters[cluster] * 3, indices + end * 3);
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount) {
+	constexpr uint32_t UNUSED = ~0u;
+	std::vector<uint32_t> remap(vertexCount, UNUSED);
+	std::vector<uint8_t> reordered(vertexCount * vertexSize);
+	const uint8_t* source = static_cast<const uint8_t*>(vertices);
+
+	uint32_t next = 0;
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		uint32_t& target = remap[indices[ix]];
+		if (target == UNUSED) {
+			target = next++;
+			memcpy(reordered.data() + (size_t)target * vertexSize, source + (size_t)indices[ix] * vertexSize, vertexSize);
+		}
+		indices[ix] = target;
+	}
+	memcpy(vertices, reordered.data(), (size_t)next * vertexSize);
+	return next;
+}
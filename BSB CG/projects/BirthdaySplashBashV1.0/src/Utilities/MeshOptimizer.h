@@ -0,0 +1,95 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/// <summary>
+/// Post-transform vertex cache statistics for an index buffer
+/// </summary>
+struct VertexCacheStats
+{
+	/// <summary>
+	/// Average cache miss ratio, the number of vertices transformed per triangle (0.5 is the best case for a
+	/// large regular grid, 3 means no reuse at all)
+	/// </summary>
+	float ACMR = 0.0f;
+	/// <summary>
+	/// Average transform to vertex ratio, the number of vertices transformed per unique vertex (1 is perfect)
+	/// </summary>
+	float ATVR = 0.0f;
+};
+
+/// <summary>
+/// Reorders index and vertex buffers so that meshes are cheaper for the GPU to draw. The passes are meant to
+/// be run in order: OptimizeVertexCache, then OptimizeOverdraw, then OptimizeVertexFetch. MeshBuilder::Optimize
+/// does all three.
+///
+/// The vertex cache pass is Tipsify, from "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+/// (Sander, Nehab and Barczak 2007), which runs in linear time and does not depend on the exact cache size
+/// </summary>
+class MeshOptimizer
+{
+public:
+	/// <summary>
+	/// The cache size that we optimize for and report statistics with. Modern GPUs don't have a simple FIFO
+	/// cache anymore, but they still reward the same locality
+	/// </summary>
+	static constexpr uint32_t CACHE_SIZE = 16;
+	/// <summary>
+	/// How much the overdraw pass is allowed to raise the ACMR, as a multiple of the ACMR after the cache pass
+	/// </summary>
+	static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+	/// <summary>
+	/// Simulates a FIFO vertex cache over a triangle list
+	/// </summary>
+	/// <param name="indices">The triangle list to analyze</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	/// <param name="cacheSize">The number of entries in the simulated cache</param>
+	static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+	/// <summary>
+	/// Reorders the triangles for post-transform cache locality
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder, in place</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="vertexCount">The number of vertices the indices refer to</param>
+	/// <param name="cacheSize">The cache size to optimize for</param>
+	static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+	/// <summary>
+	/// Splits a cache optimized triangle list into clusters, and reorders them so that the parts of the mesh that
+	/// are most likely to occlude the rest are drawn first. A cluster starts wherever the cache order already jumps
+	/// to a new patch of the mesh, and wherever a split costs less than the threshold
+	/// </summary>
+	/// <param name="indices">The triangle list to reorder, in place</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="positions">A pointer to the position of the first vertex (3 floats)</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="positionStride">The number of bytes between each vertex's position</param>
+	/// <param name="threshold">How much the ACMR may increase, see OVERDRAW_THRESHOLD</param>
+	static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+		float threshold = OVERDRAW_THRESHOLD);
+
+	/// <summary>
+	/// Reorders the vertices into the order that they are first used by the index buffer, so that vertex fetches
+	/// walk through memory linearly. Vertices that are never referenced are dropped
+	/// </summary>
+	/// <param name="vertices">The vertex data, reordered in place</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="vertexSize">The size of a single vertex in bytes</param>
+	/// <param name="indices">The index buffer, remapped in place</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <returns>The new number of vertices</returns>
+	static size_t OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices, size_t indexCount);
+
+protected:
+	MeshOptimizer() = default;
+	~MeshOptimizer() = default;
+
+	/// <summary>
+	/// Finds the first triangle of each cluster for the overdraw pass
+	/// </summary>
+	static std::vector<uint32_t> _FindClusters(const uint32_t* indices, size_t indexCount, size_t vertexCount, float threshold, uint32_t cacheSize);
+};
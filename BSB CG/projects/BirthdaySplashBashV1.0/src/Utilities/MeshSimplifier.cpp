@@ -0,0 +1,567 @@
+#include "MeshSimplifier.h"
+
+#include <cmath>
+#include <cfloat>
+#include <numeric>
+#include <algorithm>
+#include <GLM/glm.hpp>
+
+#include "Utilities/MeshOptimizer.h"
+
+namespace
+{
+	// Border edges have no neighbour to hold them in place, so their quadrics get a heavier weight
+	constexpr double BORDER_WEIGHT = 10.0;
+	// A pass stops once collapses get this much more expensive than the one that would have met its goal, so
+	// that cheap areas don't get simplified all the way before expensive ones are even looked at
+	constexpr float PASS_ERROR_SLACK = 1.5f;
+
+	/// <summary>
+	/// The sum of squared distances to a set of planes, stored as the upper triangle of a symmetric 4x4 matrix.
+	/// Weight is the total area of the planes, so that Error gives the average rather than the sum
+	/// </summary>
+	struct Quadric
+	{
+		double A00 = 0.0, A01 = 0.0, A02 = 0.0, A11 = 0.0, A12 = 0.0, A22 = 0.0;
+		double B0 = 0.0, B1 = 0.0, B2 = 0.0, C = 0.0;
+		double Weight = 0.0;
+
+		static Quadric FromPlane(const glm::dvec3& normal, double distance, double weight) {
+			Quadric result;
+			result.A00 = normal.x * normal.x * weight;
+			result.A01 = normal.x * normal.y * weight;
+			result.A02 = normal.x * normal.z * weight;
+			result.A11 = normal.y * normal.y * weight;
+			result.A12 = normal.y * normal.z * weight;
+			result.A22 = normal.z * normal.z * weight;
+			result.B0  = normal.x * distance * weight;
+			result.B1  = normal.y * distance * weight;
+			result.B2  = normal.z * distance * weight;
+			result.C   = distance * distance * weight;
+			result.Weight = weight;
+			return result;
+		}
+
+		Quadric& operator +=(const Quadric& other) {
+			A00 += other.A00; A01 += other.A01; A02 += other.A02;
+			A11 += other.A11; A12 += other.A12; A22 += other.A22;
+			B0 += other.B0; B1 += other.B1; B2 += other.B2;
+			C += other.C;
+			Weight += other.Weight;
+			return *this;
+		}
+		Quadric operator +(const Quadric& other) const {
+			Quadric result = *this;
+			return result += other;
+		}
+
+		/// <summary>
+		/// Gets the average squared distance from the point to the planes
+		/// </summary>
+		float Error(const glm::vec3& point) const {
+			const double x = point.x, y = point.y, z = point.z;
+			const double result =
+				A00 * x * x + A11 * y * y + A22 * z * z +
+				2.0 * (A01 * x * y + A02 * x * z + A12 * y * z) +
+				2.0 * (B0 * x + B1 * y + B2 * z) + C;
+			return Weight > 0.0 ? (float)(std::abs(result) / Weight) : 0.0f;
+		}
+	};
+
+	inline uint64_t EdgeKey(uint32_t a, uint32_t b) {
+		return ((uint64_t)a << 32) | b;
+	}
+
+	/// <summary>
+	/// The working state for a single call to MeshSimplifier::Simplify. Vertices that share a position are merged
+	/// into a "group", the topology and error are tracked per group, and the triangles keep pointing at the
+	/// original vertices ("wedges") so that their normals and UVs survive
+	/// </summary>
+	class Simplifier
+	{
+	public:
+		Simplifier(const uint32_t* indices, size_t indexCount, const float* positions, const float* texCoords, const float* normals,
+			size_t vertexCount, size_t vertexStride) :
+			_corners(indices, indices + (indexCount / 3) * 3),
+			_texCoords(texCoords), _normals(normals), _vertexStride(vertexStride)
+		{
+			_BuildGroups(positions, vertexCount);
+			_BuildQuadrics();
+		}
+
+		/// <summary>
+		/// Collapses edges until the triangle count reaches the target, or the next collapse would cost more
+		/// than maxError (a squared distance in normalized space)
+		/// </summary>
+		void Run(size_t targetTriangles, float maxError) {
+			while (_liveTriangles > targetTriangles) {
+				if (_RunPass(targetTriangles, maxError) == 0) {
+					break;
+				}
+			}
+		}
+
+		size_t WriteIndices(uint32_t* destination) const {
+			size_t count = 0;
+			for (size_t tri = 0; tri < _alive.size(); tri++) {
+				if (_alive[tri]) {
+					destination[count++] = _corners[tri * 3 + 0];
+					destination[count++] = _corners[tri * 3 + 1];
+					destination[count++] = _corners[tri * 3 + 2];
+				}
+			}
+			return count;
+		}
+
+		/// <summary>
+		/// Gets the largest error of any collapse, as a distance in model units
+		/// </summary>
+		float GetError() const { return std::sqrt(_worstError) / _scale; }
+
+	private:
+		struct Collapse {
+			float    Cost;
+			uint32_t From;
+			uint32_t To;
+		};
+
+		std::vector<uint32_t>  _corners;       // The wedge used by each corner of each triangle
+		std::vector<uint8_t>   _alive;
+		size_t                 _liveTriangles = 0;
+
+		std::vector<uint32_t>  _groupOf;       // Vertex -> group
+		std::vector<uint32_t>  _groupStart;    // Group -> first entry in _groupVerts
+		std::vector<uint32_t>  _groupVerts;    // The wedges of each group, back to back
+		std::vector<glm::vec3> _positions;     // Group -> position, normalized so the mesh fits in a unit cube
+		std::vector<Quadric>   _quadrics;
+		std::vector<uint8_t>   _border;
+		std::vector<uint8_t>   _locked;
+		std::vector<uint64_t>  _borderEdges;   // Sorted, always stored with the smaller group first, rebuilt each pass
+		float                  _scale = 1.0f;
+		float                  _worstError = 0.0f;
+
+		// Group -> live triangles, rebuilt at the start of each pass
+		std::vector<uint32_t>  _adjacencyStart;
+		std::vector<uint32_t>  _adjacency;
+		// Scratch for the link condition
+		std::vector<uint32_t>  _marks;
+		uint32_t               _markStamp = 0;
+
+		const float* _texCoords;
+		const float* _normals;
+		size_t       _vertexStride;
+
+		const float* _Attribute(const float* base, uint32_t vertex) const {
+			return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(base) + vertex * _vertexStride);
+		}
+		glm::vec2 _TexCoord(uint32_t vertex) const {
+			if (_texCoords == nullptr) return glm::vec2(0.0f);
+			const float* uv = _Attribute(_texCoords, vertex);
+			return glm::vec2(uv[0], uv[1]);
+		}
+		glm::vec3 _Normal(uint32_t vertex) const {
+			if (_normals == nullptr) return glm::vec3(0.0f);
+			const float* n = _Attribute(_normals, vertex);
+			return glm::vec3(n[0], n[1], n[2]);
+		}
+		uint32_t _Group(size_t tri, int corner) const { return _groupOf[_corners[tri * 3 + corner]]; }
+		bool _Contains(size_t tri, uint32_t group) const {
+			return _Group(tri, 0) == group || _Group(tri, 1) == group || _Group(tri, 2) == group;
+		}
+		int _CornerOf(size_t tri, uint32_t group) const {
+			return _Group(tri, 0) == group ? 0 : (_Group(tri, 1) == group ? 1 : 2);
+		}
+		bool _IsBorderEdge(uint32_t a, uint32_t b) const {
+			return std::binary_search(_borderEdges.begin(), _borderEdges.end(), EdgeKey(std::min(a, b), std::max(a, b)));
+		}
+
+		void _BuildGroups(const float* positions, size_t vertexCount) {
+			std::vector<glm::vec3> source(vertexCount);
+			for (size_t ix = 0; ix < vertexCount; ix++) {
+				const float* p = _Attribute(positions, (uint32_t)ix);
+				source[ix] = glm::vec3(p[0], p[1], p[2]);
+			}
+
+			// Sorting puts vertices with the same position next to each other
+			_groupVerts.resize(vertexCount);
+			std::iota(_groupVerts.begin(), _groupVerts.end(), 0u);
+			std::sort(_groupVerts.begin(), _groupVerts.end(), [&](uint32_t l, uint32_t r) {
+				const glm::vec3& a = source[l];
+				const glm::vec3& b = source[r];
+				if (a.x != b.x) return a.x < b.x;
+				if (a.y != b.y) return a.y < b.y;
+				if (a.z != b.z) return a.z < b.z;
+				return l < r;
+			});
+			_groupOf.resize(vertexCount);
+			for (size_t ix = 0; ix < vertexCount; ix++) {
+				if (ix == 0 || source[_groupVerts[ix]] != source[_groupVerts[ix - 1]]) {
+					_groupStart.push_back((uint32_t)ix);
+				}
+				_groupOf[_groupVerts[ix]] = (uint32_t)_groupStart.size() - 1;
+			}
+			_groupStart.push_back((uint32_t)vertexCount);
+			const size_t groupCount = _groupStart.size() - 1;
+
+			// Errors are measured in a unit cube, so the error limits mean the same thing for every mesh
+			glm::vec3 boundsMin = glm::vec3(FLT_MAX), boundsMax = glm::vec3(-FLT_MAX);
+			for (const glm::vec3& p : source) {
+				boundsMin = glm::min(boundsMin, p);
+				boundsMax = glm::max(boundsMax, p);
+			}
+			const float extent = vertexCount > 0 ? glm::max(glm::max(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y), boundsMax.z - boundsMin.z) : 0.0f;
+			_scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+			_positions.resize(groupCount);
+			for (size_t group = 0; group < groupCount; group++) {
+				_positions[group] = (source[_groupVerts[_groupStart[group]]] - boundsMin) * _scale;
+			}
+
+			_quadrics.resize(groupCount);
+			_border.assign(groupCount, 0);
+			_locked.assign(groupCount, 0);
+			_marks.assign(groupCount, 0);
+		}
+
+		void _BuildQuadrics() {
+			const size_t triangleCount = _corners.size() / 3;
+			_alive.assign(triangleCount, 1);
+			_liveTriangles = triangleCount;
+
+			std::vector<uint64_t> halfEdges;
+			halfEdges.reserve(triangleCount * 3);
+			for (size_t tri = 0; tri < triangleCount; tri++) {
+				const uint32_t g[3] = { _Group(tri, 0), _Group(tri, 1), _Group(tri, 2) };
+				// Triangles that are already degenerate once welded have nothing to contribute
+				if (g[0] == g[1] || g[1] == g[2] || g[0] == g[2]) {
+					_alive[tri] = 0;
+					_liveTriangles--;
+					continue;
+				}
+				const glm::dvec3 p0 = _positions[g[0]], p1 = _positions[g[1]], p2 = _positions[g[2]];
+				const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const double length = glm::length(normal);
+				if (length > 0.0) {
+					const glm::dvec3 unit = normal / length;
+					const Quadric plane = Quadric::FromPlane(unit, -glm::dot(unit, p0), length * 0.5);
+					for (int corner = 0; corner < 3; corner++) {
+						_quadrics[g[corner]] += plane;
+					}
+				}
+				for (int corner = 0; corner < 3; corner++) {
+					halfEdges.push_back(EdgeKey(g[corner], g[(corner + 1) % 3]));
+				}
+			}
+			std::sort(halfEdges.begin(), halfEdges.end());
+
+			for (size_t tri = 0; tri < triangleCount; tri++) {
+				if (!_alive[tri]) continue;
+				for (int corner = 0; corner < 3; corner++) {
+					const uint32_t a = _Group(tri, corner), b = _Group(tri, (corner + 1) % 3);
+					const auto same     = std::equal_range(halfEdges.begin(), halfEdges.end(), EdgeKey(a, b));
+					const auto opposite = std::equal_range(halfEdges.begin(), halfEdges.end(), EdgeKey(b, a));
+					// Edges shared by more than two triangles, or by two triangles facing opposite ways, can't
+					// be collapsed without tearing the surface, so we leave them alone
+					if (same.second - same.first > 1 || opposite.second - opposite.first > 1) {
+						_locked[a] = _locked[b] = 1;
+					} else if (opposite.first == opposite.second) {
+						_AddBorderEdge(tri, a, b);
+					}
+				}
+			}
+			std::sort(_borderEdges.begin(), _borderEdges.end());
+		}
+
+		/// <summary>
+		/// Adds a plane through the border edge that is perpendicular to its triangle, so moving the border
+		/// away from where it was costs as much as moving the surface would
+		/// </summary>
+		void _AddBorderEdge(size_t tri, uint32_t a, uint32_t b) {
+			_border[a] = _border[b] = 1;
+			_borderEdges.push_back(EdgeKey(std::min(a, b), std::max(a, b)));
+
+			const glm::dvec3 p0 = _positions[_Group(tri, 0)], p1 = _positions[_Group(tri, 1)], p2 = _positions[_Group(tri, 2)];
+			const glm::dvec3 edge = glm::dvec3(_positions[b]) - glm::dvec3(_positions[a]);
+			const glm::dvec3 perpendicular = glm::cross(edge, glm::cross(p1 - p0, p2 - p0));
+			const double length = glm::length(perpendicular);
+			if (length > 0.0) {
+				const glm::dvec3 unit = perpendicular / length;
+				const Quadric plane = Quadric::FromPlane(unit, -glm::dot(unit, glm::dvec3(_positions[a])), glm::dot(edge, edge) * BORDER_WEIGHT);
+				_quadrics[a] += plane;
+				_quadrics[b] += plane;
+			}
+		}
+
+		void _BuildAdjacency() {
+			const size_t groupCount = _positions.size();
+			_adjacencyStart.assign(groupCount + 1, 0);
+			for (size_t tri = 0; tri < _alive.size(); tri++) {
+				if (!_alive[tri]) continue;
+				for (int corner = 0; corner < 3; corner++) {
+					_adjacencyStart[_Group(tri, corner) + 1]++;
+				}
+			}
+			for (size_t group = 0; group < groupCount; group++) {
+				_adjacencyStart[group + 1] += _adjacencyStart[group];
+			}
+			_adjacency.resize(_adjacencyStart[groupCount]);
+			std::vector<uint32_t> fill(_adjacencyStart.begin(), _adjacencyStart.end() - 1);
+			for (size_t tri = 0; tri < _alive.size(); tri++) {
+				if (!_alive[tri]) continue;
+				for (int corner = 0; corner < 3; corner++) {
+					_adjacency[fill[_Group(tri, corner)]++] = (uint32_t)tri;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Finds the wedge that a corner using the given wedge of from should use once from has been collapsed
+		/// onto to. The triangles along the edge tell us which UVs at to continue the UVs at from, and of the
+		/// wedges with that UV we keep the one with the closest normal. Returns false if the wedge's UVs don't
+		/// reach the edge, meaning the collapse would move a UV seam
+		/// </summary>
+		bool _FindWedge(uint32_t wedge, uint32_t from, uint32_t to, const uint32_t* edgeTris, size_t edgeCount, uint32_t& result) const {
+			const glm::vec2 uv = _TexCoord(wedge);
+			for (size_t ix = 0; ix < edgeCount; ix++) {
+				const size_t tri = edgeTris[ix];
+				if (_TexCoord(_corners[tri * 3 + _CornerOf(tri, from)]) != uv) continue;
+
+				const glm::vec2 target = _TexCoord(_corners[tri * 3 + _CornerOf(tri, to)]);
+				const glm::vec3 normal = _Normal(wedge);
+				float bestDot = -FLT_MAX;
+				for (uint32_t jx = _groupStart[to]; jx < _groupStart[to + 1]; jx++) {
+					const uint32_t candidate = _groupVerts[jx];
+					if (_TexCoord(candidate) != target) continue;
+					const float dot = glm::dot(normal, _Normal(candidate));
+					if (dot > bestDot) {
+						bestDot = dot;
+						result = candidate;
+					}
+				}
+				return true;
+			}
+			return false;
+		}
+
+		/// <summary>
+		/// Gathers the live triangles around from that also use to
+		/// </summary>
+		size_t _FindEdgeTriangles(uint32_t from, uint32_t to, uint32_t* result, size_t capacity) const {
+			size_t count = 0;
+			for (uint32_t ix = _adjacencyStart[from]; ix < _adjacencyStart[from + 1] && count < capacity; ix++) {
+				const uint32_t tri = _adjacency[ix];
+				if (_alive[tri] && _Contains(tri, to)) {
+					result[count++] = tri;
+				}
+			}
+			return count;
+		}
+
+		/// <summary>
+		/// Checks that collapsing from onto to keeps the mesh manifold, doesn't flip any triangles and doesn't
+		/// move a UV seam
+		/// </summary>
+		bool _CanCollapse(uint32_t from, uint32_t to) {
+			if (_locked[from] || (_border[from] && !_IsBorderEdge(from, to))) {
+				return false;
+			}
+			uint32_t edgeTris[2];
+			const size_t edgeCount = _FindEdgeTriangles(from, to, edgeTris, 2);
+			if (edgeCount == 0) {
+				return false;
+			}
+
+			// The link condition: the only neighbours that from and to may share are the ones across the edge,
+			// otherwise the collapse would pinch the surface into a non-manifold fin
+			_markStamp++;
+			for (uint32_t ix = _adjacencyStart[from]; ix < _adjacencyStart[from + 1]; ix++) {
+				const uint32_t tri = _adjacency[ix];
+				if (!_alive[tri]) continue;
+				for (int corner = 0; corner < 3; corner++) {
+					_marks[_Group(tri, corner)] = _markStamp;
+				}
+			}
+			_markStamp++;
+			size_t shared = 0;
+			for (uint32_t ix = _adjacencyStart[to]; ix < _adjacencyStart[to + 1]; ix++) {
+				const uint32_t tri = _adjacency[ix];
+				if (!_alive[tri]) continue;
+				for (int corner = 0; corner < 3; corner++) {
+					const uint32_t group = _Group(tri, corner);
+					if (group != from && group != to && _marks[group] == _markStamp - 1) {
+						_marks[group] = _markStamp;
+						shared++;
+					}
+				}
+			}
+			if (shared > edgeCount) {
+				return false;
+			}
+
+			const glm::vec3 target = _positions[to];
+			for (uint32_t ix = _adjacencyStart[from]; ix < _adjacencyStart[from + 1]; ix++) {
+				const uint32_t tri = _adjacency[ix];
+				if (!_alive[tri] || _Contains(tri, to)) continue;
+
+				const int corner = _CornerOf(tri, from);
+				uint32_t wedge;
+				if (!_FindWedge(_corners[tri * 3 + corner], from, to, edgeTris, edgeCount, wedge)) {
+					return false;
+				}
+
+				const glm::vec3 p0 = _positions[_Group(tri, (corner + 1) % 3)];
+				const glm::vec3 p1 = _positions[_Group(tri, (corner + 2) % 3)];
+				const glm::vec3 before = glm::cross(p0 - _positions[from], p1 - _positions[from]);
+				const glm::vec3 after  = glm::cross(p0 - target, p1 - target);
+				if (glm::dot(before, after) <= 0.0f) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void _Collapse(uint32_t from, uint32_t to) {
+			uint32_t edgeTris[2];
+			const size_t edgeCount = _FindEdgeTriangles(from, to, edgeTris, 2);
+			for (uint32_t ix = _adjacencyStart[from]; ix < _adjacencyStart[from + 1]; ix++) {
+				const uint32_t tri = _adjacency[ix];
+				if (!_alive[tri] || _Contains(tri, to)) continue;
+				const int corner = _CornerOf(tri, from);
+				_FindWedge(_corners[tri * 3 + corner], from, to, edgeTris, edgeCount, _corners[tri * 3 + corner]);
+			}
+			for (size_t ix = 0; ix < edgeCount; ix++) {
+				_alive[edgeTris[ix]] = 0;
+				_liveTriangles--;
+			}
+			_quadrics[to] += _quadrics[from];
+		}
+
+		/// <summary>
+		/// Collapses the cheapest edges that don't touch each other, returns the number of collapses
+		/// </summary>
+		size_t _RunPass(size_t targetTriangles, float maxError) {
+			_BuildAdjacency();
+
+			std::vector<uint64_t> edges;
+			edges.reserve(_liveTriangles * 3);
+			for (size_t tri = 0; tri < _alive.size(); tri++) {
+				if (!_alive[tri]) continue;
+				for (int corner = 0; corner < 3; corner++) {
+					const uint32_t a = _Group(tri, corner), b = _Group(tri, (corner + 1) % 3);
+					edges.push_back(EdgeKey(std::min(a, b), std::max(a, b)));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+
+			// Collapses along a border move it, so the border is found again from the edges that only have one triangle
+			std::fill(_border.begin(), _border.end(), 0);
+			_borderEdges.clear();
+			for (size_t ix = 0; ix < edges.size(); ix++) {
+				const bool single = (ix == 0 || edges[ix - 1] != edges[ix]) && (ix + 1 == edges.size() || edges[ix + 1] != edges[ix]);
+				if (single) {
+					_border[(uint32_t)(edges[ix] >> 32)] = _border[(uint32_t)edges[ix]] = 1;
+					_borderEdges.push_back(edges[ix]);
+				}
+			}
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+			// Each edge can be collapsed in either direction, we only keep the cheaper one
+			std::vector<Collapse> collapses;
+			collapses.reserve(edges.size());
+			for (uint64_t edge : edges) {
+				const uint32_t a = (uint32_t)(edge >> 32), b = (uint32_t)edge;
+				const Quadric combined = _quadrics[a] + _quadrics[b];
+				Collapse best = { FLT_MAX, 0, 0 };
+				if (_CanCollapse(a, b)) {
+					best = { combined.Error(_positions[b]), a, b };
+				}
+				if (_CanCollapse(b, a)) {
+					const float cost = combined.Error(_positions[a]);
+					if (cost < best.Cost) {
+						best = { cost, b, a };
+					}
+				}
+				if (best.Cost <= maxError) {
+					collapses.push_back(best);
+				}
+			}
+			if (collapses.empty()) {
+				return 0;
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.Cost < r.Cost; });
+
+			// Every collapse removes about 2 triangles
+			const size_t goal = std::max<size_t>((_liveTriangles - targetTriangles) / 2, 1);
+			const float passLimit = collapses[std::min(goal, collapses.size()) - 1].Cost * PASS_ERROR_SLACK;
+
+			std::vector<uint8_t> touched(_positions.size(), 0);
+			size_t performed = 0;
+			for (const Collapse& collapse : collapses) {
+				if (collapse.Cost > passLimit || _liveTriangles <= targetTriangles) {
+					break;
+				}
+				if (touched[collapse.From] || touched[collapse.To]) {
+					continue;
+				}
+				// Earlier collapses in this pass may have changed the neighbourhood since the cost was measured
+				if (!_CanCollapse(collapse.From, collapse.To)) {
+					continue;
+				}
+				_Collapse(collapse.From, collapse.To);
+				touched[collapse.From] = touched[collapse.To] = 1;
+				_worstError = std::max(_worstError, collapse.Cost);
+				performed++;
+			}
+			return performed;
+		}
+	};
+}
+
+size_t MeshSimplifier::Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const float* positions, const float* texCoords, const float* normals, size_t vertexCount, size_t vertexStride,
+	size_t targetIndexCount, float targetError, float* resultError)
+{
+	Simplifier simplifier(indices, indexCount, positions, texCoords, normals, vertexCount, vertexStride);
+	simplifier.Run(targetIndexCount / 3, targetError * targetError);
+	if (resultError != nullptr) {
+		*resultError = simplifier.GetError();
+	}
+	return simplifier.WriteIndices(destination);
+}
+
+std::vector<MeshLod> MeshSimplifier::GenerateLods(const uint32_t* indices, size_t indexCount,
+	const float* positions, const float* texCoords, const float* normals, size_t vertexCount, size_t vertexStride,
+	uint32_t levelCount)
+{
+	std::vector<MeshLod> result;
+	const uint32_t* source = indices;
+	size_t sourceCount = indexCount;
+	float error = 0.0f;
+
+	for (uint32_t level = 0; level < levelCount; level++) {
+		const size_t target = (size_t)(sourceCount / 3 * LOD_REDUCTION) * 3;
+		if (target / 3 < MIN_LOD_TRIANGLES) {
+			break;
+		}
+
+		MeshLod lod;
+		lod.Indices.resize(sourceCount);
+		float levelError = 0.0f;
+		const size_t count = Simplify(lod.Indices.data(), source, sourceCount, positions, texCoords, normals, vertexCount, vertexStride,
+			target, MAX_LOD_ERROR, &levelError);
+		// A level that barely removes anything costs memory without saving any work
+		if (count == 0 || count > sourceCount * 0.8f) {
+			break;
+		}
+		lod.Indices.resize(count);
+		MeshOptimizer::OptimizeVertexCache(lod.Indices.data(), count, vertexCount);
+		MeshOptimizer::OptimizeOverdraw(lod.Indices.data(), count, positions, vertexCount, vertexStride);
+
+		// Each level is simplified from the last one, so the errors add up
+		error += levelError;
+		lod.Error = error;
+		result.push_back(std::move(lod));
+		source = result.back().Indices.data();
+		sourceCount = count;
+	}
+	return result;
+}
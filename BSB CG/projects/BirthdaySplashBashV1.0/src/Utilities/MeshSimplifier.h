@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/// <summary>
+/// A simplified version of a mesh. The indices refer to the vertices of the full detail mesh, so every level
+/// of detail can share a single vertex buffer
+/// </summary>
+struct MeshLod
+{
+	std::vector<uint32_t> Indices;
+	/// <summary>
+	/// An estimate of how far the simplified surface strays from the full detail mesh, in model units
+	/// </summary>
+	float Error = 0.0f;
+};
+
+/// <summary>
+/// Builds levels of detail by collapsing edges in order of their quadric error, from "Surface Simplification
+/// Using Quadric Error Metrics" (Garland and Heckbert 1997).
+///
+/// A vertex is only ever collapsed onto one of its neighbours (a half edge collapse), so the simplified triangles
+/// reuse the existing vertices and each level only needs a new index buffer. Vertices that share a position are
+/// treated as one, so normal and UV seams don't stop the mesh from being simplified, but a collapse that would
+/// drag a UV seam across the surface is rejected. Open borders are weighted so that they keep their shape
+/// </summary>
+class MeshSimplifier
+{
+public:
+	/// <summary>
+	/// The number of levels to build after the full detail mesh
+	/// </summary>
+	static constexpr uint32_t MAX_LODS = 3;
+	/// <summary>
+	/// The fraction of triangles that each level aims to keep from the level before it
+	/// </summary>
+	static constexpr float LOD_REDUCTION = 0.5f;
+	/// <summary>
+	/// Levels with fewer triangles than this are not worth a draw of their own
+	/// </summary>
+	static constexpr size_t MIN_LOD_TRIANGLES = 256;
+	/// <summary>
+	/// The most error a single level may add, as a fraction of the mesh's largest dimension
+	/// </summary>
+	static constexpr float MAX_LOD_ERROR = 0.05f;
+
+	/// <summary>
+	/// Simplifies a triangle list until it reaches the target index count, or until the next collapse would
+	/// exceed the target error
+	/// </summary>
+	/// <param name="destination">Receives the simplified indices, must have room for indexCount indices</param>
+	/// <param name="indices">The triangle list to simplify</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="positions">A pointer to the position of the first vertex (3 floats)</param>
+	/// <param name="texCoords">A pointer to the UV of the first vertex (2 floats), or nullptr to ignore UV seams</param>
+	/// <param name="normals">A pointer to the normal of the first vertex (3 floats), or nullptr</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="vertexStride">The number of bytes between each vertex's attributes</param>
+	/// <param name="targetIndexCount">The number of indices to aim for</param>
+	/// <param name="targetError">The largest error to allow, as a fraction of the mesh's largest dimension</param>
+	/// <param name="resultError">If not nullptr, receives the error of the result in model units</param>
+	/// <returns>The number of indices written to destination</returns>
+	static size_t Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+		const float* positions, const float* texCoords, const float* normals, size_t vertexCount, size_t vertexStride,
+		size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+	/// <summary>
+	/// Builds a chain of levels of detail, each simplified from the one before it and optimized for the vertex
+	/// cache. Stops early once a level would be too small, or once the mesh can't be simplified much further
+	/// </summary>
+	/// <param name="indices">The triangle list of the full detail mesh</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="positions">A pointer to the position of the first vertex (3 floats)</param>
+	/// <param name="texCoords">A pointer to the UV of the first vertex (2 floats), or nullptr</param>
+	/// <param name="normals">A pointer to the normal of the first vertex (3 floats), or nullptr</param>
+	/// <param name="vertexCount">The number of vertices</param>
+	/// <param name="vertexStride">The number of bytes between each vertex's attributes</param>
+	/// <param name="levelCount">The most levels to build</param>
+	/// <returns>The levels, from the most to the least detailed, not including the full detail mesh</returns>
+	static std::vector<MeshLod> GenerateLods(const uint32_t* indices, size_t indexCount,
+		const float* positions, const float* texCoords, const float* normals, size_t vertexCount, size_t vertexStride,
+		uint32_t levelCount = MAX_LODS);
+
+protected:
+	MeshSimplifier() = default;
+	~MeshSimplifier() = default;
+};
@@ -1,129 +1,674 @@
 #include "ObjLoader.h"
 
 #include <string>
-#include <sstream>
-#include <fstream>
-#include <iostream>
-#include <unordered_map>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <charconv>
+#include <thread>
+#include <stdexcept>
+#include <exception>
 
-#include "StringUtils.h"
+#include "Logging.h"
+#include "MappedFile.h"
+#include "BinaryMeshLoader.h"
+
+namespace
+{
+	// We can construct a key using a bitmask of the attribute indices
+	// This let's us quickly look up a combination of attributes to see if it's already been added
+	// Note that this limits us to 2,097,151 unique attributes for positions, normals and textures
+	constexpr uint32_t MAX_ATTRIBUTE_INDEX = (1u << 21) - 1u;
+
+	inline uint64_t MakeVertexKey(uint32_t position, uint32_t uv, uint32_t normal) {
+		return (static_cast<uint64_t>(position) << 42) | (static_cast<uint64_t>(uv) << 21) | static_cast<uint64_t>(normal);
+	}
+
+	inline uint64_t HashVertexKey(uint64_t key) {
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdull;
+		key ^= key >> 33;
+		return key;
+	}
+
+	/// <summary>
+	/// An open addressing hash map from vertex keys to vertex indices. Unlike std::unordered_map this
+	/// does not allocate a node per entry, it only allocates when it needs to grow
+	/// </summary>
+	class VertexIndexMap
+	{
+	public:
+		explicit VertexIndexMap(size_t expectedCount) {
+			size_t capacity = 64;
+			while (capacity < expectedCount * 2) {
+				capacity <<= 1;
+			}
+			_slots.resize(capacity);
+			_count = 0;
+		}
+
+		/// <summary>
+		/// Finds the index for the given key, or inserts the given index if the key is new
+		/// </summary>
+		/// <returns>True if the key was inserted, false if it already existed</returns>
+		bool FindOrInsert(uint64_t key, uint32_t newIndex, uint32_t& outIndex) {
+			if ((_count + 1) * 2 > _slots.size()) {
+				_Grow();
+			}
+			const size_t mask = _slots.size() - 1;
+			for (size_t ix = _Hash(key) & mask; ; ix = (ix + 1) & mask) {
+				Slot& slot = _slots[ix];
+				if (slot.Key == key) {
+					outIndex = slot.Index;
+					return false;
+				}
+				if (slot.Key == 0) {
+					slot.Key = key;
+					slot.Index = newIndex;
+					_count++;
+					outIndex = newIndex;
+					return true;
+				}
+			}
+		}
+
+	private:
+		// Since position indices start at 1, a key of 0 can never be generated and marks an empty slot
+		struct Slot {
+			uint64_t Key   = 0;
+			uint32_t Index = 0;
+		};
+		std::vector<Slot> _slots;
+		size_t _count;
+
+		static size_t _Hash(uint64_t key) {
+			return static_cast<size_t>(HashVertexKey(key));
+		}
+
+		void _Grow() {
+			std::vector<Slot> old;
+			old.swap(_slots);
+			_slots.resize(old.size() * 2);
+			const size_t mask = _slots.size() - 1;
+			for (const Slot& slot : old) {
+				if (slot.Key != 0) {
+					size_t ix = _Hash(slot.Key) & mask;
+					while (_slots[ix].Key != 0) {
+						ix = (ix + 1) & mask;
+					}
+					_slots[ix] = slot;
+				}
+			}
+		}
+	};
+
+	inline bool IsSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline const char* SkipSpaces(const char* it, const char* end) {
+		while (it < end && IsSpace(*it)) {
+			it++;
+		}
+		return it;
+	}
+
+	inline const char* FindLineEnd(const char* it, const char* end) {
+		const char* result = static_cast<const char*>(memchr(it, '\n', end - it));
+		return result != nullptr ? result : end;
+	}
+
+	/// <summary>
+	/// Reads a float from the line, leaving the value as 0 if there is no number to read
+	/// </summary>
+	inline const char* ParseFloat(const char* it, const char* end, float& value) {
+		it = SkipSpaces(it, end);
+		// from_chars does not accept a leading plus sign, so we skip it ourselves
+		if (it < end && *it == '+') {
+			it++;
+		}
+		value = 0.0f;
+		std::from_chars_result result = std::from_chars(it, end, value);
+		return result.ec == std::errc() ? result.ptr : it;
+	}
+
+	/// <summary>
+	/// Reads a single face index from the line, returns 0 if no index was present
+	/// </summary>
+	inline const char* ParseIndex(const char* it, const char* end, int64_t& value) {
+		value = 0;
+		std::from_chars_result result = std::from_chars(it, end, value);
+		return result.ec == std::errc() ? result.ptr : it;
+	}
+
+	/// <summary>
+	/// Converts a 1-based or negative (relative) OBJ index into a 1-based absolute index, where 0 means the attribute was not specified
+	/// </summary>
+	inline uint32_t ResolveIndex(int64_t index, size_t count) {
+		if (index < 0) {
+			index += static_cast<int64_t>(count) + 1;
+			if (index <= 0) {
+				throw std::runtime_error("OBJ face references an attribute before the start of the file");
+			}
+		}
+		if (static_cast<size_t>(index) > count) {
+			throw std::runtime_error("OBJ face references an attribute that has not been declared");
+		}
+		if (index > MAX_ATTRIBUTE_INDEX) {
+			throw std::runtime_error("OBJ file has too many attributes for the vertex key");
+		}
+		return static_cast<uint32_t>(index);
+	}
+
+	/// <summary>
+	/// Counts the records in the file so that we can reserve all of our storage up front
+	/// </summary>
+	struct RecordCounts {
+		size_t Positions = 0;
+		size_t Normals   = 0;
+		size_t UVs       = 0;
+		size_t Faces     = 0;
+	};
+
+	RecordCounts CountRecords(const char* it, const char* end) {
+		RecordCounts result;
+		while (it < end) {
+			const char* lineEnd = FindLineEnd(it, end);
+			it = SkipSpaces(it, lineEnd);
+			if (lineEnd - it > 1) {
+				if (it[0] == 'v') {
+					if (IsSpace(it[1]))  result.Positions++;
+					else if (it[1] == 'n') result.Normals++;
+					else if (it[1] == 't') result.UVs++;
+				}
+				else if (it[0] == 'f' && IsSpace(it[1])) {
+					result.Faces++;
+				}
+			}
+			it = lineEnd + 1;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Parses a v, vn or vt record into the matching attribute list
+	/// </summary>
+	/// <returns>True if the line was an attribute record</returns>
+	inline bool ParseAttribute(const char* it, const char* lineEnd,
+		std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& textureCoords)
+	{
+		if (it[0] != 'v') {
+			return false;
+		}
+		glm::vec3 temp;
+		// Load in vertex positions
+		if (IsSpace(it[1])) {
+			it = ParseFloat(it + 1, lineEnd, temp.x);
+			it = ParseFloat(it, lineEnd, temp.y);
+			it = ParseFloat(it, lineEnd, temp.z);
+			positions.push_back(temp);
+			return true;
+		}
+		// Load in vertex normals
+		if (it[1] == 'n') {
+			it = ParseFloat(it + 2, lineEnd, temp.x);
+			it = ParseFloat(it, lineEnd, temp.y);
+			it = ParseFloat(it, lineEnd, temp.z);
+			normals.push_back(temp);
+			return true;
+		}
+		// Load in UV coordinates (ignoring the optional 3rd component)
+		if (it[1] == 't') {
+			it = ParseFloat(it + 2, lineEnd, temp.x);
+			it = ParseFloat(it, lineEnd, temp.y);
+			textureCoords.emplace_back(temp.x, temp.y);
+			return true;
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Parses a single corner of a face, which can be v, v/vt, v//vn or v/vt/vn. Missing attributes are returned as 0
+	/// </summary>
+	/// <returns>A pointer to the character after the corner</returns>
+	inline const char* ParseCorner(const char* it, const char* lineEnd, int64_t& position, int64_t& uv, int64_t& normal) {
+		uv = 0;
+		normal = 0;
+		const char* start = it;
+		it = ParseIndex(it, lineEnd, position);
+		if (it == start) {
+			throw std::runtime_error("Malformed face in OBJ file");
+		}
+		if (it < lineEnd && *it == '/') {
+			it = ParseIndex(it + 1, lineEnd, uv);
+			if (it < lineEnd && *it == '/') {
+				it = ParseIndex(it + 1, lineEnd, normal);
+			}
+		}
+		return it;
+	}
+
+	inline VertexPosNormTexCol MakeVertex(uint32_t positionIx, uint32_t uvIx, uint32_t normalIx,
+		const glm::vec3* positions, const glm::vec2* textureCoords, const glm::vec3* normals, const glm::vec4& inColor)
+	{
+		VertexPosNormTexCol vertex;
+		vertex.Position = positions[positionIx - 1];
+		vertex.UV = uvIx != 0 ? textureCoords[uvIx - 1] : glm::vec2(0.0f);
+		vertex.Normal = normalIx != 0 ? normals[normalIx - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
+		vertex.Color = inColor;
+		return vertex;
+	}
+
+	/// <summary>
+	/// Runs the given function on count threads (including the calling thread), passing each one its index.
+	/// Any exceptions thrown by the workers are re-thrown on the calling thread
+	/// </summary>
+	template <typename Func>
+	void ParallelFor(size_t count, Func&& func) {
+		std::vector<std::exception_ptr> errors(count);
+		std::vector<std::thread> threads;
+		threads.reserve(count);
+		for (size_t ix = 1; ix < count; ix++) {
+			threads.emplace_back([&, ix]() {
+				try { func(ix); }
+				catch (...) { errors[ix] = std::current_exception(); }
+			});
+		}
+		try { func(0); }
+		catch (...) { errors[0] = std::current_exception(); }
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		for (std::exception_ptr& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+
+	/// <summary>
+	/// A face corner as parsed from a chunk. Negative indices can only be resolved once we know how many
+	/// attributes the previous chunks declared, so we store them relative to the start of the chunk
+	/// </summary>
+	struct ChunkCorner {
+		int32_t Position;
+		int32_t UV;
+		int32_t Normal;
+		uint8_t RelativeMask;
+	};
+
+	enum CornerRelative : uint8_t {
+		RelativePosition = 1 << 0,
+		RelativeUV       = 1 << 1,
+		RelativeNormal   = 1 << 2
+	};
+
+	/// <summary>
+	/// Everything parsed out of one chunk of the file, plus where that data lands in the merged mesh
+	/// </summary>
+	struct ParsedChunk {
+		std::vector<glm::vec3>   Positions;
+		std::vector<glm::vec3>   Normals;
+		std::vector<glm::vec2>   TextureCoords;
+		std::vector<ChunkCorner> Corners;
+		std::vector<uint32_t>    FaceSizes;
+		size_t TriangleCount = 0;
+
+		// Filled in by the prefix sums during the merge
+		size_t PositionOffset = 0;
+		size_t NormalOffset = 0;
+		size_t UVOffset = 0;
+		size_t CornerOffset = 0;
+		size_t TriangleOffset = 0;
+		size_t NewVertexCount = 0;
+		size_t VertexOffset = 0;
+	};
+
+	/// <summary>
+	/// Converts a chunk local index into a 32 bit value, storing negative indices relative to the start of the chunk
+	/// </summary>
+	inline int32_t MakeChunkIndex(int64_t index, size_t localCount, uint8_t relativeBit, uint8_t& mask) {
+		if (index > MAX_ATTRIBUTE_INDEX || index < -static_cast<int64_t>(MAX_ATTRIBUTE_INDEX)) {
+			throw std::runtime_error("OBJ file has too many attributes for the vertex key");
+		}
+		if (index < 0) {
+			mask |= relativeBit;
+			return static_cast<int32_t>(index + static_cast<int64_t>(localCount) + 1);
+		}
+		return static_cast<int32_t>(index);
+	}
+
+	/// <summary>
+	/// Converts a chunk index into a 1-based absolute index, where 0 means the attribute was not specified
+	/// </summary>
+	inline uint32_t ResolveChunkIndex(int32_t index, bool relative, size_t chunkOffset, size_t count) {
+		if (!relative) {
+			return ResolveIndex(index, count);
+		}
+		const int64_t result = static_cast<int64_t>(index) + static_cast<int64_t>(chunkOffset);
+		if (result <= 0) {
+			throw std::runtime_error("OBJ face references an attribute before the start of the file");
+		}
+		return ResolveIndex(result, count);
+	}
+
+	void ParseChunk(const char* it, const char* end, ParsedChunk& chunk) {
+		const RecordCounts counts = CountRecords(it, end);
+		chunk.Positions.reserve(counts.Positions);
+		chunk.Normals.reserve(counts.Normals);
+		chunk.TextureCoords.reserve(counts.UVs);
+		chunk.FaceSizes.reserve(counts.Faces);
+		chunk.Corners.reserve(counts.Faces * 3);
+
+		while (it < end) {
+			const char* lineEnd = FindLineEnd(it, end);
+			it = SkipSpaces(it, lineEnd);
+
+			if (lineEnd - it >= 2) {
+				if (ParseAttribute(it, lineEnd, chunk.Positions, chunk.Normals, chunk.TextureCoords)) {
+					// Nothing else to do
+				}
+				else if (it[0] == 'f' && IsSpace(it[1])) {
+					it++;
+					uint32_t corners = 0;
+					while (true) {
+						it = SkipSpaces(it, lineEnd);
+						if (it >= lineEnd) {
+							break;
+						}
+						int64_t position, uv, normal;
+						it = ParseCorner(it, lineEnd, position, uv, normal);
+
+						ChunkCorner corner;
+						corner.RelativeMask = 0;
+						corner.Position = MakeChunkIndex(position, chunk.Positions.size(), RelativePosition, corner.RelativeMask);
+						corner.UV       = MakeChunkIndex(uv, chunk.TextureCoords.size(), RelativeUV, corner.RelativeMask);
+						corner.Normal   = MakeChunkIndex(normal, chunk.Normals.size(), RelativeNormal, corner.RelativeMask);
+						chunk.Corners.push_back(corner);
+						corners++;
+					}
+					chunk.FaceSizes.push_back(corners);
+					chunk.TriangleCount += corners > 2 ? corners - 2 : 0;
+				}
+			}
+
+			it = lineEnd + 1;
+		}
+	}
+}
 
 VertexArrayObject::sptr ObjLoader::LoadFromFile(const std::string& filename, const glm::vec4& inColor)
-{	
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+{
+	// If we've already parsed this model before, we can skip straight to the binary cache
+	VertexArrayObject::sptr cached = BinaryMeshLoader::LoadFromCache(filename, inColor);
+	if (cached != nullptr) {
+		return cached;
+	}
+
+	// We'll leverage the mesh builder class
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	_ParseAndCache(filename, mesh, inColor);
+	return mesh.Bake();
+}
+
+void ObjLoader::LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount)
+{
+	if (!BinaryMeshLoader::ReadFromCache(filename, inColor, mesh)) {
+		_ParseAndCache(filename, mesh, inColor, threadCount);
+	}
+}
+
+void ObjLoader::_ParseAndCache(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount)
+{
+	// Map the whole file into memory, so that the parser can work on one contiguous buffer
+	MappedFile file(filename);
 
 	// If our file fails to open, we will throw an error
-	if (!file) {
+	if (!file.IsOpen()) {
 		throw std::runtime_error("Failed to open file");
 	}
 
-	// Stores attributes
+	const size_t firstVertex = mesh.GetVertexCount();
+	const size_t firstIndex  = mesh.GetIndexCount();
+	ParseFromMemory(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), mesh, inColor, threadCount);
+	file.Close();
+
+	// Store the result so the next load can skip parsing entirely. The cache can only describe a mesh on its own,
+	// so we skip it if we were appending to a builder that already had data in it. Optimizing and building the
+	// levels of detail is done here rather than on every load, so that the cache holds the finished mesh
+	if (firstVertex == 0 && firstIndex == 0) {
+		const MeshOptimizeReport report = mesh.Optimize();
+		LOG_INFO("Optimized \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", filename,
+			report.Before.ACMR, report.After.ACMR, report.Before.ATVR, report.After.ATVR);
+		const std::vector<MeshLod>& lods = mesh.GenerateLods();
+		for (size_t ix = 0; ix < lods.size(); ix++) {
+			LOG_INFO("  LOD {}: {} triangles, error {:.4f}", ix + 1, lods[ix].Indices.size() / 3, lods[ix].Error);
+		}
+		BinaryMeshLoader::SaveToCache(filename, inColor,
+			mesh.GetVertexDataPtr(), mesh.GetVertexCount(),
+			mesh.GetIndexDataPtr(), mesh.GetIndexCount(), lods);
+	}
+}
+
+void ObjLoader::ParseFromMemory(const char* data, size_t size, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount)
+{
+	if (threadCount == 0) {
+		threadCount = size >= MULTITHREAD_MIN_BYTES ? glm::max(std::thread::hardware_concurrency(), 1u) : 1;
+	}
+	// Make sure that every thread gets a meaningful amount of work
+	threadCount = glm::min(threadCount, size / (64 * 1024) + 1);
+
+	if (threadCount > 1) {
+		_ParseMultiThreaded(data, size, mesh, inColor, threadCount);
+	} else {
+		_ParseSingleThreaded(data, size, mesh, inColor);
+	}
+}
+
+void ObjLoader::_ParseSingleThreaded(const char* data, size_t size, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor)
+{
+	const char* it  = data;
+	const char* end = data + size;
+
+	// Stores attributes, reserved from a quick pre-pass so that we never re-allocate while parsing
+	const RecordCounts counts = CountRecords(it, end);
 	std::vector<glm::vec3> positions;
 	std::vector<glm::vec3> normals;
 	std::vector<glm::vec2> textureCoords;
+	positions.reserve(counts.Positions);
+	normals.reserve(counts.Normals);
+	textureCoords.reserve(counts.UVs);
 
-	// We'll use bitmask keys and a map to avoid duplicate vertices
-	std::unordered_map<uint64_t, uint32_t> indexMap;
+	// Most models are triangles or quads, so the number of unique vertices will be close to the largest attribute count
+	const size_t expectedVertices = glm::max(counts.Positions, glm::max(counts.Normals, counts.UVs));
+	mesh.ReserveVertexSpace(expectedVertices);
+	mesh.ReserveIndexSpace(counts.Faces * 3);
 
-	// We'll leverage the mesh builder class
-	MeshBuilder<VertexPosNormTexCol> mesh;
+	// We'll use bitmask keys and a map to avoid duplicate vertices
+	VertexIndexMap indexMap(expectedVertices);
 
-	// Temporaries for loading data
-	glm::vec3 temp;
-	glm::ivec3 vertexIndices;
-	
-	std::string line;
-	// Iterate as long as there is content to read
-	while (file.peek() != EOF) {
-		std::string command;
-		file >> command;
+	while (it < end) {
+		const char* lineEnd = FindLineEnd(it, end);
+		it = SkipSpaces(it, lineEnd);
 
-		// Load in vertex positions
-		if (command == "v") {
-			file >> temp.x >> temp.y >> temp.z;
-			positions.push_back(temp);
+		// Skip empty lines, comments and anything we don't care about (o, g, s, usemtl, mtllib)
+		if (lineEnd - it < 2) {
+			it = lineEnd + 1;
+			continue;
 		}
-		// Load in vertex normals
-		else if (command == "vn") {
-			file >> temp.x >> temp.y >> temp.z;
-			normals.push_back(temp);
+
+		if (ParseAttribute(it, lineEnd, positions, normals, textureCoords)) {
+			// Nothing else to do
 		}
-		// Load in UV coordinates
-		else if (command == "vt") {
-			file >> temp.x >> temp.y;
-			textureCoords.push_back(temp);
-		}
-		// Load in face lines
-		else if (command == "f") {
-			// Read the entire line, trim it, and stuff it into a string stream
-			std::string line;
-			std::getline(file, line);
-			trim(line);			
-			std::stringstream stream = std::stringstream(line);
-
-			// We'll store the edges in case we added a quad
-			uint32_t edges[4];
-			int ix = 0;
-			// Iterate over up to 4 sets of attributes
-			for (; ix < 4; ix++) {
-				if (stream.peek() != EOF) {
-					// Load in the faces, split up by slashes
-					char tempChar;
-					vertexIndices = glm::ivec3(0);
-					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
-					// The OBJ format can have negative values, which are a reference from the last added attributes
-					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() - 1 + vertexIndices.x; }
-					if (vertexIndices.y < 0) { vertexIndices.y = textureCoords.size() - 1 + vertexIndices.y; }
-					if (vertexIndices.z < 0) { vertexIndices.z = normals.size() - 1 + vertexIndices.z; }
-					// We can construct a key using a bitmask of the attribute indices
-					// This let's us quickly look up a combination of attributes to see if it's already been added
-					// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
-					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
-					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
-
-					// Find the index associated with the combination of attributes
-					auto it = indexMap.find(key);
-
-					// If it exists, we push the index to our indices
-					if (it != indexMap.end()) {
-						edges[ix] = it->second;
-					}
-					else {
-						// Construct a new vertex using the indices for the vertex
-						VertexPosNormTexCol vertex;
-						vertex.Position = positions[vertexIndices.x - 1];
-						vertex.UV = vertexIndices.y != 0 ? textureCoords[vertexIndices.y - 1] : glm::vec2(0.0f);
-						vertex.Normal = vertexIndices.z != 0 ? normals[vertexIndices.z - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
-						vertex.Color = inColor;
-
-						// Add to the mesh, get index of the added vertex
-						uint32_t index = mesh.AddVertex(vertex);
-						// Cache the index based on our key
-						indexMap[key] = index;
-						// Add index to mesh, and add to edges list for if we are using quads
-						edges[ix] = index;
-					}
-				} else {
+		// Load in face lines, triangulating polygons as a fan around the first corner
+		else if (it[0] == 'f' && IsSpace(it[1])) {
+			it++;
+			uint32_t first = 0, previous = 0;
+			int corner = 0;
+			while (true) {
+				it = SkipSpaces(it, lineEnd);
+				if (it >= lineEnd) {
 					break;
 				}
+
+				int64_t position, uv, normal;
+				it = ParseCorner(it, lineEnd, position, uv, normal);
+
+				const uint32_t positionIx = ResolveIndex(position, positions.size());
+				const uint32_t uvIx       = ResolveIndex(uv, textureCoords.size());
+				const uint32_t normalIx   = ResolveIndex(normal, normals.size());
+				if (positionIx == 0) {
+					throw std::runtime_error("OBJ face is missing a position index");
+				}
+
+				// Find the index associated with the combination of attributes, adding a new vertex if it does not exist yet
+				uint32_t index;
+				if (indexMap.FindOrInsert(MakeVertexKey(positionIx, uvIx, normalIx), static_cast<uint32_t>(mesh.GetVertexCount()), index)) {
+					mesh.AddVertex(MakeVertex(positionIx, uvIx, normalIx, positions.data(), textureCoords.data(), normals.data(), inColor));
+				}
+
+				if (corner == 0) {
+					first = index;
+				} else if (corner >= 2) {
+					mesh.AddIndexTri(first, previous, index);
+				}
+				previous = index;
+				corner++;
 			}
-			// Handling for trangle faces
-			if (ix == 3) {
-				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
-			}
-			// Handling for quad faces
-			else if (ix == 4) {
-				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
-				mesh.AddIndexTri(edges[0], edges[2], edges[3]);
+		}
+
+		it = lineEnd + 1;
+	}
+}
+
+void ObjLoader::_ParseMultiThreaded(const char* data, size_t size, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount)
+{
+	const char* end = data + size;
+
+	// Split the file into roughly equal chunks, moving each split forward to the start of the next line
+	std::vector<const char*> bounds(threadCount + 1);
+	bounds[0] = data;
+	bounds[threadCount] = end;
+	for (size_t ix = 1; ix < threadCount; ix++) {
+		const char* split = std::max(data + (size * ix) / threadCount, bounds[ix - 1]);
+		split = FindLineEnd(split, end);
+		bounds[ix] = split < end ? split + 1 : end;
+	}
+
+	// Parse the records of each chunk in parallel
+	std::vector<ParsedChunk> chunks(threadCount);
+	ParallelFor(threadCount, [&](size_t ix) {
+		ParseChunk(bounds[ix], bounds[ix + 1], chunks[ix]);
+	});
+
+	// Prefix sum the chunk sizes, so that every chunk knows where its data lives in the merged arrays
+	size_t positionCount = 0, normalCount = 0, uvCount = 0, cornerCount = 0, triangleCount = 0;
+	for (ParsedChunk& chunk : chunks) {
+		chunk.PositionOffset = positionCount;
+		chunk.NormalOffset   = normalCount;
+		chunk.UVOffset       = uvCount;
+		chunk.CornerOffset   = cornerCount;
+		chunk.TriangleOffset = triangleCount;
+		positionCount += chunk.Positions.size();
+		normalCount   += chunk.Normals.size();
+		uvCount       += chunk.TextureCoords.size();
+		cornerCount   += chunk.Corners.size();
+		triangleCount += chunk.TriangleCount;
+	}
+	if (cornerCount > UINT32_MAX) {
+		throw std::runtime_error("OBJ file has too many face corners");
+	}
+
+	// Gather the attributes and resolve every corner into a global vertex key
+	std::vector<glm::vec3> positions(positionCount);
+	std::vector<glm::vec3> normals(normalCount);
+	std::vector<glm::vec2> textureCoords(uvCount);
+	std::vector<uint64_t>  keys(cornerCount);
+	ParallelFor(threadCount, [&](size_t ix) {
+		ParsedChunk& chunk = chunks[ix];
+		std::copy(chunk.Positions.begin(), chunk.Positions.end(), positions.begin() + chunk.PositionOffset);
+		std::copy(chunk.Normals.begin(), chunk.Normals.end(), normals.begin() + chunk.NormalOffset);
+		std::copy(chunk.TextureCoords.begin(), chunk.TextureCoords.end(), textureCoords.begin() + chunk.UVOffset);
+
+		for (size_t cx = 0; cx < chunk.Corners.size(); cx++) {
+			const ChunkCorner& corner = chunk.Corners[cx];
+			const uint32_t positionIx = ResolveChunkIndex(corner.Position, corner.RelativeMask & RelativePosition, chunk.PositionOffset, positionCount);
+			const uint32_t uvIx       = ResolveChunkIndex(corner.UV, corner.RelativeMask & RelativeUV, chunk.UVOffset, uvCount);
+			const uint32_t normalIx   = ResolveChunkIndex(corner.Normal, corner.RelativeMask & RelativeNormal, chunk.NormalOffset, normalCount);
+			if (positionIx == 0) {
+				throw std::runtime_error("OBJ face is missing a position index");
 			}
+			keys[chunk.CornerOffset + cx] = MakeVertexKey(positionIx, uvIx, normalIx);
+		}
+	});
+
+	// De-duplicate in a single pass over the corners in file order, mapping every key to the index of the first
+	// corner that uses it. This is one hash lookup per corner, the passes around it are what run in parallel
+	std::vector<uint32_t> firstCorner(cornerCount);
+	const size_t expectedVertices = glm::max(positionCount, glm::max(normalCount, uvCount));
+	{
+		VertexIndexMap indexMap(expectedVertices);
+		for (size_t cx = 0; cx < cornerCount; cx++) {
+			indexMap.FindOrInsert(keys[cx], static_cast<uint32_t>(cx), firstCorner[cx]);
 		}
 	}
 
-	// Note: with actual OBJ files you're going to run into the issue where faces are composited of different indices
-	// You'll need to keep track of these and create vertex entries for each vertex in the face
-	// If you want to get fancy, you can track which vertices you've already added
+	// Count the new vertices in each chunk and prefix sum them, so that vertices are numbered in order of first occurrence
+	ParallelFor(threadCount, [&](size_t ix) {
+		ParsedChunk& chunk = chunks[ix];
+		for (size_t cx = chunk.CornerOffset; cx < chunk.CornerOffset + chunk.Corners.size(); cx++) {
+			chunk.NewVertexCount += firstCorner[cx] == cx;
+		}
+	});
+	const size_t baseVertex = mesh._vertices.size();
+	size_t vertexCount = 0;
+	for (ParsedChunk& chunk : chunks) {
+		chunk.VertexOffset = baseVertex + vertexCount;
+		vertexCount += chunk.NewVertexCount;
+	}
+	if (baseVertex + vertexCount > UINT32_MAX) {
+		throw std::runtime_error("OBJ file has too many vertices");
+	}
 
-	return mesh.Bake();
+	// Build the new vertices
+	std::vector<uint32_t> vertexOfCorner(cornerCount);
+	mesh._vertices.resize(baseVertex + vertexCount);
+	ParallelFor(threadCount, [&](size_t ix) {
+		ParsedChunk& chunk = chunks[ix];
+		size_t next = chunk.VertexOffset;
+		for (size_t cx = chunk.CornerOffset; cx < chunk.CornerOffset + chunk.Corners.size(); cx++) {
+			if (firstCorner[cx] == cx) {
+				const uint64_t key = keys[cx];
+				const uint32_t positionIx = static_cast<uint32_t>(key >> 42);
+				const uint32_t uvIx       = static_cast<uint32_t>(key >> 21) & MAX_ATTRIBUTE_INDEX;
+				const uint32_t normalIx   = static_cast<uint32_t>(key) & MAX_ATTRIBUTE_INDEX;
+				mesh._vertices[next] = MakeVertex(positionIx, uvIx, normalIx, positions.data(), textureCoords.data(), normals.data(), inColor);
+				vertexOfCorner[cx] = static_cast<uint32_t>(next);
+				next++;
+			}
+		}
+	});
+
+	// Triangulate the faces of each chunk straight into their slice of the index buffer
+	const size_t baseIndex = mesh._indices.size();
+	mesh._indices.resize(baseIndex + triangleCount * 3);
+	ParallelFor(threadCount, [&](size_t ix) {
+		ParsedChunk& chunk = chunks[ix];
+		uint32_t* out = mesh._indices.data() + baseIndex + chunk.TriangleOffset * 3;
+		size_t cx = chunk.CornerOffset;
+		for (uint32_t faceSize : chunk.FaceSizes) {
+			if (faceSize > 2) {
+				const uint32_t first = vertexOfCorner[firstCorner[cx]];
+				uint32_t previous = vertexOfCorner[firstCorner[cx + 1]];
+				for (uint32_t corner = 2; corner < faceSize; corner++) {
+					const uint32_t index = vertexOfCorner[firstCorner[cx + corner]];
+					*out++ = first;
+					*out++ = previous;
+					*out++ = index;
+					previous = index;
+				}
+			}
+			cx += faceSize;
+		}
+	});
 }
@@ -4,9 +4,47 @@
 class ObjLoader
 {
 public:
+	/// <summary>
+	/// Files smaller than this are always parsed on the calling thread, since the cost of
+	/// starting workers and merging their results outweighs the gains
+	/// </summary>
+	static constexpr size_t MULTITHREAD_MIN_BYTES = 512 * 1024;
+
 	static VertexArrayObject::sptr LoadFromFile(const std::string& filename, const glm::vec4& inColor = glm::vec4(1.0f));
 
+	/// <summary>
+	/// Loads the vertices and indices for a model into a mesh builder without creating any OpenGL objects,
+	/// using the binary cache when it is valid and parsing (then caching) the OBJ otherwise. This is the part
+	/// of LoadFromFile that is safe to run on a worker thread
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="mesh">The mesh builder to append the model to</param>
+	/// <param name="inColor">The color to apply to all vertices</param>
+	/// <param name="threadCount">The number of threads to parse with if the file isn't cached, see ParseFromMemory. Pass 1 from
+	/// thread pool workers, so that several loads at once don't each start a thread per core</param>
+	static void LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor = glm::vec4(1.0f), size_t threadCount = 0);
+
+	/// <summary>
+	/// Parses the contents of an OBJ file from memory, appending the de-duplicated vertices and
+	/// triangulated indices to the given mesh builder. Supports v/vt/vn, v//vn and v faces, negative
+	/// (relative) indices and polygons with any number of sides.
+	///
+	/// Large files are split into chunks at line boundaries and parsed on multiple threads, the result
+	/// is identical to parsing the file on a single thread
+	/// </summary>
+	/// <param name="data">A pointer to the first character of the file</param>
+	/// <param name="size">The size of the file in bytes</param>
+	/// <param name="mesh">The mesh builder to append the results to</param>
+	/// <param name="inColor">The color to apply to all vertices</param>
+	/// <param name="threadCount">The number of threads to use, or 0 to pick based on the file size and core count. Only
+	/// synchronous loads on the main thread should use 0, callers that are already on a worker should pass 1</param>
+	static void ParseFromMemory(const char* data, size_t size, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor = glm::vec4(1.0f), size_t threadCount = 0);
+
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
-};
\ No newline at end of file
+
+	static void _ParseAndCache(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount = 0);
+	static void _ParseSingleThreaded(const char* data, size_t size, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor);
+	static void _ParseMultiThreaded(const char* data, size_t size, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount);
+};
@@ -0,0 +1,259 @@
+#include "ObjLoaderBenchmark.h"
+
+#ifdef OBJ_LOADER_BENCHMARK
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <thread>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+
+#include "Logging.h"
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "StringUtils.h"
+
+static std::atomic<size_t> AllocationCount = 0;
+
+void* operator new(size_t size) {
+	AllocationCount++;
+	void* result = malloc(size > 0 ? size : 1);
+	if (result == nullptr) {
+		throw std::bad_alloc();
+	}
+	return result;
+}
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+/// <summary>
+/// The original iostream based loader, kept here as the baseline for the benchmark
+/// </summary>
+static void LegacyParse(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor)
+{
+	std::ifstream file;
+	file.open(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open file");
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> textureCoords;
+	std::unordered_map<uint64_t, uint32_t> indexMap;
+
+	glm::vec3 temp;
+	glm::ivec3 vertexIndices;
+	while (file.peek() != EOF) {
+		std::string command;
+		file >> command;
+
+		if (command == "v") {
+			file >> temp.x >> temp.y >> temp.z;
+			positions.push_back(temp);
+		}
+		else if (command == "vn") {
+			file >> temp.x >> temp.y >> temp.z;
+			normals.push_back(temp);
+		}
+		else if (command == "vt") {
+			file >> temp.x >> temp.y;
+			textureCoords.push_back(temp);
+		}
+		else if (command == "f") {
+			std::string line;
+			std::getline(file, line);
+			trim(line);
+			std::stringstream stream = std::stringstream(line);
+
+			uint32_t edges[4];
+			int ix = 0;
+			for (; ix < 4; ix++) {
+				if (stream.peek() != EOF) {
+					char tempChar;
+					vertexIndices = glm::ivec3(0);
+					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
+					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() - 1 + vertexIndices.x; }
+					if (vertexIndices.y < 0) { vertexIndices.y = textureCoords.size() - 1 + vertexIndices.y; }
+					if (vertexIndices.z < 0) { vertexIndices.z = normals.size() - 1 + vertexIndices.z; }
+					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
+
+					auto it = indexMap.find(key);
+					if (it != indexMap.end()) {
+						edges[ix] = it->second;
+					}
+					else {
+						VertexPosNormTexCol vertex;
+						vertex.Position = positions[vertexIndices.x - 1];
+						vertex.UV = vertexIndices.y != 0 ? textureCoords[vertexIndices.y - 1] : glm::vec2(0.0f);
+						vertex.Normal = vertexIndices.z != 0 ? normals[vertexIndices.z - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
+						vertex.Color = inColor;
+						uint32_t index = mesh.AddVertex(vertex);
+						indexMap[key] = index;
+						edges[ix] = index;
+					}
+				} else {
+					break;
+				}
+			}
+			if (ix == 3) {
+				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
+			}
+			else if (ix == 4) {
+				mesh.AddIndexTri(edges[0], edges[1], edges[2]);
+				mesh.AddIndexTri(edges[0], edges[2], edges[3]);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Parses a file with the current loader, including mapping the file so both loaders pay for their IO
+/// </summary>
+static void CurrentParse(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& inColor, size_t threadCount = 0)
+{
+	MappedFile file(filename);
+	if (!file.IsOpen()) {
+		throw std::runtime_error("Failed to open file");
+	}
+	ObjLoader::ParseFromMemory(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), mesh, inColor, threadCount);
+}
+
+struct BenchmarkResult {
+	double BestSeconds = 0.0;
+	size_t Allocations = 0;
+	std::vector<VertexPosNormTexCol> Vertices;
+	std::vector<uint32_t> Indices;
+};
+
+static bool IsIdentical(const BenchmarkResult& a, const BenchmarkResult& b) {
+	return
+		a.Vertices.size() == b.Vertices.size() &&
+		a.Indices == b.Indices &&
+		memcmp(a.Vertices.data(), b.Vertices.data(), a.Vertices.size() * sizeof(VertexPosNormTexCol)) == 0;
+}
+
+static std::vector<std::filesystem::path> FindModels(const std::string& directory) {
+	namespace fs = std::filesystem;
+	std::vector<fs::path> files;
+	for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+		if (entry.is_regular_file() && entry.path().extension() == ".obj") {
+			files.push_back(entry.path());
+		}
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+template <typename Func>
+static BenchmarkResult Measure(const std::string& filename, int iterations, Func&& parse) {
+	using Clock = std::chrono::high_resolution_clock;
+	BenchmarkResult result;
+	result.BestSeconds = 1e30;
+	for (int ix = 0; ix < iterations; ix++) {
+		MeshBuilder<VertexPosNormTexCol> mesh;
+		const size_t allocsBefore = AllocationCount;
+		const Clock::time_point start = Clock::now();
+		parse(filename, mesh, glm::vec4(1.0f));
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		result.Allocations = AllocationCount - allocsBefore;
+		result.BestSeconds = std::min(result.BestSeconds, seconds);
+
+		if (ix == 0) {
+			result.Vertices.assign(mesh.GetVertexDataPtr(), mesh.GetVertexDataPtr() + mesh.GetVertexCount());
+			result.Indices.assign(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+		}
+	}
+	return result;
+}
+
+void ObjLoaderBenchmark::Run(const std::string& directory, int iterations)
+{
+	namespace fs = std::filesystem;
+
+	const std::vector<fs::path> files = FindModels(directory);
+
+	LOG_INFO("OBJ loader benchmark on \"{}\" ({} files, best of {})", directory, files.size(), iterations);
+	LOG_INFO("{:<20} {:>9} | {:>10} {:>8} | {:>10} {:>8} | {:>7} {}", "File", "KB", "Old MB/s", "Allocs", "New MB/s", "Allocs", "Speedup", "Output");
+
+	double totalMegabytes = 0.0, totalOld = 0.0, totalNew = 0.0;
+	size_t totalOldAllocs = 0, totalNewAllocs = 0;
+	for (const fs::path& path : files) {
+		const std::string filename = path.string();
+		const double megabytes = static_cast<double>(fs::file_size(path)) / (1024.0 * 1024.0);
+
+		BenchmarkResult legacy  = Measure(filename, iterations, LegacyParse);
+		BenchmarkResult current = Measure(filename, iterations, [](const std::string& file, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& color) {
+			CurrentParse(file, mesh, color);
+		});
+
+		const bool identical = IsIdentical(legacy, current);
+
+		LOG_INFO("{:<20} {:>9.1f} | {:>10.1f} {:>8} | {:>10.1f} {:>8} | {:>6.1f}x {}",
+			path.filename().string(), megabytes * 1024.0,
+			megabytes / legacy.BestSeconds, legacy.Allocations,
+			megabytes / current.BestSeconds, current.Allocations,
+			legacy.BestSeconds / current.BestSeconds,
+			identical ? "identical" : "DIFFERENT");
+
+		totalMegabytes += megabytes;
+		totalOld += legacy.BestSeconds;
+		totalNew += current.BestSeconds;
+		totalOldAllocs += legacy.Allocations;
+		totalNewAllocs += current.Allocations;
+	}
+
+	if (!files.empty()) {
+		LOG_INFO("{:<20} {:>9.1f} | {:>10.1f} {:>8} | {:>10.1f} {:>8} | {:>6.1f}x",
+			"Total", totalMegabytes * 1024.0,
+			totalMegabytes / totalOld, totalOldAllocs / files.size(),
+			totalMegabytes / totalNew, totalNewAllocs / files.size(),
+			totalOld / totalNew);
+	}
+}
+
+void ObjLoaderBenchmark::RunScaling(const std::string& directory, size_t maxThreads, int iterations)
+{
+	namespace fs = std::filesystem;
+
+	if (maxThreads == 0) {
+		maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	LOG_INFO("OBJ loader thread scaling on \"{}\" (1 to {} threads, best of {})", directory, maxThreads, iterations);
+	for (const fs::path& path : FindModels(directory)) {
+		const size_t bytes = fs::file_size(path);
+		if (bytes < ObjLoader::MULTITHREAD_MIN_BYTES) {
+			continue;
+		}
+		const std::string filename = path.string();
+		const double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+
+		BenchmarkResult baseline;
+		for (size_t threads = 1; threads <= maxThreads; threads++) {
+			BenchmarkResult result = Measure(filename, iterations, [threads](const std::string& file, MeshBuilder<VertexPosNormTexCol>& mesh, const glm::vec4& color) {
+				CurrentParse(file, mesh, color, threads);
+			});
+			if (threads == 1) {
+				baseline = result;
+			}
+			LOG_INFO("{:<20} {:>2} threads: {:>8.1f} MB/s {:>5.2f}x {}",
+				path.filename().string(), threads,
+				megabytes / result.BestSeconds, baseline.BestSeconds / result.BestSeconds,
+				IsIdentical(baseline, result) ? "identical" : "DIFFERENT");
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+
+// Uncomment to benchmark the OBJ parser against the original iostream based loader on startup.
+// This also replaces the global operator new so that allocations can be counted
+//#define OBJ_LOADER_BENCHMARK
+
+/// <summary>
+/// Compares the throughput and allocation count of ObjLoader::ParseFromMemory against the original
+/// iostream based OBJ loader, and checks that both produce identical meshes
+/// </summary>
+class ObjLoaderBenchmark
+{
+public:
+	/// <summary>
+	/// Parses every .obj file in the given directory with both loaders and logs the results
+	/// </summary>
+	/// <param name="directory">The directory to search for models (ex: models/Arena1)</param>
+	/// <param name="iterations">The number of times to parse each file, the fastest run is reported</param>
+	static void Run(const std::string& directory, int iterations = 5);
+	/// <summary>
+	/// Parses every .obj file in the given directory that is large enough to be split across threads, with
+	/// 1 to maxThreads threads, and logs the throughput of each along with whether the output matched the
+	/// single threaded result
+	/// </summary>
+	/// <param name="directory">The directory to search for models (ex: models/Arena1)</param>
+	/// <param name="maxThreads">The largest thread count to test, or 0 to use the number of hardware threads</param>
+	/// <param name="iterations">The number of times to parse each file, the fastest run is reported</param>
+	static void RunScaling(const std::string& directory, size_t maxThreads = 0, int iterations = 5);
+
+protected:
+	ObjLoaderBenchmark() = default;
+	~ObjLoaderBenchmark() = default;
+};
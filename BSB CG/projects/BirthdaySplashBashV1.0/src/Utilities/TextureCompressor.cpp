@@ -0,0 +1,84 @@
+#include "TextureCompressor.h"
+
+#include <vector>
+#include <future>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+#include "Logging.h"
+#include "Graphics/BlockCompression.h"
+#include "Graphics/MipGenerator.h"
+#include "Graphics/TextureContainer.h"
+#include "Utilities/ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+void TextureCompressor::CompressDirectory(const std::string& directory, bool force) {
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::string> files;
+	std::error_code error;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory, error)) {
+		if (!entry.is_regular_file()) {
+			continue;
+		}
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+		if (extension != ".png" && extension != ".jpg" && extension != ".jpeg" && extension != ".bmp" && extension != ".tga") {
+			continue;
+		}
+		const std::string path = entry.path().generic_string();
+		if (path.find("/cubemaps/") != std::string::npos) {
+			continue;
+		}
+		if (!force && TextureContainer::IsCompressedCopyValid(path, TextureContainer::GetCompressedPath(path))) {
+			continue;
+		}
+		files.push_back(path);
+	}
+	if (error) {
+		LOG_WARN("Failed to search \"{}\" for images: {}", directory, error.message());
+	}
+
+	// Each image is independent, so we compress them all in parallel
+	ThreadPool::sptr pool = ThreadPool::Create();
+	std::vector<std::future<bool>> results;
+	results.reserve(files.size());
+	for (const std::string& file : files) {
+		results.push_back(pool->Enqueue([file]() { return CompressFile(file); }));
+	}
+	size_t compressed = 0;
+	for (std::future<bool>& result : results) {
+		compressed += result.get() ? 1 : 0;
+	}
+
+	const float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	LOG_INFO("Compressed {} of {} out of date images in \"{}\" in {:.2f}s", compressed, files.size(), directory, seconds);
+}
+
+bool TextureCompressor::CompressFile(const std::string& file) {
+	Texture2DData::sptr source = Texture2DData::LoadFromFile(file, false, false);
+	if (source == nullptr) {
+		return false;
+	}
+	if (source->GetPixelType() != PixelType::UByte) {
+		LOG_WARN("Can not compress \"{}\", only 8 bit images are supported", file);
+		return false;
+	}
+
+	const InternalFormat format = BlockCompression::ChooseFormat(*source);
+	Texture2DData::sptr mips = MipGenerator::Generate(*source, MipFilter::Kaiser);
+	Texture2DData::sptr result = BlockCompression::Compress(*mips, format);
+	if (result == nullptr) {
+		return false;
+	}
+
+	const std::string output = TextureContainer::GetCompressedPath(file);
+	if (!TextureContainer::SaveDDS(output, *result, file)) {
+		return false;
+	}
+	LOG_INFO("Compressed \"{}\" to {} ({}x{}, {} levels): {:.1f} KB -> {:.1f} KB", file, ~format,
+		result->GetWidth(), result->GetHeight(), result->GetLevelCount(), mips->GetDataSize() / 1024.0f, result->GetDataSize() / 1024.0f);
+	return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+
+#include "Graphics/Texture2DData.h"
+
+// Uncomment to make compressed copies of all of the images in the images folder on startup. Only images that
+// have changed since their copy was made are compressed again
+//#define TEXTURE_COMPRESSOR
+
+/// <summary>
+/// Makes block compressed copies of our images ahead of time. Each copy includes a full mip chain (built with
+/// the MipGenerator) and is saved next to its source image (see TextureContainer::GetCompressedPath), where
+/// Texture2DData::LoadFromFile will pick it up instead of decoding the source image.
+///
+/// Images with transparency are compressed to BC3, two channel images to BC5 and everything else to BC1
+/// </summary>
+class TextureCompressor
+{
+public:
+	/// <summary>
+	/// Compresses every image in a directory and its subdirectories. Cube map faces (anything in a folder named
+	/// cubemaps) are skipped, since cube maps are always uploaded uncompressed
+	/// </summary>
+	/// <param name="directory">The directory to search for images (ex: images)</param>
+	/// <param name="force">True to compress images again even if their compressed copy is up to date</param>
+	static void CompressDirectory(const std::string& directory, bool force = false);
+	/// <summary>
+	/// Compresses a single image and saves the compressed copy next to it
+	/// </summary>
+	/// <param name="file">The path of the image to compress</param>
+	/// <returns>True if the compressed copy was written</returns>
+	static bool CompressFile(const std::string& file);
+
+protected:
+	TextureCompressor() = default;
+	~TextureCompressor() = default;
+};
@@ -0,0 +1,44 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount) :
+	_isStopping(false)
+{
+	if (threadCount == 0) {
+		const size_t hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	_workers.reserve(threadCount);
+	for (size_t ix = 0; ix < threadCount; ix++) {
+		_workers.emplace_back(&ThreadPool::_WorkerMain, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_isStopping = true;
+		// Dropping the tasks destroys their packaged_tasks, which breaks the promises of anyone still waiting
+		std::queue<std::function<void()>>().swap(_tasks);
+	}
+	_condition.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::_WorkerMain() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _isStopping || !_tasks.empty(); });
+			if (_isStopping) {
+				return;
+			}
+			task = std::move(_tasks.front());
+			_tasks.pop();
+		}
+		task();
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <future>
+#include <functional>
+#include <condition_variable>
+
+/// <summary>
+/// A fixed size pool of worker threads that run queued tasks in FIFO order. Tasks must not touch
+/// any OpenGL state, since the GL context only lives on the main thread
+/// </summary>
+class ThreadPool final
+{
+public:
+	// The pool owns running threads, so we disallow copying and moving
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool(ThreadPool&& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+	ThreadPool& operator=(ThreadPool&& other) = delete;
+
+	typedef std::shared_ptr<ThreadPool> sptr;
+	static inline sptr Create(size_t threadCount = 0) {
+		return std::make_shared<ThreadPool>(threadCount);
+	}
+
+public:
+	/// <summary>
+	/// Creates a new thread pool and starts its workers
+	/// </summary>
+	/// <param name="threadCount">The number of workers to start, or 0 to leave one hardware thread free for the main thread</param>
+	explicit ThreadPool(size_t threadCount = 0);
+	/// <summary>
+	/// Stops the pool, any tasks that have not started yet are discarded and their futures will report a broken promise
+	/// </summary>
+	~ThreadPool();
+
+	/// <summary>
+	/// Queues a function to run on one of the workers
+	/// </summary>
+	/// <param name="func">The function to run</param>
+	/// <returns>A future that will receive the result of the function, or the exception it threw</returns>
+	template <typename Func>
+	auto Enqueue(Func&& func) -> std::future<decltype(func())> {
+		typedef decltype(func()) TResult;
+		// std::function needs to be copyable, so the packaged task lives behind a shared pointer
+		std::shared_ptr<std::packaged_task<TResult()>> task = std::make_shared<std::packaged_task<TResult()>>(std::forward<Func>(func));
+		std::future<TResult> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.emplace([task]() { (*task)(); });
+		}
+		_condition.notify_one();
+		return result;
+	}
+
+	/// <summary>
+	/// Returns the number of worker threads in this pool
+	/// </summary>
+	size_t GetThreadCount() const { return _workers.size(); }
+
+private:
+	std::vector<std::thread>          _workers;
+	std::queue<std::function<void()>> _tasks;
+	std::mutex                        _mutex;
+	std::condition_variable           _condition;
+	bool                              _isStopping;
+
+	void _WorkerMain();
+};
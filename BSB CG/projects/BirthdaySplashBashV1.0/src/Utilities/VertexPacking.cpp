@@ -0,0 +1,270 @@
+#include "VertexPacking.h"
+
+#include <cstring>
+#include <algorithm>
+#include <GLM/gtc/packing.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Graphics/GeometryPool.h"
+
+namespace
+{
+	uint32_t PositionSize(PackedPosition format) {
+		return format == PackedPosition::Float32 ? 12 : 8; // 3 x uint16 padded to 4 for alignment
+	}
+	uint32_t TexCoordSize(PackedTexCoord format) {
+		return format == PackedTexCoord::Float32 ? 8 : 4;
+	}
+	uint32_t ColorSize(PackedColor format) {
+		switch (format) {
+			case PackedColor::Float32: return 16;
+			case PackedColor::RGBA8:   return 4;
+			default:                   return 0;
+		}
+	}
+
+	inline float SignNotZero(float value) {
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	inline int16_t ToSnorm16(float value) {
+		return (int16_t)glm::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f);
+	}
+	inline uint16_t ToUnorm16(float value) {
+		return (uint16_t)glm::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f);
+	}
+	inline uint8_t ToUnorm8(float value) {
+		return (uint8_t)glm::round(glm::clamp(value, 0.0f, 1.0f) * 255.0f);
+	}
+}
+
+uint32_t PackedVertexFormat::GetStride() const {
+	return PositionSize(Position) + 4 + TexCoordSize(TexCoord) + ColorSize(Color);
+}
+
+std::vector<BufferAttribute> PackedVertexFormat::GetDecl() const {
+	const GLsizei stride = (GLsizei)GetStride();
+	std::vector<BufferAttribute> result;
+	size_t offset = 0;
+
+	if (Position == PackedPosition::Float32) {
+		result.push_back(BufferAttribute(0, 3, GL_FLOAT, false, stride, offset, AttribUsage::Position));
+	} else {
+		result.push_back(BufferAttribute(0, 3, GL_UNSIGNED_SHORT, true, stride, offset, AttribUsage::Position));
+	}
+	offset += PositionSize(Position);
+
+	result.push_back(BufferAttribute(2, 2, GL_SHORT, true, stride, offset, AttribUsage::Normal));
+	offset += 4;
+
+	switch (TexCoord) {
+		case PackedTexCoord::Float32: result.push_back(BufferAttribute(3, 2, GL_FLOAT, false, stride, offset, AttribUsage::Texture)); break;
+		case PackedTexCoord::Half:    result.push_back(BufferAttribute(3, 2, GL_HALF_FLOAT, false, stride, offset, AttribUsage::Texture)); break;
+		case PackedTexCoord::Unorm16: result.push_back(BufferAttribute(3, 2, GL_UNSIGNED_SHORT, true, stride, offset, AttribUsage::Texture)); break;
+	}
+	offset += TexCoordSize(TexCoord);
+
+	switch (Color) {
+		case PackedColor::Float32: result.push_back(BufferAttribute(1, 4, GL_FLOAT, false, stride, offset, AttribUsage::Color)); break;
+		case PackedColor::RGBA8:   result.push_back(BufferAttribute(1, 4, GL_UNSIGNED_BYTE, true, stride, offset, AttribUsage::Color)); break;
+		default: break;
+	}
+	return result;
+}
+
+glm::vec2 VertexPacker::OctEncode(const glm::vec3& normal) {
+	// Project onto the octahedron, then fold the lower hemisphere over the diagonals
+	glm::vec3 n = normal / (glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z));
+	glm::vec2 result = glm::vec2(n.x, n.y);
+	if (n.z < 0.0f) {
+		result = glm::vec2(
+			(1.0f - glm::abs(n.y)) * SignNotZero(n.x),
+			(1.0f - glm::abs(n.x)) * SignNotZero(n.y));
+	}
+	return result;
+}
+
+glm::vec3 VertexPacker::OctDecode(const glm::vec2& encoded) {
+	glm::vec3 n = glm::vec3(encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+	const float t = glm::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+PackedMeshData::sptr VertexPacker::Pack(const MeshBuilder<VertexPosNormTexCol>& mesh, const PackedVertexFormat& format) {
+	PackedMeshData::sptr result = Pack(mesh.GetVertexDataPtr(), mesh.GetVertexCount(), mesh.GetIndexDataPtr(), mesh.GetIndexCount(), format);
+	// Packing keeps the vertex order, so the levels of detail stay valid
+	result->Lods = mesh.GetLods();
+	return result;
+}
+
+PackedMeshData::sptr VertexPacker::Pack(const VertexPosNormTexCol* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, const PackedVertexFormat& requestedFormat) {
+	// Dropping the colors is only lossless if every vertex has the same one (ex: glTF files can have COLOR_0)
+	PackedVertexFormat format = requestedFormat;
+	if (format.Color == PackedColor::None) {
+		for (size_t ix = 1; ix < vertexCount; ix++) {
+			if (vertices[ix].Color != vertices[0].Color) {
+				format.Color = PackedColor::RGBA8;
+				break;
+			}
+		}
+	}
+
+	PackedMeshData::sptr result = std::make_shared<PackedMeshData>();
+	result->Format = format;
+	result->VertexCount = (uint32_t)vertexCount;
+	result->Indices.assign(indices, indices + indexCount);
+	result->DecodeInfo.OctNormals = true;
+
+	// Find the bounds for quantizing positions and UVs
+	glm::vec3 posMin = glm::vec3(0.0f), posMax = glm::vec3(0.0f);
+	glm::vec2 uvMin  = glm::vec2(0.0f), uvMax  = glm::vec2(0.0f);
+	if (vertexCount > 0) {
+		posMin = posMax = vertices[0].Position;
+		uvMin  = uvMax  = vertices[0].UV;
+		for (size_t ix = 1; ix < vertexCount; ix++) {
+			posMin = glm::min(posMin, vertices[ix].Position);
+			posMax = glm::max(posMax, vertices[ix].Position);
+			uvMin  = glm::min(uvMin, vertices[ix].UV);
+			uvMax  = glm::max(uvMax, vertices[ix].UV);
+		}
+	}
+	if (vertexCount > 0) {
+		result->Bounds = MeshBounds::FromPositions(&vertices[0].Position, vertexCount, sizeof(VertexPosNormTexCol));
+	}
+
+	// Flat meshes (ex: a ground plane) have a zero extent along one axis, which we can't divide by
+	const glm::vec3 posExtent = glm::max(posMax - posMin, glm::vec3(1e-6f));
+	const glm::vec2 uvExtent  = glm::max(uvMax - uvMin, glm::vec2(1e-6f));
+
+	if (format.Position == PackedPosition::Unorm16) {
+		result->DecodeInfo.PositionDequantize = glm::scale(glm::translate(glm::mat4(1.0f), posMin), posExtent);
+	}
+	if (format.TexCoord == PackedTexCoord::Unorm16) {
+		result->DecodeInfo.TexCoordTransform = glm::vec4(uvExtent, uvMin);
+	}
+	if (format.Color == PackedColor::None) {
+		result->DecodeInfo.HasConstantColor = true;
+		result->DecodeInfo.ConstantColor = vertexCount > 0 ? vertices[0].Color : glm::vec4(1.0f);
+	}
+
+	const uint32_t stride = format.GetStride();
+	result->Vertices.resize((size_t)stride * vertexCount);
+	uint8_t* out = result->Vertices.data();
+
+	for (size_t ix = 0; ix < vertexCount; ix++, out += stride) {
+		const VertexPosNormTexCol& vertex = vertices[ix];
+		uint8_t* it = out;
+
+		if (format.Position == PackedPosition::Float32) {
+			memcpy(it, &vertex.Position, 12);
+			it += 12;
+		} else {
+			const glm::vec3 normalized = (vertex.Position - posMin) / posExtent;
+			const uint16_t packed[4] = { ToUnorm16(normalized.x), ToUnorm16(normalized.y), ToUnorm16(normalized.z), 0 };
+			memcpy(it, packed, 8);
+			it += 8;
+		}
+
+		// Rounding each component to the nearest step isn't always the closest encoding once decoded, so we try
+		// all 4 neighbouring encodings and keep the best one
+		const glm::vec3 normal = glm::length(vertex.Normal) > 0.0f ? glm::normalize(vertex.Normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+		const glm::vec2 encoded = OctEncode(normal) * 32767.0f;
+		int16_t best[2] = { ToSnorm16(encoded.x / 32767.0f), ToSnorm16(encoded.y / 32767.0f) };
+		float bestError = -2.0f;
+		for (int corner = 0; corner < 4; corner++) {
+			const float x = (corner & 1) ? glm::ceil(encoded.x) : glm::floor(encoded.x);
+			const float y = (corner & 2) ? glm::ceil(encoded.y) : glm::floor(encoded.y);
+			const int16_t candidate[2] = { ToSnorm16(x / 32767.0f), ToSnorm16(y / 32767.0f) };
+			const float error = glm::dot(normal, OctDecode(glm::vec2(candidate[0], candidate[1]) / 32767.0f));
+			if (error > bestError) {
+				bestError = error;
+				best[0] = candidate[0];
+				best[1] = candidate[1];
+			}
+		}
+		memcpy(it, best, 4);
+		it += 4;
+
+		switch (format.TexCoord) {
+			case PackedTexCoord::Float32:
+				memcpy(it, &vertex.UV, 8);
+				break;
+			case PackedTexCoord::Half: {
+				const uint32_t packed = glm::packHalf2x16(vertex.UV);
+				memcpy(it, &packed, 4);
+				break;
+			}
+			case PackedTexCoord::Unorm16: {
+				const glm::vec2 normalized = (vertex.UV - uvMin) / uvExtent;
+				const uint16_t packed[2] = { ToUnorm16(normalized.x), ToUnorm16(normalized.y) };
+				memcpy(it, packed, 4);
+				break;
+			}
+		}
+		it += TexCoordSize(format.TexCoord);
+
+		switch (format.Color) {
+			case PackedColor::Float32:
+				memcpy(it, &vertex.Color, 16);
+				break;
+			case PackedColor::RGBA8: {
+				const uint8_t packed[4] = { ToUnorm8(vertex.Color.r), ToUnorm8(vertex.Color.g), ToUnorm8(vertex.Color.b), ToUnorm8(vertex.Color.a) };
+				memcpy(it, packed, 4);
+				break;
+			}
+			default: break;
+		}
+	}
+	return result;
+}
+
+VertexArrayObject::sptr VertexPacker::Bake(const PackedMeshData& data, VertexArrayObject::sptr target, MeshLodChain* lods) {
+	VertexArrayObject::sptr result = target != nullptr ? target : VertexArrayObject::Create();
+
+	// Indexed meshes go into the shared pool for their format, and every level of detail shares the vertex range
+	GeometryPool::sptr pool = nullptr;
+	GeometryAllocation::sptr vertices = nullptr;
+	VertexBuffer::sptr vbo = nullptr;
+	if (GeometryPool::IsEnabled() && data.VertexCount > 0 && !data.Indices.empty()) {
+		pool = GeometryPool::Get(data.Format.GetDecl(), GeometryPool::GetIndexType(data.VertexCount));
+		vertices = pool->AllocateVertices(data.Vertices.data(), (uint32_t)data.VertexCount);
+		result->SetPoolGeometry(pool, vertices, pool->AllocateIndices(data.Indices.data(), (uint32_t)data.Indices.size()));
+	} else {
+		vbo = VertexBuffer::Create();
+		vbo->LoadData(data.Vertices.data(), data.Format.GetStride(), data.VertexCount);
+
+		IndexBuffer::sptr ebo = IndexBuffer::Create();
+		ebo->LoadIndices(data.Indices.data(), data.Indices.size(), data.VertexCount);
+
+		result->AddVertexBuffer(vbo, data.Format.GetDecl());
+		result->SetIndexBuffer(ebo);
+	}
+	result->SetDecodeInfo(data.DecodeInfo);
+	result->SetBounds(data.Bounds);
+
+	if (lods != nullptr) {
+		lods->SetBounds(data.Bounds.Center, data.Bounds.Radius);
+		if (lods->GetLevelCount() == 0) {
+			lods->AddLevel(result, 0.0f);
+		}
+		for (const MeshLod& lod : data.Lods) {
+			VertexArrayObject::sptr level = VertexArrayObject::Create();
+			if (pool != nullptr) {
+				level->SetPoolGeometry(pool, vertices, pool->AllocateIndices(lod.Indices.data(), (uint32_t)lod.Indices.size()));
+			} else {
+				IndexBuffer::sptr lodEbo = IndexBuffer::Create();
+				lodEbo->LoadIndices(lod.Indices.data(), lod.Indices.size(), data.VertexCount);
+
+				level->AddVertexBuffer(vbo, data.Format.GetDecl());
+				level->SetIndexBuffer(lodEbo);
+			}
+			level->SetDecodeInfo(data.DecodeInfo);
+			level->SetBounds(data.Bounds);
+			lods->AddLevel(level, lod.Error);
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Graphics/MeshLodChain.h"
+#include "Utilities/MeshBuilder.h"
+#include "Utilities/VertexTypes.h"
+
+/// <summary>
+/// How positions are stored in a packed vertex
+/// </summary>
+enum class PackedPosition : uint8_t {
+	Float32, // 12 bytes, stored as-is
+	Unorm16  // 8 bytes, quantized to the mesh's bounding box and restored by VertexDecodeInfo::PositionDequantize
+};
+/// <summary>
+/// How texture coordinates are stored in a packed vertex
+/// </summary>
+enum class PackedTexCoord : uint8_t {
+	Float32, // 8 bytes, stored as-is
+	Half,    // 4 bytes, exact for UVs near the [0, 1] range, loses precision on heavily tiled UVs
+	Unorm16  // 4 bytes, quantized to the mesh's UV bounds and restored by VertexDecodeInfo::TexCoordTransform
+};
+/// <summary>
+/// How vertex colors are stored in a packed vertex
+/// </summary>
+enum class PackedColor : uint8_t {
+	Float32, // 16 bytes, stored as-is
+	RGBA8,   // 4 bytes
+	None     // 0 bytes, the first vertex's color is used for the whole mesh. Meshes whose colors vary get RGBA8 instead
+};
+
+/// <summary>
+/// Selects the layout of a packed mesh's vertices. Normals are always stored as 2 octahedral encoded snorm16
+/// components (4 bytes), which has lower error than 3 snorm8 components in the same space
+/// </summary>
+struct PackedVertexFormat
+{
+	PackedPosition Position = PackedPosition::Unorm16;
+	PackedTexCoord TexCoord = PackedTexCoord::Half;
+	PackedColor    Color    = PackedColor::None;
+
+	/// <summary>
+	/// The smallest format, 16 bytes per vertex (20 if the colors vary, versus 48 for VertexPosNormTexCol)
+	/// </summary>
+	static PackedVertexFormat Compact() { return PackedVertexFormat(); }
+	/// <summary>
+	/// Keeps positions, UVs and colors at full precision, only the normals are packed
+	/// </summary>
+	static PackedVertexFormat Precise() { return { PackedPosition::Float32, PackedTexCoord::Float32, PackedColor::Float32 }; }
+
+	/// <summary>
+	/// Gets the size of a single vertex in bytes, every attribute is 4 byte aligned
+	/// </summary>
+	uint32_t GetStride() const;
+	/// <summary>
+	/// Builds the attribute layout for this format, using the same slots as VertexPosNormTexCol
+	/// (0 = position, 1 = color, 2 = normal, 3 = UV), so the same shaders work for packed and unpacked meshes
+	/// </summary>
+	std::vector<BufferAttribute> GetDecl() const;
+
+	bool operator ==(const PackedVertexFormat& other) const {
+		return Position == other.Position && TexCoord == other.TexCoord && Color == other.Color;
+	}
+	bool operator !=(const PackedVertexFormat& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// A mesh that has been packed and is ready to upload
+/// </summary>
+struct PackedMeshData
+{
+	typedef std::shared_ptr<PackedMeshData> sptr;
+
+	PackedVertexFormat    Format;
+	VertexDecodeInfo      DecodeInfo;
+	uint32_t              VertexCount = 0;
+	std::vector<uint8_t>  Vertices;
+	std::vector<uint32_t> Indices;
+	// Levels of detail that index into the same vertices, see MeshBuilder::GenerateLods
+	std::vector<MeshLod>  Lods;
+	// The bounds of the unpacked positions, in model space
+	MeshBounds            Bounds;
+};
+
+/// <summary>
+/// Converts meshes built with VertexPosNormTexCol into smaller vertex formats. Packing is done on the CPU
+/// (safe on worker threads), the shader restores the values with the VAO's VertexDecodeInfo
+/// </summary>
+class VertexPacker
+{
+public:
+	/// <summary>
+	/// Packs the vertices of a mesh into the given format, taking its indices and levels of detail as-is
+	/// </summary>
+	/// <param name="mesh">The mesh to pack</param>
+	/// <param name="format">The layout of the packed vertices</param>
+	static PackedMeshData::sptr Pack(const MeshBuilder<VertexPosNormTexCol>& mesh, const PackedVertexFormat& format);
+	/// <summary>
+	/// Packs a block of vertices into the given format. If the format drops the colors but the vertices don't all
+	/// share one color, they are stored as RGBA8 instead, check the result's Format for the layout that was used
+	/// </summary>
+	static PackedMeshData::sptr Pack(const VertexPosNormTexCol* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, const PackedVertexFormat& format);
+
+	/// <summary>
+	/// Uploads a packed mesh into a VAO, must be called on the GL thread
+	/// </summary>
+	/// <param name="data">The packed mesh to upload</param>
+	/// <param name="target">An existing, empty VAO to attach the buffers to, or nullptr to create a new one</param>
+	/// <param name="lods">If not nullptr, receives the bounds and a VAO for each level of detail. The levels share the
+	/// target's vertex buffer, and target is added as level 0 if the chain is empty</param>
+	static VertexArrayObject::sptr Bake(const PackedMeshData& data, VertexArrayObject::sptr target = nullptr, MeshLodChain* lods = nullptr);
+
+	/// <summary>
+	/// Encodes a unit vector as 2 octahedral components in [-1, 1], see "A Survey of Efficient Representations
+	/// for Independent Unit Vectors" (Cigolle et al. 2014)
+	/// </summary>
+	static glm::vec2 OctEncode(const glm::vec3& normal);
+	static glm::vec3 OctDecode(const glm::vec2& encoded);
+
+protected:
+	VertexPacker() = default;
+	~VertexPacker() = default;
+};
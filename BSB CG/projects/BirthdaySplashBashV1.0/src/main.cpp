@@ -31,6 +31,9 @@ We have been using Parsec, a screen sharing program, to play online "locally" wi
 #include "Graphics/VertexBuffer.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/Shader.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/GLStateCache.h"
+#include "Graphics/GeometryPool.h"
 #include "Gameplay/Camera.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -50,10 +53,16 @@ We have been using Parsec, a screen sharing program, to play online "locally" wi
 #include "Utilities/MeshFactory.h"
 #include "Utilities/NotObjLoader.h"
 #include "Utilities/ObjLoader.h"
+#include "Utilities/ObjLoaderBenchmark.h"
+#include "Utilities/TextureCompressor.h"
+#include "Utilities/AssetLoader.h"
+#include "Utilities/AssetCache.h"
 #include "Utilities/VertexTypes.h"
 #include "Gameplay/Scene.h"
 #include "Gameplay/ShaderMaterial.h"
 #include "Gameplay/RendererComponent.h"
+#include "Gameplay/RenderSystem.h"
+#include "Gameplay/MaterialMerger.h"
 #include "Gameplay/Timing.h"
 #include "Graphics/TextureCubeMap.h"
 #include "Graphics/TextureCubeMapData.h"
@@ -67,6 +76,7 @@ We have been using Parsec, a screen sharing program, to play online "locally" wi
 #define DNS_X 3.0f
 #define DNS_Y 3.0f
 #define NUM_HITBOXES_TEST 2
+#define ASSET_UPLOAD_BUDGET_MS 4.0f
 
 /*
 	Handles debug messages from OpenGL
@@ -103,7 +113,7 @@ void GlDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsi
 GLFWwindow* window;
 
 void GlfwWindowResizedCallback(GLFWwindow* window, int width, int height) {
-	glViewport(0, 0, width, height);
+	GLStateCache::Viewport(0, 0, width, height);
 	Application::Instance().ActiveScene->Registry().view<Camera>().each([=](Camera & cam) {
 		cam.ResizeWindow(width, height);
 	});
@@ -226,31 +236,18 @@ bool Collision(Transform& hitbox1, Transform& hitbox2)
 	return colX && colY;
 }
 
-void RenderVAO(
-	const Shader::sptr& shader,
-	const VertexArrayObject::sptr& vao,
-	const glm::mat4& viewProjection,
-	const Transform& transform)
-{
-	shader->SetUniformMatrix("u_ModelViewProjection", viewProjection * transform.WorldTransform());
-	shader->SetUniformMatrix("u_Model", transform.WorldTransform()); 
-	shader->SetUniformMatrix("u_NormalMatrix", transform.WorldNormalMatrix());
-	vao->Render();
-}
-
-void SetupShaderForFrame(const Shader::sptr& shader, const glm::mat4& view, const glm::mat4& projection) {
-	shader->Bind();
-	// These are the uniforms that update only once per frame
-	shader->SetUniformMatrix("u_View", view);
-	shader->SetUniformMatrix("u_ViewProjection", projection * view);
-	shader->SetUniformMatrix("u_SkyboxMatrix", projection * glm::mat4(glm::mat3(view)));
-	glm::vec3 camPos = glm::inverse(view) * glm::vec4(0,0,0,1);
-	shader->SetUniform("u_CamPos", camPos);
-}
-
 int main() {
 	Logger::Init(); // We'll borrow the logger from the toolkit, but we need to initialize it
 
+	#ifdef OBJ_LOADER_BENCHMARK
+	ObjLoaderBenchmark::Run("models/Arena1");
+	ObjLoaderBenchmark::RunScaling("models/Arena1");
+	#endif
+
+	#ifdef TEXTURE_COMPRESSOR
+	TextureCompressor::CompressDirectory("images");
+	#endif
+
 	//Initialize GLFW
 	if (!InitGLFW())
 		return 1;
@@ -259,6 +256,9 @@ int main() {
 	if (!InitGLAD())
 		return 1;
 
+	// Let the driver compile our shaders on its own threads, if it can
+	Shader::InitParallelCompile((GLADloadproc)glfwGetProcAddress);
+
 	int frameIx = 0;
 	float fpsBuffer[128];
 	float minFps, maxFps, avgFps;
@@ -271,6 +271,11 @@ int main() {
 
 	// Enable texturing
 	glEnable(GL_TEXTURE_2D);
+	// Lets the prefiltered levels of our environment maps blend across the edges of each face
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	// Start the background loader, so that our textures and models can be decoded while we show the menu
+	AssetLoader::Init();
 
 	// Push another scope so most memory should be freed *before* we exit the app
 	{
@@ -282,6 +287,12 @@ int main() {
 		shader->LoadShaderPartFromFile("shaders/frag_blinn_phong_textured.glsl", GL_FRAGMENT_SHADER);
 		shader->Link();
 
+		// The same as shader, but with the diffuse textures of merged materials in an array (see MaterialMerger)
+		Shader::sptr arrayShader = Shader::Create();
+		arrayShader->LoadShaderPartFromFile("shaders/vertex_shader.glsl", GL_VERTEX_SHADER);
+		arrayShader->LoadShaderPartFromFile("shaders/frag_blinn_phong_textured.glsl", GL_FRAGMENT_SHADER, { "USE_TEXTURE_ARRAY" });
+		arrayShader->Link();
+
 		Shader::sptr colorCorrectionShader = Shader::Create();
 		colorCorrectionShader->LoadShaderPartFromFile("shaders/passthrough_vert.glsl", GL_VERTEX_SHADER);
 		colorCorrectionShader->LoadShaderPartFromFile("shaders/color_correction_frag.glsl", GL_FRAGMENT_SHADER);
@@ -298,20 +309,29 @@ int main() {
 		reflective->LoadShaderPartFromFile("shaders/frag_blinn_phong_reflection.glsl", GL_FRAGMENT_SHADER);
 		reflective->Link();
 
-		glm::vec3 lightPos = glm::vec3(0.0f, 0.0f, 10.0f);
-		glm::vec3 lightCol = glm::vec3(0.9f, 0.85f, 0.5f);
-		float     lightAmbientPow = 2.1f;
-		float     lightSpecularPow = 1.0f;
-		glm::vec3 ambientCol = glm::vec3(1.0f);
-		float     ambientPow = 0.1f;
-		float     lightLinearFalloff = 0.009;
-		float     lightQuadraticFalloff = 0.032f;
+		// The skybox shader is submitted with the rest, so that it can compile while we load the scenes
+		Shader::sptr skybox = Shader::Create();
+		skybox->LoadShaderPartFromFile("shaders/skybox-shader.vert.glsl", GL_VERTEX_SHADER);
+		skybox->LoadShaderPartFromFile("shaders/skybox-shader.frag.glsl", GL_FRAGMENT_SHADER);
+		skybox->Link();
+
+		// The scene's light is shared by every shader through a uniform buffer (see RenderSystem::LightData)
+		RenderSystem::LightData light;
+		light.LightPos = glm::vec3(0.0f, 0.0f, 10.0f);
+		light.LightCol = glm::vec3(0.9f, 0.85f, 0.5f);
+		light.AmbientLightStrength = 2.1f;
+		light.SpecularLightStrength = 1.0f;
+		light.AmbientCol = glm::vec3(1.0f);
+		light.AmbientStrength = 0.1f;
+		light.AttenuationConstant = 1.0f;
+		light.AttenuationLinear = 0.009;
+		light.AttenuationQuadratic = 0.032f;
 		//variables for turning lighting off and on
-		int		  lightoff = 0;
-		int		  ambientonly = 0;
-		int		  specularonly = 0;
-		int		  ambientandspecular = 0;
-		int		  ambientspeculartoon = 0;
+		light.LightOff = 0;
+		light.Ambient = 0;
+		light.Specular = 0;
+		light.AmbientSpecular = 0;
+		light.AmbientSpecularToon = 0;
 		bool	  cool = false;
 		bool	  warm = false;
 		bool	  magenta = false;
@@ -321,52 +341,47 @@ int main() {
 		bool	  magentaBind = false;
 		bool	  sepiaBind = false;
 		// These are our application / scene level uniforms that don't necessarily update
-		// every frame
-		shader->SetUniform("u_LightPos", lightPos);
-		shader->SetUniform("u_LightCol", lightCol);
-		shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
-		shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
-		shader->SetUniform("u_AmbientCol", ambientCol);
-		shader->SetUniform("u_AmbientStrength", ambientPow);
-		shader->SetUniform("u_LightAttenuationConstant", 1.0f);
-		shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
-		shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
-		shader->SetUniform("u_lightoff", lightoff);
-		shader->SetUniform("u_ambient", ambientonly);
-		shader->SetUniform("u_specular", specularonly);
-		shader->SetUniform("u_ambientspecular", ambientandspecular);
-		shader->SetUniform("u_ambientspeculartoon", ambientspeculartoon);
+		// every frame, so we only re-upload them when the light changes
+		UniformBuffer::sptr lightBuffer = UniformBuffer::Create();
+		lightBuffer->SetData(light);
+		lightBuffer->Bind(RenderSystem::LIGHT_DATA_BINDING);
+		// Sets one of the lighting modes, and turns off the others
+		auto setLightingMode = [&](int RenderSystem::LightData::* mode) {
+			light.LightOff = light.Ambient = light.Specular = light.AmbientSpecular = light.AmbientSpecularToon = 0;
+			light.*mode = 1;
+			lightBuffer->SetData(light);
+		};
 
 		// We'll add some ImGui controls to control our shader
 		imGuiCallbacks.push_back([&]() {
 			if (ImGui::CollapsingHeader("Scene Level Lighting Settings"))
 			{
-				if (ImGui::ColorPicker3("Ambient Color", glm::value_ptr(ambientCol))) {
-					shader->SetUniform("u_AmbientCol", ambientCol);
+				if (ImGui::ColorPicker3("Ambient Color", glm::value_ptr(light.AmbientCol))) {
+					lightBuffer->SetData(light);
 				}
-				if (ImGui::SliderFloat("Fixed Ambient Power", &ambientPow, 0.01f, 1.0f)) {
-					shader->SetUniform("u_AmbientStrength", ambientPow);
+				if (ImGui::SliderFloat("Fixed Ambient Power", &light.AmbientStrength, 0.01f, 1.0f)) {
+					lightBuffer->SetData(light);
 				}
 			}
 			if (ImGui::CollapsingHeader("Light Level Lighting Settings"))
 			{
-				if (ImGui::DragFloat3("Light Pos", glm::value_ptr(lightPos), 0.01f, -10.0f, 10.0f)) {
-					shader->SetUniform("u_LightPos", lightPos);
+				if (ImGui::DragFloat3("Light Pos", glm::value_ptr(light.LightPos), 0.01f, -10.0f, 10.0f)) {
+					lightBuffer->SetData(light);
 				}
-				if (ImGui::ColorPicker3("Light Col", glm::value_ptr(lightCol))) {
-					shader->SetUniform("u_LightCol", lightCol);
+				if (ImGui::ColorPicker3("Light Col", glm::value_ptr(light.LightCol))) {
+					lightBuffer->SetData(light);
 				}
-				if (ImGui::SliderFloat("Light Ambient Power", &lightAmbientPow, 0.0f, 1.0f)) {
-					shader->SetUniform("u_AmbientLightStrength", lightAmbientPow);
+				if (ImGui::SliderFloat("Light Ambient Power", &light.AmbientLightStrength, 0.0f, 1.0f)) {
+					lightBuffer->SetData(light);
 				}
-				if (ImGui::SliderFloat("Light Specular Power", &lightSpecularPow, 0.0f, 1.0f)) {
-					shader->SetUniform("u_SpecularLightStrength", lightSpecularPow);
+				if (ImGui::SliderFloat("Light Specular Power", &light.SpecularLightStrength, 0.0f, 1.0f)) {
+					lightBuffer->SetData(light);
 				}
-				if (ImGui::DragFloat("Light Linear Falloff", &lightLinearFalloff, 0.01f, 0.0f, 1.0f)) {
-					shader->SetUniform("u_LightAttenuationLinear", lightLinearFalloff);
+				if (ImGui::DragFloat("Light Linear Falloff", &light.AttenuationLinear, 0.01f, 0.0f, 1.0f)) {
+					lightBuffer->SetData(light);
 				}
-				if (ImGui::DragFloat("Light Quadratic Falloff", &lightQuadraticFalloff, 0.01f, 0.0f, 1.0f)) {
-					shader->SetUniform("u_LightAttenuationQuadratic", lightQuadraticFalloff);
+				if (ImGui::DragFloat("Light Quadratic Falloff", &light.AttenuationQuadratic, 0.01f, 0.0f, 1.0f)) {
+					lightBuffer->SetData(light);
 				}
 			}
 
@@ -378,43 +393,23 @@ int main() {
 			Ambient, Specular, and Toon Shader*/
 			if (ImGui::CollapsingHeader("Toggle buttons")) {
 				if (ImGui::Button("No Lighting")) {
-					shader->SetUniform("u_lightoff", lightoff = 1);
-					shader->SetUniform("u_ambient", ambientonly = 0);
-					shader->SetUniform("u_specular", specularonly = 0);
-					shader->SetUniform("u_ambientspecular", ambientandspecular = 0);
-					shader->SetUniform("u_ambientspeculartoon", ambientspeculartoon = 0);
+					setLightingMode(&RenderSystem::LightData::LightOff);
 				}
 
 				if (ImGui::Button("Ambient only")) {
-					shader->SetUniform("u_lightoff", lightoff = 0);
-					shader->SetUniform("u_ambient", ambientonly = 1);
-					shader->SetUniform("u_specular", specularonly = 0);
-					shader->SetUniform("u_ambientspecular", ambientandspecular = 0);
-					shader->SetUniform("u_ambientspeculartoon", ambientspeculartoon = 0);
+					setLightingMode(&RenderSystem::LightData::Ambient);
 				}
 
 				if (ImGui::Button("specular only")) {
-					shader->SetUniform("u_lightoff", lightoff = 0);
-					shader->SetUniform("u_ambient", ambientonly = 0);
-					shader->SetUniform("u_specular", specularonly = 1);
-					shader->SetUniform("u_ambientspecular", ambientandspecular = 0);
-					shader->SetUniform("u_ambientspeculartoon", ambientspeculartoon = 0);
+					setLightingMode(&RenderSystem::LightData::Specular);
 				}
 
 				if (ImGui::Button("Ambient and Specular")) {
-					shader->SetUniform("u_lightoff", lightoff = 0);
-					shader->SetUniform("u_ambient", ambientonly = 0);
-					shader->SetUniform("u_specular", specularonly = 0);
-					shader->SetUniform("u_ambientspecular", ambientandspecular = 1);
-					shader->SetUniform("u_ambientspeculartoon", ambientspeculartoon = 0);
+					setLightingMode(&RenderSystem::LightData::AmbientSpecular);
 				}
 
 				if (ImGui::Button("Ambient, Specular, and Toon Shading")) {
-					shader->SetUniform("u_lightoff", lightoff = 0);
-					shader->SetUniform("u_ambient", ambientonly = 0);
-					shader->SetUniform("u_specular", specularonly = 0);
-					shader->SetUniform("u_ambientspecular", ambientandspecular = 0);
-					shader->SetUniform("u_ambientspeculartoon", ambientspeculartoon = 1);
+					setLightingMode(&RenderSystem::LightData::AmbientSpecularToon);
 				}
 
 				if (cool) {
@@ -501,60 +496,49 @@ int main() {
 			}
 			ImGui::PlotLines("FPS", fpsBuffer, 128);
 			ImGui::Text("MIN: %f MAX: %f AVG: %f", minFps, maxFps, avgFps / 128.0f);
+
+			if (ImGui::CollapsingHeader("Level of Detail")) {
+				float lodBias = MeshLodChain::GetLodBias();
+				if (ImGui::SliderFloat("LOD Bias", &lodBias, -2.0f, 4.0f)) {
+					MeshLodChain::SetLodBias(lodBias);
+				}
+			}
 			});
 
 		#pragma endregion Shader and ImGui
 
 		// GL states
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_CULL_FACE);
-		glDepthFunc(GL_LEQUAL); // New 
+		GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
+		GLStateCache::SetEnabled(GL_CULL_FACE, true);
+		GLStateCache::DepthFunc(GL_LEQUAL); // New 
 
 		#pragma region TEXTURE LOADING
 
 		#pragma region testing scene difuses
 		// Load some textures from files
-		Texture2D::sptr diffuse = Texture2D::LoadFromFile("images/TestScene/Stone_001_Diffuse.png");
-		Texture2D::sptr diffuseGround = Texture2D::LoadFromFile("images/TestScene/grass.jpg");
-		Texture2D::sptr diffuseDunce = Texture2D::LoadFromFile("images/TestScene/Dunce.png");
-		Texture2D::sptr diffuseDuncet = Texture2D::LoadFromFile("images/TestScene/Duncet.png");
-		Texture2D::sptr diffuseSlide = Texture2D::LoadFromFile("images/TestScene/Slide.png");
-		Texture2D::sptr diffuseSwing = Texture2D::LoadFromFile("images/TestScene/Swing.png");
-		Texture2D::sptr diffuseTable = Texture2D::LoadFromFile("images//TestScene/Table.png");
-		Texture2D::sptr diffuseTreeBig = Texture2D::LoadFromFile("images/TestScene/TreeBig.png");
-		Texture2D::sptr diffuseRedBalloon = Texture2D::LoadFromFile("images/TestScene/BalloonRed.png");
-		Texture2D::sptr diffuseYellowBalloon = Texture2D::LoadFromFile("images/TestScene/BalloonYellow.png");
-		Texture2D::sptr diffuse2 = Texture2D::LoadFromFile("images/TestScene/box.bmp");
-		Texture2D::sptr specular = Texture2D::LoadFromFile("images/TestScene/Stone_001_Specular.png");
-		Texture2D::sptr reflectivity = Texture2D::LoadFromFile("images/TestScene/box-reflections.bmp");
+		Texture2D::sptr diffuse = AssetCache::LoadTexture2D("images/TestScene/Stone_001_Diffuse.png", "Shared");
+		Texture2D::sptr diffuseGround = AssetCache::LoadTexture2D("images/TestScene/grass.jpg", "Shared");
+		Texture2D::sptr diffuseDunce = AssetCache::LoadTexture2D("images/TestScene/Dunce.png", "Shared");
+		Texture2D::sptr diffuseDuncet = AssetCache::LoadTexture2D("images/TestScene/Duncet.png", "Shared");
+		Texture2D::sptr diffuseSlide = AssetCache::LoadTexture2D("images/TestScene/Slide.png", "Shared");
+		Texture2D::sptr diffuseSwing = AssetCache::LoadTexture2D("images/TestScene/Swing.png", "Shared");
+		Texture2D::sptr diffuseTable = AssetCache::LoadTexture2D("images//TestScene/Table.png", "Shared");
+		Texture2D::sptr diffuseTreeBig = AssetCache::LoadTexture2D("images/TestScene/TreeBig.png", "Shared");
+		Texture2D::sptr diffuseRedBalloon = AssetCache::LoadTexture2D("images/TestScene/BalloonRed.png", "Shared");
+		Texture2D::sptr diffuseYellowBalloon = AssetCache::LoadTexture2D("images/TestScene/BalloonYellow.png", "Shared");
+		Texture2D::sptr diffuse2 = AssetCache::LoadTexture2D("images/TestScene/box.bmp", "Shared");
+		Texture2D::sptr specular = AssetCache::LoadTexture2D("images/TestScene/Stone_001_Specular.png", "Shared");
+		Texture2D::sptr reflectivity = AssetCache::LoadTexture2D("images/TestScene/box-reflections.bmp", "Shared");
 		#pragma endregion testing scene difuses
 
-		#pragma region Arena1 diffuses
-		Texture2D::sptr diffuseTrees = Texture2D::LoadFromFile("images/Arena1/Trees.png");
-		Texture2D::sptr diffuseFlowers = Texture2D::LoadFromFile("images/Arena1/Flower.png");
-		Texture2D::sptr diffuseGroundArena = Texture2D::LoadFromFile("images/Arena1/Ground.png");
-		Texture2D::sptr diffuseHedge = Texture2D::LoadFromFile("images/Arena1/Hedge.png");
-		Texture2D::sptr diffuseBalloons = Texture2D::LoadFromFile("images/Arena1/Ballons.png");
-		Texture2D::sptr diffuseDunceArena = Texture2D::LoadFromFile("images/Arena1/Dunce.png");
-		Texture2D::sptr diffuseDuncetArena = Texture2D::LoadFromFile("images/Arena1/Duncet.png");
-		Texture2D::sptr diffusered = Texture2D::LoadFromFile("images/Arena1/red.png");
-		Texture2D::sptr diffuseyellow = Texture2D::LoadFromFile("images/Arena1/yellow.png");
-		Texture2D::sptr diffusepink = Texture2D::LoadFromFile("images/Arena1/pink.png");
-		Texture2D::sptr diffusemonkeybar = Texture2D::LoadFromFile("images/Arena1/MonkeyBar.png");
-		Texture2D::sptr diffusecake = Texture2D::LoadFromFile("images/Arena1/SliceOfCake.png");
-		Texture2D::sptr diffusesandbox = Texture2D::LoadFromFile("images/Arena1/SandBox.png");
-		Texture2D::sptr diffuseroundabout = Texture2D::LoadFromFile("images/Arena1/RoundAbout.png");
-		Texture2D::sptr diffusepinwheel = Texture2D::LoadFromFile("images/Arena1/Pinwheel.png");
-		#pragma endregion Arena1 diffuses
-
-		LUT3D coolCube("cubes/cool.cube");
-		LUT3D warmCube("cubes/warm.cube");
-		LUT3D magentaCube("cubes/magenta.cube");
-		LUT3D sepiaCube("cubes/sepia.cube");
+		LUT3D::sptr coolCube = AssetLoader::LoadLUT3D("cubes/cool.cube", "Shared");
+		LUT3D::sptr warmCube = AssetLoader::LoadLUT3D("cubes/warm.cube", "Shared");
+		LUT3D::sptr magentaCube = AssetLoader::LoadLUT3D("cubes/magenta.cube", "Shared");
+		LUT3D::sptr sepiaCube = AssetLoader::LoadLUT3D("cubes/sepia.cube", "Shared");
 
 		// Load the cube map
 		//TextureCubeMap::sptr environmentMap = TextureCubeMap::LoadFromImages("images/cubemaps/skybox/sample.jpg");
-		TextureCubeMap::sptr environmentMap = TextureCubeMap::LoadFromImages("images/cubemaps/skybox/ocean.jpg"); 
+		TextureCubeMap::sptr environmentMap = AssetCache::LoadTextureCubeMap("images/cubemaps/skybox/ocean.jpg", "Shared");
 
 		// Creating an empty texture
 		Texture2DDescription desc = Texture2DDescription();  
@@ -582,20 +566,29 @@ int main() {
 		GameScene::sptr Instructions = GameScene::Create("Instructions");
 		GameScene::sptr Pause = GameScene::Create("Pause");
 		GameScene::sptr WinandLose = GameScene::Create("Win/Lose");
-		Application::Instance().ActiveScene = scene;
+		// Start on the menu, so that it can be shown while the arena's assets are still streaming in
+		Application::Instance().ActiveScene = Menu;
 
-		// We can create a group ahead of time to make iterating on the group faster
-		entt::basic_group<entt::entity, entt::exclude_t<>, entt::get_t<Transform>, RendererComponent> renderGroup =
-			scene->Registry().group<RendererComponent>(entt::get_t<Transform>());
-		
-		entt::basic_group<entt::entity, entt::exclude_t<>, entt::get_t<Transform>, RendererComponent> renderGroupArena =
-			Arena1->Registry().group<RendererComponent>(entt::get_t<Transform>());
-		
-		entt::basic_group<entt::entity, entt::exclude_t<>, entt::get_t<Transform>, RendererComponent> renderGroupPause =
-			Pause->Registry().group<RendererComponent>(entt::get_t<Transform>());
-		
-		entt::basic_group<entt::entity, entt::exclude_t<>, entt::get_t<Transform>, RendererComponent> renderGroupMenu =
-			Menu->Registry().group<RendererComponent>(entt::get_t<Transform>());
+		// Each scene gets a render system that sorts and draws all of its renderers
+		RenderSystem::sptr renderSystem = RenderSystem::Create(scene->Registry());
+		RenderSystem::sptr renderSystemArena = RenderSystem::Create(Arena1->Registry());
+		RenderSystem::sptr renderSystemPause = RenderSystem::Create(Pause->Registry());
+		RenderSystem::sptr renderSystemMenu = RenderSystem::Create(Menu->Registry());
+
+		imGuiCallbacks.push_back([&]() {
+			if (ImGui::CollapsingHeader("Render Stats")) {
+				const RenderSystem::Stats& stats = renderSystem->GetStats();
+				ImGui::Text("Draw calls: %d Instanced items: %d Culled: %d", (int)stats.Draws, (int)stats.Instanced, (int)stats.Culled);
+				ImGui::Text("Shader switches: %d Material switches: %d", (int)stats.ShaderSwitches, (int)stats.MaterialSwitches);
+				ImGui::Text("Batches in multi draws: %d", (int)stats.MultiDrawn);
+				for (const GeometryPool::sptr& pool : GeometryPool::GetPools()) {
+					ImGui::Text("Geometry pool (%d byte vertices): %d/%d vertices %d/%d indices", (int)pool->GetStride(),
+						(int)pool->GetVerticesUsed(), (int)pool->GetVertexCapacity(), (int)pool->GetIndicesUsed(), (int)pool->GetIndexCapacity());
+				}
+				const GLStateCache::Stats& glStats = GLStateCache::GetFrameStats();
+				ImGui::Text("GL state changes: %d Redundant changes skipped: %d", (int)glStats.Issued, (int)glStats.Skipped);
+			}
+		});
 
 		#pragma endregion Scene Generation
 
@@ -640,46 +633,6 @@ int main() {
 		materialSwing->Set("u_Shininess", 8.0f);
 		materialSwing->Set("u_TextureMix", 0.0f);
 		
-		ShaderMaterial::sptr materialMonkeyBar = ShaderMaterial::Create();  
-		materialMonkeyBar->Shader = shader;
-		materialMonkeyBar->Set("s_Diffuse", diffusemonkeybar);
-		materialMonkeyBar->Set("s_Diffuse2", diffuse2);
-		materialMonkeyBar->Set("s_Specular", specular);
-		materialMonkeyBar->Set("u_Shininess", 8.0f);
-		materialMonkeyBar->Set("u_TextureMix", 0.0f);
-
-		ShaderMaterial::sptr materialSliceOfCake = ShaderMaterial::Create();
-		materialSliceOfCake->Shader = shader;
-		materialSliceOfCake->Set("s_Diffuse", diffusecake);
-		materialSliceOfCake->Set("s_Diffuse2", diffuse2);
-		materialSliceOfCake->Set("s_Specular", specular);
-		materialSliceOfCake->Set("u_Shininess", 8.0f);
-		materialSliceOfCake->Set("u_TextureMix", 0.0f);
-
-		ShaderMaterial::sptr materialSandBox = ShaderMaterial::Create();
-		materialSandBox->Shader = shader;
-		materialSandBox->Set("s_Diffuse", diffusesandbox);
-		materialSandBox->Set("s_Diffuse2", diffuse2);
-		materialSandBox->Set("s_Specular", specular);
-		materialSandBox->Set("u_Shininess", 8.0f);
-		materialSandBox->Set("u_TextureMix", 0.0f);
-
-		ShaderMaterial::sptr materialRA = ShaderMaterial::Create();
-		materialRA->Shader = shader;
-		materialRA->Set("s_Diffuse", diffuseroundabout);
-		materialRA->Set("s_Diffuse2", diffuse2);
-		materialRA->Set("s_Specular", specular);
-		materialRA->Set("u_Shininess", 8.0f);
-		materialRA->Set("u_TextureMix", 0.0f);
-
-		ShaderMaterial::sptr materialPinwheel = ShaderMaterial::Create();
-		materialPinwheel->Shader = shader;
-		materialPinwheel->Set("s_Diffuse", diffusepinwheel);
-		materialPinwheel->Set("s_Diffuse2", diffuse2);
-		materialPinwheel->Set("s_Specular", specular);
-		materialPinwheel->Set("u_Shininess", 8.0f);
-		materialPinwheel->Set("u_TextureMix", 0.0f);
-		
 		ShaderMaterial::sptr materialTable = ShaderMaterial::Create();  
 		materialTable->Shader = shader;
 		materialTable->Set("s_Diffuse", diffuseTable);
@@ -712,78 +665,6 @@ int main() {
 		materialyellowballoon->Set("u_Shininess", 8.0f);
 		materialyellowballoon->Set("u_TextureMix", 0.0f);
 		
-		ShaderMaterial::sptr materialtrees = ShaderMaterial::Create();  
-		materialtrees->Shader = shader;
-		materialtrees->Set("s_Diffuse", diffuseTrees);
-		materialtrees->Set("s_Diffuse2", diffuse2);
-		materialtrees->Set("s_Specular", specular);
-		materialtrees->Set("u_Shininess", 8.0f);
-		materialtrees->Set("u_TextureMix", 0.0f);
-		
-		ShaderMaterial::sptr materialflowers = ShaderMaterial::Create();  
-		materialflowers->Shader = shader;
-		materialflowers->Set("s_Diffuse", diffuseFlowers);
-		materialflowers->Set("s_Diffuse2", diffuse2);
-		materialflowers->Set("s_Specular", specular);
-		materialflowers->Set("u_Shininess", 8.0f);
-		materialflowers->Set("u_TextureMix", 0.0f);
-		
-		ShaderMaterial::sptr materialGroundArena = ShaderMaterial::Create();  
-		materialGroundArena->Shader = shader;
-		materialGroundArena->Set("s_Diffuse", diffuseGroundArena);
-		materialGroundArena->Set("s_Diffuse2", diffuse2);
-		materialGroundArena->Set("s_Specular", specular);
-		materialGroundArena->Set("u_Shininess", 8.0f);
-		materialGroundArena->Set("u_TextureMix", 0.0f);
-		
-		ShaderMaterial::sptr materialHedge = ShaderMaterial::Create();  
-		materialHedge->Shader = shader;
-		materialHedge->Set("s_Diffuse", diffuseHedge);
-		materialHedge->Set("s_Diffuse2", diffuse2);
-		materialHedge->Set("s_Specular", specular);
-		materialHedge->Set("u_Shininess", 8.0f);
-		materialHedge->Set("u_TextureMix", 0.0f);
-		
-		ShaderMaterial::sptr materialBalloons = ShaderMaterial::Create();  
-		materialBalloons->Shader = shader;
-		materialBalloons->Set("s_Diffuse", diffuseBalloons);
-		materialBalloons->Set("s_Diffuse2", diffuse2);
-		materialBalloons->Set("s_Specular", specular);
-		materialBalloons->Set("u_Shininess", 8.0f);
-		materialBalloons->Set("u_TextureMix", 0.0f);
-		
-		ShaderMaterial::sptr materialDunceArena = ShaderMaterial::Create();  
-		materialDunceArena->Shader = shader;
-		materialDunceArena->Set("s_Diffuse", diffuseDunceArena);
-		materialDunceArena->Set("s_Diffuse2", diffuse2);
-		materialDunceArena->Set("s_Specular", specular);
-		materialDunceArena->Set("u_Shininess", 8.0f);
-		materialDunceArena->Set("u_TextureMix", 0.0f);
-		
-		ShaderMaterial::sptr materialDuncetArena = ShaderMaterial::Create();  
-		materialDuncetArena->Shader = shader;
-		materialDuncetArena->Set("s_Diffuse", diffuseDuncetArena);
-		materialDuncetArena->Set("s_Diffuse2", diffuse2);
-		materialDuncetArena->Set("s_Specular", specular);
-		materialDuncetArena->Set("u_Shininess", 8.0f);
-		materialDuncetArena->Set("u_TextureMix", 0.0f);
-
-		ShaderMaterial::sptr materialBottleyellow = ShaderMaterial::Create();  
-		materialBottleyellow->Shader = shader;
-		materialBottleyellow->Set("s_Diffuse", diffuseyellow);
-		materialBottleyellow->Set("s_Diffuse2", diffuse2);
-		materialBottleyellow->Set("s_Specular", specular);
-		materialBottleyellow->Set("u_Shininess", 8.0f);
-		materialBottleyellow->Set("u_TextureMix", 0.0f);
-
-		ShaderMaterial::sptr materialBottlepink = ShaderMaterial::Create();  
-		materialBottlepink->Shader = shader;
-		materialBottlepink->Set("s_Diffuse", diffusepink);
-		materialBottlepink->Set("s_Diffuse2", diffuse2);
-		materialBottlepink->Set("s_Specular", specular);
-		materialBottlepink->Set("u_Shininess", 8.0f);
-		materialBottlepink->Set("u_TextureMix", 0.0f);
-
 		// 
 		ShaderMaterial::sptr material1 = ShaderMaterial::Create();
 		material1->Shader = reflective;
@@ -792,23 +673,16 @@ int main() {
 		material1->Set("s_Specular", specular);
 		material1->Set("s_Reflectivity", reflectivity);
 		material1->Set("s_Environment", environmentMap);
-		material1->Set("u_LightPos", lightPos);
-		material1->Set("u_LightCol", lightCol);
-		material1->Set("u_AmbientLightStrength", lightAmbientPow);
-		material1->Set("u_SpecularLightStrength", lightSpecularPow);
-		material1->Set("u_AmbientCol", ambientCol);
-		material1->Set("u_AmbientStrength", ambientPow);
-		material1->Set("u_LightAttenuationConstant", 1.0f);
-		material1->Set("u_LightAttenuationLinear", lightLinearFalloff);
-		material1->Set("u_LightAttenuationQuadratic", lightQuadraticFalloff);
 		material1->Set("u_Shininess", 8.0f);
 		material1->Set("u_TextureMix", 0.5f);
 		material1->Set("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1, 0, 0))));
+		material1->Set("u_EnvironmentRoughness", 0.35f);
 
 		ShaderMaterial::sptr reflectiveMat = ShaderMaterial::Create();
 		reflectiveMat->Shader = reflectiveShader;
 		reflectiveMat->Set("s_Environment", environmentMap);
 		reflectiveMat->Set("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1, 0, 0))));
+		reflectiveMat->Set("u_EnvironmentRoughness", 0.0f);
 
 		// Create an object to be our camera
 		GameObject cameraObject = scene->CreateEntity("Camera");
@@ -829,8 +703,6 @@ int main() {
 
 		GameObject objGround = scene->CreateEntity("Ground"); 
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Ground.obj");
-			objGround.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialGround);
 			objGround.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			objGround.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			objGround.get<Transform>().SetLocalScale(0.5f, 0.25f, 0.5f);
@@ -839,8 +711,6 @@ int main() {
 
 		GameObject objDunce = scene->CreateEntity("Dunce");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Dunce.obj");
-			objDunce.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialDunce);
 			objDunce.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.9f);
 			objDunce.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			BehaviourBinding::BindDisabled<SimpleMoveBehaviour>(objDunce);
@@ -848,8 +718,6 @@ int main() {
 
 		GameObject objDuncet = scene->CreateEntity("Duncet");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Duncet.obj");
-			objDuncet.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialDuncet);
 			objDuncet.get<Transform>().SetLocalPosition(2.0f, 0.0f, 0.8f);
 			objDuncet.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			BehaviourBinding::BindDisabled<SimpleMoveBehaviour>(objDuncet);
@@ -858,8 +726,6 @@ int main() {
 
 		GameObject objSlide = scene->CreateEntity("Slide");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Slide.obj");
-			objSlide.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialSlide);
 			objSlide.get<Transform>().SetLocalPosition(0.0f, 5.0f, 3.0f);
 			objSlide.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			objSlide.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
@@ -868,8 +734,6 @@ int main() {
 		
 		GameObject objRedBalloon = scene->CreateEntity("Redballoon");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Balloon.obj");
-			objRedBalloon.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialredballoon);
 			objRedBalloon.get<Transform>().SetLocalPosition(2.5f, -10.0f, 3.0f);
 			objRedBalloon.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			objRedBalloon.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
@@ -887,8 +751,6 @@ int main() {
 		
 		GameObject objYellowBalloon = scene->CreateEntity("Yellowballoon");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Balloon.obj");
-			objYellowBalloon.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialyellowballoon);
 			objYellowBalloon.get<Transform>().SetLocalPosition(-2.5f, -10.0f, 3.0f);
 			objYellowBalloon.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			objYellowBalloon.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
@@ -906,8 +768,6 @@ int main() {
 
 		GameObject objSwing = scene->CreateEntity("Swing");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Swing.obj");
-			objSwing.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialSwing);
 			objSwing.get<Transform>().SetLocalPosition(-5.0f, 0.0f, 3.5f);
 			objSwing.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			objSwing.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
@@ -916,8 +776,6 @@ int main() {
 
 		GameObject objTable = scene->CreateEntity("table");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Table.obj");
-			objTable.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialTable);
 			objTable.get<Transform>().SetLocalPosition(5.0f, 0.0f, 1.25f);
 			objTable.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			objTable.get<Transform>().SetLocalScale(0.35f, 0.35f, 0.35f);
@@ -926,11 +784,9 @@ int main() {
 		//HitBoxes generated using a for loop then each one is given a position
 		std::vector<GameObject> Hitboxes;
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/HitBox.obj");
 			for (int i = 0; i < NUM_HITBOXES_TEST; i++)//NUM_HITBOXES_TEST is located at the top of the code
 			{
 				Hitboxes.push_back(scene->CreateEntity("Hitbox" + (std::to_string(i + 1))));
-				Hitboxes[i].emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialTreeBig);//Material does not matter just invisable hitboxes
 			}
 
 			Hitboxes[0].get<Transform>().SetLocalPosition(4.0f, 4.0f, 2.0f);
@@ -943,8 +799,6 @@ int main() {
 
 		GameObject objDunceArena = Arena1->CreateEntity("Dunce");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Dunce.obj");
-			objDunceArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialDunceArena);
 			objDunceArena.get<Transform>().SetLocalPosition(8.0f, 6.0f, 0.0f);
 			objDunceArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objDunceArena.get<Transform>().SetLocalScale(1.0f, 1.0f, 1.0f);
@@ -952,8 +806,6 @@ int main() {
 		
 		GameObject objDuncetArena = Arena1->CreateEntity("Duncet");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Duncet.obj");
-			objDuncetArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialDuncetArena);
 			objDuncetArena.get<Transform>().SetLocalPosition(-8.0f, 6.0f, 0.0f);
 			objDuncetArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objDuncetArena.get<Transform>().SetLocalScale(1.0f, 1.0f, 1.0f);
@@ -961,8 +813,6 @@ int main() {
 		
 		GameObject objSlideArena = Arena1->CreateEntity("slide");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/Slide.obj");
-			objSlideArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialSlide);
 			objSlideArena.get<Transform>().SetLocalPosition(-2.0f, -2.0f, 2.0f);
 			objSlideArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objSlideArena.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -970,8 +820,6 @@ int main() {
 		
 		GameObject objSwingArena = Arena1->CreateEntity("swing");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/TestScene/swing.obj");
-			objSwingArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialSwing);
 			objSwingArena.get<Transform>().SetLocalPosition(-4.0f, 2.0f, 2.0f);
 			objSwingArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objSwingArena.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -979,8 +827,6 @@ int main() {
 
 		GameObject objMonkeyBarArena = Arena1->CreateEntity("monkeybar");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/MonkeyBar.obj");
-			objMonkeyBarArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialMonkeyBar);
 			objMonkeyBarArena.get<Transform>().SetLocalPosition(2.0f, 2.0f, 2.0f);
 			objMonkeyBarArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objMonkeyBarArena.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -988,8 +834,6 @@ int main() {
 
 		GameObject objcakeArena = Arena1->CreateEntity("cake");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/SliceofCake.obj");
-			objcakeArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialSliceOfCake);
 			objcakeArena.get<Transform>().SetLocalPosition(6.0f, -2.0f, 0.0f);
 			objcakeArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objcakeArena.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -997,8 +841,6 @@ int main() {
 
 		GameObject objSandBoxArena = Arena1->CreateEntity("sandBox");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/SandBox.obj");
-			objSandBoxArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialSandBox);
 			objSandBoxArena.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			objSandBoxArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objSandBoxArena.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -1006,8 +848,6 @@ int main() {
 		
 		GameObject objraArena = Arena1->CreateEntity("roundabout");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/RoundAbout.obj");
-			objraArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialRA);
 			objraArena.get<Transform>().SetLocalPosition(2.0f, 3.0f, 2.0f);
 			objraArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objraArena.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -1015,8 +855,6 @@ int main() {
 
 		GameObject objpinwheelArena = Arena1->CreateEntity("pinwheel");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/PinWheel.obj");
-			objpinwheelArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialPinwheel);
 			objpinwheelArena.get<Transform>().SetLocalPosition(3.0f, 0.0f, 2.0f);
 			objpinwheelArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 180.0f);
 			objpinwheelArena.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -1024,8 +862,6 @@ int main() {
 
 		GameObject objTables = Arena1->CreateEntity("table");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/Table.obj");
-			objTables.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialTable);
 			objTables.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			objTables.get<Transform>().SetLocalRotation(90.0f, 0.0f, 270.0f);
 			objTables.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -1033,7 +869,7 @@ int main() {
 		
 		/*GameObject objBenches = Arena1->CreateEntity("Benches");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/Table.obj");
+			VertexArrayObject::sptr vao = AssetCache::LoadMesh("models/Arena1/Table.obj", "Arena1");
 			objBenches.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialTable);
 			objBenches.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			objBenches.get<Transform>().SetLocalRotation(90.0f, 0.0f, 270.0f);
@@ -1042,8 +878,6 @@ int main() {
 		
 		GameObject objBalloons = Arena1->CreateEntity("Balloons");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/Balloons.obj");
-			objBalloons.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialBalloons);
 			objBalloons.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			objBalloons.get<Transform>().SetLocalRotation(90.0f, 0.0f, 270.0f);
 			objBalloons.get<Transform>().SetLocalScale(0.23f, 0.25f, 0.25f);
@@ -1051,8 +885,6 @@ int main() {
 		
 		GameObject objTrees = Arena1->CreateEntity("trees");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/Trees.obj");
-			objTrees.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialtrees);
 			objTrees.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			objTrees.get<Transform>().SetLocalRotation(90.0f, 0.0f, 270.0f);
 			objTrees.get<Transform>().SetLocalScale(0.27f, 0.27f, 0.27f);
@@ -1060,8 +892,6 @@ int main() {
 		
 		GameObject objFlowers = Arena1->CreateEntity("flowers");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/Flower.obj");
-			objFlowers.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialflowers);
 			objFlowers.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 			objFlowers.get<Transform>().SetLocalRotation(90.0f, 0.0f, 90.0f);
 			objFlowers.get<Transform>().SetLocalScale(0.23f, 0.23f, 0.23f);
@@ -1069,8 +899,6 @@ int main() {
 		
 		GameObject objHedge = Arena1->CreateEntity("Hedge");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/Hedge.obj");
-			objHedge.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialHedge);
 			objHedge.get<Transform>().SetLocalPosition(0.0f, 0.0f, 3.0f);
 			objHedge.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			objHedge.get<Transform>().SetLocalScale(0.25f, 0.25f, 0.25f);
@@ -1078,8 +906,6 @@ int main() {
 		
 		GameObject objGroundArena = Arena1->CreateEntity("Ground");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/Ground.obj");
-			objGroundArena.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialGroundArena);
 			objGroundArena.get<Transform>().SetLocalPosition(0.0f, 0.0f, -4.0f);
 			objGroundArena.get<Transform>().SetLocalRotation(90.0f, 0.0f, 0.0f);
 			objGroundArena.get<Transform>().SetLocalScale(0.5f, 0.5f, 0.5f);
@@ -1087,8 +913,6 @@ int main() {
 		
 		GameObject objBottleText1 = Arena1->CreateEntity("BottleUItext");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/BottleText.obj");
-			objBottleText1.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialBottleyellow);
 			objBottleText1.get<Transform>().SetLocalPosition(12.0f, 14.0f, 2.0f);
 			objBottleText1.get<Transform>().SetLocalRotation(0.0f, 180.0f, 180.0f);
 			objBottleText1.get<Transform>().SetLocalScale(3.0f, 3.0f, 3.0f);
@@ -1096,8 +920,6 @@ int main() {
 
 		GameObject objBottleText2 = Arena1->CreateEntity("BottleUItext");
 		{
-			VertexArrayObject::sptr vao = ObjLoader::LoadFromFile("models/Arena1/BottleText.obj");
-			objBottleText2.emplace<RendererComponent>().SetMesh(vao).SetMaterial(materialBottlepink);
 			objBottleText2.get<Transform>().SetLocalPosition(-4.0f, 14.0f, 2.0f);
 			objBottleText2.get<Transform>().SetLocalRotation(0.0f, 180.0f, 180.0f);
 			objBottleText2.get<Transform>().SetLocalScale(3.0f, 3.0f, 3.0f);
@@ -1120,31 +942,201 @@ int main() {
 
 		#pragma region Skybox
 		/////////////////////////////////// SKYBOX ///////////////////////////////////////////////
-		{
-			// Load our shaders
-			Shader::sptr skybox = std::make_shared<Shader>();
-			skybox->LoadShaderPartFromFile("shaders/skybox-shader.vert.glsl", GL_VERTEX_SHADER);
-			skybox->LoadShaderPartFromFile("shaders/skybox-shader.frag.glsl", GL_FRAGMENT_SHADER);
-			skybox->Link();
-
-			ShaderMaterial::sptr skyboxMat = ShaderMaterial::Create();
-			skyboxMat->Shader = skybox;  
-			skyboxMat->Set("s_Environment", environmentMap);
-			skyboxMat->Set("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1, 0, 0))));
-			skyboxMat->RenderLayer = 100;
+		ShaderMaterial::sptr skyboxMat = ShaderMaterial::Create();
+		skyboxMat->Shader = skybox;  
+		skyboxMat->Set("s_Environment", environmentMap);
+		skyboxMat->Set("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1, 0, 0))));
+		skyboxMat->RenderLayer = 100;
 
+		VertexArrayObject::sptr skyboxVao;
+		{
 			MeshBuilder<VertexPosNormTexCol> mesh;
 			MeshFactory::AddIcoSphere(mesh, glm::vec3(0.0f), 1.0f);
 			MeshFactory::InvertFaces(mesh);
-			VertexArrayObject::sptr meshVao = mesh.Bake();
-			
-			GameObject skyboxObj = scene->CreateEntity("skybox");  
-			skyboxObj.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
-			skyboxObj.get_or_emplace<RendererComponent>().SetMesh(meshVao).SetMaterial(skyboxMat);
+			skyboxVao = mesh.Bake();
 		}
+			
+		GameObject skyboxObj = scene->CreateEntity("skybox");  
+		skyboxObj.get<Transform>().SetLocalPosition(0.0f, 0.0f, 0.0f);
 		////////////////////////////////////////////////////////////////////////////////////////
 		#pragma endregion Skybox
 
+		#pragma region Scene Loading
+		// The renderers are what hold on to a scene's meshes and materials, and through those its textures, so they're
+		// attached here instead of with the objects above. Leaving a scene drops them to unload its assets, while the
+		// objects themselves stay around so that coming back picks up where the scene was left
+		auto loadTestScene = [&]() {
+			objGround.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Ground.obj", "TestScene")).SetMaterial(materialGround);
+			objDunce.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Dunce.obj", "TestScene")).SetMaterial(materialDunce);
+			objDuncet.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Duncet.obj", "TestScene")).SetMaterial(materialDuncet);
+			objSlide.emplace<RendererComponent>().SetLods(AssetCache::LoadMeshLods("models/TestScene/Slide.obj", "TestScene")).SetMaterial(materialSlide);
+			objRedBalloon.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Balloon.obj", "TestScene")).SetMaterial(materialredballoon);
+			objYellowBalloon.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Balloon.obj", "TestScene")).SetMaterial(materialyellowballoon);
+			objSwing.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Swing.obj", "TestScene")).SetMaterial(materialSwing);
+			objTable.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Table.obj", "TestScene")).SetMaterial(materialTable);
+			VertexArrayObject::sptr hitboxVao = AssetCache::LoadMesh("models/TestScene/HitBox.obj", "TestScene");
+			for (GameObject& hitbox : Hitboxes) {
+				hitbox.emplace<RendererComponent>().SetMesh(hitboxVao).SetMaterial(materialTreeBig);//Material does not matter just invisable hitboxes
+			}
+			skyboxObj.emplace<RendererComponent>().SetMesh(skyboxVao).SetMaterial(skyboxMat).SetCulling(false);
+		};
+
+		// The Arena1 props only differ by their diffuse textures, so once those are in we merge them into one material
+		bool arenaMaterialsMerged = false;
+		auto loadArena1 = [&]() {
+			// Nothing outside of this keeps the Arena1 textures and materials, so that they go away with the renderers
+			Texture2D::sptr diffuseTrees = AssetCache::LoadTexture2D("images/Arena1/Trees.png", "Arena1");
+			Texture2D::sptr diffuseFlowers = AssetCache::LoadTexture2D("images/Arena1/Flower.png", "Arena1");
+			Texture2D::sptr diffuseGroundArena = AssetCache::LoadTexture2D("images/Arena1/Ground.png", "Arena1");
+			Texture2D::sptr diffuseHedge = AssetCache::LoadTexture2D("images/Arena1/Hedge.png", "Arena1");
+			Texture2D::sptr diffuseBalloons = AssetCache::LoadTexture2D("images/Arena1/Ballons.png", "Arena1");
+			Texture2D::sptr diffuseDunceArena = AssetCache::LoadTexture2D("images/Arena1/Dunce.png", "Arena1");
+			Texture2D::sptr diffuseDuncetArena = AssetCache::LoadTexture2D("images/Arena1/Duncet.png", "Arena1");
+			Texture2D::sptr diffusered = AssetCache::LoadTexture2D("images/Arena1/red.png", "Arena1");
+			Texture2D::sptr diffuseyellow = AssetCache::LoadTexture2D("images/Arena1/yellow.png", "Arena1");
+			Texture2D::sptr diffusepink = AssetCache::LoadTexture2D("images/Arena1/pink.png", "Arena1");
+			Texture2D::sptr diffusemonkeybar = AssetCache::LoadTexture2D("images/Arena1/MonkeyBar.png", "Arena1");
+			Texture2D::sptr diffusecake = AssetCache::LoadTexture2D("images/Arena1/SliceOfCake.png", "Arena1");
+			Texture2D::sptr diffusesandbox = AssetCache::LoadTexture2D("images/Arena1/SandBox.png", "Arena1");
+			Texture2D::sptr diffuseroundabout = AssetCache::LoadTexture2D("images/Arena1/RoundAbout.png", "Arena1");
+			Texture2D::sptr diffusepinwheel = AssetCache::LoadTexture2D("images/Arena1/Pinwheel.png", "Arena1");
+
+			ShaderMaterial::sptr materialMonkeyBar = ShaderMaterial::Create();  
+			materialMonkeyBar->Shader = shader;
+			materialMonkeyBar->Set("s_Diffuse", diffusemonkeybar);
+			materialMonkeyBar->Set("s_Diffuse2", diffuse2);
+			materialMonkeyBar->Set("s_Specular", specular);
+			materialMonkeyBar->Set("u_Shininess", 8.0f);
+			materialMonkeyBar->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialSliceOfCake = ShaderMaterial::Create();
+			materialSliceOfCake->Shader = shader;
+			materialSliceOfCake->Set("s_Diffuse", diffusecake);
+			materialSliceOfCake->Set("s_Diffuse2", diffuse2);
+			materialSliceOfCake->Set("s_Specular", specular);
+			materialSliceOfCake->Set("u_Shininess", 8.0f);
+			materialSliceOfCake->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialSandBox = ShaderMaterial::Create();
+			materialSandBox->Shader = shader;
+			materialSandBox->Set("s_Diffuse", diffusesandbox);
+			materialSandBox->Set("s_Diffuse2", diffuse2);
+			materialSandBox->Set("s_Specular", specular);
+			materialSandBox->Set("u_Shininess", 8.0f);
+			materialSandBox->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialRA = ShaderMaterial::Create();
+			materialRA->Shader = shader;
+			materialRA->Set("s_Diffuse", diffuseroundabout);
+			materialRA->Set("s_Diffuse2", diffuse2);
+			materialRA->Set("s_Specular", specular);
+			materialRA->Set("u_Shininess", 8.0f);
+			materialRA->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialPinwheel = ShaderMaterial::Create();
+			materialPinwheel->Shader = shader;
+			materialPinwheel->Set("s_Diffuse", diffusepinwheel);
+			materialPinwheel->Set("s_Diffuse2", diffuse2);
+			materialPinwheel->Set("s_Specular", specular);
+			materialPinwheel->Set("u_Shininess", 8.0f);
+			materialPinwheel->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialtrees = ShaderMaterial::Create();  
+			materialtrees->Shader = shader;
+			materialtrees->Set("s_Diffuse", diffuseTrees);
+			materialtrees->Set("s_Diffuse2", diffuse2);
+			materialtrees->Set("s_Specular", specular);
+			materialtrees->Set("u_Shininess", 8.0f);
+			materialtrees->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialflowers = ShaderMaterial::Create();  
+			materialflowers->Shader = shader;
+			materialflowers->Set("s_Diffuse", diffuseFlowers);
+			materialflowers->Set("s_Diffuse2", diffuse2);
+			materialflowers->Set("s_Specular", specular);
+			materialflowers->Set("u_Shininess", 8.0f);
+			materialflowers->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialGroundArena = ShaderMaterial::Create();  
+			materialGroundArena->Shader = shader;
+			materialGroundArena->Set("s_Diffuse", diffuseGroundArena);
+			materialGroundArena->Set("s_Diffuse2", diffuse2);
+			materialGroundArena->Set("s_Specular", specular);
+			materialGroundArena->Set("u_Shininess", 8.0f);
+			materialGroundArena->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialHedge = ShaderMaterial::Create();  
+			materialHedge->Shader = shader;
+			materialHedge->Set("s_Diffuse", diffuseHedge);
+			materialHedge->Set("s_Diffuse2", diffuse2);
+			materialHedge->Set("s_Specular", specular);
+			materialHedge->Set("u_Shininess", 8.0f);
+			materialHedge->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialBalloons = ShaderMaterial::Create();  
+			materialBalloons->Shader = shader;
+			materialBalloons->Set("s_Diffuse", diffuseBalloons);
+			materialBalloons->Set("s_Diffuse2", diffuse2);
+			materialBalloons->Set("s_Specular", specular);
+			materialBalloons->Set("u_Shininess", 8.0f);
+			materialBalloons->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialDunceArena = ShaderMaterial::Create();  
+			materialDunceArena->Shader = shader;
+			materialDunceArena->Set("s_Diffuse", diffuseDunceArena);
+			materialDunceArena->Set("s_Diffuse2", diffuse2);
+			materialDunceArena->Set("s_Specular", specular);
+			materialDunceArena->Set("u_Shininess", 8.0f);
+			materialDunceArena->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialDuncetArena = ShaderMaterial::Create();  
+			materialDuncetArena->Shader = shader;
+			materialDuncetArena->Set("s_Diffuse", diffuseDuncetArena);
+			materialDuncetArena->Set("s_Diffuse2", diffuse2);
+			materialDuncetArena->Set("s_Specular", specular);
+			materialDuncetArena->Set("u_Shininess", 8.0f);
+			materialDuncetArena->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialBottleyellow = ShaderMaterial::Create();  
+			materialBottleyellow->Shader = shader;
+			materialBottleyellow->Set("s_Diffuse", diffuseyellow);
+			materialBottleyellow->Set("s_Diffuse2", diffuse2);
+			materialBottleyellow->Set("s_Specular", specular);
+			materialBottleyellow->Set("u_Shininess", 8.0f);
+			materialBottleyellow->Set("u_TextureMix", 0.0f);
+
+			ShaderMaterial::sptr materialBottlepink = ShaderMaterial::Create();  
+			materialBottlepink->Shader = shader;
+			materialBottlepink->Set("s_Diffuse", diffusepink);
+			materialBottlepink->Set("s_Diffuse2", diffuse2);
+			materialBottlepink->Set("s_Specular", specular);
+			materialBottlepink->Set("u_Shininess", 8.0f);
+			materialBottlepink->Set("u_TextureMix", 0.0f);
+
+			objDunceArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Dunce.obj", "Arena1")).SetMaterial(materialDunceArena);
+			objDuncetArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/Duncet.obj", "Arena1")).SetMaterial(materialDuncetArena);
+			objSlideArena.emplace<RendererComponent>().SetLods(AssetCache::LoadMeshLods("models/TestScene/Slide.obj", "Arena1")).SetMaterial(materialSlide);
+			objSwingArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/TestScene/swing.obj", "Arena1")).SetMaterial(materialSwing);
+			objMonkeyBarArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/MonkeyBar.obj", "Arena1")).SetMaterial(materialMonkeyBar);
+			objcakeArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/SliceofCake.obj", "Arena1")).SetMaterial(materialSliceOfCake);
+			objSandBoxArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/SandBox.obj", "Arena1")).SetMaterial(materialSandBox);
+			objraArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/RoundAbout.obj", "Arena1")).SetMaterial(materialRA);
+			objpinwheelArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/PinWheel.obj", "Arena1")).SetMaterial(materialPinwheel);
+			objTables.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/Table.obj", "Arena1")).SetMaterial(materialTable);
+			objBalloons.emplace<RendererComponent>().SetLods(AssetCache::LoadMeshLods("models/Arena1/Balloons.obj", "Arena1")).SetMaterial(materialBalloons);
+			objTrees.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/Trees.obj", "Arena1")).SetMaterial(materialtrees);
+			objFlowers.emplace<RendererComponent>().SetLods(AssetCache::LoadMeshLods("models/Arena1/Flower.obj", "Arena1")).SetMaterial(materialflowers);
+			objHedge.emplace<RendererComponent>().SetLods(AssetCache::LoadMeshLods("models/Arena1/Hedge.obj", "Arena1")).SetMaterial(materialHedge);
+			objGroundArena.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/Ground.obj", "Arena1")).SetMaterial(materialGroundArena);
+			objBottleText1.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/BottleText.obj", "Arena1")).SetMaterial(materialBottleyellow);
+			objBottleText2.emplace<RendererComponent>().SetMesh(AssetCache::LoadMesh("models/Arena1/BottleText.obj", "Arena1")).SetMaterial(materialBottlepink);
+			arenaMaterialsMerged = false;
+		};
+
+		loadTestScene();
+		loadArena1();
+		#pragma endregion Scene Loading
+
 		// We'll use a vector to store all our key press events for now (this should probably be a behaviour eventually)
 		std::vector<KeyPressWatcher> keyToggles;
 		{
@@ -1184,10 +1176,45 @@ int main() {
 		Timing& time = Timing::Instance();
 		time.LastFrame = glfwGetTime();
 
+		// We'll log how much memory the asset cache saved once everything has finished streaming in
+		bool assetReportLogged = false;
+		// The shaders the game scenes draw with that the driver may still be compiling, the menu waits on these
+		std::vector<Shader::sptr> compilingShaders = { shader, arrayShader, reflectiveShader, reflective, skybox };
+		// The last scene that wasn't the pause menu, switching to another one unloads the game scenes we aren't in
+		GameScene::sptr lastGameScene = Application::Instance().ActiveScene;
+		// The loader group holding the assets that only a scene uses, assets shared with other scenes are in "Shared"
+		auto getAssetGroup = [&](const GameScene::sptr& gameScene) -> std::string {
+			if (gameScene == scene) return "TestScene";
+			if (gameScene == Arena1) return "Arena1";
+			return gameScene->Name;
+		};
+
+		// The color grading uniforms are set every frame, so we look them up once up front
+		const UniformHandle<float>     lutSize      = colorCorrectionShader->GetUniform<float>("u_LutSize");
+		const UniformHandle<glm::vec3> lutDomainMin = colorCorrectionShader->GetUniform<glm::vec3>("u_LutDomainMin");
+		const UniformHandle<glm::vec3> lutDomainMax = colorCorrectionShader->GetUniform<glm::vec3>("u_LutDomainMax");
+
 		///// Game loop /////
 		while (!glfwWindowShouldClose(window)) {
 			glfwPollEvents();
 
+			// Upload any assets that have finished loading in the background
+			AssetLoader::ProcessUploads(ASSET_UPLOAD_BUDGET_MS);
+			// Check on the shaders that are still compiling, without waiting for them
+			compilingShaders.erase(std::remove_if(compilingShaders.begin(), compilingShaders.end(), [](const Shader::sptr& compiling) {
+				return compiling->IsReady();
+			}), compilingShaders.end());
+			if (!assetReportLogged && AssetLoader::IsGroupLoaded("Shared") && AssetLoader::IsGroupLoaded("TestScene") && AssetLoader::IsGroupLoaded("Arena1")) {
+				AssetCache::LogReport();
+				assetReportLogged = true;
+			}
+			if (!arenaMaterialsMerged && AssetLoader::IsGroupLoaded("Shared") && AssetLoader::IsGroupLoaded("Arena1")) {
+				MaterialMerger::MergeTextureArrays(Arena1->Registry(), shader, arrayShader, "s_Diffuse", "s_DiffuseArray");
+				// The arrays hold copies of the textures that were packed, so the cache can let go of the originals
+				AssetCache::Purge("Arena1");
+				arenaMaterialsMerged = true;
+			}
+
 			// Update the timing
 			time.CurrentFrame = glfwGetTime();
 			time.DeltaTime = static_cast<float>(time.CurrentFrame - time.LastFrame);
@@ -1214,16 +1241,12 @@ int main() {
 			colorCorrect->Clear();
 
 			glClearColor(0.08f, 0.17f, 0.31f, 1.0f);
-			glEnable(GL_DEPTH_TEST);
+			GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
 			glClearDepth(1.0f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 			#pragma region Rendering seperate scenes
 
-			// Start by assuming no shader or material is applied
-			Shader::sptr current = nullptr;
-			ShaderMaterial::sptr currentMat = nullptr;
-
 			// Bind colorCorrect
 			/*
 				For some reason when we add colorCorrect->Bind(); it make the screen blue and we don't know to fix it.
@@ -1241,18 +1264,19 @@ int main() {
 			Transform& camTransform = cameraObject.get<Transform>();
 			glm::mat4 view = glm::inverse(camTransform.LocalTransform());
 			glm::mat4 projection = cameraObject.get<Camera>().GetProjection();
-			glm::mat4 viewProjection = projection * view;
 
 
 			#pragma region Menu
 			if (Application::Instance().ActiveScene == Menu) {
 
-				if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS)
+				// We can only leave the menu once everything the next scene needs has finished streaming in and compiling,
+				// so that the first frame of the scene doesn't stall on the driver
+				if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS && compilingShaders.empty() && AssetLoader::IsGroupLoaded("Shared") && AssetLoader::IsGroupLoaded("Arena1"))
 				{
 					Application::Instance().ActiveScene = Arena1;//just to test change to arena1 later
 				}
 				
-				if (glfwGetKey(window,GLFW_KEY_GRAVE_ACCENT) == GLFW_PRESS)
+				if (glfwGetKey(window,GLFW_KEY_GRAVE_ACCENT) == GLFW_PRESS && compilingShaders.empty() && AssetLoader::IsGroupLoaded("Shared") && AssetLoader::IsGroupLoaded("TestScene"))
 				{
 					Application::Instance().ActiveScene = scene;//just to test change to arena1 later
 				}
@@ -1272,40 +1296,8 @@ int main() {
 					t.UpdateWorldMatrix();
 					});
 
-				// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
-			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
-				renderGroupMenu.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
-					// Sort by render layer first, higher numbers get drawn last
-					if (l.Material->RenderLayer < r.Material->RenderLayer) return true;
-					if (l.Material->RenderLayer > r.Material->RenderLayer) return false;
-
-					// Sort by shader pointer next (so materials using the same shader run sequentially where possible)
-					if (l.Material->Shader < r.Material->Shader) return true;
-					if (l.Material->Shader > r.Material->Shader) return false;
-
-					// Sort by material pointer last (so we can minimize switching between materials)
-					if (l.Material < r.Material) return true;
-					if (l.Material > r.Material) return false;
-
-					return false;
-					});
-
-				// Iterate over the render group components and draw them
-				renderGroupMenu.each([&](entt::entity e, RendererComponent& renderer, Transform& transform) {
-					// If the shader has changed, set up it's uniforms
-					if (current != renderer.Material->Shader) {
-						current = renderer.Material->Shader;
-						current->Bind();
-						SetupShaderForFrame(current, view, projection);
-					}
-					// If the material has changed, apply it
-					if (currentMat != renderer.Material) {
-						currentMat = renderer.Material;
-						currentMat->Apply();
-					}
-					// Render the mesh
-					RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-					});
+				// Sort and draw all the renderers in the scene
+				renderSystemMenu->Render(view, projection);
 			}
 			#pragma endregion Menu
 
@@ -1343,40 +1335,8 @@ int main() {
 					t.UpdateWorldMatrix();
 				});
 
-				// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
-			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
-				renderGroup.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
-					// Sort by render layer first, higher numbers get drawn last
-					if (l.Material->RenderLayer < r.Material->RenderLayer) return true;
-					if (l.Material->RenderLayer > r.Material->RenderLayer) return false;
-
-					// Sort by shader pointer next (so materials using the same shader run sequentially where possible)
-					if (l.Material->Shader < r.Material->Shader) return true;
-					if (l.Material->Shader > r.Material->Shader) return false;
-
-					// Sort by material pointer last (so we can minimize switching between materials)
-					if (l.Material < r.Material) return true;
-					if (l.Material > r.Material) return false;
-
-					return false;
-					});
-
-				// Iterate over the render group components and draw them
-				renderGroup.each([&](entt::entity e, RendererComponent& renderer, Transform& transform) {
-					// If the shader has changed, set up it's uniforms
-					if (current != renderer.Material->Shader) {
-						current = renderer.Material->Shader;
-						current->Bind();
-						SetupShaderForFrame(current, view, projection);
-					}
-					// If the material has changed, apply it
-					if (currentMat != renderer.Material) {
-						currentMat = renderer.Material;
-						currentMat->Apply();
-					}
-					// Render the mesh
-					RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-				});
+				// Sort and draw all the renderers in the scene
+				renderSystem->Render(view, projection);
 			}
 			#pragma endregion scene(testing)
 
@@ -1386,7 +1346,6 @@ int main() {
 				camTransform = cameraObject.get<Transform>().SetLocalPosition(0, 0, 17).SetLocalRotation(0, 0, 180);
 				view = glm::inverse(camTransform.LocalTransform());
 				projection = cameraObject.get<Camera>().GetProjection();
-				viewProjection = projection * view;
 				if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 				{
 					Application::Instance().ActiveScene = Pause;
@@ -1414,36 +1373,8 @@ int main() {
 					t.UpdateWorldMatrix();
 				});
 
-				renderGroupArena.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
-					// Sort by render layer first, higher numbers get drawn last
-					if (l.Material->RenderLayer < r.Material->RenderLayer) return true;
-					if (l.Material->RenderLayer > r.Material->RenderLayer) return false;
-
-					// Sort by shader pointer next (so materials using the same shader run sequentially where possible)
-					if (l.Material->Shader < r.Material->Shader) return true;
-					if (l.Material->Shader > r.Material->Shader) return false;
-
-					// Sort by material pointer last (so we can minimize switching between materials)
-					if (l.Material < r.Material) return true;
-					if (l.Material > r.Material) return false;
-
-					return false;
-				});
-				renderGroupArena.each([&](entt::entity e, RendererComponent& renderer, Transform& transform) {
-					// If the shader has changed, set up it's uniforms
-					if (current != renderer.Material->Shader) {
-						current = renderer.Material->Shader;
-						current->Bind();
-						SetupShaderForFrame(current, view, projection);
-					}
-					// If the material has changed, apply it
-					if (currentMat != renderer.Material) {
-						currentMat = renderer.Material;
-						currentMat->Apply();
-					}
-					// Render the mesh
-					RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-				});
+				// Sort and draw all the renderers in the scene
+				renderSystemArena->Render(view, projection);
 			}
 			#pragma endregion Arena 1 scene stuff
 
@@ -1475,40 +1406,8 @@ int main() {
 					t.UpdateWorldMatrix();
 					});
 
-				// Sort the renderers by shader and material, we will go for a minimizing context switches approach here,
-			// but you could for instance sort front to back to optimize for fill rate if you have intensive fragment shaders
-				renderGroupPause.sort<RendererComponent>([](const RendererComponent& l, const RendererComponent& r) {
-					// Sort by render layer first, higher numbers get drawn last
-					if (l.Material->RenderLayer < r.Material->RenderLayer) return true;
-					if (l.Material->RenderLayer > r.Material->RenderLayer) return false;
-
-					// Sort by shader pointer next (so materials using the same shader run sequentially where possible)
-					if (l.Material->Shader < r.Material->Shader) return true;
-					if (l.Material->Shader > r.Material->Shader) return false;
-
-					// Sort by material pointer last (so we can minimize switching between materials)
-					if (l.Material < r.Material) return true;
-					if (l.Material > r.Material) return false;
-
-					return false;
-					});
-
-				// Iterate over the render group components and draw them
-				renderGroupPause.each([&](entt::entity e, RendererComponent& renderer, Transform& transform) {
-					// If the shader has changed, set up it's uniforms
-					if (current != renderer.Material->Shader) {
-						current = renderer.Material->Shader;
-						current->Bind();
-						SetupShaderForFrame(current, view, projection);
-					}
-					// If the material has changed, apply it
-					if (currentMat != renderer.Material) {
-						currentMat = renderer.Material;
-						currentMat->Apply();
-					}
-					// Render the mesh
-					RenderVAO(renderer.Material->Shader, renderer.Mesh, viewProjection, transform);
-					});
+				// Sort and draw all the renderers in the scene
+				renderSystemPause->Render(view, projection);
 			}
 			#pragma endregion Pause
 			
@@ -1519,39 +1418,39 @@ int main() {
 
 			colorCorrect->BindColorAsTexture(0, 0);
 
+			LUT3D::sptr activeCube = nullptr;
 			if (coolBind)
 			{
-				coolCube.bind(30);
+				activeCube = coolCube;
 				std::cout << "Colour Grading Cool" << std::endl;
 			}
 			
 			if (warmBind)
 			{
-				warmCube.bind(30);
+				activeCube = warmCube;
 				std::cout << "Colour Grading Warm" << std::endl;
 			}
 
 			if (magentaBind)
 			{
-				magentaCube.bind(30);
+				activeCube = magentaCube;
 				std::cout << "Colour Grading Magenta" << std::endl;
 			}
 
-			colorCorrect->DrawFullscreenQuad();
-
-			if (coolBind)
+			// The shader needs the size and domain of the table to sample texel centers
+			if (activeCube != nullptr && activeCube->getSize() > 0)
 			{
-				coolCube.unbind(30);
+				activeCube->bind(30);
+				colorCorrectionShader->SetUniform(lutSize, (float)activeCube->getSize());
+				colorCorrectionShader->SetUniform(lutDomainMin, activeCube->getDomainMin());
+				colorCorrectionShader->SetUniform(lutDomainMax, activeCube->getDomainMax());
 			}
 
-			if (warmBind)
-			{
-				warmCube.unbind(30);
-			}
+			colorCorrect->DrawFullscreenQuad();
 
-			if (magentaBind)
+			if (activeCube != nullptr)
 			{
-				magentaCube.unbind(30);
+				activeCube->unbind(30);
 			}
 
 			colorCorrect->UnbindTexture(0);
@@ -1562,10 +1461,40 @@ int main() {
 			#pragma endregion Rendering seperate scenes
 			
 			scene->Poll();
+
+			// Pause sits on top of the game scene, so only a switch between the other scenes counts as leaving one
+			if (Application::Instance().ActiveScene != Pause && Application::Instance().ActiveScene != lastGameScene) {
+				for (const GameScene::sptr& gameScene : { scene, Arena1 }) {
+					// Drop the renderers of every game scene we aren't in, then release the assets only that scene
+					// asked for, now that nothing references them
+					if (gameScene != Application::Instance().ActiveScene && !gameScene->Registry().empty<RendererComponent>()) {
+						gameScene->Registry().clear<RendererComponent>();
+						AssetCache::Purge(getAssetGroup(gameScene));
+					}
+				}
+				// Close up the ranges the released meshes leave in the geometry pools
+				GeometryPool::CompactAll();
+
+				// Coming back to a scene we unloaded streams its assets back in
+				if (Application::Instance().ActiveScene == scene && scene->Registry().empty<RendererComponent>()) {
+					loadTestScene();
+				}
+				if (Application::Instance().ActiveScene == Arena1 && Arena1->Registry().empty<RendererComponent>()) {
+					loadArena1();
+				}
+				lastGameScene = Application::Instance().ActiveScene;
+			}
+
+			GLStateCache::EndFrame();
 			glfwSwapBuffers(window);
 			time.LastFrame = time.CurrentFrame;
 		}
 
+		// Stop loading before we start releasing GL objects
+		AssetLoader::Uninitialize();
+		AssetCache::Clear();
+		GeometryPool::Clear();
+
 		// Nullify scene so that we can release references
 		Application::Instance().ActiveScene = nullptr;
 		ShutdownImGui();